@@ -105,3 +105,32 @@ for person, place in neighboring_entities:
 print("\nTop most common relations:")
 for place, count in sorted(hits.items(), key=lambda x:x[1], reverse=True):
     print(count, "relations claiming", query, "was born in", place)
+
+
+
+# Above we gave the whole file to the named_entity_extractor as one long
+# sentence.  That works, but on long documents it's faster to let MITIE split
+# the text into sentences and find the entities in each one.  The
+# extract_document_entities() method does this for you.  It takes the raw text
+# and returns tuples with the range of characters each entity covers in that
+# text, the entity tag, and the score.
+text = load_entire_file('../../sample_text.txt').decode('utf-8')
+print("\nEntities found by extract_document_entities():")
+for r, tag, score in ner.extract_document_entities(text):
+    print("   Score: {:0.3f}: {}: {}".format(score, tag, text[min(r):max(r)+1]))
+
+
+
+# Text like logs and chat transcripts often has no sentence boundaries at all.
+# For that, a streaming_named_entity_extractor takes tokens a few at a time and
+# runs NER over overlapping windows of them, so it never holds more than a window
+# of tokens in memory.  add_tokens() and flush() return the entities that became
+# final, each with its position in the stream of tokens, tag, score, and tokens.
+stream = streaming_named_entity_extractor(ner, window_size=100, overlap=20)
+print("\nEntities found by a streaming_named_entity_extractor:")
+tokens = tokenize(text)
+for i in range(0, len(tokens), 10):
+    for r, tag, score, entity_tokens in stream.add_tokens(tokens[i:i+10]):
+        print("   Score: {:0.3f}: {}: {}".format(score, tag, " ".join(entity_tokens)))
+for r, tag, score, entity_tokens in stream.flush():
+    print("   Score: {:0.3f}: {}: {}".format(score, tag, " ".join(entity_tokens)))
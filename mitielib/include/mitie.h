@@ -344,6 +344,108 @@ extern "C"
               the canonical decision threshold is at 0.
     !*/
 
+// ----------------------------------------------------------------------------------------
+
+    typedef struct mitie_ner_result_cache mitie_ner_result_cache;
+
+    MITIE_EXPORT mitie_ner_result_cache* mitie_create_ner_result_cache (
+        unsigned long capacity
+    );
+    /*!
+        requires
+            - capacity > 0
+        ensures
+            - Creates a cache that remembers the entities found in up to capacity
+              sentences.  You use it with mitie_extract_entities_with_cache() so that
+              sentences that have been seen before, like repeated boilerplate text,
+              aren't processed again.  A result is only reused for the same tokens and
+              the same named entity extractor, so one cache can be shared by several
+              extractors.  When the cache is full the least recently used results are
+              discarded.
+            - Unlike other MITIE objects, a mitie_ner_result_cache can be used by
+              multiple threads at the same time without any synchronization.
+            - The returned object MUST BE FREED by a call to mitie_free().
+            - If the object can't be created then this function returns NULL.
+    !*/
+
+    MITIE_EXPORT mitie_named_entity_detections* mitie_extract_entities_with_cache (
+        const mitie_named_entity_extractor* ner,
+        char** tokens,
+        mitie_ner_result_cache* cache,
+        const mitie_total_word_feature_extractor* fe
+    );
+    /*!
+        requires
+            - ner != NULL
+            - tokens == An array of NULL terminated C strings.  The end of the array must
+              be indicated by a NULL value (i.e. exactly how mitie_tokenize() defines an
+              array of tokens).
+            - cache != NULL
+            - fe == NULL or a pointer to the feature extractor which was used when
+              creating the ner model.
+        ensures
+            - The returned object MUST BE FREED by a call to mitie_free().
+            - Returns the same detections as mitie_extract_entities(ner, tokens) or, if fe
+              != NULL, mitie_extract_entities_with_extractor(ner, tokens, fe).  However,
+              if the detections for these tokens and this ner are in the cache they are
+              returned without running ner.  Otherwise ner is run and its detections are
+              added to the cache.
+            - If the object can't be created then this function returns NULL
+    !*/
+
+    MITIE_EXPORT unsigned long mitie_ner_result_cache_size (
+        const mitie_ner_result_cache* cache
+    );
+    /*!
+        requires
+            - cache != NULL
+        ensures
+            - returns the number of sentences whose detections are currently stored in
+              the cache.
+    !*/
+
+    MITIE_EXPORT unsigned long mitie_ner_result_cache_capacity (
+        const mitie_ner_result_cache* cache
+    );
+    /*!
+        requires
+            - cache != NULL
+        ensures
+            - returns the maximum number of sentences the cache will hold.
+    !*/
+
+    MITIE_EXPORT unsigned long mitie_ner_result_cache_num_hits (
+        const mitie_ner_result_cache* cache
+    );
+    /*!
+        requires
+            - cache != NULL
+        ensures
+            - returns the number of calls to mitie_extract_entities_with_cache() that
+              found their detections in the cache.
+    !*/
+
+    MITIE_EXPORT unsigned long mitie_ner_result_cache_num_misses (
+        const mitie_ner_result_cache* cache
+    );
+    /*!
+        requires
+            - cache != NULL
+        ensures
+            - returns the number of calls to mitie_extract_entities_with_cache() that
+              had to run the named entity extractor.
+    !*/
+
+    MITIE_EXPORT void mitie_ner_result_cache_clear (
+        mitie_ner_result_cache* cache
+    );
+    /*!
+        requires
+            - cache != NULL
+        ensures
+            - Removes everything from the cache and sets its hit and miss counts to 0.
+    !*/
+
 // ----------------------------------------------------------------------------------------
 
     typedef struct mitie_binary_relation_detector mitie_binary_relation_detector;
@@ -833,6 +935,33 @@ extern "C"
                   avoiding false alarms.
     !*/
 
+    MITIE_EXPORT void mitie_ner_trainer_set_gate_target_recall (
+        mitie_ner_trainer* trainer,
+        double recall
+    );
+    /*!
+        requires
+            - trainer != NULL
+            - 0 <= recall <= 1
+        ensures
+            - mitie_ner_trainer_get_gate_target_recall(trainer) == recall
+    !*/
+
+    MITIE_EXPORT double mitie_ner_trainer_get_gate_target_recall (
+        const mitie_ner_trainer* trainer
+    );
+    /*!
+        requires
+            - trainer != NULL
+        ensures
+            - returns the fraction of the training entities that the sentence gate
+              trained along with the named entity extractor should let through.  The gate
+              is a very cheap model that lets the extractor skip sentences that are
+              unlikely to contain any entities, which makes it much faster on text where
+              most sentences have none.  Smaller values skip more sentences but miss more
+              entities.  0 means no gate is trained, which is the default.
+    !*/
+
     MITIE_EXPORT void mitie_ner_trainer_set_num_threads (
         mitie_ner_trainer* trainer,
         unsigned long num_threads 
@@ -1258,6 +1387,1210 @@ extern "C"
             - If something prevents this function from succeeding then a NULL is returned.
     */ 
 
+// ----------------------------------------------------------------------------------------
+
+    typedef struct mitie_word_similarity_index mitie_word_similarity_index;
+    typedef struct mitie_similar_words mitie_similar_words;
+
+    MITIE_EXPORT mitie_word_similarity_index* mitie_create_word_similarity_index (
+        const mitie_total_word_feature_extractor* twfe
+    );
+    /*!
+        requires
+            - twfe != NULL
+        ensures
+            - Builds an index that can quickly find the words in twfe's dictionary that
+              are most similar to a query word or vector.  Building takes a while for big
+              dictionaries so you will usually want to save the index with
+              mitie_save_word_similarity_index() and load it again later.
+            - The returned object MUST BE FREED by a call to mitie_free().
+            - If the object can't be created then this function returns NULL.
+    !*/
+
+    MITIE_EXPORT mitie_word_similarity_index* mitie_load_word_similarity_index (
+        const char* filename
+    );
+    /*!
+        requires
+            - filename == a valid pointer to a NULL terminated C string
+        ensures
+            - Reads a saved word similarity index from disk and returns a pointer to it.
+            - The returned object MUST BE FREED by a call to mitie_free().
+            - If the object can't be created then this function returns NULL.
+    !*/
+
+    MITIE_EXPORT int mitie_save_word_similarity_index (
+        const char* filename,
+        const mitie_word_similarity_index* index
+    );
+    /*!
+        requires
+            - filename == a valid pointer to a NULL terminated C string
+            - index != NULL
+        ensures
+            - Saves the given index to disk in a file with the given filename.
+            - returns 0 upon success and a non-zero value on failure.
+    !*/
+
+    MITIE_EXPORT unsigned long mitie_word_similarity_index_fingerprint (
+        const mitie_word_similarity_index* index
+    );
+    /*!
+        requires
+            - index != NULL
+        ensures
+            - returns the fingerprint of the total word feature extractor the index was
+              built from.
+    !*/
+
+    MITIE_EXPORT unsigned long mitie_word_similarity_index_num_dimensions (
+        const mitie_word_similarity_index* index
+    );
+    /*!
+        requires
+            - index != NULL
+        ensures
+            - returns the dimensionality of the vectors in the index.  This is the same as
+              mitie_total_word_feature_extractor_num_dimensions() for the total word
+              feature extractor the index was built from.
+    !*/
+
+    MITIE_EXPORT mitie_similar_words* mitie_find_similar_words (
+        const mitie_word_similarity_index* index,
+        const mitie_total_word_feature_extractor* twfe,
+        const char* word,
+        unsigned long k
+    );
+    /*!
+        requires
+            - index != NULL
+            - twfe != NULL
+            - twfe is the total word feature extractor the index was built from.  That
+              is, mitie_total_word_feature_extractor_fingerprint(twfe) ==
+              mitie_word_similarity_index_fingerprint(index)
+            - word == a NULL terminated C string.
+        ensures
+            - Finds the k words in the dictionary most similar to word, not counting word
+              itself.  word doesn't have to be in the dictionary.
+            - The returned object MUST BE FREED by a call to mitie_free().
+            - If something prevents this function from succeeding then a NULL is returned.
+    !*/
+
+    MITIE_EXPORT mitie_similar_words* mitie_find_nearest_words (
+        const mitie_word_similarity_index* index,
+        const float* vect,
+        unsigned long k
+    );
+    /*!
+        requires
+            - index != NULL
+            - vect == a pointer to mitie_word_similarity_index_num_dimensions(index) floats.
+        ensures
+            - Finds the k words in the dictionary whose vectors have the largest cosine
+              similarity to vect.
+            - The returned object MUST BE FREED by a call to mitie_free().
+            - If something prevents this function from succeeding then a NULL is returned.
+    !*/
+
+    MITIE_EXPORT unsigned long mitie_similar_words_size (
+        const mitie_similar_words* words
+    );
+    /*!
+        requires
+            - words != NULL
+        ensures
+            - returns the number of words in words.
+    !*/
+
+    MITIE_EXPORT const char* mitie_similar_words_get_word (
+        const mitie_similar_words* words,
+        unsigned long idx
+    );
+    /*!
+        requires
+            - words != NULL
+            - idx < mitie_similar_words_size(words)
+        ensures
+            - returns the idx-th word.  The words are sorted with the most similar first.
+            - The returned string is owned by words and is valid until words is freed.
+    !*/
+
+    MITIE_EXPORT double mitie_similar_words_get_similarity (
+        const mitie_similar_words* words,
+        unsigned long idx
+    );
+    /*!
+        requires
+            - words != NULL
+            - idx < mitie_similar_words_size(words)
+        ensures
+            - returns the cosine similarity between the idx-th word and the query.
+    !*/
+
+// ----------------------------------------------------------------------------------------
+
+    typedef struct mitie_pipeline_stats mitie_pipeline_stats;
+
+    MITIE_EXPORT void mitie_set_pipeline_stats_enabled (
+        int enabled
+    );
+    /*!
+        ensures
+            - If enabled != 0 then MITIE starts recording how long each stage of
+              tokenizing text, finding named entities, categorizing text, and extracting
+              binary relations takes, along with counts of the tokens, out of dictionary
+              tokens, and entities it sees.  Otherwise it stops recording.  Recording
+              is off when the program starts and costs almost nothing while it's off.
+            - The statistics from all threads are combined.
+            - If MITIE was built with MITIE_DISABLE_PIPELINE_STATS then nothing is ever
+              recorded and this function does nothing.
+    !*/
+
+    MITIE_EXPORT int mitie_pipeline_stats_enabled (
+    );
+    /*!
+        ensures
+            - returns 1 if MITIE is currently recording pipeline statistics and 0
+              otherwise.
+    !*/
+
+    MITIE_EXPORT void mitie_reset_pipeline_stats (
+    );
+    /*!
+        ensures
+            - Sets all the recorded pipeline statistics back to 0.
+    !*/
+
+    MITIE_EXPORT mitie_pipeline_stats* mitie_get_pipeline_stats (
+    );
+    /*!
+        ensures
+            - Returns a snapshot of the pipeline statistics recorded so far.  Later
+              recording doesn't change the returned object.
+            - The returned object MUST BE FREED by a call to mitie_free().
+            - If the object can't be created then this function returns NULL.
+    !*/
+
+    MITIE_EXPORT unsigned long mitie_pipeline_stats_num_stages (
+        const mitie_pipeline_stats* stats
+    );
+    /*!
+        requires
+            - stats != NULL
+        ensures
+            - returns the number of pipeline stages in stats.
+    !*/
+
+    MITIE_EXPORT const char* mitie_pipeline_stats_stage_name (
+        const mitie_pipeline_stats* stats,
+        unsigned long idx
+    );
+    /*!
+        requires
+            - stats != NULL
+            - idx < mitie_pipeline_stats_num_stages(stats)
+        ensures
+            - returns the name of the idx-th stage, like "ner.segmentation".  The
+              returned string is valid for the life of the program.
+    !*/
+
+    MITIE_EXPORT unsigned long mitie_pipeline_stats_stage_count (
+        const mitie_pipeline_stats* stats,
+        unsigned long idx
+    );
+    /*!
+        requires
+            - stats != NULL
+            - idx < mitie_pipeline_stats_num_stages(stats)
+        ensures
+            - returns the number of times the idx-th stage was run.
+    !*/
+
+    MITIE_EXPORT double mitie_pipeline_stats_stage_total_seconds (
+        const mitie_pipeline_stats* stats,
+        unsigned long idx
+    );
+    /*!
+        requires
+            - stats != NULL
+            - idx < mitie_pipeline_stats_num_stages(stats)
+        ensures
+            - returns the total time spent in the idx-th stage.
+    !*/
+
+    MITIE_EXPORT double mitie_pipeline_stats_stage_max_seconds (
+        const mitie_pipeline_stats* stats,
+        unsigned long idx
+    );
+    /*!
+        requires
+            - stats != NULL
+            - idx < mitie_pipeline_stats_num_stages(stats)
+        ensures
+            - returns the longest time one run of the idx-th stage took.
+    !*/
+
+    MITIE_EXPORT double mitie_pipeline_stats_stage_percentile_seconds (
+        const mitie_pipeline_stats* stats,
+        unsigned long idx,
+        double p
+    );
+    /*!
+        requires
+            - stats != NULL
+            - idx < mitie_pipeline_stats_num_stages(stats)
+            - 0 <= p <= 1
+        ensures
+            - returns an upper bound on the time taken by the fastest p fraction of the
+              runs of the idx-th stage.  For example, p == 0.99 gives the 99th
+              percentile latency.  It comes from the latency histogram so it's only
+              accurate to within a factor of 2.
+    !*/
+
+    MITIE_EXPORT unsigned long mitie_pipeline_stats_num_histogram_buckets (
+        const mitie_pipeline_stats* stats
+    );
+    /*!
+        requires
+            - stats != NULL
+        ensures
+            - returns the number of buckets in each stage's latency histogram.
+    !*/
+
+    MITIE_EXPORT unsigned long mitie_pipeline_stats_stage_histogram (
+        const mitie_pipeline_stats* stats,
+        unsigned long idx,
+        unsigned long bucket
+    );
+    /*!
+        requires
+            - stats != NULL
+            - idx < mitie_pipeline_stats_num_stages(stats)
+            - bucket < mitie_pipeline_stats_num_histogram_buckets(stats)
+        ensures
+            - returns the number of runs of the idx-th stage that took between 2^bucket
+              and 2^(bucket+1) nanoseconds.  The first bucket also counts faster runs
+              and the last bucket also counts slower ones.
+    !*/
+
+    MITIE_EXPORT unsigned long mitie_pipeline_stats_num_counters (
+        const mitie_pipeline_stats* stats
+    );
+    /*!
+        requires
+            - stats != NULL
+        ensures
+            - returns the number of counters in stats.
+    !*/
+
+    MITIE_EXPORT const char* mitie_pipeline_stats_counter_name (
+        const mitie_pipeline_stats* stats,
+        unsigned long idx
+    );
+    /*!
+        requires
+            - stats != NULL
+            - idx < mitie_pipeline_stats_num_counters(stats)
+        ensures
+            - returns the name of the idx-th counter, like "ner.oov_tokens".  The
+              returned string is valid for the life of the program.
+    !*/
+
+    MITIE_EXPORT unsigned long mitie_pipeline_stats_counter_value (
+        const mitie_pipeline_stats* stats,
+        unsigned long idx
+    );
+    /*!
+        requires
+            - stats != NULL
+            - idx < mitie_pipeline_stats_num_counters(stats)
+        ensures
+            - returns the value of the idx-th counter.
+    !*/
+
+// ----------------------------------------------------------------------------------------
+
+    typedef struct mitie_memory_usage mitie_memory_usage;
+
+    MITIE_EXPORT mitie_memory_usage* mitie_get_named_entity_extractor_memory_usage (
+        const mitie_named_entity_extractor* ner
+    );
+    /*!
+        requires
+            - ner != NULL
+        ensures
+            - Returns a breakdown of the memory used by ner.  It's a list of named
+              components with their sizes in bytes:
+                - tag_strings: the entity type names.
+                - segmenter_weights: the weights of the model that finds entity chunks.
+                - classifier_weights: the weights of the model that labels the chunks.
+                - feature_extractor.word_table.keys, feature_extractor.word_table.vectors,
+                  and feature_extractor.word_table.map_nodes: the table of word vectors.
+                - feature_extractor.morph_trans and feature_extractor.substring_table.*:
+                  the word morphology features used for words not in the table.
+                - feature_extractor.oov_cache: the cache of out of dictionary word vectors.
+            - The sizes are estimates.  They don't include the bookkeeping the memory
+              allocator adds to each allocation.
+            - Models made with the same total_word_feature_extractor share one copy of its
+              word table, but each model reports the whole table.
+            - The returned object MUST BE FREED by a call to mitie_free().
+            - If the object can't be created then this function returns NULL.
+    !*/
+
+    MITIE_EXPORT mitie_memory_usage* mitie_get_text_categorizer_memory_usage (
+        const mitie_text_categorizer* tcat
+    );
+    /*!
+        requires
+            - tcat != NULL
+        ensures
+            - Returns a breakdown of the memory used by tcat.  It has the same
+              components as mitie_get_named_entity_extractor_memory_usage() except for
+              segmenter_weights.
+            - The returned object MUST BE FREED by a call to mitie_free().
+            - If the object can't be created then this function returns NULL.
+    !*/
+
+    MITIE_EXPORT mitie_memory_usage* mitie_get_binary_relation_detector_memory_usage (
+        const mitie_binary_relation_detector* detector
+    );
+    /*!
+        requires
+            - detector != NULL
+        ensures
+            - Returns a breakdown of the memory used by detector.  It has the
+              relation_type string and the classifier_weights.
+            - The returned object MUST BE FREED by a call to mitie_free().
+            - If the object can't be created then this function returns NULL.
+    !*/
+
+    MITIE_EXPORT mitie_memory_usage* mitie_get_total_word_feature_extractor_memory_usage (
+        const mitie_total_word_feature_extractor* twfe
+    );
+    /*!
+        requires
+            - twfe != NULL
+        ensures
+            - Returns a breakdown of the memory used by twfe.  It has the components
+              listed under feature_extractor in the discussion of
+              mitie_get_named_entity_extractor_memory_usage(), without the
+              "feature_extractor." prefix.
+            - The returned object MUST BE FREED by a call to mitie_free().
+            - If the object can't be created then this function returns NULL.
+    !*/
+
+    MITIE_EXPORT unsigned long mitie_memory_usage_num_components (
+        const mitie_memory_usage* usage
+    );
+    /*!
+        requires
+            - usage != NULL
+        ensures
+            - returns the number of components in usage.
+    !*/
+
+    MITIE_EXPORT const char* mitie_memory_usage_component_name (
+        const mitie_memory_usage* usage,
+        unsigned long idx
+    );
+    /*!
+        requires
+            - usage != NULL
+            - idx < mitie_memory_usage_num_components(usage)
+        ensures
+            - returns the name of the idx-th component, like "segmenter_weights".  The
+              returned string is valid until usage is freed.
+    !*/
+
+    MITIE_EXPORT unsigned long mitie_memory_usage_component_bytes (
+        const mitie_memory_usage* usage,
+        unsigned long idx
+    );
+    /*!
+        requires
+            - usage != NULL
+            - idx < mitie_memory_usage_num_components(usage)
+        ensures
+            - returns the number of bytes used by the idx-th component.
+    !*/
+
+    MITIE_EXPORT unsigned long mitie_memory_usage_total_bytes (
+        const mitie_memory_usage* usage
+    );
+    /*!
+        requires
+            - usage != NULL
+        ensures
+            - returns the sum of the sizes of all the components in usage.
+    !*/
+
+// ----------------------------------------------------------------------------------------
+
+    typedef struct mitie_document_entities mitie_document_entities;
+
+    MITIE_EXPORT mitie_document_entities* mitie_extract_document_entities (
+        const mitie_named_entity_extractor* ner,
+        const char* text,
+        unsigned long max_sentence_length,
+        unsigned long num_threads
+    );
+    /*!
+        requires
+            - ner != NULL
+            - text == a NULL terminated UTF-8 string holding a whole document.
+            - max_sentence_length > 0
+        ensures
+            - Finds the named entities in text.  Unlike mitie_extract_entities(), you
+              don't need to tokenize the text or split it into sentences first.  This
+              function tokenizes text the same way mitie_tokenize() does, splits the
+              tokens into sentences with simple punctuation based rules, and runs ner on
+              each sentence.  Sentences are never longer than max_sentence_length
+              tokens, so the time spent on each one stays bounded even when the text
+              has no punctuation.  100 is a good value for max_sentence_length.
+            - If num_threads > 1 then the sentences are processed by that many threads.
+              The results are the same either way.
+            - The returned object MUST BE FREED by a call to mitie_free().
+            - If the object can't be created then this function returns NULL.  This
+              happens, for instance, if ner is a pure model loaded without its
+              total_word_feature_extractor.
+    !*/
+
+    MITIE_EXPORT unsigned long mitie_document_entities_size (
+        const mitie_document_entities* dets
+    );
+    /*!
+        requires
+            - dets != NULL
+        ensures
+            - returns the number of named entities in dets.  They are listed in the
+              order they appear in the text.
+    !*/
+
+    MITIE_EXPORT unsigned long mitie_document_entity_begin (
+        const mitie_document_entities* dets,
+        unsigned long idx
+    );
+    /*!
+        requires
+            - dets != NULL
+            - idx < mitie_document_entities_size(dets)
+        ensures
+            - returns the byte offset in the text of the first byte of the idx-th
+              entity.
+    !*/
+
+    MITIE_EXPORT unsigned long mitie_document_entity_end (
+        const mitie_document_entities* dets,
+        unsigned long idx
+    );
+    /*!
+        requires
+            - dets != NULL
+            - idx < mitie_document_entities_size(dets)
+        ensures
+            - returns the byte offset in the text one past the last byte of the idx-th
+              entity.  So the entity is the text in the half open range
+              [mitie_document_entity_begin(dets,idx), mitie_document_entity_end(dets,idx)).
+    !*/
+
+    MITIE_EXPORT unsigned long mitie_document_entity_char_begin (
+        const mitie_document_entities* dets,
+        unsigned long idx
+    );
+    /*!
+        requires
+            - dets != NULL
+            - idx < mitie_document_entities_size(dets)
+        ensures
+            - returns the same thing as mitie_document_entity_begin() except the offset
+              is counted in Unicode characters rather than bytes.
+    !*/
+
+    MITIE_EXPORT unsigned long mitie_document_entity_char_end (
+        const mitie_document_entities* dets,
+        unsigned long idx
+    );
+    /*!
+        requires
+            - dets != NULL
+            - idx < mitie_document_entities_size(dets)
+        ensures
+            - returns the same thing as mitie_document_entity_end() except the offset
+              is counted in Unicode characters rather than bytes.
+    !*/
+
+    MITIE_EXPORT unsigned long mitie_document_entity_tag (
+        const mitie_document_entities* dets,
+        unsigned long idx
+    );
+    /*!
+        requires
+            - dets != NULL
+            - idx < mitie_document_entities_size(dets)
+        ensures
+            - returns the label of the idx-th entity, as an index into the
+              named_entity_extractor's tags.  See mitie_get_named_entity_tagstr().
+    !*/
+
+    MITIE_EXPORT const char* mitie_document_entity_tagstr (
+        const mitie_document_entities* dets,
+        unsigned long idx
+    );
+    /*!
+        requires
+            - dets != NULL
+            - idx < mitie_document_entities_size(dets)
+        ensures
+            - returns the name of the label of the idx-th entity.  The returned string
+              is valid until dets is freed.
+    !*/
+
+    MITIE_EXPORT double mitie_document_entity_score (
+        const mitie_document_entities* dets,
+        unsigned long idx
+    );
+    /*!
+        requires
+            - dets != NULL
+            - idx < mitie_document_entities_size(dets)
+        ensures
+            - returns the score of the idx-th entity.  It has the same meaning as
+              mitie_ner_get_detection_score().
+    !*/
+
+    MITIE_EXPORT unsigned long mitie_document_entity_sentence (
+        const mitie_document_entities* dets,
+        unsigned long idx
+    );
+    /*!
+        requires
+            - dets != NULL
+            - idx < mitie_document_entities_size(dets)
+        ensures
+            - returns the index of the sentence that contains the idx-th entity.
+    !*/
+
+    MITIE_EXPORT unsigned long mitie_document_num_sentences (
+        const mitie_document_entities* dets
+    );
+    /*!
+        requires
+            - dets != NULL
+        ensures
+            - returns the number of sentences the text was split into.
+    !*/
+
+    MITIE_EXPORT unsigned long mitie_document_sentence_begin (
+        const mitie_document_entities* dets,
+        unsigned long idx
+    );
+    /*!
+        requires
+            - dets != NULL
+            - idx < mitie_document_num_sentences(dets)
+        ensures
+            - returns the byte offset in the text of the first byte of the idx-th
+              sentence.
+    !*/
+
+    MITIE_EXPORT unsigned long mitie_document_sentence_end (
+        const mitie_document_entities* dets,
+        unsigned long idx
+    );
+    /*!
+        requires
+            - dets != NULL
+            - idx < mitie_document_num_sentences(dets)
+        ensures
+            - returns the byte offset in the text one past the last byte of the idx-th
+              sentence.
+    !*/
+
+// ----------------------------------------------------------------------------------------
+
+    typedef struct mitie_streaming_ner mitie_streaming_ner;
+    typedef struct mitie_streaming_entities mitie_streaming_entities;
+
+    MITIE_EXPORT mitie_streaming_ner* mitie_create_streaming_ner (
+        const mitie_named_entity_extractor* ner,
+        unsigned long window_size,
+        unsigned long overlap
+    );
+    /*!
+        requires
+            - ner != NULL
+            - window_size > 0
+            - overlap < window_size
+        ensures
+            - Creates an object that finds the named entities in an unbounded stream of
+              tokens, like a log file or chat transcript that has no usable sentence
+              boundaries.  You give it tokens with mitie_streaming_ner_add_token() and
+              take the entities it finds with mitie_streaming_ner_take_entities().
+            - ner is run over windows of window_size tokens, each sharing overlap
+              tokens with the one before it, and the entities found in the shared
+              regions are reconciled so each part of the stream is labeled once.  So
+              the object never holds more than window_size tokens and an entity is
+              final at most window_size tokens after it starts.  100 and 20 are good
+              values for window_size and overlap.
+            - The returned object holds a pointer to ner, so ner must not be freed
+              before it.
+            - The returned object MUST BE FREED by a call to mitie_free().
+            - If the object can't be created then this function returns NULL.  This
+              happens, for instance, if ner is a pure model loaded without its
+              total_word_feature_extractor.
+    !*/
+
+    MITIE_EXPORT int mitie_streaming_ner_add_token (
+        mitie_streaming_ner* stream,
+        const char* token
+    );
+    /*!
+        requires
+            - stream != NULL
+            - token == a NULL terminated C string
+        ensures
+            - Appends token to the end of the stream.  If this fills a window it is
+              processed, which may make more entities final.
+            - returns 0 upon success and a non-zero value on failure.
+    !*/
+
+    MITIE_EXPORT int mitie_streaming_ner_add_tokens (
+        mitie_streaming_ner* stream,
+        char** tokens
+    );
+    /*!
+        requires
+            - stream != NULL
+            - tokens == An array of NULL terminated C strings.  The end of the array
+              must be indicated by a NULL value (i.e. exactly how mitie_tokenize()
+              defines an array of tokens).
+        ensures
+            - Calls mitie_streaming_ner_add_token() on each of the tokens in order.
+            - returns 0 upon success and a non-zero value on failure.
+    !*/
+
+    MITIE_EXPORT int mitie_streaming_ner_flush (
+        mitie_streaming_ner* stream
+    );
+    /*!
+        requires
+            - stream != NULL
+        ensures
+            - Treats the tokens added so far as the end of the stream, making all the
+              entities in them final.  You can keep adding tokens afterward, but the
+              tokens before the flush aren't used as context for the ones after it.  So
+              it's a good idea to flush at the end of each document.
+            - returns 0 upon success and a non-zero value on failure.
+    !*/
+
+    MITIE_EXPORT unsigned long mitie_streaming_ner_num_tokens (
+        const mitie_streaming_ner* stream
+    );
+    /*!
+        requires
+            - stream != NULL
+        ensures
+            - returns the number of tokens added to stream.
+    !*/
+
+    MITIE_EXPORT unsigned long mitie_streaming_ner_finalized_position (
+        const mitie_streaming_ner* stream
+    );
+    /*!
+        requires
+            - stream != NULL
+        ensures
+            - returns the position in the stream up to which all the entities are
+              final.  That is, every entity that starts before this token has already
+              been made available to mitie_streaming_ner_take_entities().
+    !*/
+
+    MITIE_EXPORT void mitie_streaming_ner_clear (
+        mitie_streaming_ner* stream
+    );
+    /*!
+        requires
+            - stream != NULL
+        ensures
+            - Throws away all the tokens and entities in stream and starts a new stream
+              at position 0.
+    !*/
+
+    MITIE_EXPORT mitie_streaming_entities* mitie_streaming_ner_take_entities (
+        mitie_streaming_ner* stream
+    );
+    /*!
+        requires
+            - stream != NULL
+        ensures
+            - Removes all the entities that are final from stream and returns them.
+              Entities come out in the order they appear in the stream, each one
+              exactly once, and they never overlap.
+            - The returned object MUST BE FREED by a call to mitie_free().
+            - returns NULL if the object could not be created.
+    !*/
+
+    MITIE_EXPORT unsigned long mitie_streaming_entities_size (
+        const mitie_streaming_entities* ents
+    );
+    /*!
+        requires
+            - ents != NULL
+        ensures
+            - returns the number of entities in ents.
+    !*/
+
+    MITIE_EXPORT unsigned long mitie_streaming_entity_begin (
+        const mitie_streaming_entities* ents,
+        unsigned long idx
+    );
+    /*!
+        requires
+            - ents != NULL
+            - idx < mitie_streaming_entities_size(ents)
+        ensures
+            - returns the position in the stream of the first token of the idx-th
+              entity.  The first token ever added to the stream is at position 0.
+    !*/
+
+    MITIE_EXPORT unsigned long mitie_streaming_entity_end (
+        const mitie_streaming_entities* ents,
+        unsigned long idx
+    );
+    /*!
+        requires
+            - ents != NULL
+            - idx < mitie_streaming_entities_size(ents)
+        ensures
+            - returns the position in the stream one past the last token of the idx-th
+              entity.
+    !*/
+
+    MITIE_EXPORT unsigned long mitie_streaming_entity_tag (
+        const mitie_streaming_entities* ents,
+        unsigned long idx
+    );
+    /*!
+        requires
+            - ents != NULL
+            - idx < mitie_streaming_entities_size(ents)
+        ensures
+            - returns the tag of the idx-th entity, an index into the tags of the
+              named entity extractor the stream was created with.
+    !*/
+
+    MITIE_EXPORT const char* mitie_streaming_entity_tagstr (
+        const mitie_streaming_entities* ents,
+        unsigned long idx
+    );
+    /*!
+        requires
+            - ents != NULL
+            - idx < mitie_streaming_entities_size(ents)
+        ensures
+            - returns the name of the tag of the idx-th entity.  The returned string is
+              valid until ents is freed.
+    !*/
+
+    MITIE_EXPORT double mitie_streaming_entity_score (
+        const mitie_streaming_entities* ents,
+        unsigned long idx
+    );
+    /*!
+        requires
+            - ents != NULL
+            - idx < mitie_streaming_entities_size(ents)
+        ensures
+            - returns the confidence of the named entity extractor in the tag of the
+              idx-th entity.  > 0 means it's likely correct.
+    !*/
+
+    MITIE_EXPORT const char* mitie_streaming_entity_token (
+        const mitie_streaming_entities* ents,
+        unsigned long idx,
+        unsigned long token_idx
+    );
+    /*!
+        requires
+            - ents != NULL
+            - idx < mitie_streaming_entities_size(ents)
+            - token_idx < mitie_streaming_entity_end(ents,idx) - mitie_streaming_entity_begin(ents,idx)
+        ensures
+            - returns the token_idx-th token of the idx-th entity.  The tokens are kept
+              with the entities so you don't need to hold on to the stream yourself.
+              The returned string is valid until ents is freed.
+    !*/
+
+// ----------------------------------------------------------------------------------------
+
+    typedef struct mitie_async_queue mitie_async_queue;
+    typedef struct mitie_async_request mitie_async_request;
+
+    /*
+        The status of a request submitted to a mitie_async_queue.  A request starts out
+        pending and then completes exactly once as done, canceled, or failed.
+    */
+    #define MITIE_ASYNC_PENDING  0
+    #define MITIE_ASYNC_DONE     1
+    #define MITIE_ASYNC_CANCELED 2
+    #define MITIE_ASYNC_FAILED   3
+
+    typedef void (*mitie_async_callback)(mitie_async_request* request, void* user_data);
+    /*!
+        A callback given to one of the mitie_async_*() submission functions is called
+        with the request and the user_data given along with it once the request
+        completes.  It's called on one of the queue's worker threads, or, if the request
+        was canceled, on the thread that canceled it or freed the queue.  So it must be
+        thread safe and it should return quickly, since the worker doesn't start another
+        request until it does.  A typical callback just hands the request to the
+        program's event loop.  It may free the request.
+    !*/
+
+    MITIE_EXPORT mitie_async_queue* mitie_create_async_queue (
+        unsigned long num_threads,
+        unsigned long max_pending,
+        int block_when_full
+    );
+    /*!
+        requires
+            - num_threads > 0
+            - max_pending > 0
+        ensures
+            - Creates a queue that runs NER, text categorization, and binary relation
+              scoring on num_threads worker threads, so programs built around an event
+              loop can use MITIE without blocking it.  Requests are submitted with the
+              mitie_async_*() functions below, which return right away.
+            - At most max_pending requests wait for a worker at once.  When the queue is
+              full, submitting another request blocks until there is room if
+              block_when_full != 0, otherwise the submission fails and returns NULL.
+            - The models used by the requests must not be freed before the queue.
+            - The returned object MUST BE FREED by a call to mitie_free().  Freeing it
+              cancels the requests that haven't started and waits for the running ones
+              to finish.
+            - If the object can't be created then this function returns NULL.
+    !*/
+
+    MITIE_EXPORT int mitie_async_queue_get_fd (
+        const mitie_async_queue* queue
+    );
+    /*!
+        requires
+            - queue != NULL
+        ensures
+            - returns a file descriptor that becomes readable when a request submitted
+              without a callback completes.  Add it to your event loop (e.g. with poll(),
+              epoll, libuv, or mio) and when it's readable call
+              mitie_async_queue_next_completed() until it returns NULL.  Don't read from
+              it or close it yourself.
+            - returns -1 on Windows, where you must poll
+              mitie_async_queue_next_completed() or use callbacks instead.
+    !*/
+
+    MITIE_EXPORT mitie_async_request* mitie_async_queue_next_completed (
+        mitie_async_queue* queue
+    );
+    /*!
+        requires
+            - queue != NULL
+        ensures
+            - returns the next completed request that was submitted without a callback,
+              in the order they completed.  Each request is returned once.
+            - returns NULL if there isn't one.
+    !*/
+
+    MITIE_EXPORT unsigned long mitie_async_queue_num_pending (
+        const mitie_async_queue* queue
+    );
+    /*!
+        requires
+            - queue != NULL
+        ensures
+            - returns the number of requests waiting for a worker thread.
+    !*/
+
+// ----------------------------------------------------------------------------------------
+
+    /*
+        The following functions submit requests to a mitie_async_queue.  They are the
+        asynchronous versions of mitie_extract_entities(), mitie_categorize_text(), and
+        mitie_extract_binary_relation() followed by mitie_classify_binary_relation().
+        The inputs are copied, so they can be freed as soon as the function returns.
+
+        When the request completes, if callback != NULL then it's called with the
+        request and user_data.  Otherwise the request is returned by
+        mitie_async_queue_next_completed().
+
+        Each function returns NULL if the request couldn't be submitted.  This happens
+        when the queue is full and doesn't block, or if the inputs are invalid.
+        Otherwise the returned request MUST BE FREED by a call to mitie_free().  It can
+        be freed at any time, including from inside its own callback.  A request freed
+        before it completes still runs unless it's canceled, but its callback isn't
+        called and it isn't returned by mitie_async_queue_next_completed().  If its
+        callback is running in another thread, mitie_free() waits for the callback to
+        return.  So a callback must not free requests other than its own.  To stop a
+        request that hasn't started, use mitie_async_cancel().
+    */
+
+    MITIE_EXPORT mitie_async_request* mitie_async_extract_entities (
+        mitie_async_queue* queue,
+        const mitie_named_entity_extractor* ner,
+        char** tokens,
+        mitie_async_callback callback,
+        void* user_data
+    );
+    /*!
+        requires
+            - queue != NULL
+            - ner != NULL
+            - tokens == An array of NULL terminated C strings.  The end of the array must
+              be indicated by a NULL value (i.e. exactly how mitie_tokenize() defines an
+              array of tokens).
+        ensures
+            - Submits a request to find the named entities in tokens.  Once it's done,
+              get them with mitie_async_get_entities().
+            - Returns NULL if tokens is NULL.
+    !*/
+
+    MITIE_EXPORT mitie_async_request* mitie_async_extract_entities_from_text (
+        mitie_async_queue* queue,
+        const mitie_named_entity_extractor* ner,
+        const char* text,
+        mitie_async_callback callback,
+        void* user_data
+    );
+    /*!
+        requires
+            - queue != NULL
+            - ner != NULL
+            - text == a NULL terminated C string
+        ensures
+            - Just like mitie_async_extract_entities() except the worker thread first
+              splits text into tokens like mitie_tokenize() does.  The tokens can be
+              read with mitie_async_get_num_tokens() and mitie_async_get_token().
+            - Returns NULL if text is NULL.
+    !*/
+
+    MITIE_EXPORT mitie_async_request* mitie_async_categorize_text (
+        mitie_async_queue* queue,
+        const mitie_text_categorizer* tcat,
+        char** tokens,
+        mitie_async_callback callback,
+        void* user_data
+    );
+    /*!
+        requires
+            - queue != NULL
+            - tcat != NULL
+            - tokens == An array of NULL terminated C strings.  The end of the array must
+              be indicated by a NULL value (i.e. exactly how mitie_tokenize() defines an
+              array of tokens).
+        ensures
+            - Submits a request to categorize tokens.  Once it's done, get the result with
+              mitie_async_get_category().  The request fails if tokens is empty.
+            - Returns NULL if tokens is NULL.
+    !*/
+
+    MITIE_EXPORT mitie_async_request* mitie_async_categorize_text_from_text (
+        mitie_async_queue* queue,
+        const mitie_text_categorizer* tcat,
+        const char* text,
+        mitie_async_callback callback,
+        void* user_data
+    );
+    /*!
+        requires
+            - queue != NULL
+            - tcat != NULL
+            - text == a NULL terminated C string
+        ensures
+            - Just like mitie_async_categorize_text() except the worker thread first
+              splits text into tokens like mitie_tokenize() does.
+            - Returns NULL if text is NULL.
+    !*/
+
+    MITIE_EXPORT mitie_async_request* mitie_async_score_binary_relation (
+        mitie_async_queue* queue,
+        const mitie_named_entity_extractor* ner,
+        const mitie_binary_relation_detector* detector,
+        char** tokens,
+        unsigned long arg1_start,
+        unsigned long arg1_length,
+        unsigned long arg2_start,
+        unsigned long arg2_length,
+        mitie_async_callback callback,
+        void* user_data
+    );
+    /*!
+        requires
+            - queue != NULL
+            - ner != NULL
+            - detector != NULL
+            - tokens == An array of NULL terminated C strings.  The end of the array must
+              be indicated by a NULL value (i.e. exactly how mitie_tokenize() defines an
+              array of tokens).
+            - arg1_length > 0
+            - arg2_length > 0
+            - The two arguments do not overlap.  That is:
+              mitie_entities_overlap(arg1_start,arg1_length,arg2_start,arg2_length) == 0
+        ensures
+            - Submits a request to score how likely the two arguments in tokens are to be
+              in the relation detector detects.  Once it's done, get the score with
+              mitie_async_get_relation_score().
+            - Returns NULL if tokens is NULL or the arguments run past the end of tokens.
+            - The request fails if detector wasn't trained with ner's
+              total_word_feature_extractor.
+    !*/
+
+// ----------------------------------------------------------------------------------------
+
+    MITIE_EXPORT int mitie_async_get_status (
+        const mitie_async_request* request
+    );
+    /*!
+        requires
+            - request != NULL
+        ensures
+            - returns the status of the request, one of MITIE_ASYNC_PENDING,
+              MITIE_ASYNC_DONE, MITIE_ASYNC_CANCELED, or MITIE_ASYNC_FAILED.
+    !*/
+
+    MITIE_EXPORT int mitie_async_wait (
+        const mitie_async_request* request
+    );
+    /*!
+        requires
+            - request != NULL
+        ensures
+            - blocks until the request completes and returns its status.  The callback,
+              if any, may still be running when this function returns.
+    !*/
+
+    MITIE_EXPORT int mitie_async_cancel (
+        mitie_async_request* request
+    );
+    /*!
+        requires
+            - request != NULL
+            - The queue the request was submitted to hasn't been freed.
+        ensures
+            - If no worker thread has started the request then it's removed from the
+              queue, completed with a status of MITIE_ASYNC_CANCELED, and this function
+              returns 0.  The request's callback is called before this function returns,
+              and if it has no callback it will be returned by
+              mitie_async_queue_next_completed().
+            - Otherwise this function does nothing and returns a non-zero value.  A
+              request that's already running can't be interrupted.
+    !*/
+
+    MITIE_EXPORT void* mitie_async_get_user_data (
+        const mitie_async_request* request
+    );
+    /*!
+        requires
+            - request != NULL
+        ensures
+            - returns the user_data given when the request was submitted.
+    !*/
+
+    MITIE_EXPORT const char* mitie_async_get_error (
+        mitie_async_request* request
+    );
+    /*!
+        requires
+            - request != NULL
+        ensures
+            - if (mitie_async_get_status(request) == MITIE_ASYNC_FAILED) then
+                - returns a description of what went wrong.
+            - else
+                - returns ""
+            - The returned string is valid until request is freed or this function is
+              called on it again.
+    !*/
+
+    MITIE_EXPORT const mitie_named_entity_detections* mitie_async_get_entities (
+        const mitie_async_request* request
+    );
+    /*!
+        requires
+            - request != NULL
+        ensures
+            - if (request is a finished mitie_async_extract_entities() or
+              mitie_async_extract_entities_from_text() request with a status of
+              MITIE_ASYNC_DONE) then
+                - returns the named entities found.  Read them with the
+                  mitie_ner_get_*() functions.  They belong to the request, so don't
+                  free them, and they are valid until request is freed.
+            - else
+                - returns NULL
+    !*/
+
+    MITIE_EXPORT unsigned long mitie_async_get_num_tokens (
+        const mitie_async_request* request
+    );
+    /*!
+        requires
+            - request != NULL
+        ensures
+            - if (request is an NER or text categorization request with a status of
+              MITIE_ASYNC_DONE) then
+                - returns the number of tokens it was run on.  This is how you get the
+                  tokens a *_from_text() request split its text into.
+            - else
+                - returns 0
+    !*/
+
+    MITIE_EXPORT const char* mitie_async_get_token (
+        const mitie_async_request* request,
+        unsigned long idx
+    );
+    /*!
+        requires
+            - request != NULL
+            - idx < mitie_async_get_num_tokens(request)
+        ensures
+            - returns the idx-th token the request was run on.  The returned string is
+              valid until request is freed.
+    !*/
+
+    MITIE_EXPORT int mitie_async_get_category (
+        const mitie_async_request* request,
+        const char** label,
+        double* score
+    );
+    /*!
+        requires
+            - request != NULL
+            - label != NULL
+            - score != NULL
+        ensures
+            - if (request is a text categorization request with a status of
+              MITIE_ASYNC_DONE) then
+                - #*label == the predicted label.  It's valid until request is freed.
+                - #*score == the confidence of the prediction, as returned by
+                  mitie_categorize_text().
+                - returns 0
+            - else
+                - returns a non-zero value.
+    !*/
+
+    MITIE_EXPORT int mitie_async_get_relation_score (
+        const mitie_async_request* request,
+        double* score
+    );
+    /*!
+        requires
+            - request != NULL
+            - score != NULL
+        ensures
+            - if (request is a binary relation request with a status of
+              MITIE_ASYNC_DONE) then
+                - #*score == the score mitie_classify_binary_relation() would give.
+                  > 0 means the arguments are likely in the relation.
+                - returns 0
+            - else
+                - returns a non-zero value.
+    !*/
+
 // ----------------------------------------------------------------------------------------
 // ----------------------------------------------------------------------------------------
 
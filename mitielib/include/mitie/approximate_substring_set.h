@@ -8,6 +8,7 @@
 #include <dlib/uintn.h>
 #include <dlib/serialize.h>
 #include <vector>
+#include "memory_usage.h"
 
 using namespace std;
 
@@ -162,6 +163,36 @@ namespace mitie
             }
         }
 
+        memory_usage get_memory_usage (
+        ) const
+        /*!
+            ensures
+                - returns a breakdown of the memory used by this object.
+        !*/
+        {
+            memory_usage result;
+            result.add("hash_table", heap_bytes(hash_table));
+            result.add("crc_table", heap_bytes(crc_table));
+            return result;
+        }
+
+        void swap (
+            approximate_substring_set& item
+        )
+        /*!
+            ensures
+                - swaps *this with item
+        !*/
+        {
+            // The constants are swapped the same way deserialize() loads them.
+            std::swap(const_cast<dlib::uint32&>(mask), const_cast<dlib::uint32&>(item.mask));
+            std::swap(const_cast<dlib::uint32&>(mask_bits), const_cast<dlib::uint32&>(item.mask_bits));
+            std::swap(const_cast<dlib::uint32&>(init_hash), const_cast<dlib::uint32&>(item.init_hash));
+            std::swap(max_substr_len, item.max_substr_len);
+            hash_table.swap(item.hash_table);
+            crc_table.swap(item.crc_table);
+        }
+
         friend void serialize(const approximate_substring_set& item, std::ostream& out)
         {
             int version = 1;
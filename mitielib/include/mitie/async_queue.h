@@ -0,0 +1,327 @@
+// Copyright (C) 2014 Massachusetts Institute of Technology, Lincoln Laboratory
+// License: Boost Software License   See LICENSE.txt for the full license.
+// Authors: Davis E. King (davis@dlib.net)
+#ifndef MIT_LL_ASYNC_QUEuE_H_
+#define MIT_LL_ASYNC_QUEuE_H_
+
+#include <string>
+#include <vector>
+#include <list>
+#include <deque>
+#include <dlib/threads.h>
+#include <dlib/smart_pointers.h>
+#include <dlib/smart_pointers_thread_safe.h>
+#include <mitie/ner_feature_extraction.h>
+
+namespace mitie
+{
+
+// ----------------------------------------------------------------------------------------
+
+    class async_task
+    {
+        /*!
+            WHAT THIS OBJECT REPRESENTS
+                This is the interface for a piece of work run by an async_work_queue.
+                An implementation holds its inputs, does the work in run(), and keeps
+                the results for whoever submitted it to read once it's done.
+        !*/
+    public:
+        virtual ~async_task() {}
+
+        virtual void run (
+            sentence_features& scratch
+        ) = 0;
+        /*!
+            ensures
+                - Does the work.  Throwing an exception makes the request fail with the
+                  exception's message.
+                - scratch belongs to the worker thread running this task, which gives
+                  the same object to every task it runs.  So a task can pass it to
+                  something like named_entity_extractor::predict() rather than
+                  allocating new word feature buffers.
+                - Note that dlib ends the program if a failed DLIB_CASSERT is caught and
+                  ignored twice, so an implementation must check its inputs and throw
+                  something like dlib::error rather than let the models assert.
+        !*/
+    };
+
+// ----------------------------------------------------------------------------------------
+
+    enum async_status
+    {
+        async_pending = 0,
+        async_done = 1,
+        async_canceled = 2,
+        async_failed = 3
+    };
+
+    // The function an async_request calls when it completes.  It's given the context
+    // pointer given to the async_request's constructor.
+    typedef void (*async_callback)(void* context);
+
+    class async_request : dlib::noncopyable
+    {
+        /*!
+            WHAT THIS OBJECT REPRESENTS
+                This object is an async_task along with the state of running it on an
+                async_work_queue.  async_requests are shared between the code that
+                submitted them and the queue, so they are always held by an
+                async_request_ptr.
+
+            THREAD SAFETY
+                All the member functions are safe to call from any thread.
+        !*/
+    public:
+
+        async_request (
+            async_task* task,
+            async_callback callback,
+            void* context
+        );
+        /*!
+            requires
+                - task was allocated with new.  This object takes ownership of it.
+            ensures
+                - #get_status() == async_pending
+                - When this request completes, if callback != 0 then callback(context)
+                  is called, otherwise context is handed out by the queue's
+                  next_completed().  Either way, that doesn't happen if detach() was
+                  called first.
+        !*/
+
+        async_status get_status (
+        ) const;
+
+        async_status wait (
+        ) const;
+        /*!
+            ensures
+                - blocks until get_status() != async_pending and returns the status.
+        !*/
+
+        std::string get_error (
+        ) const;
+        /*!
+            ensures
+                - if (get_status() == async_failed) then
+                    - returns the message of the exception the task threw.
+                - else
+                    - returns ""
+        !*/
+
+        async_task& get_task (
+        ) { return *task; }
+
+        const async_task& get_task (
+        ) const { return *task; }
+        /*!
+            ensures
+                - returns the task.  Its results may only be looked at once get_status()
+                  is async_done, since until then a worker thread may be running it.
+        !*/
+
+        void detach (
+        );
+        /*!
+            ensures
+                - The callback won't be called, and the context won't be returned by
+                  next_completed(), if that hasn't already begun.  This is for when
+                  the submitter is no longer interested in the request.  The request
+                  still runs unless it's canceled.
+                - If the callback is running in another thread then this function waits
+                  for it to return.  So once detach() returns the callback is done with
+                  the context.  Calling detach() from inside the callback is fine.
+        !*/
+
+    private:
+        friend class async_work_queue;
+
+        bool finish (
+            async_status status,
+            const std::string& error
+        );
+
+        bool begin_delivery (
+        );
+
+        void end_delivery (
+        );
+
+        mutable dlib::mutex m;
+        mutable dlib::signaler completed;
+        async_status status;
+        std::string error;
+        bool detached;
+
+        // Set while a thread is calling the callback.
+        dlib::signaler delivered;
+        bool delivering;
+        dlib::thread_id_type delivering_thread;
+
+        dlib::scoped_ptr<async_task> task;
+        const async_callback callback;
+        void* const context;
+
+        // These fields are guarded by the mutex of the queue the request was given to.
+        const void* queue;
+        bool queued;
+        std::list<dlib::shared_ptr_thread_safe<async_request> >::iterator position;
+    };
+
+    typedef dlib::shared_ptr_thread_safe<async_request> async_request_ptr;
+
+// ----------------------------------------------------------------------------------------
+
+    class async_work_queue : dlib::noncopyable
+    {
+        /*!
+            WHAT THIS OBJECT REPRESENTS
+                This object runs async_tasks on a pool of worker threads, so programs
+                that can't block, like ones built around an event loop, can use MITIE's
+                models.  Each submitted request completes exactly once, as done,
+                failed, or canceled, and then either its callback is called or it's
+                handed out by next_completed().  get_completion_fd() can be watched by
+                an event loop to learn when next_completed() has something.
+
+                At most get_max_pending() requests wait in the queue at once.  When the
+                queue is full, submit() either blocks until a worker takes a request or
+                refuses the new one, depending on blocks_when_full().
+
+            THREAD SAFETY
+                All the member functions are safe to call from any thread.  Callbacks
+                are called on the worker threads, or, for requests canceled before they
+                started, on the thread that canceled them.  So they must be thread
+                safe, and they should be quick since a worker doesn't start its next
+                request until the callback returns.  Since detach() waits for a running
+                callback, a callback must not detach requests other than its own.
+        !*/
+    public:
+
+        async_work_queue (
+            unsigned long num_threads,
+            unsigned long max_pending,
+            bool block_when_full
+        );
+        /*!
+            requires
+                - num_threads > 0
+                - max_pending > 0
+            ensures
+                - #get_num_threads() == num_threads
+                - #get_max_pending() == max_pending
+                - #blocks_when_full() == block_when_full
+            throws
+                - dlib::error if the completion file descriptor can't be created.
+        !*/
+
+        ~async_work_queue (
+        );
+        /*!
+            ensures
+                - Cancels all the requests that haven't started and waits for the ones
+                  that have to finish.
+        !*/
+
+        unsigned long get_num_threads (
+        ) const { return workers.size(); }
+
+        unsigned long get_max_pending (
+        ) const { return max_pending; }
+
+        bool blocks_when_full (
+        ) const { return block_when_full; }
+
+        unsigned long num_pending (
+        ) const;
+        /*!
+            ensures
+                - returns the number of submitted requests that no worker has started
+                  yet.
+        !*/
+
+        bool submit (
+            const async_request_ptr& req
+        );
+        /*!
+            requires
+                - req hasn't been submitted before.
+            ensures
+                - Queues req to be run by a worker thread.  If the queue is full then
+                  this function waits for room if blocks_when_full(), otherwise it
+                  returns false without queuing req.
+                - returns true if req was queued.
+        !*/
+
+        bool cancel (
+            const async_request_ptr& req
+        );
+        /*!
+            ensures
+                - if (req was submitted to this queue and no worker has started it) then
+                    - removes req from the queue and completes it with a status of
+                      async_canceled.
+                    - returns true
+                - else
+                    - returns false.  Requests that are already running can't be
+                      interrupted and finish normally.
+        !*/
+
+        bool next_completed (
+            void*& context
+        );
+        /*!
+            ensures
+                - if (a request without a callback has completed and hasn't been handed
+                  out yet) then
+                    - #context == that request's context
+                    - returns true
+                - else
+                    - returns false
+                - Requests are handed out in the order they completed.
+        !*/
+
+        int get_completion_fd (
+        ) const { return fds[0]; }
+        /*!
+            ensures
+                - returns a file descriptor that is readable whenever next_completed()
+                  would return true.  Don't read from it, just call next_completed()
+                  until it returns false.
+                - returns -1 on platforms without pipes, i.e. Windows.
+        !*/
+
+    private:
+
+        static void worker_thread (
+            async_work_queue* self
+        );
+
+        void deliver (
+            const async_request_ptr& req
+        );
+
+        void drain_completion_fd (
+        );
+
+        const unsigned long max_pending;
+        const bool block_when_full;
+
+        mutable dlib::mutex m;
+        dlib::signaler not_empty;
+        dlib::signaler not_full;
+        std::list<async_request_ptr> pending;
+        std::deque<async_request_ptr> completed;
+        bool stopping;
+        int fds[2];
+        bool fd_signaled;
+
+        std::vector<dlib::shared_ptr<dlib::thread_function> > workers;
+    };
+
+// ----------------------------------------------------------------------------------------
+
+}
+
+#endif // MIT_LL_ASYNC_QUEuE_H_
+
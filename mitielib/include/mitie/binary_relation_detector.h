@@ -9,6 +9,7 @@
 #include <dlib/serialize.h>
 #include <vector>
 #include <mitie/total_word_feature_extractor.h>
+#include <mitie/pipeline_stats.h>
 
 namespace mitie
 {
@@ -63,6 +64,16 @@ namespace mitie
         binary_relation_detector(
         ) : total_word_feature_extractor_fingerprint(0) {}
 
+        binary_relation_detector(
+            const std::string& relation_type_,
+            dlib::uint64 total_word_feature_extractor_fingerprint_,
+            const dlib::decision_function<dlib::sparse_linear_kernel<sparse_vector_type> >& df_
+        ) :
+            relation_type(relation_type_),
+            total_word_feature_extractor_fingerprint(total_word_feature_extractor_fingerprint_),
+            df(df_)
+        {}
+
         std::string relation_type;
         dlib::uint64 total_word_feature_extractor_fingerprint;
         dlib::decision_function<dlib::sparse_linear_kernel<sparse_vector_type> > df;
@@ -73,8 +84,27 @@ namespace mitie
         {
             if (rel.total_word_feature_extractor_fingerprint != total_word_feature_extractor_fingerprint)
                 throw dlib::error("Incompatible total_word_feature_extractor used with binary_relation_detector.");
+            pipeline_stage_timer timer(stage_relation_classification);
             return df(rel.feats);
         }
+
+        memory_usage get_memory_usage (
+        ) const
+        /*!
+            ensures
+                - returns a breakdown of the memory used by this object.  It has the
+                  relation_type string and the classifier_weights.  It doesn't include a
+                  total_word_feature_extractor since this object doesn't hold one.
+        !*/
+        {
+            memory_usage result;
+            result.add("relation_type", heap_bytes(relation_type));
+            dlib::uint64 weight_bytes = heap_bytes(df.alpha) + heap_bytes(df.basis_vectors);
+            for (long i = 0; i < df.basis_vectors.size(); ++i)
+                weight_bytes += heap_bytes(df.basis_vectors(i));
+            result.add("classifier_weights", weight_bytes);
+            return result;
+        }
     };
 
     inline void serialize(
@@ -6,6 +6,7 @@
 
 #include <mitie/binary_relation_detector.h>
 #include <mitie/named_entity_extractor.h>
+#include <mitie/training_timer.h>
 #include <mitie.h>
 
 namespace mitie
@@ -185,6 +186,21 @@ namespace mitie
                   get_relation_name().
         !*/
 
+        binary_relation_detector train (
+            std::vector<training_phase>& phases
+        ) const;
+        /*!
+            requires
+                - num_positive_examples() > 0
+                - num_negative_examples() > 0
+            ensures
+                - Does the same thing as train() and returns the result.
+                - #phases == a list of the phases of training, in the order they ran, along
+                  with how long each took.  That is, the feature extraction, each
+                  cross-validation run done while searching for good C values, and the
+                  final fit.
+        !*/
+
     private:
 
         /*!
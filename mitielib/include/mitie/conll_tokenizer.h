@@ -78,6 +78,8 @@ namespace mitie
                 (unsigned char)token[2] == 0x9C)
             {
                 next_token = token.substr(3);
+                next_token_offset = token_offset + 3;
+                next_token_front_padding = 0;
                 token.resize(3);
                 return result;
             }
@@ -87,6 +89,8 @@ namespace mitie
                 (unsigned char)token[token.size()-1] == 0x9D)
             {
                 next_token = token.substr(token.size()-3);
+                next_token_offset = token_offset + next_token_front_padding + token.size()-3;
+                next_token_front_padding = 0;
                 token.resize(token.size()-3);
                 return result;
             }
@@ -7,6 +7,7 @@
 #include "dlib/array2d.h"
 #include "dlib/uintn.h"
 #include "dlib/hash.h"
+#include "dlib/general_hash/murmur_hash3.h"
 #include "dlib/byte_orderer.h"
 #include <queue>
 #include "dlib/image_transforms.h"
@@ -25,6 +26,21 @@ namespace mitie
                 This is a data structure used for counting how many times you see various
                 objects.  It uses a fixed amount of RAM but provides only approximate
                 counts.
+
+                All the hash table locations for an object are derived from a single
+                128bit murmur hash of the object.  So incrementing or querying an object
+                costs one hash evaluation regardless of get_num_hashes().
+
+                This object can also optionally use the "conservative update" rule from
+                the paper New Directions in Traffic Measurement and Accounting by Estan and
+                Varghese.  Under this rule increment() only raises the counters that would
+                otherwise be below the new estimated count.  The counts are still always
+                upper bounds on the true counts but are usually much tighter.
+
+            THREAD SAFETY
+                Multiple threads may call the const member functions at the same time.  To
+                count a data set in parallel, give each thread its own count_min_sketch
+                with the same dimensions and then merge them together with absorb().
         !*/
     public:
 
@@ -35,10 +51,12 @@ namespace mitie
                 - #get_hash_table_size() == 1000000 
                 - #get_num_hashes() == 8
                 - #get_total_count() == 0
+                - #uses_conservative_update() == false
                 - for all valid X:
                     - #get_count(X) == 0
         !*/
         {
+            conservative_update = false;
             counts.set_size(8, 1000000);
             set_counts_to_zero();
         }
@@ -48,6 +66,7 @@ namespace mitie
         )
         {
             total_count = item.total_count;
+            conservative_update = item.conservative_update;
             assign_image(counts, item.counts);
         }
 
@@ -61,12 +80,14 @@ namespace mitie
                 - #get_hash_table_size() == hash_table_size
                 - #get_num_hashes() == 8
                 - #get_total_count() == 0
+                - #uses_conservative_update() == false
                 - for all valid X:
                     - #get_count(X) == 0
         !*/
         {
             DLIB_CASSERT(hash_table_size > 0, "Invalid inputs were given to this function");
 
+            conservative_update = false;
             counts.set_size(8, hash_table_size);
             set_counts_to_zero();
         }
@@ -83,12 +104,14 @@ namespace mitie
                 - #get_hash_table_size() == hash_table_size
                 - #get_num_hashes() == num_hashes 
                 - #get_total_count() == 0
+                - #uses_conservative_update() == false
                 - for all valid X:
                     - #get_count(X) == 0
         !*/
         {
             DLIB_CASSERT(hash_table_size > 0 && num_hashes > 0, "Invalid inputs were given to this function");
 
+            conservative_update = false;
             counts.set_size(num_hashes, hash_table_size);
             set_counts_to_zero();
         }
@@ -137,6 +160,24 @@ namespace mitie
                   paper.
         !*/
 
+        bool uses_conservative_update (
+        ) const { return conservative_update; }
+        /*!
+            ensures
+                - returns true if increment() uses the conservative update rule and false
+                  if it uses the plain count min sketch update rule.
+        !*/
+
+        void set_conservative_update (
+            bool enabled
+        ) { conservative_update = enabled; }
+        /*!
+            ensures
+                - #uses_conservative_update() == enabled
+                - Switching modes does not change any counts already in this object.
+                  Only subsequent calls to increment() are affected.
+        !*/
+
         template <typename T>
         void increment (
             const T& item,
@@ -151,11 +192,21 @@ namespace mitie
                 - #total_count() == total_count() + amount
         !*/
         {
-            using namespace dlib;
-            for (long r = 0; r < counts.nr(); ++r)
+            const std::pair<dlib::uint64,dlib::uint64> h = hash128(item);
+            if (conservative_update)
             {
-                const dlib::uint32 h = dlib::hash(item,(dlib::uint32)r)%counts.nc();
-                counts[r][h] += amount;
+                const dlib::uint64 new_count = get_count_from_hash(h) + amount;
+                for (long r = 0; r < counts.nr(); ++r)
+                {
+                    dlib::uint64& c = counts[r][table_index(h,r)];
+                    if (c < new_count)
+                        c = new_count;
+                }
+            }
+            else
+            {
+                for (long r = 0; r < counts.nr(); ++r)
+                    counts[r][table_index(h,r)] += amount;
             }
             total_count += amount;
         }
@@ -171,17 +222,7 @@ namespace mitie
                   for this item.
         !*/
         {
-            using namespace dlib;
-            uint64 val = std::numeric_limits<uint64>::max();
-
-            for (long r = 0; r < counts.nr(); ++r)
-            {
-                const dlib::uint32 h = dlib::hash(item,(dlib::uint32)r)%counts.nc();
-                if ( counts[r][h] < val)
-                    val = counts[r][h];
-            }
-
-            return val;
+            return get_count_from_hash(hash128(item));
         }
 
         dlib::uint64 get_count_at_top_n (
@@ -222,8 +263,9 @@ namespace mitie
                 - serializes item to the given output stream
         !*/
         {
-            int version = 1;
+            int version = 2;
             dlib::serialize(version, out);
+            dlib::serialize(item.conservative_update, out);
             dlib::serialize(item.counts.nr(), out);
             dlib::serialize(item.counts.nc(), out);
             if (item.counts.size() != 0)
@@ -257,9 +299,12 @@ namespace mitie
         {
             int version = 0;
             dlib::deserialize(version, in);
-            if (version != 1)
+            // Note that version 1 sketches used a different hashing scheme so their
+            // counts can't be looked up by this version of the code.
+            if (version != 2)
                 throw dlib::serialization_error("Wrong version found while deserializing a mitie::count_min_sketch object.");
 
+            dlib::deserialize(item.conservative_update, in);
             long nr, nc;
             dlib::deserialize(nr, in);
             dlib::deserialize(nc, in);
@@ -295,6 +340,7 @@ namespace mitie
         {
             counts.swap(item.counts);
             std::swap(total_count, item.total_count);
+            std::swap(conservative_update, item.conservative_update);
         }
 
         void absorb (
@@ -312,6 +358,10 @@ namespace mitie
                     - #total_count() == total_count() + item.total_count()
                     - for all items:
                         - #get_count(obj) == get_count(obj) + item.get_count(obj)
+                - This works regardless of the update rule used by either sketch.  The
+                  merged counts are still upper bounds on the true counts.  So a large
+                  data set can be counted in parallel by giving each thread its own shard
+                  of the data and its own sketch and then absorbing them all into one.
         !*/
         {
             // make sure requires clause is not broken
@@ -334,8 +384,60 @@ namespace mitie
 
     private:
 
+        static std::pair<dlib::uint64,dlib::uint64> hash128 (
+            const std::string& item
+        )
+        {
+            if (item.size() == 0)
+                return std::make_pair(0,0);
+            return dlib::murmur_hash3_128bit(&item[0], item.size());
+        }
+
+        template <typename T>
+        static std::pair<dlib::uint64,dlib::uint64> hash128 (
+            const T& item
+        )
+        {
+            // Objects which aren't plain strings don't expose their bytes so we fall back
+            // on dlib::hash() to make the 128 bits.
+            const dlib::uint64 a = dlib::hash(item,0);
+            const dlib::uint64 b = dlib::hash(item,1);
+            const dlib::uint64 c = dlib::hash(item,2);
+            return std::make_pair(a, (b<<32)|c);
+        }
+
+        unsigned long table_index (
+            const std::pair<dlib::uint64,dlib::uint64>& h,
+            long r
+        ) const
+        /*!
+            ensures
+                - returns the bucket in hash table r that corresponds to the 128bit hash h.
+                  We use the Kirsch and Mitzenmacher double hashing trick to get all the
+                  row hashes from h.  The second half is made odd so that the rows never
+                  collapse onto the same bucket sequence.
+        !*/
+        {
+            return (h.first + r*(h.second|1))%counts.nc();
+        }
+
+        dlib::uint64 get_count_from_hash (
+            const std::pair<dlib::uint64,dlib::uint64>& h
+        ) const
+        {
+            dlib::uint64 val = std::numeric_limits<dlib::uint64>::max();
+            for (long r = 0; r < counts.nr(); ++r)
+            {
+                const dlib::uint64 c = counts[r][table_index(h,r)];
+                if (c < val)
+                    val = c;
+            }
+            return val;
+        }
+
         dlib::array2d<dlib::uint64> counts;
         dlib::uint64 total_count;
+        bool conservative_update;
     };
 
     inline void swap (
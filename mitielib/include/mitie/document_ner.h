@@ -0,0 +1,126 @@
+// Copyright (C) 2014 Massachusetts Institute of Technology, Lincoln Laboratory
+// License: Boost Software License   See LICENSE.txt for the full license.
+// Authors: Davis E. King (davis@dlib.net)
+#ifndef MIT_LL_DOCUMENT_NeR_H_
+#define MIT_LL_DOCUMENT_NeR_H_
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <mitie/named_entity_extractor.h>
+
+namespace mitie
+{
+
+// ----------------------------------------------------------------------------------------
+
+    void tokenize_document (
+        const std::string& text,
+        std::vector<std::string>& tokens,
+        std::vector<std::pair<unsigned long,unsigned long> >& token_spans
+    );
+    /*!
+        ensures
+            - Splits text into tokens with the conll_tokenizer, the same way
+              mitie_tokenize() does, and stores them into #tokens.
+            - #token_spans.size() == #tokens.size()
+            - for all valid i:
+                - #token_spans[i] is the half open range of byte offsets in text
+                  that #tokens[i] came from.  This is usually [offset,
+                  offset+#tokens[i].size()), but the tokenizer sometimes changes the
+                  text of a token, like turning the UTF-8 ’ character into ', and the
+                  span always covers the original text.
+    !*/
+
+    const unsigned long default_max_sentence_length = 100;
+
+    void split_into_sentences (
+        const std::string& text,
+        const std::vector<std::string>& tokens,
+        const std::vector<std::pair<unsigned long,unsigned long> >& token_spans,
+        const unsigned long max_sentence_length,
+        std::vector<std::pair<unsigned long,unsigned long> >& sentences
+    );
+    /*!
+        requires
+            - tokens and token_spans came from tokenize_document(text,tokens,token_spans)
+            - max_sentence_length > 0
+        ensures
+            - Splits the tokens into sentences with a few simple rules and stores the
+              half open range of token indices in each sentence into #sentences, in
+              order.  A sentence ends:
+                - after a token made of ., !, and ? characters, along with any closing
+                  quotes or brackets after it, unless the next token starts with a
+                  lowercase letter or digit or the token before the . is a common
+                  abbreviation like "Mrs" or "Prof".
+                - before a token that is separated from the previous one by a blank
+                  line.
+                - after max_sentence_length tokens.  Such a sentence is broken after
+                  the last comma, semicolon, or colon in its second half if it has one.
+              These rules keep the sentences short, which keeps the time the
+              named_entity_extractor takes on each one predictable, even for text that
+              has no punctuation at all.
+            - Every token is in exactly one sentence and no sentence is empty.
+    !*/
+
+// ----------------------------------------------------------------------------------------
+
+    struct document_entity
+    {
+        /*!
+            WHAT THIS OBJECT REPRESENTS
+                This object is a named entity found in a document by
+                extract_document_entities().
+        !*/
+
+        document_entity() : begin(0), end(0), char_begin(0), char_end(0), tag(0), score(0), sentence(0) {}
+
+        // The half open range of bytes in the document's UTF-8 text that the entity
+        // covers.
+        unsigned long begin;
+        unsigned long end;
+        // The same range counted in Unicode characters instead of bytes.
+        unsigned long char_begin;
+        unsigned long char_end;
+        // The entity's label, an index into the named_entity_extractor's
+        // get_tag_name_strings().
+        unsigned long tag;
+        // The named_entity_extractor's confidence in the label.  > 0 means it's likely
+        // correct.
+        double score;
+        // The index of the sentence the entity is in.
+        unsigned long sentence;
+    };
+
+    void extract_document_entities (
+        const named_entity_extractor& ner,
+        const std::string& text,
+        std::vector<document_entity>& entities,
+        std::vector<std::pair<unsigned long,unsigned long> >& sentence_spans,
+        const unsigned long max_sentence_length = default_max_sentence_length,
+        const unsigned long num_threads = 1
+    );
+    /*!
+        requires
+            - text is UTF-8 encoded.
+            - max_sentence_length > 0
+        ensures
+            - Finds the named entities in a whole document.  That is, this function
+              tokenizes text with tokenize_document(), splits the tokens into sentences
+              with split_into_sentences(), and runs ner on each sentence.
+            - #sentence_spans contains the half open range of bytes in text covered by
+              each sentence, in order.
+            - #entities contains all the entities found, in the order they appear in
+              text.
+            - If num_threads > 1 then the sentences are processed by that many threads.
+              The results are the same either way.
+            - ner must hold its total_word_feature_extractor, i.e. it can't be a pure
+              model loaded without one.
+    !*/
+
+// ----------------------------------------------------------------------------------------
+
+}
+
+#endif // MIT_LL_DOCUMENT_NeR_H_
+
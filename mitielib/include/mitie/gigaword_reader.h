@@ -7,8 +7,10 @@
 #include "dlib/xml_parser.h"
 #include "dlib/string.h"
 #include "dlib/dir_nav.h"
+#include "dlib/smart_pointers.h"
 #include <list>
 #include <fstream>
+#include <mitie/prefetching_reader.h>
 
 namespace mitie
 {
@@ -249,6 +251,11 @@ namespace mitie
             WHAT THIS OBJECT REPRESENTS
                 This is a tool that wraps the gigaword_file_reader and makes it easer
                 to read from a set of files or individual files.
+
+                If you give a number of prefetch threads to the constructor then the files
+                are parsed by that many background threads, using a prefetching_reader,
+                while you consume the documents.  The documents come out in the same
+                order either way.
         !*/
     public:
 
@@ -261,6 +268,7 @@ namespace mitie
                   given filename.
         !*/
         {
+            num_prefetch_threads = 0;
             file_list.push_back(filename);
             reset();
         }
@@ -274,6 +282,7 @@ namespace mitie
                   given filename.
         !*/
         {
+            num_prefetch_threads = 0;
             file_list.push_back(filename);
             reset();
         }
@@ -287,19 +296,25 @@ namespace mitie
                   given filename.
         !*/
         {
+            num_prefetch_threads = 0;
             file_list.push_back(filename.full_name());
             reset();
         }
 
         gigaword_reader (
-            const std::vector<dlib::file>& files
+            const std::vector<dlib::file>& files,
+            unsigned long num_prefetch_threads_ = 0
         )
         /*!
             ensures
                 - This object will read gigaword_documents out of the list of supplied
                   files.
+                - if (num_prefetch_threads_ != 0) then
+                    - up to num_prefetch_threads_ background threads will parse the files
+                      ahead of calls to operator().
         !*/
         {
+            num_prefetch_threads = num_prefetch_threads_;
             for (unsigned long i = 0; i < files.size(); ++i)
             {
                 file_list.push_back(files[i].full_name());
@@ -308,7 +323,14 @@ namespace mitie
         }
 
         void reset(
-        ){ next_file = 0; reader = gigaword_file_reader();  }
+        )
+        { 
+            next_file = 0; 
+            reader = gigaword_file_reader();  
+            prefetcher.reset();
+            if (num_prefetch_threads != 0)
+                prefetcher.reset(new prefetching_reader<gigaword_file_reader,gigaword_document>(file_list, num_prefetch_threads));
+        }
         /*!
             ensures
                 - puts the reader back at the start of the document sequence.  Therefore,
@@ -327,6 +349,9 @@ namespace mitie
                     - returns false
         !*/
         {
+            if (prefetcher)
+                return (*prefetcher)(doc);
+
             while (true)
             {
                 // try to get the next doc
@@ -373,6 +398,8 @@ namespace mitie
         std::vector<std::string> file_list;
         std::ifstream fin;
         gigaword_file_reader reader;
+        unsigned long num_prefetch_threads;
+        dlib::scoped_ptr<prefetching_reader<gigaword_file_reader,gigaword_document> > prefetcher;
     };
 
 // ----------------------------------------------------------------------------------------
@@ -420,13 +447,17 @@ namespace mitie
         !*/
 
         gigaword_tokenizer (
-            const std::vector<dlib::file>& files
-        ) : reader(files) {}
+            const std::vector<dlib::file>& files,
+            unsigned long num_prefetch_threads = 0
+        ) : reader(files, num_prefetch_threads) {}
         /*!
             requires
                 - files.size() > 0
             ensures
                 - This object will read tokens out of the list of supplied files.
+                - if (num_prefetch_threads != 0) then
+                    - up to num_prefetch_threads background threads will parse the files
+                      ahead of calls to operator().
         !*/
 
         void reset(
@@ -6,8 +6,12 @@
 
 #include <string>
 #include <vector>
+#include <algorithm>
 #include <dlib/dir_nav.h>
+#include <dlib/uintn.h>
+#include <dlib/smart_pointers.h>
 #include <fstream>
+#include <mitie/prefetching_reader.h>
 
 
 namespace mitie
@@ -25,6 +29,11 @@ namespace mitie
                 This object is a tool for turning a single document tokenizer into one that
                 tokenizes a bunch of documents in a set.  It therefore makes it look like all
                 the documents have been concatenated together.
+
+                If you give a number of prefetch threads to the constructor then the files
+                are read and tokenized by that many background threads, using a
+                prefetching_reader, while you consume the tokens.  The tokens come out in
+                the same order either way.
         !*/
 
     public:
@@ -39,6 +48,7 @@ namespace mitie
                 - This object will read tokens from the file with the given filename.
         !*/
         {
+            num_prefetch_threads = 0;
             next_file = 0;
             files.push_back(filename);
         }
@@ -51,6 +61,7 @@ namespace mitie
                 - This object will read tokens from the file with the given filename.
         !*/
         {
+            num_prefetch_threads = 0;
             next_file = 0;
             files.push_back(filename);
         }
@@ -63,27 +74,40 @@ namespace mitie
                 - This object will read tokens from the file with the given filename.
         !*/
         {
+            num_prefetch_threads = 0;
             next_file = 0;
             files.push_back(filename.full_name());
         }
 
         group_tokenizer (
-            const std::vector<dlib::file>& file_list 
+            const std::vector<dlib::file>& file_list,
+            unsigned long num_prefetch_threads_ = 0
         ) 
         /*!
             ensures
                 - This object will read tokens out of the list of supplied file_list.
+                - if (num_prefetch_threads_ != 0) then
+                    - up to num_prefetch_threads_ background threads will read and
+                      tokenize the files ahead of calls to operator().
         !*/
         {
-            next_file = 0;
+            num_prefetch_threads = num_prefetch_threads_;
             for (unsigned long i = 0; i < file_list.size(); ++i)
             {
                 files.push_back(file_list[i].full_name());
             }
+            reset();
         }
 
         void reset (
-        ) { next_file = 0; tok = basic_tokenizer(); }
+        ) 
+        { 
+            next_file = 0; 
+            tok = basic_tokenizer(); 
+            prefetcher.reset();
+            if (num_prefetch_threads != 0)
+                prefetcher.reset(new prefetching_reader<basic_tokenizer,std::string>(files, num_prefetch_threads));
+        }
         /*!
             ensures
                 - puts the tokenizer back at the start of the token sequence.  Therefore,
@@ -105,6 +129,14 @@ namespace mitie
                     - returns true
         !*/
         {
+            if (prefetcher)
+            {
+                if ((*prefetcher)(token))
+                    return true;
+                token.clear();
+                return false;
+            }
+
             while (true)
             {
                 // if there is a token then return it
@@ -127,7 +159,47 @@ namespace mitie
         std::vector<std::string> files;
         std::ifstream fin;
         basic_tokenizer tok;
+        unsigned long num_prefetch_threads;
+        dlib::scoped_ptr<prefetching_reader<basic_tokenizer,std::string> > prefetcher;
     };
+
+// ----------------------------------------------------------------------------------------
+
+    inline std::vector<std::vector<dlib::file> > split_into_shards (
+        const std::vector<dlib::file>& files,
+        unsigned long num_shards
+    )
+    /*!
+        requires
+            - num_shards > 0
+        ensures
+            - Splits files into groups so that each group can be handed to a different
+              consumer thread, e.g. by giving each one its own group_tokenizer.  Each
+              file goes into exactly one group and the groups are made to contain
+              roughly the same number of bytes.
+            - returns an array S such that:
+                - S.size() == max(1, min(num_shards, files.size()))
+    !*/
+    {
+        std::vector<std::pair<dlib::uint64,unsigned long> > sizes;
+        for (unsigned long i = 0; i < files.size(); ++i)
+            sizes.push_back(std::make_pair(files[i].size(), i));
+        std::sort(sizes.rbegin(), sizes.rend());
+
+        std::vector<std::vector<dlib::file> > shards(std::max<unsigned long>(1,std::min<unsigned long>(num_shards, files.size())));
+        std::vector<dlib::uint64> shard_sizes(shards.size(), 0);
+        // put each file, biggest first, into the shard with the fewest bytes so far
+        for (unsigned long i = 0; i < sizes.size(); ++i)
+        {
+            const unsigned long s = std::min_element(shard_sizes.begin(), shard_sizes.end()) - shard_sizes.begin();
+            shards[s].push_back(files[sizes[i].second]);
+            shard_sizes[s] += sizes[i].first;
+        }
+        return shards;
+    }
+
+// ----------------------------------------------------------------------------------------
+
 }
 
 #endif // MIT_LL_GROUP_ToKENIZER_H_
@@ -0,0 +1,193 @@
+// Copyright (C) 2014 Massachusetts Institute of Technology, Lincoln Laboratory
+// License: Boost Software License   See LICENSE.txt for the full license.
+// Authors: Davis E. King (davis@dlib.net)
+#ifndef MIT_LL_HASHING_OsTREAM_H_
+#define MIT_LL_HASHING_OsTREAM_H_
+
+#include <ostream>
+#include <streambuf>
+#include <utility>
+#include <algorithm>
+#include <cstring>
+#include <dlib/uintn.h>
+#include <dlib/general_hash/murmur_hash3.h>
+
+namespace mitie
+{
+
+// ----------------------------------------------------------------------------------------
+
+    class hashing_ostream : public std::ostream
+    {
+        /*!
+            WHAT THIS OBJECT REPRESENTS
+                This is an output stream that doesn't store anything written to it.
+                Instead, it keeps a running hash of the bytes.  get_hash() returns the
+                same value as calling dlib::murmur_hash3_128bit() on a buffer holding
+                all the bytes written so far.
+
+                We use it to compute the fingerprints of our models.  Those are hashes
+                of the serialized model and this way we get them without making a
+                complete serialized copy of the model in memory.
+        !*/
+
+    public:
+
+        hashing_ostream (
+        ) : std::ostream(&buf) {}
+        /*!
+            ensures
+                - #get_hash() == dlib::murmur_hash3_128bit(0,0)
+        !*/
+
+        std::pair<dlib::uint64,dlib::uint64> get_hash (
+        ) const { return buf.get_hash(); }
+        /*!
+            ensures
+                - returns dlib::murmur_hash3_128bit() of all the bytes written to this
+                  stream.
+        !*/
+
+    private:
+
+        class hashing_streambuf : public std::streambuf
+        {
+        public:
+            hashing_streambuf (
+            ) : h1(0), h2(0), num_hashed(0)
+            {
+                setp(buffer, buffer + sizeof(buffer));
+            }
+
+            std::pair<dlib::uint64,dlib::uint64> get_hash (
+            ) const
+            {
+                // Finish the hash on copies of the state so more bytes can still be
+                // written to the stream afterwards.
+                dlib::uint64 t1 = h1;
+                dlib::uint64 t2 = h2;
+                const unsigned long num_pending = pptr() - pbase();
+                const unsigned long num_blocks = num_pending/16;
+                for (unsigned long i = 0; i < num_blocks; ++i)
+                    hash_block(buffer + 16*i, t1, t2);
+
+                // This is the tail handling from dlib::murmur_hash3_128bit().
+                const unsigned char* tail = reinterpret_cast<const unsigned char*>(buffer + 16*num_blocks);
+                const unsigned long tail_size = num_pending%16;
+                dlib::uint64 k1 = 0;
+                dlib::uint64 k2 = 0;
+                for (unsigned long i = tail_size; i > 8; --i)
+                    k2 ^= dlib::uint64(tail[i-1]) << (8*(i-9));
+                if (tail_size > 8)
+                {
+                    k2 *= c2; k2 = DLIB_ROTL64(k2,33); k2 *= c1; t2 ^= k2;
+                }
+                for (unsigned long i = std::min<unsigned long>(tail_size,8); i > 0; --i)
+                    k1 ^= dlib::uint64(tail[i-1]) << (8*(i-1));
+                if (tail_size > 0)
+                {
+                    k1 *= c1; k1 = DLIB_ROTL64(k1,31); k1 *= c2; t1 ^= k1;
+                }
+
+                const dlib::uint64 len = num_hashed + num_pending;
+                t1 ^= len; t2 ^= len;
+                t1 += t2;
+                t2 += t1;
+                t1 = dlib::murmur_fmix(t1);
+                t2 = dlib::murmur_fmix(t2);
+                t1 += t2;
+                t2 += t1;
+                return std::make_pair(t1,t2);
+            }
+
+        private:
+
+            static const dlib::uint64 c1 = DLIB_BIG_CONSTANT(0x87c37b91114253d5);
+            static const dlib::uint64 c2 = DLIB_BIG_CONSTANT(0x4cf5ad432745937f);
+
+            static dlib::uint64 read_little_endian (
+                const char* p
+            )
+            {
+                const unsigned char* b = reinterpret_cast<const unsigned char*>(p);
+                dlib::uint64 val = 0;
+                for (int i = 7; i >= 0; --i)
+                    val = (val<<8) | b[i];
+                return val;
+            }
+
+            static void hash_block (
+                const char* block,
+                dlib::uint64& h1,
+                dlib::uint64& h2
+            )
+            {
+                // This is the body of dlib::murmur_hash3_128bit() applied to one block.
+                dlib::uint64 k1 = read_little_endian(block);
+                dlib::uint64 k2 = read_little_endian(block+8);
+
+                k1 *= c1; k1 = DLIB_ROTL64(k1,31); k1 *= c2; h1 ^= k1;
+                h1 = DLIB_ROTL64(h1,27); h1 += h2; h1 = h1*5+0x52dce729;
+                k2 *= c2; k2 = DLIB_ROTL64(k2,33); k2 *= c1; h2 ^= k2;
+                h2 = DLIB_ROTL64(h2,31); h2 += h1; h2 = h2*5+0x38495ab5;
+            }
+
+            void hash_buffer (
+            )
+            {
+                // The buffer size is a multiple of 16 so when it's full it holds only
+                // whole blocks.
+                for (char* p = pbase(); p != epptr(); p += 16)
+                    hash_block(p, h1, h2);
+                num_hashed += sizeof(buffer);
+                setp(buffer, buffer + sizeof(buffer));
+            }
+
+            int_type overflow (
+                int_type c
+            )
+            {
+                if (pptr() == epptr())
+                    hash_buffer();
+                if (c != traits_type::eof())
+                {
+                    *pptr() = traits_type::to_char_type(c);
+                    pbump(1);
+                }
+                return traits_type::not_eof(c);
+            }
+
+            std::streamsize xsputn (
+                const char* s,
+                std::streamsize num
+            )
+            {
+                std::streamsize num_left = num;
+                while (num_left > 0)
+                {
+                    if (pptr() == epptr())
+                        hash_buffer();
+                    const std::streamsize n = std::min<std::streamsize>(num_left, epptr() - pptr());
+                    std::memcpy(pptr(), s, n);
+                    pbump(n);
+                    s += n;
+                    num_left -= n;
+                }
+                return num;
+            }
+
+            char buffer[4096];
+            dlib::uint64 h1;
+            dlib::uint64 h2;
+            dlib::uint64 num_hashed;
+        };
+
+        hashing_streambuf buf;
+    };
+
+// ----------------------------------------------------------------------------------------
+
+}
+
+#endif // MIT_LL_HASHING_OsTREAM_H_
+
@@ -0,0 +1,187 @@
+// Copyright (C) 2014 Massachusetts Institute of Technology, Lincoln Laboratory
+// License: Boost Software License   See LICENSE.txt for the full license.
+// Authors: Davis E. King (davis@dlib.net)
+#ifndef MIT_LL_MEMORY_UsAGE_H_
+#define MIT_LL_MEMORY_UsAGE_H_
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <dlib/uintn.h>
+#include <dlib/matrix.h>
+#include <dlib/assert.h>
+
+namespace mitie
+{
+
+// ----------------------------------------------------------------------------------------
+
+    class memory_usage
+    {
+        /*!
+            WHAT THIS OBJECT REPRESENTS
+                This object is a breakdown of the memory used by a MITIE model.  It's a
+                list of named components, like "word_table.vectors", each with the
+                number of bytes of heap memory it holds.
+
+                The numbers are estimates.  They count the memory the containers in a
+                model ask for, but not the bookkeeping the memory allocator adds to
+                each allocation.
+        !*/
+
+    public:
+
+        void add (
+            const std::string& name,
+            dlib::uint64 bytes
+        )
+        /*!
+            ensures
+                - Adds a component with the given name and size to the end of this
+                  breakdown.
+        !*/
+        {
+            components.push_back(std::make_pair(name, bytes));
+        }
+
+        void add (
+            const std::string& prefix,
+            const memory_usage& item
+        )
+        /*!
+            ensures
+                - Adds all the components of item to the end of this breakdown.  Their
+                  names are prefixed with prefix + "." unless prefix is empty.
+        !*/
+        {
+            for (unsigned long i = 0; i < item.size(); ++i)
+            {
+                if (prefix.size() == 0)
+                    add(item.name(i), item.bytes(i));
+                else
+                    add(prefix + "." + item.name(i), item.bytes(i));
+            }
+        }
+
+        unsigned long size (
+        ) const { return components.size(); }
+        /*!
+            ensures
+                - returns the number of components in this breakdown.
+        !*/
+
+        const std::string& name (
+            unsigned long i
+        ) const
+        /*!
+            requires
+                - i < size()
+            ensures
+                - returns the name of the i-th component.
+        !*/
+        {
+            DLIB_ASSERT(i < size(), "Invalid index");
+            return components[i].first;
+        }
+
+        dlib::uint64 bytes (
+            unsigned long i
+        ) const
+        /*!
+            requires
+                - i < size()
+            ensures
+                - returns the number of bytes used by the i-th component.
+        !*/
+        {
+            DLIB_ASSERT(i < size(), "Invalid index");
+            return components[i].second;
+        }
+
+        dlib::uint64 total_bytes (
+        ) const
+        /*!
+            ensures
+                - returns the sum of bytes(i) over all the components.
+        !*/
+        {
+            dlib::uint64 total = 0;
+            for (unsigned long i = 0; i < components.size(); ++i)
+                total += components[i].second;
+            return total;
+        }
+
+    private:
+        std::vector<std::pair<std::string,dlib::uint64> > components;
+    };
+
+// ----------------------------------------------------------------------------------------
+
+    // Each node of a std::map holds 3 pointers and a color flag along with its key and
+    // value in all the common standard library implementations.  A std::list node holds
+    // 2 pointers.
+    const unsigned long map_node_overhead = 4*sizeof(void*);
+    const unsigned long list_node_overhead = 2*sizeof(void*);
+
+    inline dlib::uint64 heap_bytes (
+        const std::string& str
+    )
+    /*!
+        ensures
+            - returns the number of bytes str has allocated on the heap.  This is 0 for
+              short strings the standard library stores inside the string object itself.
+    !*/
+    {
+        const char* data = str.data();
+        const char* obj = reinterpret_cast<const char*>(&str);
+        if (obj <= data && data < obj + sizeof(str))
+            return 0;
+        return str.capacity() + 1;
+    }
+
+    template <typename T>
+    dlib::uint64 heap_bytes (
+        const std::vector<T>& item
+    )
+    /*!
+        requires
+            - T doesn't own any heap memory of its own.
+        ensures
+            - returns the number of bytes item has allocated on the heap.
+    !*/
+    {
+        return item.capacity()*sizeof(T);
+    }
+
+    inline dlib::uint64 heap_bytes (
+        const std::vector<std::string>& item
+    )
+    {
+        dlib::uint64 bytes = item.capacity()*sizeof(std::string);
+        for (unsigned long i = 0; i < item.size(); ++i)
+            bytes += heap_bytes(item[i]);
+        return bytes;
+    }
+
+    template <typename T, typename MM, typename L>
+    dlib::uint64 heap_bytes (
+        const dlib::matrix<T,0,0,MM,L>& item
+    )
+    {
+        return item.size()*sizeof(T);
+    }
+
+    template <typename T, typename MM, typename L>
+    dlib::uint64 heap_bytes (
+        const dlib::matrix<T,0,1,MM,L>& item
+    )
+    {
+        return item.size()*sizeof(T);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+}
+
+#endif // MIT_LL_MEMORY_UsAGE_H_
+
@@ -5,7 +5,9 @@
 #define MIT_LL_MITIE_NaMED_ENTITY_EXTRACTOR_H_
 
 #include <mitie/total_word_feature_extractor.h>
+#include <mitie/hashing_ostream.h>
 #include <mitie/ner_feature_extraction.h>
+#include <mitie/ner_gate.h>
 #include <dlib/svm.h>
 #include <dlib/vectorstream.h>
 #include <dlib/hash.h>
@@ -22,13 +24,13 @@ namespace mitie
                 of each named entity.
 
             THREAD SAFETY
-                Note that this object uses mutable internal scratch space.  Therefore, it is
-                unsafe for two threads to touch the same instance of this object at a time
-                without mutex locking it first.
+                It is safe for multiple threads to make concurrent calls to the const
+                member functions of this object.  However, you must not modify an instance
+                of this object while other threads are using it.
         !*/
     public:
 
-        named_entity_extractor():fingerprint(0), tfe_fingerprint(0), pure_model_version(0){}
+        named_entity_extractor():fingerprint(0), tfe_fingerprint(0), pure_model_version(0), save_sparse(false){}
         /*!
             ensures
                 - When used this object won't output any entities.   You need to either use
@@ -161,6 +163,24 @@ namespace mitie
                       an exception is thrown if there is a mismatch
         !*/
 
+        void predict(
+            const std::vector<std::string>& sentence,
+            std::vector<std::pair<unsigned long, unsigned long> >& chunks,
+            std::vector<unsigned long>& chunk_tags,
+            std::vector<double>& chunk_scores,
+            const total_word_feature_extractor& fe,
+            sentence_features& scratch
+        ) const;
+        /*!
+            ensures
+                - Does the same thing as predict(sentence, chunks, chunk_tags,
+                  chunk_scores, fe), except it puts the word features of sentence into
+                  scratch rather than into a new object.  So a thread that runs many
+                  sentences can reuse the same scratch object for all of them and not
+                  allocate memory for each one.  Each thread needs its own scratch
+                  object.
+        !*/
+
         void operator() (
             const std::vector<std::string>& sentence,
             std::vector<std::pair<unsigned long, unsigned long> >& chunks,
@@ -220,33 +240,128 @@ namespace mitie
                 - Returns a vector that maps entity numeric ID tags into their string labels.  
         !*/
 
+        memory_usage get_memory_usage (
+        ) const;
+        /*!
+            ensures
+                - returns a breakdown of the memory used by this object.  It has these
+                  components:
+                    - tag_strings: the strings in get_tag_name_strings().
+                    - segmenter_weights: the weights of the sequence segmenter that finds
+                      the entity chunks.
+                    - classifier_weights: the weights of the classifier that labels the
+                      chunks.
+                    - gate_weights: the weights of get_gate(), 0 if there isn't one.
+                    - feature_extractor.*: the components of the
+                      total_word_feature_extractor's breakdown.  These are all 0 for a
+                      pure model, since it doesn't hold a feature extractor.
+        !*/
+
+        const ner_gate& get_gate (
+        ) const { return gate; }
+        /*!
+            ensures
+                - returns the gate predict() uses to skip sentences that are unlikely to
+                  contain any named entities.  It's disabled unless the ner_trainer was
+                  asked to train one or set_gate() was called.
+        !*/
+
+        void set_gate (
+            const ner_gate& new_gate
+        );
+        /*!
+            ensures
+                - #get_gate() == new_gate
+                - Since the gate changes which entities are found, the fingerprint of this
+                  object changes too, unless new_gate is disabled.
+                - The gate is saved by serialize() but isn't part of a pure model.
+        !*/
+
+        bool get_save_sparse_weights (
+        ) const { return save_sparse; }
+        /*!
+            ensures
+                - returns true if serialize() saves the entity classifier weights in a
+                  sparse form when most of them are 0.  Models saved that way can't be
+                  loaded by versions of MITIE older than this one, so this is false unless
+                  set_save_sparse_weights(true) was called or *this was deserialized
+                  from a model that was saved in the sparse form.
+        !*/
+
+        void set_save_sparse_weights (
+            bool value
+        ) { save_sparse = value; }
+        /*!
+            ensures
+                - #get_save_sparse_weights() == value
+                - This only changes how *this is saved, not what it predicts, so the
+                  fingerprint doesn't change.
+        !*/
+
         friend void serialize(const named_entity_extractor& item, std::ostream& out)
         {
-            int version = 2;
+            // Models made by the prune_model tool ask for their classifier weights to be
+            // saved in a sparse form, which needs a new version number.  So we only do it
+            // when asked to and when it makes a difference.  Likewise, only models with a
+            // gate are saved as version 4.  Everything else is still saved as version 2
+            // so older versions of MITIE can read it.
+            const bool sparse_df = item.save_sparse && use_sparse_weights(item.df);
+            int version = item.gate.is_enabled() ? 4 : (sparse_df ? 3 : 2);
             dlib::serialize(version, out);
             dlib::serialize(item.fingerprint, out);
             dlib::serialize(item.tag_name_strings, out);
             serialize(item.fe, out);
             serialize(item.segmenter, out);
-            serialize(item.df, out);
+            if (version == 4)
+                dlib::serialize(sparse_df, out);
+            if (sparse_df)
+                serialize_sparse(item.df, out);
+            else
+                serialize(item.df, out);
+            if (version == 4)
+                serialize(item.gate, out);
         }
 
         friend void deserialize(named_entity_extractor& item, std::istream& in)
         {
             int version = 0;
             dlib::deserialize(version, in);
-            if (version != 2)
+            if (version != 2 && version != 3 && version != 4)
                 throw dlib::serialization_error("Unexpected version found while deserializing mitie::named_entity_extractor.");
             dlib::deserialize(item.fingerprint, in);
             dlib::deserialize(item.tag_name_strings, in);
             deserialize(item.fe, in);
             deserialize(item.segmenter, in);
-            deserialize(item.df, in);
+            bool sparse_df = (version == 3);
+            if (version == 4)
+                dlib::deserialize(sparse_df, in);
+            item.save_sparse = sparse_df;
+            if (sparse_df)
+                deserialize_sparse(item.df, in);
+            else
+                deserialize(item.df, in);
+            if (version == 4)
+                deserialize(item.gate, in);
+            else
+                item.gate = ner_gate();
+            // So compute_fingerprint() gives the same answer it did before serialization.
+            item.tfe_fingerprint = item.fe.get_fingerprint();
+            item.dense_fe = dense_chunk_feature_extractor(item.segmenter.get_feature_extractor().num_features());
         }
 
         const total_word_feature_extractor& get_total_word_feature_extractor(
         ) const { return fe; }
 
+        void set_oov_cache_capacity (
+            unsigned long capacity
+        ) { fe.set_oov_cache_capacity(capacity); }
+        /*!
+            ensures
+                - calls get_total_word_feature_extractor().set_oov_cache_capacity(capacity).
+                  That is, it turns on (or off if capacity == 0) the cache of out of
+                  dictionary word vectors in the feature extractor used by this object.
+        !*/
+
         const dlib::sequence_segmenter<ner_feature_extractor>& get_segmenter() const {
             return segmenter;
         }
@@ -263,17 +378,94 @@ namespace mitie
         };
 
     private:
+
+        typedef dlib::multiclass_linear_decision_function<dlib::sparse_linear_kernel<ner_sample_type>,unsigned long> classifier_type;
+
+        static bool use_sparse_weights (
+            const classifier_type& df
+        )
+        {
+            // The sparse form indexes the weights with 32bit integers.
+            if (df.weights.size() >= 0xFFFFFFFF)
+                return false;
+            long num_nonzero = 0;
+            for (long r = 0; r < df.weights.nr(); ++r)
+            {
+                for (long c = 0; c < df.weights.nc(); ++c)
+                {
+                    if (df.weights(r,c) != 0)
+                        ++num_nonzero;
+                }
+            }
+            // Each non-zero weight costs 12 bytes in the sparse form instead of 8.
+            return 3*num_nonzero < 2*df.weights.size();
+        }
+
+        static void serialize_sparse (
+            const classifier_type& df,
+            std::ostream& out
+        )
+        {
+            std::vector<dlib::uint32> idx;
+            std::vector<double> vals;
+            for (long r = 0; r < df.weights.nr(); ++r)
+            {
+                for (long c = 0; c < df.weights.nc(); ++c)
+                {
+                    if (df.weights(r,c) != 0)
+                    {
+                        idx.push_back(r*df.weights.nc() + c);
+                        vals.push_back(df.weights(r,c));
+                    }
+                }
+            }
+            dlib::serialize(df.weights.nr(), out);
+            dlib::serialize(df.weights.nc(), out);
+            dlib::serialize(idx, out);
+            dlib::serialize(vals, out);
+            dlib::serialize(df.b, out);
+            dlib::serialize(df.labels, out);
+        }
+
+        static void deserialize_sparse (
+            classifier_type& df,
+            std::istream& in
+        )
+        {
+            long nr, nc;
+            std::vector<dlib::uint32> idx;
+            std::vector<double> vals;
+            dlib::deserialize(nr, in);
+            dlib::deserialize(nc, in);
+            dlib::deserialize(idx, in);
+            dlib::deserialize(vals, in);
+            dlib::deserialize(df.b, in);
+            dlib::deserialize(df.labels, in);
+            if (nr < 0 || nc < 0 || idx.size() != vals.size())
+                throw dlib::serialization_error("Invalid sparse weights found while deserializing mitie::named_entity_extractor.");
+            df.weights.set_size(nr, nc);
+            df.weights = 0;
+            for (unsigned long i = 0; i < idx.size(); ++i)
+            {
+                if (idx[i] >= (dlib::uint64)nr*nc)
+                    throw dlib::serialization_error("Invalid sparse weights found while deserializing mitie::named_entity_extractor.");
+                df.weights(idx[i]/nc, idx[i]%nc) = vals[i];
+            }
+        }
+
         void compute_fingerprint()
         {
-            std::vector<char> buf;
-            dlib::vectorstream sout(buf);
+            hashing_ostream sout;
             sout << "fingerprint";
             dlib::serialize(tag_name_strings, sout);
             serialize(tfe_fingerprint, sout);
             serialize(segmenter, sout);
             serialize(df, sout);
+            // Models without a gate keep the fingerprints they always had.
+            if (gate.is_enabled())
+                serialize(gate, sout);
 
-            fingerprint = dlib::murmur_hash3_128bit(&buf[0], buf.size()).first;
+            fingerprint = sout.get_hash().first;
         }
 
         int pure_model_version;
@@ -283,6 +475,11 @@ namespace mitie
         total_word_feature_extractor fe;
         dlib::sequence_segmenter<ner_feature_extractor> segmenter;
         dlib::multiclass_linear_decision_function<dlib::sparse_linear_kernel<ner_sample_type>,unsigned long> df;
+        ner_gate gate;
+        bool save_sparse;
+        // Computes the dense chunk features.  It's picked once for the dimensionality
+        // of the segmenter's features whenever the segmenter is set.
+        dense_chunk_feature_extractor dense_fe;
     };
 }
 
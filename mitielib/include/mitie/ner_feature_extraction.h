@@ -14,13 +14,121 @@
 namespace mitie
 {
 
+// ----------------------------------------------------------------------------------------
+
+    class sentence_features
+    {
+        /*!
+            WHAT THIS OBJECT REPRESENTS
+                This object holds the word feature vectors for all the words in a
+                sentence.  It is a size() by get_num_dimensions() matrix of floats stored
+                in one contiguous block of memory, where row i is the feature vector for
+                the i-th word.
+
+                Changing the size of this object only allocates memory if it needs more
+                than it has ever held before.  So if you reuse one object for many
+                sentences it stops allocating once it has seen the longest sentence.
+        !*/
+
+    public:
+
+        sentence_features (
+        ) : num_words(0), num_dims(0) {}
+        /*!
+            ensures
+                - #size() == 0
+                - #get_num_dimensions() == 0
+        !*/
+
+        void set_size (
+            unsigned long num_words_,
+            unsigned long num_dims_
+        )
+        /*!
+            ensures
+                - #size() == num_words_
+                - #get_num_dimensions() == num_dims_
+                - The contents of the rows are undefined.
+        !*/
+        {
+            num_words = num_words_;
+            num_dims = num_dims_;
+            data.resize(num_words*num_dims);
+        }
+
+        unsigned long size (
+        ) const { return num_words; }
+        /*!
+            ensures
+                - returns the number of words (i.e. rows) in this object.
+        !*/
+
+        unsigned long get_num_dimensions (
+        ) const { return num_dims; }
+        /*!
+            ensures
+                - returns the number of features for each word.
+        !*/
+
+        const float* operator[] (
+            unsigned long i
+        ) const { return data.empty() ? 0 : &data[i*num_dims]; }
+        /*!
+            requires
+                - i < size()
+            ensures
+                - returns a pointer to the get_num_dimensions() features of the i-th word.
+        !*/
+
+        float* operator[] (
+            unsigned long i
+        ) { return data.empty() ? 0 : &data[i*num_dims]; }
+        /*!
+            requires
+                - i < size()
+            ensures
+                - returns a pointer to the get_num_dimensions() features of the i-th word.
+        !*/
+
+        const dlib::matrix_op<dlib::op_pointer_to_col_vect<float> > row (
+            unsigned long i
+        ) const { return dlib::mat((*this)[i], num_dims); }
+        /*!
+            requires
+                - i < size()
+            ensures
+                - returns a column vector view of the features of the i-th word.  It
+                  references the memory inside this object, so it's only valid until the
+                  size of this object is changed.
+        !*/
+
+        void swap (
+            sentence_features& item
+        )
+        {
+            data.swap(item.data);
+            std::swap(num_words, item.num_words);
+            std::swap(num_dims, item.num_dims);
+        }
+
+    private:
+        std::vector<float> data;
+        unsigned long num_words;
+        unsigned long num_dims;
+    };
+
+    inline void swap (
+        sentence_features& a,
+        sentence_features& b
+    ) { a.swap(b); }
+
 // ----------------------------------------------------------------------------------------
 
     class ner_feature_extractor
     {
 
     public:
-        typedef std::vector<dlib::matrix<float,0,1> > sequence_type;
+        typedef sentence_features sequence_type;
 
         ner_feature_extractor() :num_feats(1) {}
 
@@ -47,9 +155,9 @@ namespace mitie
             unsigned long position
         ) const
         {
-            const dlib::matrix<float,0,1>& feats = sentence[position];
-            for (long i = 0; i < feats.size(); ++i)
-                set_feature(i, feats(i));
+            const float* feats = sentence[position];
+            for (unsigned long i = 0; i < sentence.get_num_dimensions(); ++i)
+                set_feature(i, feats[i]);
         }
     };
 
@@ -64,16 +172,31 @@ namespace mitie
 
 // ----------------------------------------------------------------------------------------
 
-    std::vector<dlib::matrix<float,0,1> > sentence_to_feats (
+    void sentence_to_feats (
+        const total_word_feature_extractor& fe,
+        const std::vector<std::string>& sentence,
+        sentence_features& feats
+    );
+    /*!
+        ensures
+            - #feats.size() == sentence.size()
+            - #feats.get_num_dimensions() == fe.get_num_dimensions()
+            - for all valid i:
+                - #feats.row(i) == the word feature vector for the word sentence[i]
+            - feats is resized with set_size().  So reusing the same feats object for
+              many sentences avoids allocating memory for each one.
+    !*/
+
+    sentence_features sentence_to_feats (
         const total_word_feature_extractor& fe,
         const std::vector<std::string>& sentence
     );
     /*!
         ensures
-            - returns an array of vectors V such that:
-                - V.size() == sentence.size()
+            - returns a sentence_features object F such that:
+                - F.size() == sentence.size()
                 - for all valid i:
-                    V[i] == the word feature vector for the word sentence[i]
+                    F.row(i) == the word feature vector for the word sentence[i]
     !*/
 
 // ----------------------------------------------------------------------------------------
@@ -103,9 +226,89 @@ namespace mitie
 
     typedef std::vector<std::pair<dlib::uint32,double> > ner_sample_type;
 
+    class dense_chunk_feature_extractor
+    {
+        /*!
+            WHAT THIS OBJECT REPRESENTS
+                This object computes the dense part of the feature vectors made by
+                extract_ner_chunk_features().  That is, the normalized word vectors of
+                the first and last words of a chunk, the average word vector of the
+                chunk, and the word vectors of the words just before and after it.
+
+                The work done here is a handful of loops over word vectors, all done in
+                a single pass.  There is also a version compiled for 271 dimensional
+                vectors, the size used by the models that come with MITIE, so the
+                compiler can unroll its loops and keep the chunk average on the stack.
+                When you make this object it picks that version if it matches the
+                number of dimensions you give it and otherwise uses a version that works
+                for any number of dimensions.  Either way the outputs are exactly the
+                same.  Making one of these once when a model is loaded means that choice
+                isn't repeated for each chunk.
+
+                Only the chunk features are specialized this way.  Computing the word
+                vectors themselves (see total_word_feature_extractor) is dominated by
+                dictionary lookups and substring hashing, and the segmenter's use of
+                them by sums that must stay in order to give the same results, so fixed
+                size versions of those didn't make them any faster.  Most of the speed
+                here also comes from the single pass rather than the fixed size.
+        !*/
+
+    public:
+
+        dense_chunk_feature_extractor (
+        );
+        /*!
+            ensures
+                - #get_num_dimensions() == 0
+        !*/
+
+        explicit dense_chunk_feature_extractor (
+            unsigned long num_dims
+        );
+        /*!
+            ensures
+                - #get_num_dimensions() == num_dims
+        !*/
+
+        unsigned long get_num_dimensions (
+        ) const { return num_dims; }
+
+        bool is_specialized (
+        ) const;
+        /*!
+            ensures
+                - returns true if this object uses a version of the feature computation
+                  compiled specifically for get_num_dimensions() dimensional vectors.
+        !*/
+
+        void operator() (
+            const sentence_features& feats,
+            const std::pair<unsigned long, unsigned long>& chunk_range,
+            ner_sample_type& result
+        ) const { append_features(feats, chunk_range, result); }
+        /*!
+            requires
+                - feats.get_num_dimensions() == get_num_dimensions()
+                - chunk_range.first < chunk_range.second <= feats.size()
+            ensures
+                - appends the 5*get_num_dimensions() dense features for the given chunk
+                  onto the end of result.
+        !*/
+
+    private:
+        typedef void (*append_features_fn)(
+            const sentence_features&,
+            const std::pair<unsigned long, unsigned long>&,
+            ner_sample_type&
+        );
+
+        unsigned long num_dims;
+        append_features_fn append_features;
+    };
+
     ner_sample_type extract_ner_chunk_features (
         const std::vector<std::string>& words,
-        const std::vector<dlib::matrix<float,0,1> >& feats,
+        const sentence_features& feats,
         const std::pair<unsigned long, unsigned long>& chunk_range
     );
     /*!
@@ -120,6 +323,51 @@ namespace mitie
               predicting the type of named entity contained within this range. 
     !*/
 
+    ner_sample_type extract_ner_chunk_features (
+        const std::vector<std::string>& words,
+        const sentence_features& feats,
+        const std::pair<unsigned long, unsigned long>& chunk_range,
+        const dense_chunk_feature_extractor& dense_fe
+    );
+    /*!
+        requires
+            - words.size() == feats.size()
+            - chunk_range.first < chunk_range.second
+        ensures
+            - returns extract_ner_chunk_features(words, feats, chunk_range).  This
+              version uses dense_fe rather than making a new
+              dense_chunk_feature_extractor for each call, unless
+              dense_fe.get_num_dimensions() != feats.get_num_dimensions().
+    !*/
+
+// ----------------------------------------------------------------------------------------
+
+    typedef dlib::matrix<double,0,1> ner_gate_sample_type;
+
+    // The number of shape features and hashed context word features in the vectors made
+    // by extract_ner_gate_features().
+    const unsigned long num_ner_gate_shape_features = 12;
+    const unsigned long num_ner_gate_hash_features = 32;
+
+    ner_gate_sample_type extract_ner_gate_features (
+        const std::vector<std::string>& words,
+        const total_word_feature_extractor& fe
+    );
+    /*!
+        ensures
+            - returns a small dense feature vector that describes how likely the sentence
+              made of words is to contain a named entity.  It's meant to be much cheaper
+              to compute than sentence_to_feats() so it can be used to decide whether to
+              run the rest of NER on a sentence at all.
+            - The returned vector has num_ner_gate_shape_features +
+              num_ner_gate_hash_features elements.  The first are a constant 1 and the
+              fractions of words with various shapes, like capitalized words that don't
+              start the sentence, words with digits, and words that aren't in fe's
+              dictionary.  The rest count the hashes of the words just before
+              capitalized words, like "Mr" or "in", so that common ways of introducing
+              an entity can be learned.
+    !*/
+
 // ----------------------------------------------------------------------------------------
 
 }
@@ -0,0 +1,152 @@
+// Copyright (C) 2014 Massachusetts Institute of Technology, Lincoln Laboratory
+// License: Boost Software License   See LICENSE.txt for the full license.
+// Authors: Davis E. King (davis@dlib.net)
+#ifndef MIT_LL_NER_GaTE_H_
+#define MIT_LL_NER_GaTE_H_
+
+#include <string>
+#include <vector>
+#include <dlib/matrix.h>
+#include <dlib/serialize.h>
+#include <mitie/ner_feature_extraction.h>
+#include <mitie/memory_usage.h>
+
+namespace mitie
+{
+
+// ----------------------------------------------------------------------------------------
+
+    class ner_gate
+    {
+        /*!
+            WHAT THIS OBJECT REPRESENTS
+                This object is a cheap test a named_entity_extractor can run on a
+                sentence before doing any real work on it.  Most sentences in most text
+                don't contain any named entities, and finding that out the normal way
+                costs a word vector lookup for every word and a full run of the sequence
+                segmenter.  This object is a linear model over the few shape features
+                made by extract_ner_gate_features(), and sentences it scores below
+                get_threshold() are skipped.
+
+                An ner_gate is made by the ner_trainer, which picks the threshold so
+                that few of the entities in the training data would be lost.  A default
+                constructed ner_gate is disabled and never skips anything.
+        !*/
+
+    public:
+
+        ner_gate (
+        ) : threshold(0) {}
+        /*!
+            ensures
+                - #is_enabled() == false
+        !*/
+
+        ner_gate (
+            const ner_gate_sample_type& weights_,
+            double threshold_
+        ) : weights(weights_), threshold(threshold_) {}
+        /*!
+            requires
+                - weights_.size() == num_ner_gate_shape_features + num_ner_gate_hash_features
+            ensures
+                - #is_enabled() == true
+                - #get_weights() == weights_
+                - #get_threshold() == threshold_
+        !*/
+
+        bool is_enabled (
+        ) const { return weights.size() != 0; }
+        /*!
+            ensures
+                - returns true if this gate ever skips sentences.
+        !*/
+
+        const ner_gate_sample_type& get_weights (
+        ) const { return weights; }
+
+        double get_threshold (
+        ) const { return threshold; }
+        /*!
+            ensures
+                - returns the score below which sentences are skipped.
+        !*/
+
+        void set_threshold (
+            double new_threshold
+        ) { threshold = new_threshold; }
+        /*!
+            ensures
+                - #get_threshold() == new_threshold
+                - Lowering the threshold skips fewer sentences but loses fewer entities.
+        !*/
+
+        double score (
+            const std::vector<std::string>& sentence,
+            const total_word_feature_extractor& fe
+        ) const
+        /*!
+            requires
+                - is_enabled() == true
+            ensures
+                - returns a score for how likely sentence is to contain a named entity.
+                  Bigger means more likely.
+        !*/
+        {
+            return dlib::dot(weights, extract_ner_gate_features(sentence, fe));
+        }
+
+        bool should_skip (
+            const std::vector<std::string>& sentence,
+            const total_word_feature_extractor& fe
+        ) const
+        /*!
+            ensures
+                - returns true if is_enabled() and score(sentence,fe) < get_threshold().
+                  That is, returns true if NER doesn't need to be run on sentence since
+                  it's unlikely to contain any named entities.
+        !*/
+        {
+            return is_enabled() && score(sentence, fe) < threshold;
+        }
+
+        memory_usage get_memory_usage (
+        ) const
+        {
+            memory_usage result;
+            result.add("gate_weights", heap_bytes(weights));
+            return result;
+        }
+
+        friend void serialize(const ner_gate& item, std::ostream& out)
+        {
+            int version = 1;
+            dlib::serialize(version, out);
+            dlib::serialize(item.weights, out);
+            dlib::serialize(item.threshold, out);
+        }
+
+        friend void deserialize(ner_gate& item, std::istream& in)
+        {
+            int version = 0;
+            dlib::deserialize(version, in);
+            if (version != 1)
+                throw dlib::serialization_error("Unexpected version found while deserializing mitie::ner_gate.");
+            dlib::deserialize(item.weights, in);
+            dlib::deserialize(item.threshold, in);
+            if (item.weights.size() != 0 &&
+                item.weights.size() != (long)(num_ner_gate_shape_features + num_ner_gate_hash_features))
+                throw dlib::serialization_error("Invalid weights found while deserializing mitie::ner_gate.");
+        }
+
+    private:
+        ner_gate_sample_type weights;
+        double threshold;
+    };
+
+// ----------------------------------------------------------------------------------------
+
+}
+
+#endif // MIT_LL_NER_GaTE_H_
+
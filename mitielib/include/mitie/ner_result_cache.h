@@ -0,0 +1,173 @@
+// Copyright (C) 2014 Massachusetts Institute of Technology, Lincoln Laboratory
+// License: Boost Software License   See LICENSE.txt for the full license.
+// Authors: Davis E. King (davis@dlib.net)
+#ifndef MIT_LL_NER_RESULT_CaCHE_H_
+#define MIT_LL_NER_RESULT_CaCHE_H_
+
+#include <string>
+#include <vector>
+#include <utility>
+#include <mitie/named_entity_extractor.h>
+#include <mitie/sharded_lru_cache.h>
+#include <dlib/uintn.h>
+
+namespace mitie
+{
+
+// ----------------------------------------------------------------------------------------
+
+    class ner_result_cache : dlib::noncopyable
+    {
+        /*!
+            WHAT THIS OBJECT REPRESENTS
+                This object remembers the outputs of named_entity_extractor::predict() so
+                that sentences that have already been seen don't need to be processed
+                again.  This is useful for text like news and web pages, which repeat
+                things like bylines, disclaimers, and navigation text over and over.
+
+                A result is found by a 128bit hash of the sentence's tokens together with
+                the fingerprint of the named_entity_extractor that made it.  So a single
+                cache can be shared by several different models.  The results are kept
+                in a sharded_lru_cache, so the cache holds at most get_capacity()
+                results and throws away the least recently used ones when it's full.
+
+            THREAD SAFETY
+                Unlike most MITIE objects, it is safe for multiple threads to make
+                concurrent calls to any of the member functions of this object.
+        !*/
+
+    public:
+
+        explicit ner_result_cache (
+            unsigned long capacity = 10000,
+            unsigned long num_shards = 16
+        );
+        /*!
+            requires
+                - capacity > 0
+                - num_shards > 0
+            ensures
+                - #get_capacity() == capacity
+                - #size() == 0
+                - #get_num_hits() == 0
+                - #get_num_misses() == 0
+        !*/
+
+        void predict (
+            const named_entity_extractor& ner,
+            const std::vector<std::string>& sentence,
+            std::vector<std::pair<unsigned long, unsigned long> >& chunks,
+            std::vector<unsigned long>& chunk_tags,
+            std::vector<double>& chunk_scores
+        );
+        /*!
+            ensures
+                - Does the same thing as ner.predict(sentence, chunks, chunk_tags,
+                  chunk_scores).  However, if the result for this sentence and model is
+                  in the cache it is returned without running ner.  Otherwise ner is run
+                  and its result is added to the cache.
+                - Increments get_num_hits() if the result was found in the cache and
+                  get_num_misses() otherwise.
+        !*/
+
+        void predict (
+            const named_entity_extractor& ner,
+            const std::vector<std::string>& sentence,
+            std::vector<std::pair<unsigned long, unsigned long> >& chunks,
+            std::vector<unsigned long>& chunk_tags,
+            std::vector<double>& chunk_scores,
+            const total_word_feature_extractor& fe
+        );
+        /*!
+            requires
+                - fe is the feature extractor ner was trained with.
+            ensures
+                - Does the same thing as ner.predict(sentence, chunks, chunk_tags,
+                  chunk_scores, fe), except that results are looked up in and added to
+                  the cache just like the version of predict() above.
+        !*/
+
+        unsigned long get_capacity (
+        ) const { return results.get_capacity(); }
+        /*!
+            ensures
+                - returns the maximum number of results this cache will hold.
+        !*/
+
+        unsigned long size (
+        ) const { return results.size(); }
+        /*!
+            ensures
+                - returns the number of results currently in the cache.
+        !*/
+
+        dlib::uint64 get_num_hits (
+        ) const { return results.get_num_hits(); }
+        /*!
+            ensures
+                - returns the number of calls to predict() that found their result in
+                  the cache.
+        !*/
+
+        dlib::uint64 get_num_misses (
+        ) const { return results.get_num_misses(); }
+        /*!
+            ensures
+                - returns the number of calls to predict() that had to run the
+                  named_entity_extractor.
+        !*/
+
+        void clear (
+        ) { results.clear(); }
+        /*!
+            ensures
+                - Removes all the results from the cache.
+                - #size() == 0
+                - #get_num_hits() == 0
+                - #get_num_misses() == 0
+        !*/
+
+    private:
+
+        typedef std::pair<dlib::uint64,dlib::uint64> key_type;
+
+        struct cached_result
+        {
+            std::vector<std::pair<unsigned long, unsigned long> > chunks;
+            std::vector<unsigned long> chunk_tags;
+            std::vector<double> chunk_scores;
+        };
+
+        struct key_hasher
+        {
+            dlib::uint64 operator() (const key_type& key) const { return key.second; }
+        };
+
+        static key_type hash_sentence (
+            const named_entity_extractor& ner,
+            const std::vector<std::string>& sentence
+        );
+
+        bool find (
+            const key_type& key,
+            std::vector<std::pair<unsigned long, unsigned long> >& chunks,
+            std::vector<unsigned long>& chunk_tags,
+            std::vector<double>& chunk_scores
+        );
+
+        void insert (
+            const key_type& key,
+            const std::vector<std::pair<unsigned long, unsigned long> >& chunks,
+            const std::vector<unsigned long>& chunk_tags,
+            const std::vector<double>& chunk_scores
+        );
+
+        sharded_lru_cache<key_type, cached_result, key_hasher> results;
+    };
+
+// ----------------------------------------------------------------------------------------
+
+}
+
+#endif // MIT_LL_NER_RESULT_CaCHE_H_
+
@@ -9,6 +9,7 @@
 #include <utility>
 #include <mitie/total_word_feature_extractor.h>
 #include <mitie/named_entity_extractor.h>
+#include <mitie/training_timer.h>
 #include <dlib/svm.h>
 #include <map>
 
@@ -123,6 +124,7 @@ namespace mitie
             ensures
                 - #get_beta() == 0.5
                 - #num_threads() == 4
+                - #get_gate_target_recall() == 0
                 - This function attempts to load a mitie::total_word_feature_extractor from the
                   file with the given filename.  This feature extractor is used during the
                   NER training process.  
@@ -221,6 +223,30 @@ namespace mitie
                 - #get_beta() == new_beta
         !*/
 
+        double get_gate_target_recall (
+        ) const;
+        /*!
+            ensures
+                - returns the fraction of the training entities the ner_gate made by
+                  train() should let through, or 0 if train() doesn't make a gate.  The
+                  gate lets the named_entity_extractor skip sentences that are unlikely to
+                  contain entities.  So the smaller this value the faster the resulting
+                  extractor is, but the more entities it misses.  The gate's threshold is
+                  picked on the same data the gate is trained on, so the recall on new
+                  data is usually a little lower.  train() prints a cross-validated
+                  estimate of it.
+        !*/
+
+        void set_gate_target_recall (
+            double recall
+        );
+        /*!
+            requires
+                - 0 <= recall <= 1
+            ensures
+                - #get_gate_target_recall() == recall
+        !*/
+
         named_entity_extractor train (
         ) const;
         /*!
@@ -229,6 +255,25 @@ namespace mitie
             ensures
                 - Trains a named_entity_extractor based on the training instances given to
                   this object via add() calls and returns the result.
+                - if (get_gate_target_recall() != 0) then
+                    - Also trains an ner_gate for the result.  This needs a few training
+                      instances with entities and a few without.  If there aren't enough
+                      then the result doesn't have a gate.
+        !*/
+
+        named_entity_extractor train (
+            std::vector<training_phase>& phases
+        ) const;
+        /*!
+            requires
+                - size() > 0
+            ensures
+                - Does the same thing as train() and returns the result.
+                - #phases == a list of the phases of training, in the order they ran, along
+                  with how long each took.  That is, the feature extraction, each
+                  cross-validation run done while searching for good parameters, and the
+                  final fit, for both the entity segmenter and the entity type classifier,
+                  and the gate if one is trained.
         !*/
 
     private:
@@ -240,7 +285,8 @@ namespace mitie
         typedef dlib::multiclass_linear_decision_function<dlib::sparse_linear_kernel<ner_sample_type>,unsigned long> classifier_type;
         classifier_type train_ner_segment_classifier (
             const std::vector<ner_sample_type>& samples,
-            const std::vector<unsigned long>& labels
+            const std::vector<unsigned long>& labels,
+            std::vector<training_phase>& phases
         ) const;
 
         void extract_ner_segment_feats (
@@ -250,7 +296,12 @@ namespace mitie
         ) const;
 
         void train_segmenter (
-            dlib::sequence_segmenter<ner_feature_extractor>& segmenter
+            dlib::sequence_segmenter<ner_feature_extractor>& segmenter,
+            std::vector<training_phase>& phases
+        ) const;
+
+        ner_gate train_gate (
+            std::vector<training_phase>& phases
         ) const;
 
         unsigned long get_label_id (
@@ -264,6 +315,7 @@ namespace mitie
         total_word_feature_extractor tfe;
         double beta;
         unsigned long num_threads;
+        double gate_target_recall;
         std::map<std::string,unsigned long> label_to_id;
         std::vector<std::vector<std::string> > sentences;
         std::vector<std::vector<std::pair<unsigned long, unsigned long> > > chunks;
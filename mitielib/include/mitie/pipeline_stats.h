@@ -0,0 +1,256 @@
+// Copyright (C) 2014 Massachusetts Institute of Technology, Lincoln Laboratory
+// License: Boost Software License   See LICENSE.txt for the full license.
+// Authors: Davis E. King (davis@dlib.net)
+#ifndef MIT_LL_PIPELINE_StATS_H_
+#define MIT_LL_PIPELINE_StATS_H_
+
+#include <dlib/uintn.h>
+#include <dlib/noncopyable.h>
+
+/*!
+    This file contains tools for measuring how much time MITIE spends in each step of
+    running its models.  Recording is off until set_pipeline_stats_enabled(true) is
+    called, and while it's off each instrumented step only costs a check of one global
+    flag.
+
+    If MITIE_DISABLE_PIPELINE_STATS is #defined when MITIE is built then the recording
+    code is compiled out entirely and pipeline_stats_enabled() always returns false.
+    You can do this by giving -DMITIE_DISABLE_PIPELINE_STATS=ON to cmake or by running
+    make with MITIE_DISABLE_PIPELINE_STATS=1.
+!*/
+
+namespace mitie
+{
+
+// ----------------------------------------------------------------------------------------
+
+    enum pipeline_stage
+    {
+        stage_tokenize,
+        stage_ner,
+        stage_ner_gate,
+        stage_ner_word_features,
+        stage_ner_segmentation,
+        stage_ner_chunk_features,
+        stage_ner_chunk_classification,
+        stage_text_categorizer,
+        stage_text_categorizer_features,
+        stage_text_categorizer_classification,
+        stage_relation_features,
+        stage_relation_classification,
+        num_pipeline_stages
+    };
+
+    enum pipeline_counter
+    {
+        counter_tokenized_tokens,
+        counter_ner_tokens,
+        counter_ner_oov_tokens,
+        counter_ner_candidate_chunks,
+        counter_ner_entities,
+        counter_ner_gate_sentences,
+        counter_ner_gate_skipped_sentences,
+        counter_text_categorizer_tokens,
+        counter_text_categorizer_oov_tokens,
+        num_pipeline_counters
+    };
+
+    const char* pipeline_stage_name (
+        pipeline_stage stage
+    );
+    /*!
+        requires
+            - stage < num_pipeline_stages
+        ensures
+            - returns a short name for the stage, like "ner.segmentation".
+    !*/
+
+    const char* pipeline_counter_name (
+        pipeline_counter counter
+    );
+    /*!
+        requires
+            - counter < num_pipeline_counters
+        ensures
+            - returns a short name for the counter, like "ner.oov_tokens".
+    !*/
+
+// ----------------------------------------------------------------------------------------
+
+    namespace impl
+    {
+        extern volatile bool pipeline_stats_on;
+    }
+
+    inline bool pipeline_stats_enabled (
+    )
+    /*!
+        ensures
+            - returns true if MITIE is currently recording pipeline statistics.
+    !*/
+    {
+#ifdef MITIE_DISABLE_PIPELINE_STATS
+        return false;
+#else
+        return impl::pipeline_stats_on;
+#endif
+    }
+
+    void set_pipeline_stats_enabled (
+        bool enabled
+    );
+    /*!
+        ensures
+            - #pipeline_stats_enabled() == enabled, unless MITIE was built with
+              MITIE_DISABLE_PIPELINE_STATS, in which case this function does nothing.
+            - Statistics that were already recorded are kept.  Use
+              reset_pipeline_stats() to clear them.
+    !*/
+
+    void reset_pipeline_stats (
+    );
+    /*!
+        ensures
+            - Sets all the recorded statistics back to 0.
+    !*/
+
+// ----------------------------------------------------------------------------------------
+
+    // Bucket i of a latency histogram counts the calls that took between 2^i and
+    // 2^(i+1) nanoseconds, except the first bucket also counts calls under 1 ns and the
+    // last one also counts everything longer.
+    const unsigned long num_latency_buckets = 40;
+
+    struct stage_stats
+    {
+        dlib::uint64 count;
+        dlib::uint64 total_ns;
+        dlib::uint64 min_ns;
+        dlib::uint64 max_ns;
+        dlib::uint64 histogram[num_latency_buckets];
+
+        double mean_ns (
+        ) const;
+        /*!
+            ensures
+                - returns the average time of one call, or 0 if count == 0.
+        !*/
+
+        dlib::uint64 percentile_ns (
+            double p
+        ) const;
+        /*!
+            requires
+                - 0 <= p <= 1
+            ensures
+                - returns an upper bound on the time taken by the fastest p fraction of
+                  the calls.  It's found from the histogram so it's accurate to within a
+                  factor of 2, but it's never bigger than max_ns.  Returns 0 if count ==
+                  0.
+        !*/
+    };
+
+    struct pipeline_stats_snapshot
+    {
+        stage_stats stages[num_pipeline_stages];
+        dlib::uint64 counters[num_pipeline_counters];
+
+        double ner_oov_rate (
+        ) const;
+        /*!
+            ensures
+                - returns the fraction of the tokens given to named_entity_extractors
+                  that weren't in the feature extractor's dictionary, or 0 if there
+                  weren't any tokens.
+        !*/
+
+        double ner_gate_skip_rate (
+        ) const;
+        /*!
+            ensures
+                - returns the fraction of the sentences checked by a named_entity_extractor's
+                  ner_gate that it skipped, or 0 if none were checked.
+        !*/
+    };
+
+    pipeline_stats_snapshot get_pipeline_stats (
+    );
+    /*!
+        ensures
+            - returns the statistics recorded by all threads since the program started or
+              reset_pipeline_stats() was last called.
+    !*/
+
+// ----------------------------------------------------------------------------------------
+
+    dlib::uint64 pipeline_stats_clock_ns (
+    );
+    /*!
+        ensures
+            - returns the current time in nanoseconds from a monotonic clock.  Only the
+              difference between two calls is meaningful.
+    !*/
+
+    void record_pipeline_stage (
+        pipeline_stage stage,
+        dlib::uint64 elapsed_ns
+    );
+    /*!
+        requires
+            - stage < num_pipeline_stages
+        ensures
+            - Adds one call to stage that took elapsed_ns nanoseconds to the statistics.
+              This happens whether or not pipeline_stats_enabled() is true, so callers
+              should check it first.
+            - Each thread records into its own part of the statistics, so threads
+              recording at the same time rarely wait on each other.
+    !*/
+
+    void add_to_pipeline_counter (
+        pipeline_counter counter,
+        dlib::uint64 amount
+    );
+    /*!
+        requires
+            - counter < num_pipeline_counters
+        ensures
+            - Adds amount to the given counter.  Like record_pipeline_stage(), this
+              happens whether or not pipeline_stats_enabled() is true.
+    !*/
+
+// ----------------------------------------------------------------------------------------
+
+    class pipeline_stage_timer : dlib::noncopyable
+    {
+        /*!
+            WHAT THIS OBJECT REPRESENTS
+                This object times one call to a pipeline stage.  If pipeline statistics
+                are enabled when it's constructed then its destructor records the time
+                since construction with record_pipeline_stage().  Otherwise it does
+                nothing.
+        !*/
+    public:
+        explicit pipeline_stage_timer (
+            pipeline_stage stage_
+        ) : stage(stage_), running(pipeline_stats_enabled()), start(running ? pipeline_stats_clock_ns() : 0)
+        {}
+
+        ~pipeline_stage_timer (
+        )
+        {
+            if (running)
+                record_pipeline_stage(stage, pipeline_stats_clock_ns() - start);
+        }
+
+    private:
+        const pipeline_stage stage;
+        const bool running;
+        const dlib::uint64 start;
+    };
+
+// ----------------------------------------------------------------------------------------
+
+}
+
+#endif // MIT_LL_PIPELINE_StATS_H_
+
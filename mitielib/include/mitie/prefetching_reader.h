@@ -0,0 +1,200 @@
+// Copyright (C) 2014 Massachusetts Institute of Technology, Lincoln Laboratory
+// License: Boost Software License   See LICENSE.txt for the full license.
+// Authors: Davis E. King (davis@dlib.net)
+#ifndef MIT_LL_PREFETCHING_ReADER_H_
+#define MIT_LL_PREFETCHING_ReADER_H_
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <algorithm>
+#include <dlib/pipe.h>
+#include <dlib/threads.h>
+#include <dlib/noncopyable.h>
+#include <dlib/smart_pointers.h>
+#include <dlib/error.h>
+
+namespace mitie
+{
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename parser_type,
+        typename item_type
+        >
+    class prefetching_reader : dlib::noncopyable
+    {
+        /*!
+            REQUIREMENTS ON parser_type
+                This must be an object that can be constructed from a std::istream and
+                that has a bool operator()(item_type& item) which reads the next item out
+                of that stream.  For example, the unigram_tokenizer with item_type ==
+                std::string or the gigaword_file_reader with item_type ==
+                gigaword_document.
+
+            WHAT THIS OBJECT REPRESENTS
+                This object reads items out of a list of files.  You get the same items,
+                in the same order, as you would if you opened each file in turn and ran a
+                parser_type over it.  The difference is that the files are opened and
+                parsed by background threads while you are busy with the items they
+                already produced.  So the reading and parsing doesn't happen on the
+                thread that consumes the items.
+
+                Each background thread handles every num_threads-th file and hands its
+                items over in batches through its own bounded queue.  So at most
+                num_threads*(queue_size+2) batches of items exist at any one time, no
+                matter how big the files are.
+        !*/
+
+    public:
+
+        prefetching_reader (
+            const std::vector<std::string>& files_,
+            unsigned long num_threads,
+            unsigned long queue_size = 4,
+            unsigned long batch_size_ = 1000
+        ) :
+            files(files_),
+            batch_size(std::max<unsigned long>(1,batch_size_)),
+            pos(0),
+            next_file(0)
+        /*!
+            requires
+                - num_threads > 0
+            ensures
+                - Starts up to num_threads threads which begin reading the given files.
+                - This object will read items out of the given list of files.
+        !*/
+        {
+            const unsigned long n = std::min<unsigned long>(num_threads, files.size());
+            for (unsigned long i = 0; i < n; ++i)
+                queues.push_back(dlib::shared_ptr<dlib::pipe<batch> >(new dlib::pipe<batch>(std::max<unsigned long>(1,queue_size))));
+            for (unsigned long i = 0; i < n; ++i)
+                loaders.push_back(dlib::shared_ptr<dlib::thread_function>(new dlib::thread_function(&prefetching_reader::load_files, this, i)));
+        }
+
+        ~prefetching_reader (
+        )
+        {
+            // Unblock any loaders waiting on a full queue and then wait for them to end.
+            for (unsigned long i = 0; i < queues.size(); ++i)
+                queues[i]->disable();
+            loaders.clear();
+        }
+
+        bool operator() (
+            item_type& item
+        )
+        /*!
+            ensures
+                - if (there is another item in the files) then
+                    - #item == the next item
+                    - returns true
+                - else
+                    - returns false
+            throws
+                - dlib::error
+                    This exception is thrown if a background thread failed with an
+                    exception while parsing a file.
+        !*/
+        {
+            while (pos >= current.items.size())
+            {
+                if (current.end_of_file)
+                {
+                    current.end_of_file = false;
+                    ++next_file;
+                }
+                if (next_file >= files.size())
+                    return false;
+
+                // the files are spread over the queues round robin
+                queues[next_file%queues.size()]->dequeue(current);
+                pos = 0;
+                if (current.error.size() != 0)
+                    throw dlib::error("Error while reading " + files[next_file] + ": " + current.error);
+            }
+
+            std::swap(item, current.items[pos++]);
+            return true;
+        }
+
+    private:
+
+        struct batch
+        {
+            batch() : end_of_file(false) {}
+
+            std::vector<item_type> items;
+            bool end_of_file;
+            std::string error;
+        };
+
+        friend void swap (batch& a, batch& b)
+        {
+            a.items.swap(b.items);
+            std::swap(a.end_of_file, b.end_of_file);
+            a.error.swap(b.error);
+        }
+
+        static void load_files (
+            prefetching_reader* self,
+            unsigned long thread_id
+        )
+        {
+            const unsigned long stride = self->queues.size();
+            dlib::pipe<batch>& queue = *self->queues[thread_id];
+            batch b;
+            item_type item;
+            for (unsigned long f = thread_id; f < self->files.size(); f += stride)
+            {
+                try
+                {
+                    std::ifstream fin(self->files[f].c_str());
+                    parser_type parser(fin);
+                    b.items.clear();
+                    while (parser(item))
+                    {
+                        b.items.resize(b.items.size()+1);
+                        std::swap(b.items.back(), item);
+                        if (b.items.size() >= self->batch_size)
+                        {
+                            b.end_of_file = false;
+                            b.error.clear();
+                            if (!queue.enqueue(b))
+                                return;
+                            b.items.clear();
+                        }
+                    }
+                    b.error.clear();
+                }
+                catch (std::exception& e)
+                {
+                    b.items.clear();
+                    b.error = e.what();
+                }
+                b.end_of_file = true;
+                if (!queue.enqueue(b))
+                    return;
+            }
+        }
+
+        const std::vector<std::string> files;
+        const unsigned long batch_size;
+
+        std::vector<dlib::shared_ptr<dlib::pipe<batch> > > queues;
+        std::vector<dlib::shared_ptr<dlib::thread_function> > loaders;
+
+        // The batch currently being handed out by operator() and our position in it.
+        batch current;
+        unsigned long pos;
+        unsigned long next_file;
+    };
+
+// ----------------------------------------------------------------------------------------
+
+}
+
+#endif // MIT_LL_PREFETCHING_ReADER_H_
+
@@ -0,0 +1,346 @@
+// Copyright (C) 2014 Massachusetts Institute of Technology, Lincoln Laboratory
+// License: Boost Software License   See LICENSE.txt for the full license.
+// Authors: Davis E. King (davis@dlib.net)
+#ifndef MIT_LL_SHARDED_LRU_CaCHE_H_
+#define MIT_LL_SHARDED_LRU_CaCHE_H_
+
+#include <vector>
+#include <list>
+#include <utility>
+#include <algorithm>
+#include <dlib/threads.h>
+#include <dlib/smart_pointers.h>
+#include <dlib/uintn.h>
+
+namespace mitie
+{
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename key_type,
+        typename value_type,
+        typename hasher
+        >
+    class sharded_lru_cache : dlib::noncopyable
+    {
+        /*!
+            REQUIREMENTS ON key_type
+                key_type must be copyable and comparable with operator==.
+
+            REQUIREMENTS ON value_type
+                value_type must be default constructable and copyable.
+
+            REQUIREMENTS ON hasher
+                hasher must be a default constructable function object such that
+                hasher()(key) returns a dlib::uint64 hash of a key_type object.
+
+            WHAT THIS OBJECT REPRESENTS
+                This object is a map from keys to values that holds at most
+                get_capacity() entries.  When it's full, adding a new entry throws away
+                the least recently used one.  It also counts how many lookups found
+                what they were looking for.
+
+                Internally, it is split into several independent shards, each with its
+                own mutex, so many threads can use it at once without waiting on each
+                other much.  Keys are assigned to shards by their hash and each shard
+                finds its entries with a hash table, so a lookup hashes the key once and
+                usually compares it to just one stored key.  Since each shard does its
+                own LRU bookkeeping, the entry that gets thrown away is the least
+                recently used one in its shard rather than in the whole cache.
+
+            THREAD SAFETY
+                It is safe for multiple threads to make concurrent calls to any of the
+                member functions of this object.
+        !*/
+
+    public:
+
+        explicit sharded_lru_cache (
+            unsigned long capacity_,
+            unsigned long num_shards = 16
+        ) : capacity(capacity_)
+        /*!
+            requires
+                - capacity_ > 0
+                - num_shards > 0
+            ensures
+                - #get_capacity() == capacity_
+                - #size() == 0
+                - #get_num_hits() == 0
+                - #get_num_misses() == 0
+        !*/
+        {
+            DLIB_CASSERT(capacity > 0 && num_shards > 0, "Invalid arguments");
+            // Each shard holds an equal part of the capacity, so don't make more shards
+            // than there are entries to hold.  When the capacity doesn't divide evenly
+            // the first capacity%num_shards shards hold one extra entry, so the shards
+            // add up to exactly capacity.
+            num_shards = std::min(num_shards, capacity);
+            shards.resize(num_shards);
+            for (unsigned long i = 0; i < shards.size(); ++i)
+            {
+                shards[i].reset(new shard);
+                shards[i]->capacity = capacity/num_shards + (i < capacity%num_shards ? 1 : 0);
+                // Use at least one bucket per entry so the bucket lists stay short.
+                unsigned long num_buckets = 1;
+                while (num_buckets < shards[i]->capacity)
+                    num_buckets *= 2;
+                shards[i]->buckets.resize(num_buckets);
+            }
+        }
+
+        bool find (
+            const key_type& key,
+            value_type& value
+        )
+        /*!
+            ensures
+                - if (key is in the cache) then
+                    - #value == the value stored for key
+                    - key becomes the most recently used entry in its shard.
+                    - increments get_num_hits()
+                    - returns true
+                - else
+                    - increments get_num_misses()
+                    - returns false
+        !*/
+        {
+            value_assigner assign(value);
+            return visit(key, assign);
+        }
+
+        template <typename visitor_type>
+        bool visit (
+            const key_type& key,
+            visitor_type& visitor
+        )
+        /*!
+            requires
+                - visitor(const value_type&) is a valid expression.
+            ensures
+                - This function is just like find() except that instead of copying the
+                  value stored for key it calls visitor(the stored value).  So you can
+                  copy a value into memory you already have rather than into a new
+                  value_type object.
+                - visitor is called while the shard holding key is locked, so it must
+                  not use this cache.
+        !*/
+        {
+            const dlib::uint64 hash = hasher()(key);
+            shard& s = get_shard(hash);
+            dlib::auto_mutex lock(s.m);
+            bucket_type& bucket = get_bucket(s, hash);
+            const unsigned long pos = find_in_bucket(bucket, key, hash);
+            if (pos == bucket.size())
+            {
+                ++s.num_misses;
+                return false;
+            }
+
+            ++s.num_hits;
+            // move this entry to the front since it's now the most recently used.
+            s.entries.splice(s.entries.begin(), s.entries, bucket[pos]);
+            visitor(static_cast<const value_type&>(bucket[pos]->value));
+            return true;
+        }
+
+        void insert (
+            const key_type& key,
+            const value_type& value
+        )
+        /*!
+            ensures
+                - Adds key and value to the cache, throwing away the least recently used
+                  entry in key's shard if it's full.  If key is already in the cache it
+                  is left unchanged, since that happens when two threads both miss on
+                  the same key and then both compute its value.
+        !*/
+        {
+            const dlib::uint64 hash = hasher()(key);
+            shard& s = get_shard(hash);
+            dlib::auto_mutex lock(s.m);
+            bucket_type& bucket = get_bucket(s, hash);
+            if (find_in_bucket(bucket, key, hash) != bucket.size())
+                return;
+
+            if (s.entries.size() >= s.capacity)
+            {
+                // Reuse the least recently used entry for the new one.  Assigning over
+                // its key and value can reuse their memory too.
+                typename entry_list::iterator oldest = --s.entries.end();
+                bucket_type& old_bucket = get_bucket(s, oldest->hash);
+                old_bucket[find_in_bucket(old_bucket, oldest->key, oldest->hash)] = old_bucket.back();
+                old_bucket.pop_back();
+                s.entries.splice(s.entries.begin(), s.entries, oldest);
+                oldest->key = key;
+                oldest->value = value;
+                oldest->hash = hash;
+            }
+            else
+            {
+                s.entries.push_front(entry(key, value, hash));
+            }
+            bucket.push_back(s.entries.begin());
+        }
+
+        unsigned long get_capacity (
+        ) const { return capacity; }
+        /*!
+            ensures
+                - returns the maximum number of entries this cache will hold.
+        !*/
+
+        unsigned long size (
+        ) const
+        /*!
+            ensures
+                - returns the number of entries currently in the cache.
+        !*/
+        {
+            unsigned long total = 0;
+            for (unsigned long i = 0; i < shards.size(); ++i)
+            {
+                dlib::auto_mutex lock(shards[i]->m);
+                total += shards[i]->entries.size();
+            }
+            return total;
+        }
+
+        dlib::uint64 get_num_hits (
+        ) const
+        /*!
+            ensures
+                - returns the number of calls to find() that returned true.
+        !*/
+        {
+            dlib::uint64 total = 0;
+            for (unsigned long i = 0; i < shards.size(); ++i)
+            {
+                dlib::auto_mutex lock(shards[i]->m);
+                total += shards[i]->num_hits;
+            }
+            return total;
+        }
+
+        dlib::uint64 get_num_misses (
+        ) const
+        /*!
+            ensures
+                - returns the number of calls to find() that returned false.
+        !*/
+        {
+            dlib::uint64 total = 0;
+            for (unsigned long i = 0; i < shards.size(); ++i)
+            {
+                dlib::auto_mutex lock(shards[i]->m);
+                total += shards[i]->num_misses;
+            }
+            return total;
+        }
+
+        void clear (
+        )
+        /*!
+            ensures
+                - #size() == 0
+                - #get_num_hits() == 0
+                - #get_num_misses() == 0
+        !*/
+        {
+            for (unsigned long i = 0; i < shards.size(); ++i)
+            {
+                dlib::auto_mutex lock(shards[i]->m);
+                shards[i]->entries.clear();
+                for (unsigned long j = 0; j < shards[i]->buckets.size(); ++j)
+                    shards[i]->buckets[j].clear();
+                shards[i]->num_hits = 0;
+                shards[i]->num_misses = 0;
+            }
+        }
+
+    private:
+
+        struct entry
+        {
+            entry (
+                const key_type& key_,
+                const value_type& value_,
+                dlib::uint64 hash_
+            ) : key(key_), value(value_), hash(hash_) {}
+
+            key_type key;
+            value_type value;
+            dlib::uint64 hash;
+        };
+
+        typedef std::list<entry> entry_list;
+        // The entries whose hashes land in the same bucket.  These are short so they are
+        // just searched linearly.
+        typedef std::vector<typename entry_list::iterator> bucket_type;
+
+        struct shard
+        {
+            shard() : capacity(0), num_hits(0), num_misses(0) {}
+
+            dlib::mutex m;
+            // The most entries this shard holds.
+            unsigned long capacity;
+            // The most recently used entry is at the front.
+            entry_list entries;
+            // The number of buckets is a power of 2.
+            std::vector<bucket_type> buckets;
+            dlib::uint64 num_hits;
+            dlib::uint64 num_misses;
+        };
+
+        struct value_assigner
+        {
+            value_assigner (value_type& value_) : value(value_) {}
+            void operator() (const value_type& item) { value = item; }
+            value_type& value;
+        };
+
+        shard& get_shard (
+            dlib::uint64 hash
+        ) { return *shards[hash%shards.size()]; }
+
+        bucket_type& get_bucket (
+            shard& s,
+            dlib::uint64 hash
+        ) const
+        {
+            // The low part of the hash picked the shard so use the rest to pick the
+            // bucket.
+            return s.buckets[(hash/shards.size())&(s.buckets.size()-1)];
+        }
+
+        static unsigned long find_in_bucket (
+            const bucket_type& bucket,
+            const key_type& key,
+            dlib::uint64 hash
+        )
+        /*!
+            ensures
+                - returns the position of key in bucket, or bucket.size() if it isn't
+                  there.
+        !*/
+        {
+            for (unsigned long i = 0; i < bucket.size(); ++i)
+            {
+                if (bucket[i]->hash == hash && bucket[i]->key == key)
+                    return i;
+            }
+            return bucket.size();
+        }
+
+        unsigned long capacity;
+        std::vector<dlib::shared_ptr<shard> > shards;
+    };
+
+// ----------------------------------------------------------------------------------------
+
+}
+
+#endif // MIT_LL_SHARDED_LRU_CaCHE_H_
+
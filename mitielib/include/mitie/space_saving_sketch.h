@@ -0,0 +1,538 @@
+// Copyright (C) 2014 Massachusetts Institute of Technology, Lincoln Laboratory
+// License: Boost Software License   See LICENSE.txt for the full license.
+// Authors: Davis E. King (davis@dlib.net)
+#ifndef MIT_LL_SpACE_SAVING_SKETCH_H_
+#define MIT_LL_SpACE_SAVING_SKETCH_H_
+
+#include <string>
+#include <vector>
+#include <algorithm>
+#include "dlib/uintn.h"
+#include "dlib/assert.h"
+#include "dlib/general_hash/murmur_hash3.h"
+
+namespace mitie
+{
+    class space_saving_sketch
+    {
+        /*!
+            WHAT THIS OBJECT REPRESENTS
+                This is an implementation of the Space-Saving algorithm described in the
+                paper:
+                    Efficient Computation of Frequent and Top-k Elements in Data Streams
+                    by Ahmed Metwally, Divyakant Agrawal, and Amr El Abbadi
+
+                It finds the most frequent strings in a stream in a single pass and with
+                a fixed amount of RAM.  At most get_capacity() strings are tracked.  When
+                a new string arrives and the sketch is full, the string with the smallest
+                count is evicted.  The new string takes over its count, which is recorded
+                as the possible error in the new string's count.
+
+                This gives the following guarantees, where true(X) is the real number of
+                times X was given to increment():
+                    - for all tracked X: true(X) <= get_count(X) <= true(X) + get_error_bound()
+                    - if (X isn't tracked by this object) then
+                        - true(X) <= get_min_count()
+                    - if (this object was only populated by increment()) then
+                        - get_error_bound() <= get_min_count() <= get_total_count()/get_capacity()
+
+                So if you want the top K strings, use a capacity a few times larger than K.
+                Every string whose true count is larger than get_min_count() is then
+                reported, and the reported counts are off by at most get_error_bound().
+
+                Sketches can also be merged with absorb().  This lets you split a large
+                stream into shards, summarize each shard in its own thread, and then
+                combine the results.  The merge is done as in the paper Mergeable
+                Summaries by Agarwal et al.  The guarantees above still hold for the
+                merged sketch.  The error bound of the merged sketch is at most the sum,
+                over the two inputs, of max(get_error_bound(), get_min_count()).  So when
+                two sketches built only with increment() are merged, the error bound is
+                at most get_total_count()/get_capacity() for the combined stream.
+
+            THREAD SAFETY
+                Multiple threads may call the const member functions at the same time.
+                Anything else requires a mutex.
+        !*/
+    public:
+
+        space_saving_sketch (
+        )
+        /*!
+            ensures
+                - #get_capacity() == 100000
+                - #size() == 0
+                - #get_total_count() == 0
+        !*/
+        {
+            init(100000);
+        }
+
+        explicit space_saving_sketch (
+            unsigned long capacity
+        )
+        /*!
+            requires
+                - capacity > 0
+            ensures
+                - #get_capacity() == capacity
+                - #size() == 0
+                - #get_total_count() == 0
+        !*/
+        {
+            DLIB_CASSERT(capacity > 0, "Invalid inputs were given to this function");
+            init(capacity);
+        }
+
+        unsigned long get_capacity (
+        ) const { return capacity; }
+        /*!
+            ensures
+                - returns the maximum number of distinct strings this object tracks.
+        !*/
+
+        unsigned long size (
+        ) const { return words.size(); }
+        /*!
+            ensures
+                - returns the number of distinct strings currently tracked.
+        !*/
+
+        dlib::uint64 get_total_count (
+        ) const { return total_count; }
+        /*!
+            ensures
+                - returns the total of all values added into this object via increment().
+        !*/
+
+        dlib::uint64 get_min_count (
+        ) const
+        /*!
+            ensures
+                - if (size() < get_capacity()) then
+                    - returns 0.  Nothing has ever been evicted so every string given to
+                      increment() is tracked.
+                - else
+                    - returns the smallest count of any tracked string.  This is an upper
+                      bound on the true count of any string not tracked by this object.
+        !*/
+        {
+            if (words.size() < capacity)
+                return 0;
+            return counts[heap[0]];
+        }
+
+        dlib::uint64 get_error_bound (
+        ) const { return error_bound; }
+        /*!
+            ensures
+                - returns the largest amount by which get_count() might overestimate the
+                  count of any tracked string.
+        !*/
+
+        void increment (
+            const std::string& word,
+            dlib::uint64 amount = 1
+        )
+        /*!
+            ensures
+                - adds amount to the count of word, evicting the string with the smallest
+                  count if the sketch is full and word isn't tracked yet.
+                - #get_total_count() == get_total_count() + amount
+        !*/
+        {
+            total_count += amount;
+            const dlib::uint32 h = hash(word);
+            unsigned long slot = find(word, h);
+            if (slot != not_found)
+            {
+                counts[slot] += amount;
+                sift_down(heap_pos[slot]);
+            }
+            else if (words.size() < capacity)
+            {
+                add(word, h, amount, 0);
+            }
+            else
+            {
+                // Replace the string with the smallest count.
+                slot = heap[0];
+                table_remove(slot);
+                words[slot] = word;
+                hashes[slot] = h;
+                errors[slot] = counts[slot];
+                counts[slot] += amount;
+                error_bound = std::max(error_bound, errors[slot]);
+                table_insert(slot);
+                sift_down(0);
+            }
+        }
+
+        bool contains (
+            const std::string& word
+        ) const
+        /*!
+            ensures
+                - returns true if word is currently tracked by this object.
+        !*/
+        {
+            return find(word, hash(word)) != not_found;
+        }
+
+        dlib::uint64 get_count (
+            const std::string& word
+        ) const
+        /*!
+            ensures
+                - if (contains(word)) then
+                    - returns the count of word.  This overestimates the true count by at
+                      most get_error(word).
+                - else
+                    - returns get_min_count()
+        !*/
+        {
+            const unsigned long slot = find(word, hash(word));
+            if (slot == not_found)
+                return get_min_count();
+            return counts[slot];
+        }
+
+        dlib::uint64 get_error (
+            const std::string& word
+        ) const
+        /*!
+            ensures
+                - if (contains(word)) then
+                    - returns the maximum amount by which get_count(word) can overestimate
+                      the true count of word.
+                - else
+                    - returns get_min_count()
+        !*/
+        {
+            const unsigned long slot = find(word, hash(word));
+            if (slot == not_found)
+                return get_min_count();
+            return errors[slot];
+        }
+
+        void get_top_words (
+            std::vector<std::pair<dlib::uint64, std::string> >& top_words,
+            unsigned long n
+        ) const
+        /*!
+            ensures
+                - #top_words == the min(n,size()) tracked strings with the largest counts,
+                  along with their counts.
+                - #top_words is sorted in order of decreasing count.  Ties are broken by
+                  the string's lexical order so the output is deterministic.
+        !*/
+        {
+            top_words.clear();
+            top_words.reserve(words.size());
+            for (unsigned long i = 0; i < words.size(); ++i)
+                top_words.push_back(std::make_pair(counts[i], words[i]));
+            std::sort(top_words.begin(), top_words.end(), compare_count_then_word);
+            if (top_words.size() > n)
+                top_words.resize(n);
+        }
+
+        void absorb (
+            const space_saving_sketch& item
+        )
+        /*!
+            requires
+                - get_capacity() == item.get_capacity()
+            ensures
+                - Merges the counts in item into *this.  Afterwards *this summarizes the
+                  concatenation of both streams, in the sense of the guarantees listed at
+                  the top of this file.
+                - #get_total_count() == get_total_count() + item.get_total_count()
+                - #get_error_bound() <= max(get_error_bound(), get_min_count()) + 
+                                        max(item.get_error_bound(), item.get_min_count())
+        !*/
+        {
+            DLIB_CASSERT(get_capacity() == item.get_capacity(), "Invalid inputs were given to this function"
+                << "\n\t get_capacity():      " << get_capacity()
+                << "\n\t item.get_capacity(): " << item.get_capacity());
+
+            // A string missing from one of the sketches could have been seen up to
+            // get_min_count() times in that sketch's stream.  So we charge it that much,
+            // which keeps all the counts upper bounds.
+            const dlib::uint64 min1 = get_min_count();
+            const dlib::uint64 min2 = item.get_min_count();
+
+            std::vector<merge_entry> all;
+            all.reserve(words.size() + item.words.size());
+            for (unsigned long i = 0; i < words.size(); ++i)
+            {
+                merge_entry e;
+                e.word = words[i];
+                const unsigned long j = item.find(words[i], hashes[i]);
+                if (j != not_found)
+                {
+                    e.count = counts[i] + item.counts[j];
+                    e.error = errors[i] + item.errors[j];
+                }
+                else
+                {
+                    e.count = counts[i] + min2;
+                    e.error = errors[i] + min2;
+                }
+                all.push_back(e);
+            }
+            for (unsigned long j = 0; j < item.words.size(); ++j)
+            {
+                if (find(item.words[j], item.hashes[j]) != not_found)
+                    continue;
+                merge_entry e;
+                e.word = item.words[j];
+                e.count = item.counts[j] + min1;
+                e.error = item.errors[j] + min1;
+                all.push_back(e);
+            }
+
+            if (all.size() > capacity)
+            {
+                std::nth_element(all.begin(), all.begin()+capacity, all.end(), compare_merge_entry);
+                all.resize(capacity);
+            }
+
+            const dlib::uint64 new_total_count = total_count + item.total_count;
+            init(capacity);
+            for (unsigned long i = 0; i < all.size(); ++i)
+                add(all[i].word, hash(all[i].word), all[i].count, all[i].error);
+            total_count = new_total_count;
+        }
+
+        void swap (
+            space_saving_sketch& item
+        )
+        /*!
+            ensures
+                - swaps *this with item
+        !*/
+        {
+            std::swap(capacity, item.capacity);
+            std::swap(total_count, item.total_count);
+            std::swap(error_bound, item.error_bound);
+            words.swap(item.words);
+            hashes.swap(item.hashes);
+            counts.swap(item.counts);
+            errors.swap(item.errors);
+            heap.swap(item.heap);
+            heap_pos.swap(item.heap_pos);
+            table.swap(item.table);
+        }
+
+    private:
+
+        struct merge_entry
+        {
+            std::string word;
+            dlib::uint64 count;
+            dlib::uint64 error;
+        };
+
+        static bool compare_merge_entry (
+            const merge_entry& a,
+            const merge_entry& b
+        )
+        {
+            if (a.count != b.count)
+                return a.count > b.count;
+            return a.word < b.word;
+        }
+
+        static bool compare_count_then_word (
+            const std::pair<dlib::uint64, std::string>& a,
+            const std::pair<dlib::uint64, std::string>& b
+        )
+        {
+            if (a.first != b.first)
+                return a.first > b.first;
+            return a.second < b.second;
+        }
+
+        static dlib::uint32 hash (
+            const std::string& word
+        )
+        {
+            if (word.size() == 0)
+                return 0;
+            return dlib::murmur_hash3(&word[0], word.size());
+        }
+
+        void init (
+            unsigned long capacity_
+        )
+        {
+            capacity = capacity_;
+            total_count = 0;
+            error_bound = 0;
+            words.clear();
+            hashes.clear();
+            counts.clear();
+            errors.clear();
+            heap.clear();
+            heap_pos.clear();
+
+            // Keep the hash table at most half full so the linear probe runs stay short.
+            unsigned long table_size = 16;
+            while (table_size < 2*capacity)
+                table_size *= 2;
+            table.assign(table_size, 0);
+        }
+
+        void add (
+            const std::string& word,
+            dlib::uint32 h,
+            dlib::uint64 count,
+            dlib::uint64 error
+        )
+        {
+            const unsigned long slot = words.size();
+            words.push_back(word);
+            hashes.push_back(h);
+            counts.push_back(count);
+            errors.push_back(error);
+            heap.push_back(slot);
+            heap_pos.push_back(slot);
+            error_bound = std::max(error_bound, error);
+            table_insert(slot);
+            sift_up(heap.size()-1);
+        }
+
+        // ------------------------------------------------------------------------------------
+        // The hash table maps strings to their slot in words.  It uses linear probing and
+        // stores slot+1, so 0 marks an empty bucket.
+
+        static const unsigned long not_found = static_cast<unsigned long>(-1);
+
+        unsigned long find (
+            const std::string& word,
+            dlib::uint32 h
+        ) const
+        {
+            const unsigned long mask = table.size()-1;
+            for (unsigned long i = h&mask; table[i] != 0; i = (i+1)&mask)
+            {
+                const unsigned long slot = table[i]-1;
+                if (hashes[slot] == h && words[slot] == word)
+                    return slot;
+            }
+            return not_found;
+        }
+
+        void table_insert (
+            unsigned long slot
+        )
+        {
+            const unsigned long mask = table.size()-1;
+            unsigned long i = hashes[slot]&mask;
+            while (table[i] != 0)
+                i = (i+1)&mask;
+            table[i] = slot+1;
+        }
+
+        void table_remove (
+            unsigned long slot
+        )
+        {
+            const unsigned long mask = table.size()-1;
+            unsigned long i = hashes[slot]&mask;
+            while (table[i] != slot+1)
+                i = (i+1)&mask;
+
+            // Shift later members of the probe run back into the hole so that find()
+            // never stops early at an empty bucket.
+            unsigned long j = i;
+            while (true)
+            {
+                j = (j+1)&mask;
+                if (table[j] == 0)
+                    break;
+                const unsigned long k = hashes[table[j]-1]&mask;
+                if ((j > i && (k <= i || k > j)) || (j < i && (k <= i && k > j)))
+                {
+                    table[i] = table[j];
+                    i = j;
+                }
+            }
+            table[i] = 0;
+        }
+
+        // ------------------------------------------------------------------------------------
+        // heap is a binary min-heap of slots ordered by counts.  heap_pos[slot] is the
+        // position of slot within heap.
+
+        void swap_heap_entries (
+            unsigned long a,
+            unsigned long b
+        )
+        {
+            std::swap(heap[a], heap[b]);
+            heap_pos[heap[a]] = a;
+            heap_pos[heap[b]] = b;
+        }
+
+        void sift_up (
+            unsigned long i
+        )
+        {
+            while (i > 0)
+            {
+                const unsigned long parent = (i-1)/2;
+                if (counts[heap[parent]] <= counts[heap[i]])
+                    break;
+                swap_heap_entries(i, parent);
+                i = parent;
+            }
+        }
+
+        void sift_down (
+            unsigned long i
+        )
+        {
+            while (true)
+            {
+                const unsigned long left = 2*i+1;
+                const unsigned long right = left+1;
+                unsigned long smallest = i;
+                if (left < heap.size() && counts[heap[left]] < counts[heap[smallest]])
+                    smallest = left;
+                if (right < heap.size() && counts[heap[right]] < counts[heap[smallest]])
+                    smallest = right;
+                if (smallest == i)
+                    break;
+                swap_heap_entries(i, smallest);
+                i = smallest;
+            }
+        }
+
+        unsigned long capacity;
+        dlib::uint64 total_count;
+        dlib::uint64 error_bound;
+
+        std::vector<std::string> words;
+        std::vector<dlib::uint32> hashes;
+        std::vector<dlib::uint64> counts;
+        std::vector<dlib::uint64> errors;
+        std::vector<unsigned long> heap;
+        std::vector<unsigned long> heap_pos;
+        std::vector<dlib::uint32> table;
+    };
+
+    inline void swap (
+        space_saving_sketch& a,
+        space_saving_sketch& b
+    )
+    /*!
+        ensures
+            - swaps the state of a and b
+    !*/
+    {
+        a.swap(b);
+    }
+}
+
+#endif // MIT_LL_SpACE_SAVING_SKETCH_H_
+
@@ -0,0 +1,236 @@
+// Copyright (C) 2014 Massachusetts Institute of Technology, Lincoln Laboratory
+// License: Boost Software License   See LICENSE.txt for the full license.
+// Authors: Davis E. King (davis@dlib.net)
+#ifndef MIT_LL_STREAMING_NeR_H_
+#define MIT_LL_STREAMING_NeR_H_
+
+#include <string>
+#include <vector>
+#include <deque>
+#include <mitie/named_entity_extractor.h>
+#include <dlib/uintn.h>
+
+namespace mitie
+{
+
+// ----------------------------------------------------------------------------------------
+
+    struct streaming_entity
+    {
+        /*!
+            WHAT THIS OBJECT REPRESENTS
+                This object is a named entity found by a
+                streaming_named_entity_extractor.
+        !*/
+
+        streaming_entity() : begin(0), end(0), tag(0), score(0) {}
+
+        // The half open range of positions in the token stream that the entity covers.
+        // The first token ever given to the streaming_named_entity_extractor is at
+        // position 0.
+        dlib::uint64 begin;
+        dlib::uint64 end;
+        // The entity's label, an index into the named_entity_extractor's
+        // get_tag_name_strings().
+        unsigned long tag;
+        // The named_entity_extractor's confidence in the label.  > 0 means it's likely
+        // correct.
+        double score;
+        // The tokens in the entity, since the extractor doesn't keep old tokens around.
+        std::vector<std::string> tokens;
+    };
+
+// ----------------------------------------------------------------------------------------
+
+    const unsigned long default_streaming_window_size = 100;
+    const unsigned long default_streaming_overlap = 20;
+
+    class streaming_named_entity_extractor : dlib::noncopyable
+    {
+        /*!
+            WHAT THIS OBJECT REPRESENTS
+                This object finds the named entities in an unbounded stream of tokens,
+                like a log file, a chat transcript, or OCR output, where there are no
+                usable sentence boundaries.  You give it tokens one at a time and it
+                gives back entities once they are final.
+
+                Internally, it runs the named_entity_extractor's sequence_segmenter
+                over fixed size windows of get_window_size() tokens.  Each window
+                overlaps the previous one by get_overlap() tokens, so every token is
+                decoded with some context on both sides.  An entity is taken from the
+                window whose middle it's closest to, and an entity that runs into the
+                end of a window is left for the next window to find in full.  This
+                keeps both the memory this object uses and the number of tokens it
+                waits for before an entity is final bounded by get_window_size(),
+                however long the stream is.
+
+                This object doesn't use ner's gate (see named_entity_extractor::get_gate()),
+                so it never skips any tokens.  For a stream shorter than
+                get_window_size() tokens followed by a call to flush(), the entities are
+                the ones ner.predict() finds when given all the tokens at once, except
+                that predict() finds none at all in a sentence its gate skips.
+
+            THREAD SAFETY
+                This object holds a reference to the named_entity_extractor it was
+                created with, which must outlive it.  Any number of
+                streaming_named_entity_extractor objects may share one
+                named_entity_extractor, but each of them must only be used by one
+                thread at a time.
+        !*/
+
+    public:
+
+        streaming_named_entity_extractor (
+            const named_entity_extractor& ner,
+            unsigned long window_size = default_streaming_window_size,
+            unsigned long overlap = default_streaming_overlap
+        );
+        /*!
+            requires
+                - window_size > 0
+                - overlap < window_size
+            ensures
+                - #get_named_entity_extractor() == ner
+                - #get_window_size() == window_size
+                - #get_overlap() == overlap
+                - #get_num_tokens() == 0
+                - #get_finalized_position() == 0
+                - #num_ready_entities() == 0
+            throws
+                - dlib::error
+                    This exception is thrown if ner doesn't hold its
+                    total_word_feature_extractor, i.e. it's a pure model loaded without
+                    one.
+        !*/
+
+        const named_entity_extractor& get_named_entity_extractor (
+        ) const { return ner; }
+        /*!
+            ensures
+                - returns the named_entity_extractor this object runs.
+        !*/
+
+        void add_token (
+            const std::string& token
+        );
+        /*!
+            ensures
+                - Appends token to the end of the stream.
+                - #get_num_tokens() == get_num_tokens() + 1
+                - If this fills a window then the window is decoded, which may make more
+                  entities ready and advance get_finalized_position().
+        !*/
+
+        void flush (
+        );
+        /*!
+            ensures
+                - Treats the tokens given so far as the end of the stream.  That is,
+                  decodes the tokens that haven't been finalized yet and makes all their
+                  entities ready.
+                - #get_finalized_position() == get_num_tokens()
+                - You can keep adding tokens after calling flush(), but the tokens before
+                  the flush aren't used as context for the ones after it.  So calling
+                  flush() at the end of each document is a good way to keep entities
+                  from spanning documents.
+        !*/
+
+        unsigned long num_ready_entities (
+        ) const { return ready.size(); }
+        /*!
+            ensures
+                - returns the number of finalized entities waiting to be taken with
+                  next_entity().
+        !*/
+
+        bool next_entity (
+            streaming_entity& entity
+        );
+        /*!
+            ensures
+                - if (num_ready_entities() != 0) then
+                    - #entity == the oldest ready entity, which is removed from this
+                      object.
+                    - #num_ready_entities() == num_ready_entities() - 1
+                    - returns true
+                - else
+                    - returns false
+                - The entities come out in the order they appear in the stream and never
+                  overlap each other.
+        !*/
+
+        dlib::uint64 get_num_tokens (
+        ) const { return buffer_start + buffer.size(); }
+        /*!
+            ensures
+                - returns the number of tokens given to add_token().
+        !*/
+
+        dlib::uint64 get_finalized_position (
+        ) const { return committed; }
+        /*!
+            ensures
+                - returns the position in the stream up to which everything is final.
+                  That is, any entity that starts before this position is already ready,
+                  and any entity found later will start at or after it.
+                - get_num_tokens() - get_finalized_position() <= get_window_size()
+        !*/
+
+        unsigned long get_window_size (
+        ) const { return window_size; }
+        /*!
+            ensures
+                - returns the number of tokens in each window given to the
+                  sequence_segmenter.
+        !*/
+
+        unsigned long get_overlap (
+        ) const { return overlap; }
+        /*!
+            ensures
+                - returns the number of tokens each window shares with the one before
+                  it.
+        !*/
+
+        void clear (
+        );
+        /*!
+            ensures
+                - Throws away all the tokens and ready entities and starts a new stream.
+                - #get_num_tokens() == 0
+                - #get_finalized_position() == 0
+                - #num_ready_entities() == 0
+        !*/
+
+    private:
+
+        void process_window (
+            bool at_end
+        );
+
+        const named_entity_extractor& ner;
+        const total_word_feature_extractor& fe;
+        const dense_chunk_feature_extractor dense_fe;
+        const unsigned long window_size;
+        const unsigned long overlap;
+
+        // The tokens of the current window, starting at position buffer_start in the
+        // stream, along with their word feature vectors.  The vectors of the tokens a
+        // window shares with the previous one are kept rather than recomputed.
+        std::vector<std::string> buffer;
+        std::vector<float> buffer_feats;
+        dlib::uint64 buffer_start;
+        dlib::uint64 committed;
+        std::deque<streaming_entity> ready;
+
+        // Scratch space reused for each window.
+        sentence_features window_feats;
+        std::vector<std::pair<unsigned long,unsigned long> > chunks;
+    };
+
+// ----------------------------------------------------------------------------------------
+
+}
+
+#endif // MIT_LL_STREAMING_NeR_H_
+
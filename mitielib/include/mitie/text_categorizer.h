@@ -3,6 +3,7 @@
 #define MITIE_TexT_CATEGORIZER_H
 
 #include <mitie/total_word_feature_extractor.h>
+#include <mitie/hashing_ostream.h>
 #include <mitie/ner_feature_extraction.h>
 #include <dlib/svm.h>
 #include <dlib/vectorstream.h>
@@ -18,9 +19,9 @@ namespace mitie
                 pre-defined types.
 
             THREAD SAFETY
-                Note that this object uses mutable internal scratch space.  Therefore, it is
-                unsafe for two threads to touch the same instance of this object at a time
-                without mutex locking it first.
+                It is safe for multiple threads to make concurrent calls to the const
+                member functions of this object.  However, you must not modify an instance
+                of this object while other threads are using it.
         !*/
     public:
 
@@ -143,6 +144,23 @@ namespace mitie
                       while training this categorizer. For pure_model_version_1 and above,
                       an exception is thrown if there is a mismatch
         !*/
+
+        void predict(
+                const std::vector<std::string>& sentence,
+                string& text_tag,
+                double& text_score,
+                const total_word_feature_extractor& fe,
+                sentence_features& scratch
+        ) const;
+        /*!
+            ensures
+                - Does the same thing as predict(sentence, text_tag, text_score, fe),
+                  except it puts the word features of sentence into scratch rather than
+                  into a new object.  So a thread that categorizes many documents can
+                  reuse the same scratch object for all of them.  Each thread needs its
+                  own scratch object.
+        !*/
+
         string operator() (
                 const std::vector<std::string>& sentence
         ) const;
@@ -178,6 +196,20 @@ namespace mitie
                 - Returns a vector that maps text numeric ID tags into their string labels.
         !*/
 
+        memory_usage get_memory_usage (
+        ) const;
+        /*!
+            ensures
+                - returns a breakdown of the memory used by this object.  It has these
+                  components:
+                    - tag_strings: the strings in get_tag_name_strings().
+                    - classifier_weights: the weights of the classifier that picks the
+                      category.
+                    - feature_extractor.*: the components of the
+                      total_word_feature_extractor's breakdown.  These are all 0 for a
+                      pure model, since it doesn't hold a feature extractor.
+        !*/
+
         friend void serialize(const text_categorizer& item, std::ostream& out)
         {
             int version = 2;
@@ -214,14 +246,13 @@ namespace mitie
     private:
         void compute_fingerprint()
         {
-            std::vector<char> buf;
-            dlib::vectorstream sout(buf);
+            hashing_ostream sout;
             sout << "fingerprint";
             dlib::serialize(tag_name_strings, sout);
             serialize(tfe_fingerprint, sout);
             serialize(df, sout);
 
-            fingerprint = dlib::murmur_hash3_128bit(&buf[0], buf.size()).first;
+            fingerprint = sout.get_hash().first;
         }
         int pure_model_version;
         dlib::uint64 fingerprint;
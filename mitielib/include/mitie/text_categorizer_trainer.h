@@ -7,6 +7,7 @@
 #include <mitie/total_word_feature_extractor.h>
 #include <mitie/text_categorizer.h>
 #include <mitie/text_feature_extraction.h>
+#include <mitie/training_timer.h>
 #include <dlib/svm.h>
 #include <map>
 
@@ -128,6 +129,20 @@ namespace mitie
                   this object via add() calls and returns the result.
         !*/
 
+        text_categorizer train (
+            std::vector<training_phase>& phases
+        ) const;
+        /*!
+            requires
+                - size() > 0
+            ensures
+                - Does the same thing as train() and returns the result.
+                - #phases == a list of the phases of training, in the order they ran, along
+                  with how long each took.  That is, the feature extraction, each
+                  cross-validation run done while searching for a good C, and the final
+                  fit.
+        !*/
+
     private:
 
         unsigned long count_of_least_common_label (
@@ -136,6 +151,7 @@ namespace mitie
 
         typedef dlib::multiclass_linear_decision_function<dlib::sparse_linear_kernel<text_sample_type>,unsigned long> classifier_type;
         classifier_type train_text_categorizer_classifier (
+            std::vector<training_phase>& phases
         ) const;
 
         unsigned long get_label_id (
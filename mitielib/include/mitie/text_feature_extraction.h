@@ -18,7 +18,7 @@ namespace mitie
 
     text_sample_type extract_text_features (
         const std::vector<std::string>& words,
-        const std::vector<dlib::matrix<float,0,1> >& feats
+        const sentence_features& feats
     );
     /*!
         requires
@@ -44,7 +44,7 @@ namespace mitie
 // ----------------------------------------------------------------------------------------
     text_sample_type extract_combined_features (
             const std::vector<std::string>& words,
-            const std::vector<dlib::matrix<float,0,1> >& feats
+            const sentence_features& feats
     );
     /*!
         ensures
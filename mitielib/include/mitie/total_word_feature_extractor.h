@@ -5,10 +5,16 @@
 #define MIT_LL_TOTAL_WoRD_FEATURE_EXTRACTOR_H_
 
 #include <map>
+#include <set>
+#include <algorithm>
 #include "word_morphology_feature_extractor.h"
+#include "hashing_ostream.h"
+#include "sharded_lru_cache.h"
+#include "memory_usage.h"
 #include <dlib/statistics.h>
 #include <dlib/vectorstream.h>
 #include <dlib/hash.h>
+#include <dlib/smart_pointers_thread_safe.h>
 
 namespace mitie 
 {
@@ -25,10 +31,27 @@ namespace mitie
                 to descriptive feature vectors (generally created from some CCA based
                 distributional feature thing).
 
+                The table of word vectors is by far the biggest part of this object and
+                it is never modified once made.  So copies of this object share a single
+                table.  Moreover, all the total_word_feature_extractor objects in a
+                process that have the same fingerprint share a single table, no matter
+                how they were created or loaded.  For example, if you load a
+                named_entity_extractor, a text_categorizer, and a binary relation
+                detector trainer that were all made with the same
+                total_word_feature_extractor then only one copy of its word table stays
+                in memory.  A table is freed when the last object using it is destroyed.
+
+                Computing the vector of a word that isn't in the table means running the
+                word_morphology_feature_extractor, which is a lot slower than a table
+                lookup.  Since the same out of dictionary words (names, hashtags, product
+                codes, etc.) tend to show up over and over in a stream of text, you can
+                turn on a cache of the vectors of recently seen out of dictionary words
+                with set_oov_cache_capacity().  Copies of this object share its cache.
+
             THREAD SAFETY
-                Note that this object uses mutable internal scratch space.  Therefore, it is
-                unsafe for two threads to touch the same instance of this object at a time
-                without mutex locking it first.
+                It is safe for multiple threads to make concurrent calls to the const
+                member functions of this object.  However, you must not modify an instance
+                of this object while other threads are using it.
         !*/
 
         inline static std::string convert_numbers (
@@ -44,9 +67,53 @@ namespace mitie
             return str;
         }
 
+        inline static bool has_digits (
+            const std::string& str
+        )
+        {
+            for (unsigned long i = 0; i < str.size(); ++i)
+            {
+                if ('0' <= str[i] && str[i] <= '9')
+                    return true;
+            }
+            return false;
+        }
+
     public:
 
-        total_word_feature_extractor() : fingerprint(0), non_morph_feats(0) {}
+        total_word_feature_extractor(
+        ) : fingerprint(0), non_morph_feats(0), total_word_vectors(new word_table_type) {}
+
+        ~total_word_feature_extractor(
+        )
+        {
+            release_word_table();
+        }
+
+        total_word_feature_extractor& operator= (
+            const total_word_feature_extractor& item
+        )
+        {
+            // The copy takes our old table with it when it's destroyed, so the table
+            // doesn't stay in the registry after we stop using it.
+            total_word_feature_extractor(item).swap(*this);
+            return *this;
+        }
+
+        void swap (
+            total_word_feature_extractor& item
+        )
+        /*!
+            ensures
+                - swaps *this with item
+        !*/
+        {
+            std::swap(fingerprint, item.fingerprint);
+            std::swap(non_morph_feats, item.non_morph_feats);
+            total_word_vectors.swap(item.total_word_vectors);
+            morph_fe.swap(item.morph_fe);
+            oov_cache.swap(item.oov_cache);
+        }
 
         total_word_feature_extractor(
             const std::map<std::string, dlib::matrix<float,0,1> >& word_vectors,
@@ -79,15 +146,18 @@ namespace mitie
             const double scale = 1/rs_word.mean();
             // Now go though all the words again and compute the complete feature vectors for
             // each and store that into total_word_vectors.
+            word_table_type* table = new word_table_type;
+            total_word_vectors.reset(table);
             for (i = word_vectors.begin(); i != word_vectors.end(); ++i)
             {
                 morph_fe.get_feature_vector(i->first, feats);
-                total_word_vectors[i->first] = join_cols(join_cols(dlib::zeros_matrix<float>(1,1), scale*i->second), feats);
+                (*table)[i->first] = join_cols(join_cols(dlib::zeros_matrix<float>(1,1), scale*i->second), feats);
             }
 
 
             // finally, don't forget to set the fingerprint to something
             compute_fingerprint();
+            share_word_table();
         }
 
         dlib::uint64 get_fingerprint(
@@ -116,8 +186,8 @@ namespace mitie
         {
             const std::string word = convert_numbers(word_);
             std::map<std::string, dlib::matrix<float,0,1> >::const_iterator i;
-            i = total_word_vectors.find(word);
-            if (i != total_word_vectors.end())
+            i = total_word_vectors->find(word);
+            if (i != total_word_vectors->end())
             {
                 feats = i->second;
                 return;
@@ -129,11 +199,124 @@ namespace mitie
                 return;
             }
 
+            if (oov_cache && oov_cache->find(word, feats))
+                return;
+
+            dlib::matrix<float,0,1> temp;
             morph_fe.get_feature_vector(word, temp);
             feats = join_cols(dlib::zeros_matrix<float>(non_morph_feats,1), temp);
             // This is an indicator feature used to model the fact that this word is
             // outside our dictionary.
             feats(0) = 1;
+            if (oov_cache)
+                oov_cache->insert(word, feats);
+        }
+
+        void get_feature_vector(
+            const std::string& word_,
+            float* feats
+        ) const
+        /*!
+            requires
+                - feats points to an array of get_num_dimensions() floats.
+            ensures
+                - Stores the same vector the other get_feature_vector() would produce into
+                  feats[0] through feats[get_num_dimensions()-1].  This version doesn't
+                  allocate any memory for dictionary words that contain no digits, or for
+                  words found in the out of dictionary word cache.  Words with digits are
+                  copied so their digits can be replaced with #.
+        !*/
+        {
+            std::string converted;
+            const std::string& word = has_digits(word_) ? (converted = convert_numbers(word_)) : word_;
+            std::map<std::string, dlib::matrix<float,0,1> >::const_iterator i;
+            i = total_word_vectors->find(word);
+            if (i != total_word_vectors->end())
+            {
+                for (long j = 0; j < i->second.size(); ++j)
+                    feats[j] = i->second(j);
+                return;
+            }
+
+            if (get_num_dimensions() == 0)
+                return;
+
+            vector_copier copy_to_feats(feats);
+            if (oov_cache && oov_cache->visit(word, copy_to_feats))
+                return;
+
+            dlib::matrix<float,0,1> temp;
+            morph_fe.get_feature_vector(word, temp);
+            feats[0] = 1;
+            for (long j = 1; j < non_morph_feats; ++j)
+                feats[j] = 0;
+            for (long j = 0; j < temp.size(); ++j)
+                feats[non_morph_feats+j] = temp(j);
+            if (oov_cache)
+                oov_cache->insert(word, dlib::mat(feats, get_num_dimensions()));
+        }
+
+        void set_oov_cache_capacity (
+            unsigned long capacity
+        )
+        /*!
+            ensures
+                - #get_oov_cache_capacity() == capacity
+                - If capacity == 0 then the cache of out of dictionary word vectors is
+                  turned off.  Otherwise, get_feature_vector() keeps the vectors of up to
+                  capacity recently seen out of dictionary words so they don't need to be
+                  computed again.  The cache starts out empty.
+                - This object no longer shares a cache with any of its copies.
+        !*/
+        {
+            if (capacity == 0)
+                oov_cache.reset();
+            else
+                oov_cache.reset(new oov_cache_type(capacity));
+        }
+
+        unsigned long get_oov_cache_capacity (
+        ) const
+        /*!
+            ensures
+                - returns the maximum number of out of dictionary words whose vectors are
+                  cached.  0 means there is no cache.
+        !*/
+        {
+            return oov_cache ? oov_cache->get_capacity() : 0;
+        }
+
+        unsigned long get_oov_cache_size (
+        ) const
+        /*!
+            ensures
+                - returns the number of out of dictionary words whose vectors are
+                  currently cached.
+        !*/
+        {
+            return oov_cache ? oov_cache->size() : 0;
+        }
+
+        dlib::uint64 get_oov_cache_hits (
+        ) const
+        /*!
+            ensures
+                - returns the number of times get_feature_vector() found an out of
+                  dictionary word in the cache.
+        !*/
+        {
+            return oov_cache ? oov_cache->get_num_hits() : 0;
+        }
+
+        dlib::uint64 get_oov_cache_misses (
+        ) const
+        /*!
+            ensures
+                - returns the number of times get_feature_vector() had to compute the
+                  vector of an out of dictionary word while the cache was turned on.
+        !*/
+        {
+            return oov_cache ? oov_cache->get_num_misses() : 0;
         }
 
         unsigned long get_num_dimensions(
@@ -150,29 +333,126 @@ namespace mitie
         unsigned long get_num_words_in_dictionary (
         ) const
         {
-            return total_word_vectors.size();
+            return total_word_vectors->size();
+        }
+
+        bool is_in_dictionary (
+            const std::string& word
+        ) const
+        /*!
+            ensures
+                - returns true if word has its own vector in the dictionary, rather than
+                  one made from its morphology.  Digits are treated the same way
+                  get_feature_vector() treats them.  This is much cheaper than
+                  get_feature_vector().
+        !*/
+        {
+            return total_word_vectors->count(convert_numbers(word)) != 0;
+        }
+
+        memory_usage get_memory_usage (
+        ) const
+        /*!
+            ensures
+                - returns a breakdown of the memory used by this object.  It has these
+                  components:
+                    - word_table.keys: the words in the word table.
+                    - word_table.vectors: the word vectors in the word table.
+                    - word_table.map_nodes: the std::map nodes holding the words and
+                      their vectors.
+                    - morph_trans and substring_table.*: the parts of the
+                      word_morphology_feature_extractor.
+                    - oov_cache: the cache of out of dictionary word vectors.
+                - The word table is shared by every object with the same fingerprint (see
+                  the discussion above), but each one reports the whole table.  So don't
+                  add up the word_table components of models that came from the same
+                  total_word_feature_extractor.
+        !*/
+        {
+            memory_usage result;
+            dlib::uint64 key_bytes = 0, vector_bytes = 0;
+            word_table_type::const_iterator i;
+            for (i = total_word_vectors->begin(); i != total_word_vectors->end(); ++i)
+            {
+                key_bytes += sizeof(i->first) + heap_bytes(i->first);
+                vector_bytes += sizeof(i->second) + heap_bytes(i->second);
+            }
+            result.add("word_table.keys", key_bytes);
+            result.add("word_table.vectors", vector_bytes);
+            result.add("word_table.map_nodes", total_word_vectors->size()*(dlib::uint64)map_node_overhead);
+            result.add("", morph_fe.get_memory_usage());
+
+            // Each cached word is stored in an LRU list entry along with its vector and
+            // hash, and is pointed to from a bucket of the cache's hash table.  There is
+            // at least one bucket for each word the cache can hold.
+            const dlib::uint64 bytes_per_cached_word = list_node_overhead +
+                sizeof(std::string) + sizeof(dlib::matrix<float,0,1>) + sizeof(dlib::uint64) +
+                get_num_dimensions()*sizeof(float) + sizeof(void*);
+            result.add("oov_cache", get_oov_cache_size()*bytes_per_cached_word +
+                get_oov_cache_capacity()*(dlib::uint64)sizeof(std::vector<void*>));
+            return result;
         }
 
         std::vector<std::string> get_words_in_dictionary (
         ) const
         {
             std::vector<std::string> temp;
-            temp.reserve(total_word_vectors.size());
+            temp.reserve(total_word_vectors->size());
             std::map<std::string, dlib::matrix<float,0,1> >::const_iterator i;
-            for (i = total_word_vectors.begin(); i != total_word_vectors.end(); ++i)
+            for (i = total_word_vectors->begin(); i != total_word_vectors->end(); ++i)
             {
                 temp.push_back(i->first);
             }
             return temp;
         }
 
+        void prune_dictionary (
+            const std::set<std::string>& words_to_keep
+        )
+        /*!
+            ensures
+                - Removes from the dictionary every word that isn't in words_to_keep.
+                  Numbers are matched the same way get_feature_vector() matches them,
+                  that is, with their digits replaced by #.  The removed words are then
+                  treated like any other out of dictionary word, so their feature
+                  vectors come from the word morphology features alone.
+                - get_feature_vector() returns the same vectors as before for all the
+                  words in words_to_keep.
+                - #get_num_dimensions() == get_num_dimensions()
+                - #get_num_words_in_dictionary() <= get_num_words_in_dictionary()
+                - #get_fingerprint() is recomputed for the new dictionary.  So models
+                  trained with the original object must be rebuilt around the pruned one.
+        !*/
+        {
+            std::set<std::string> keep;
+            for (std::set<std::string>::const_iterator i = words_to_keep.begin(); i != words_to_keep.end(); ++i)
+                keep.insert(convert_numbers(*i));
+
+            // The word table may be shared with other objects so we make a new one.  It's
+            // owned by a smart pointer right away so it isn't leaked if an insert throws,
+            // and this object is left alone until the new table is complete.
+            dlib::shared_ptr_thread_safe<word_table_type> table(new word_table_type);
+            std::map<std::string, dlib::matrix<float,0,1> >::const_iterator i;
+            for (i = total_word_vectors->begin(); i != total_word_vectors->end(); ++i)
+            {
+                if (keep.count(i->first) != 0)
+                    table->insert(*i);
+            }
+            release_word_table();
+            total_word_vectors = table;
+            compute_fingerprint();
+            share_word_table();
+            // The removed words are now out of the dictionary, so start a new cache.
+            set_oov_cache_capacity(get_oov_cache_capacity());
+        }
+
         friend void serialize(const total_word_feature_extractor& item, std::ostream& out)
         {
             int version = 2;
             dlib::serialize(version, out);
             dlib::serialize(item.fingerprint, out);
             dlib::serialize(item.non_morph_feats, out);
-            dlib::serialize(item.total_word_vectors, out);
+            dlib::serialize(*item.total_word_vectors, out);
             serialize(item.morph_fe, out);
         }
 
@@ -182,36 +462,88 @@ namespace mitie
             dlib::deserialize(version, in);
             if (version != 2)
                 throw dlib::serialization_error("Unexpected version found while deserializing total_word_feature_extractor.");
-            dlib::deserialize(item.fingerprint, in);
-            dlib::deserialize(item.non_morph_feats, in);
-            dlib::deserialize(item.total_word_vectors, in);
-            deserialize(item.morph_fe, in);
+            // Load into temp so item is left untouched if the input is bad.
+            total_word_feature_extractor temp;
+            dlib::deserialize(temp.fingerprint, in);
+            dlib::deserialize(temp.non_morph_feats, in);
+            word_table_type* table = new word_table_type;
+            temp.total_word_vectors.reset(table);
+            dlib::deserialize(*table, in);
+            deserialize(temp.morph_fe, in);
+            temp.share_word_table();
+            temp.set_oov_cache_capacity(item.get_oov_cache_capacity());
+            item.swap(temp);
         }
 
     private:
 
+        typedef std::map<std::string, dlib::matrix<float,0,1> > word_table_type;
+
+        struct word_hasher
+        {
+            dlib::uint64 operator() (const std::string& word) const
+            {
+                return dlib::murmur_hash3(word.data(), word.size());
+            }
+        };
+        typedef sharded_lru_cache<std::string, dlib::matrix<float,0,1>, word_hasher> oov_cache_type;
+
+        struct vector_copier
+        {
+            vector_copier (float* dest_) : dest(dest_) {}
+            void operator() (const dlib::matrix<float,0,1>& vect) const
+            { std::copy(vect.begin(), vect.end(), dest); }
+            float* dest;
+        };
+
+        void share_word_table (
+        );
+        /*!
+            ensures
+                - If some other total_word_feature_extractor with the same fingerprint
+                  exists then #total_word_vectors is set to the table it uses and our
+                  current table is freed.  Otherwise our table is recorded as the table
+                  to use for our fingerprint.
+        !*/
+
+        void release_word_table (
+        );
+        /*!
+            ensures
+                - #total_word_vectors is empty.  If we were the last user of our table
+                  then it is freed.
+        !*/
+
         void compute_fingerprint()
         {
-            std::vector<char> buf;
-            dlib::vectorstream sout(buf);
+            hashing_ostream sout;
             sout << "fingerprint";
             dlib::serialize(non_morph_feats, sout);
-            dlib::serialize(total_word_vectors, sout);
+            dlib::serialize(*total_word_vectors, sout);
             serialize(morph_fe, sout);
 
-            fingerprint = dlib::murmur_hash3_128bit(&buf[0], buf.size()).first;
+            fingerprint = sout.get_hash().first;
         }
 
         dlib::uint64 fingerprint;
         long non_morph_feats;
-        std::map<std::string, dlib::matrix<float,0,1> > total_word_vectors;
+        dlib::shared_ptr_thread_safe<const word_table_type> total_word_vectors;
         word_morphology_feature_extractor morph_fe;
-
-        // This object does not logically contribute to the state of this object.  It is
-        // just here to avoid reallocating it over and over in get_feature_vector().
-        mutable dlib::matrix<float,0,1> temp;
+        dlib::shared_ptr_thread_safe<oov_cache_type> oov_cache;
     };
 
+    inline void swap (
+        total_word_feature_extractor& a,
+        total_word_feature_extractor& b
+    )
+    /*!
+        ensures
+            - swaps the state of a and b
+    !*/
+    {
+        a.swap(b);
+    }
+
 }
 
 #endif // MIT_LL_TOTAL_WoRD_FEATURE_EXTRACTOR_H_
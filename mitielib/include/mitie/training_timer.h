@@ -0,0 +1,108 @@
+// Copyright (C) 2014 Massachusetts Institute of Technology, Lincoln Laboratory
+// License: Boost Software License   See LICENSE.txt for the full license.
+// Authors: Davis E. King (davis@dlib.net)
+#ifndef MIT_LL_TRAINING_TiMER_H_
+#define MIT_LL_TRAINING_TiMER_H_
+
+#include <string>
+#include <vector>
+#include <dlib/misc_api.h>
+#include <dlib/noncopyable.h>
+
+namespace mitie
+{
+
+// ----------------------------------------------------------------------------------------
+
+    struct training_phase
+    {
+        /*!
+            WHAT THIS OBJECT REPRESENTS
+                This object records how long one phase of a training run took.  The
+                trainers in MITIE report a list of these from their train() routines so
+                you can see where the training time goes.
+        !*/
+
+        training_phase() : seconds(0) {}
+
+        // The name of the phase, e.g. "segmenter cross-validation".
+        std::string name;
+        // For phases that evaluate a set of training parameters, this is a description of
+        // those parameters, e.g. "C=20 loss=3".  Otherwise it's empty.
+        std::string params;
+        double seconds;
+    };
+
+// ----------------------------------------------------------------------------------------
+
+    class training_phase_timer : dlib::noncopyable
+    {
+        /*!
+            WHAT THIS OBJECT REPRESENTS
+                This is a tool for timing a block of code and adding the time to a list
+                of training_phase objects when the block ends.
+        !*/
+
+    public:
+
+        training_phase_timer (
+            std::vector<training_phase>& phases_,
+            const std::string& name,
+            const std::string& params = ""
+        ) : phases(phases_), start(ts.get_timestamp())
+        /*!
+            ensures
+                - When this object is destructed it adds a training_phase with the given
+                  name and params to phases.  Its seconds field is the time from when
+                  this object was constructed to when it was destructed.
+        !*/
+        {
+            phase.name = name;
+            phase.params = params;
+        }
+
+        ~training_phase_timer (
+        )
+        {
+            phase.seconds = (ts.get_timestamp() - start)/1e6;
+            phases.push_back(phase);
+        }
+
+    private:
+        std::vector<training_phase>& phases;
+        training_phase phase;
+        dlib::timestamper ts;
+        const dlib::uint64 start;
+    };
+
+// ----------------------------------------------------------------------------------------
+
+    template <
+        typename trainer_type,
+        typename sample_vector_type,
+        typename label_vector_type
+        >
+    typename trainer_type::trained_function_type timed_train (
+        std::vector<training_phase>& phases,
+        const std::string& name,
+        const trainer_type& trainer,
+        const sample_vector_type& samples,
+        const label_vector_type& labels
+    )
+    /*!
+        ensures
+            - returns trainer.train(samples, labels).
+            - adds a training_phase with the given name to phases that records how long
+              the training took.
+    !*/
+    {
+        training_phase_timer timer(phases, name);
+        return trainer.train(samples, labels);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+}
+
+#endif // MIT_LL_TRAINING_TiMER_H_
+
@@ -18,9 +18,9 @@ namespace mitie
                 morphological features of the word.
 
             THREAD SAFETY
-                Note that this object uses mutable internal scratch space.  Therefore, it is
-                unsafe for two threads to touch the same instance of this object at a time
-                without mutex locking it first.
+                It is safe for multiple threads to make concurrent calls to the const
+                member functions of this object.  However, you must not modify an instance
+                of this object while other threads are using it.
         !*/
 
     public:
@@ -64,6 +64,7 @@ namespace mitie
                 - #feats.size() == get_num_dimensions()
         !*/
         {
+            std::vector<dlib::uint16> hits;
             substrings.find_substrings(begin, end, hits);
             hits_to_vect(hits, feats);
         }
@@ -93,10 +94,37 @@ namespace mitie
                   iterator range.
         !*/
         {
+            std::vector<dlib::uint16> hits;
             substrings.find_substrings(word, hits);
             hits_to_vect(hits, feats);
         }
 
+        memory_usage get_memory_usage (
+        ) const
+        /*!
+            ensures
+                - returns a breakdown of the memory used by this object.  It has the
+                  morph_trans matrix and the substring table.
+        !*/
+        {
+            memory_usage result;
+            result.add("morph_trans", heap_bytes(morph_trans));
+            result.add("substring_table", substrings.get_memory_usage());
+            return result;
+        }
+
+        void swap (
+            word_morphology_feature_extractor& item
+        )
+        /*!
+            ensures
+                - swaps *this with item
+        !*/
+        {
+            substrings.swap(item.substrings);
+            morph_trans.swap(item.morph_trans);
+        }
+
         friend void serialize (const word_morphology_feature_extractor& item, std::ostream& out)
         {
             int version = 1;
@@ -149,11 +177,6 @@ namespace mitie
 
         approximate_substring_set substrings;
         dlib::matrix<float> morph_trans;
-
-        // This member doesn't logically contribute to the state of this object.  It is here
-        // only to avoid reallocating it over and over every time get_feature_vector() is
-        // called.
-        mutable std::vector<dlib::uint16> hits;
     };
 }
 
@@ -0,0 +1,236 @@
+// Copyright (C) 2014 Massachusetts Institute of Technology, Lincoln Laboratory
+// License: Boost Software License   See LICENSE.txt for the full license.
+// Authors: Davis E. King (davis@dlib.net)
+#ifndef MIT_LL_WORD_SIMILARITY_InDEX_H_
+#define MIT_LL_WORD_SIMILARITY_InDEX_H_
+
+#include <string>
+#include <vector>
+#include <mitie/total_word_feature_extractor.h>
+#include <dlib/matrix.h>
+#include <dlib/serialize.h>
+#include <dlib/uintn.h>
+
+namespace mitie
+{
+
+// ----------------------------------------------------------------------------------------
+
+    class word_similarity_index
+    {
+        /*!
+            WHAT THIS OBJECT REPRESENTS
+                This object finds the words in the dictionary of a
+                total_word_feature_extractor whose feature vectors are most similar, in
+                terms of cosine similarity, to some query vector.  It does this
+                approximately and very quickly.  For a dictionary of a few hundred
+                thousand words a query takes well under a millisecond and finds almost
+                all of the true nearest neighbors.
+
+                It works by building a hierarchical navigable small world graph over the
+                word vectors, as described in the paper Efficient and robust approximate
+                nearest neighbor search using Hierarchical Navigable Small World graphs
+                by Malkov and Yashunin.  Building the graph takes a while, so you
+                normally build it once and save it next to the
+                total_word_feature_extractor it was made from.
+
+            THREAD SAFETY
+                It is safe for multiple threads to make concurrent calls to the const
+                member functions of this object.  However, you must not modify an instance
+                of this object while other threads are using it.
+        !*/
+
+    public:
+
+        word_similarity_index (
+        );
+        /*!
+            ensures
+                - #size() == 0
+                - #get_num_dimensions() == 0
+                - #get_fingerprint() == 0
+                - #get_search_size() == 64
+        !*/
+
+        explicit word_similarity_index (
+            const total_word_feature_extractor& fe,
+            unsigned long max_links = 16,
+            unsigned long build_search_size = 100
+        );
+        /*!
+            requires
+                - max_links > 1
+                - build_search_size > 0
+            ensures
+                - Builds an index over all the words in fe's dictionary.
+                - #size() == fe.get_num_words_in_dictionary()
+                - #get_num_dimensions() == fe.get_num_dimensions()
+                - #get_fingerprint() == fe.get_fingerprint()
+                - #get_search_size() == 64
+                - max_links is the number of graph edges each word keeps and
+                  build_search_size is how many candidates are examined when picking
+                  them.  Bigger values give a more accurate index but make it slower to
+                  build and bigger.
+        !*/
+
+        unsigned long size (
+        ) const { return words.size(); }
+        /*!
+            ensures
+                - returns the number of words in this index.
+        !*/
+
+        unsigned long get_num_dimensions (
+        ) const { return num_dims; }
+        /*!
+            ensures
+                - returns the dimensionality of the vectors in this index.
+        !*/
+
+        dlib::uint64 get_fingerprint (
+        ) const { return fingerprint; }
+        /*!
+            ensures
+                - returns the fingerprint of the total_word_feature_extractor this index
+                  was built from.
+        !*/
+
+        void set_search_size (
+            unsigned long size
+        );
+        /*!
+            requires
+                - size > 0
+            ensures
+                - #get_search_size() == size
+        !*/
+
+        unsigned long get_search_size (
+        ) const { return search_size; }
+        /*!
+            ensures
+                - returns the number of candidate words examined by a query.  Queries
+                  always examine at least as many candidates as the number of results
+                  requested.  Bigger values make queries more accurate but slower.
+        !*/
+
+        void find_nearest_words (
+            const dlib::matrix<float,0,1>& query,
+            unsigned long k,
+            std::vector<std::pair<std::string,float> >& results
+        ) const;
+        /*!
+            requires
+                - query.size() == get_num_dimensions()
+            ensures
+                - #results == the (approximately) k words whose vectors have the largest
+                  cosine similarity with query, sorted with the most similar first.  Each
+                  element contains a word and its cosine similarity with query.
+                - #results.size() == min(k, size())
+        !*/
+
+        void find_similar_words (
+            const total_word_feature_extractor& fe,
+            const std::string& word,
+            unsigned long k,
+            std::vector<std::pair<std::string,float> >& results
+        ) const;
+        /*!
+            requires
+                - fe.get_fingerprint() == get_fingerprint()
+            ensures
+                - #results == the (approximately) k words most similar to the given word.
+                  This is the same as calling find_nearest_words() with the feature vector
+                  fe gives for word, except that word itself is left out of the results.
+                  word doesn't need to be in the dictionary.
+            throws
+                - dlib::error if fe.get_fingerprint() != get_fingerprint()
+        !*/
+
+        friend void serialize(const word_similarity_index& item, std::ostream& out)
+        {
+            int version = 1;
+            dlib::serialize(version, out);
+            dlib::serialize(item.fingerprint, out);
+            dlib::serialize(item.num_dims, out);
+            dlib::serialize(item.max_links, out);
+            dlib::serialize(item.search_size, out);
+            dlib::serialize(item.words, out);
+            dlib::serialize(item.vects, out);
+            dlib::serialize(item.links, out);
+            dlib::serialize(item.entry_point, out);
+        }
+
+        friend void deserialize(word_similarity_index& item, std::istream& in)
+        {
+            int version = 0;
+            dlib::deserialize(version, in);
+            if (version != 1)
+                throw dlib::serialization_error("Unexpected version found while deserializing word_similarity_index.");
+            dlib::deserialize(item.fingerprint, in);
+            dlib::deserialize(item.num_dims, in);
+            dlib::deserialize(item.max_links, in);
+            dlib::deserialize(item.search_size, in);
+            dlib::deserialize(item.words, in);
+            dlib::deserialize(item.vects, in);
+            dlib::deserialize(item.links, in);
+            dlib::deserialize(item.entry_point, in);
+        }
+
+    private:
+
+        typedef std::pair<float, dlib::uint32> candidate; // (distance, word ID)
+
+        float distance (
+            const float* a,
+            dlib::uint32 b
+        ) const;
+
+        void search_level (
+            const float* query,
+            std::vector<candidate>& entry_points,
+            unsigned long num_candidates,
+            unsigned long level,
+            std::vector<bool>& visited
+        ) const;
+
+        void select_links (
+            std::vector<candidate>& candidates,
+            unsigned long max_num
+        ) const;
+
+        void add_link (
+            dlib::uint32 from,
+            dlib::uint32 to,
+            unsigned long level
+        );
+
+        void search (
+            const float* query,
+            unsigned long k,
+            std::vector<candidate>& results
+        ) const;
+
+        const float* vect (
+            dlib::uint32 id
+        ) const { return &vects[id*num_dims]; }
+
+        dlib::uint64 fingerprint;
+        unsigned long num_dims;
+        unsigned long max_links;
+        unsigned long search_size;
+        std::vector<std::string> words;
+        // The unit length word vectors, one after another.
+        std::vector<float> vects;
+        // links[i][l] == the neighbors of word i at level l of the graph.  Each word is
+        // in levels 0 through links[i].size()-1.
+        std::vector<std::vector<std::vector<dlib::uint32> > > links;
+        dlib::uint32 entry_point;
+    };
+
+// ----------------------------------------------------------------------------------------
+
+}
+
+#endif // MIT_LL_WORD_SIMILARITY_InDEX_H_
+
@@ -60,6 +60,27 @@ _f.mitie_extract_entities.argtypes = ctypes.c_void_p, ctypes.c_void_p
 _f.mitie_extract_entities_with_extractor.restype = ctypes.c_void_p
 _f.mitie_extract_entities_with_extractor.argtypes = ctypes.c_void_p, ctypes.c_void_p, ctypes.c_void_p
 
+_f.mitie_extract_entities_with_cache.restype = ctypes.c_void_p
+_f.mitie_extract_entities_with_cache.argtypes = ctypes.c_void_p, ctypes.c_void_p, ctypes.c_void_p, ctypes.c_void_p
+
+_f.mitie_create_ner_result_cache.restype = ctypes.c_void_p
+_f.mitie_create_ner_result_cache.argtypes = ctypes.c_ulong,
+
+_f.mitie_ner_result_cache_size.restype = ctypes.c_ulong
+_f.mitie_ner_result_cache_size.argtypes = ctypes.c_void_p,
+
+_f.mitie_ner_result_cache_capacity.restype = ctypes.c_ulong
+_f.mitie_ner_result_cache_capacity.argtypes = ctypes.c_void_p,
+
+_f.mitie_ner_result_cache_num_hits.restype = ctypes.c_ulong
+_f.mitie_ner_result_cache_num_hits.argtypes = ctypes.c_void_p,
+
+_f.mitie_ner_result_cache_num_misses.restype = ctypes.c_ulong
+_f.mitie_ner_result_cache_num_misses.argtypes = ctypes.c_void_p,
+
+_f.mitie_ner_result_cache_clear.restype = None
+_f.mitie_ner_result_cache_clear.argtypes = ctypes.c_void_p,
+
 _f.mitie_check_ner_pure_model.restype = ctypes.c_int
 _f.mitie_check_ner_pure_model.argtypes = ctypes.c_char_p,
 
@@ -90,6 +111,69 @@ _f.mitie_ner_get_detection_score.argtypes = ctypes.c_void_p, ctypes.c_ulong
 _f.mitie_ner_get_num_detections.restype = ctypes.c_ulong
 _f.mitie_ner_get_num_detections.argtypes = ctypes.c_void_p,
 
+_f.mitie_extract_document_entities.restype = ctypes.c_void_p
+_f.mitie_extract_document_entities.argtypes = ctypes.c_void_p, ctypes.c_char_p, ctypes.c_ulong, ctypes.c_ulong
+
+_f.mitie_document_entities_size.restype = ctypes.c_ulong
+_f.mitie_document_entities_size.argtypes = ctypes.c_void_p,
+
+_f.mitie_document_entity_begin.restype = ctypes.c_ulong
+_f.mitie_document_entity_begin.argtypes = ctypes.c_void_p, ctypes.c_ulong
+
+_f.mitie_document_entity_end.restype = ctypes.c_ulong
+_f.mitie_document_entity_end.argtypes = ctypes.c_void_p, ctypes.c_ulong
+
+_f.mitie_document_entity_char_begin.restype = ctypes.c_ulong
+_f.mitie_document_entity_char_begin.argtypes = ctypes.c_void_p, ctypes.c_ulong
+
+_f.mitie_document_entity_char_end.restype = ctypes.c_ulong
+_f.mitie_document_entity_char_end.argtypes = ctypes.c_void_p, ctypes.c_ulong
+
+_f.mitie_document_entity_tagstr.restype = ctypes.c_char_p
+_f.mitie_document_entity_tagstr.argtypes = ctypes.c_void_p, ctypes.c_ulong
+
+_f.mitie_document_entity_score.restype = ctypes.c_double
+_f.mitie_document_entity_score.argtypes = ctypes.c_void_p, ctypes.c_ulong
+
+_f.mitie_create_streaming_ner.restype = ctypes.c_void_p
+_f.mitie_create_streaming_ner.argtypes = ctypes.c_void_p, ctypes.c_ulong, ctypes.c_ulong
+
+_f.mitie_streaming_ner_add_tokens.restype = ctypes.c_int
+_f.mitie_streaming_ner_add_tokens.argtypes = ctypes.c_void_p, ctypes.c_void_p
+
+_f.mitie_streaming_ner_flush.restype = ctypes.c_int
+_f.mitie_streaming_ner_flush.argtypes = ctypes.c_void_p,
+
+_f.mitie_streaming_ner_num_tokens.restype = ctypes.c_ulong
+_f.mitie_streaming_ner_num_tokens.argtypes = ctypes.c_void_p,
+
+_f.mitie_streaming_ner_finalized_position.restype = ctypes.c_ulong
+_f.mitie_streaming_ner_finalized_position.argtypes = ctypes.c_void_p,
+
+_f.mitie_streaming_ner_clear.restype = None
+_f.mitie_streaming_ner_clear.argtypes = ctypes.c_void_p,
+
+_f.mitie_streaming_ner_take_entities.restype = ctypes.c_void_p
+_f.mitie_streaming_ner_take_entities.argtypes = ctypes.c_void_p,
+
+_f.mitie_streaming_entities_size.restype = ctypes.c_ulong
+_f.mitie_streaming_entities_size.argtypes = ctypes.c_void_p,
+
+_f.mitie_streaming_entity_begin.restype = ctypes.c_ulong
+_f.mitie_streaming_entity_begin.argtypes = ctypes.c_void_p, ctypes.c_ulong
+
+_f.mitie_streaming_entity_end.restype = ctypes.c_ulong
+_f.mitie_streaming_entity_end.argtypes = ctypes.c_void_p, ctypes.c_ulong
+
+_f.mitie_streaming_entity_tagstr.restype = ctypes.c_char_p
+_f.mitie_streaming_entity_tagstr.argtypes = ctypes.c_void_p, ctypes.c_ulong
+
+_f.mitie_streaming_entity_score.restype = ctypes.c_double
+_f.mitie_streaming_entity_score.argtypes = ctypes.c_void_p, ctypes.c_ulong
+
+_f.mitie_streaming_entity_token.restype = ctypes.c_char_p
+_f.mitie_streaming_entity_token.argtypes = ctypes.c_void_p, ctypes.c_ulong, ctypes.c_ulong
+
 _f.mitie_entities_overlap.restype = ctypes.c_int
 _f.mitie_entities_overlap.argtypes = ctypes.c_ulong, ctypes.c_ulong, ctypes.c_ulong, ctypes.c_ulong
 
@@ -257,6 +341,12 @@ class named_entity_extractor:
         num = _f.mitie_get_num_possible_ner_tags(self.__obj)
         return [to_default_str_type(_f.mitie_get_named_entity_tagstr(self.__obj, i)) for i in xrange(num)]
 
+    def get_memory_usage(self):
+        """Returns a dict mapping the name of each part of this model, like
+        "segmenter_weights", to the number of bytes of memory it uses.  See
+        mitie_get_named_entity_extractor_memory_usage() in mitie.h for details."""
+        return _memory_usage_to_dict(_f.mitie_get_named_entity_extractor_memory_usage(self.__obj))
+
     def save_to_disk(self, filename, pure_model=False):
         """Save this object to disk.  You recall it from disk with the following Python
         code: 
@@ -274,10 +364,18 @@ class named_entity_extractor:
             if (_f.mitie_save_named_entity_extractor(filename, self.__obj) != 0):
                 raise Exception("Unable to save named_entity_extractor to the file " + to_default_str_type(filename));
 
-    def extract_entities(self, tokens, feature_extractor=None):
+    def extract_entities(self, tokens, feature_extractor=None, cache=None):
+        """If you give a ner_result_cache then the entities of sentences that are
+        already in the cache are returned without running this extractor again.
+        """
         tags = self.get_possible_ner_tags()
         # Now extract the entities and return the results
-        if(feature_extractor is not None and isinstance(feature_extractor, total_word_feature_extractor)):
+        if cache is not None:
+            fe = None
+            if(feature_extractor is not None and isinstance(feature_extractor, total_word_feature_extractor)):
+                fe = feature_extractor._obj
+            dets = _f.mitie_extract_entities_with_cache(self.__obj, python_to_mitie_str_array(tokens), cache._obj, fe)
+        elif(feature_extractor is not None and isinstance(feature_extractor, total_word_feature_extractor)):
             dets = _f.mitie_extract_entities_with_extractor(self.__obj, python_to_mitie_str_array(tokens), feature_extractor._obj)
         else:
             dets = _f.mitie_extract_entities(self.__obj, python_to_mitie_str_array(tokens))
@@ -292,6 +390,31 @@ class named_entity_extractor:
         _f.mitie_free(dets)
         return temp
 
+    def extract_document_entities(self, text, max_sentence_length=100, num_threads=1):
+        """Finds the named entities in a whole document.  text doesn't need to be
+        tokenized or split into sentences, this function does both for you.  It
+        returns a list of tuples, each containing an xrange with the position of the
+        entity in text, the entity tag, and a score.  So text[min(r):max(r)+1] is the
+        text of an entity with range r.  If text is a unicode string then the ranges
+        count characters, otherwise they count bytes.  If num_threads > 1 then that
+        many threads are used to process the sentences.
+        """
+        unicode_offsets = not isinstance(text, bytes)
+        dets = _f.mitie_extract_document_entities(self.__obj, to_bytes(text), max_sentence_length, num_threads)
+        if dets is None:
+            raise Exception("Unable to create entity detections.")
+        if unicode_offsets:
+            begin, end = _f.mitie_document_entity_char_begin, _f.mitie_document_entity_char_end
+        else:
+            begin, end = _f.mitie_document_entity_begin, _f.mitie_document_entity_end
+        num = _f.mitie_document_entities_size(dets)
+        temp = [(xrange(begin(dets, i), end(dets, i)),
+                 to_default_str_type(_f.mitie_document_entity_tagstr(dets, i)),
+                 _f.mitie_document_entity_score(dets, i)
+                 ) for i in xrange(num)]
+        _f.mitie_free(dets)
+        return temp
+
     def extract_binary_relation(self, tokens, arg1, arg2):
         """
         requires
@@ -321,6 +444,118 @@ class named_entity_extractor:
         return binary_relation(rel)
 
 
+class ner_result_cache:
+    """Remembers the entities found in up to capacity sentences so that repeated
+    sentences, like boilerplate text, aren't processed again.  Pass it to
+    named_entity_extractor.extract_entities().  One cache can be shared by several
+    named_entity_extractors and by multiple threads.
+    """
+    def __init__(self, capacity=10000):
+        self.__mitie_free = _f.mitie_free
+        self.__obj = _f.mitie_create_ner_result_cache(capacity)
+        if self.__obj is None:
+            raise Exception("Unable to create ner_result_cache.")
+
+    def __del__(self):
+        self.__mitie_free(self.__obj)
+
+    @property
+    def _obj(self):
+        return self.__obj
+
+    @property
+    def capacity(self):
+        return _f.mitie_ner_result_cache_capacity(self.__obj)
+
+    @property
+    def num_hits(self):
+        return _f.mitie_ner_result_cache_num_hits(self.__obj)
+
+    @property
+    def num_misses(self):
+        return _f.mitie_ner_result_cache_num_misses(self.__obj)
+
+    def __len__(self):
+        return _f.mitie_ner_result_cache_size(self.__obj)
+
+    def clear(self):
+        _f.mitie_ner_result_cache_clear(self.__obj)
+
+
+class streaming_named_entity_extractor:
+    """Finds the named entities in an unbounded stream of tokens, like a log file or
+    a chat transcript, that has no usable sentence boundaries.  ner is run over
+    windows of window_size tokens, each sharing overlap tokens with the one before
+    it, so at most window_size tokens are held in memory and an entity is reported
+    at most window_size tokens after it starts.  ner must not be a pure model loaded
+    without its total_word_feature_extractor.
+    """
+    def __init__(self, ner, window_size=100, overlap=20):
+        self.__mitie_free = _f.mitie_free
+        self.__obj = None
+        if window_size == 0 or overlap >= window_size:
+            raise Exception("window_size must be > 0 and overlap must be less than window_size.")
+        # Keep ner alive for as long as the stream refers to it.
+        self.__ner = ner
+        self.__obj = _f.mitie_create_streaming_ner(ner._obj, window_size, overlap)
+        if self.__obj is None:
+            raise Exception("Unable to create streaming_named_entity_extractor.")
+
+    def __del__(self):
+        self.__mitie_free(self.__obj)
+
+    @property
+    def num_tokens(self):
+        """The number of tokens added to the stream so far."""
+        return _f.mitie_streaming_ner_num_tokens(self.__obj)
+
+    @property
+    def finalized_position(self):
+        """Every entity that starts before this position in the stream has already
+        been returned."""
+        return _f.mitie_streaming_ner_finalized_position(self.__obj)
+
+    def add_tokens(self, tokens):
+        """Appends tokens to the end of the stream and returns the entities that
+        became final because of them.  Each entity is a tuple containing an xrange
+        with its position in the stream, its tag, its score, and a list of its
+        tokens.  The first token ever added is at position 0.
+        """
+        if _f.mitie_streaming_ner_add_tokens(self.__obj, python_to_mitie_str_array(tokens)) != 0:
+            raise Exception("Unable to add tokens to the stream.")
+        return self.__take_entities()
+
+    def flush(self):
+        """Treats the tokens added so far as the end of the stream and returns all the
+        remaining entities in the same format as add_tokens().  You can keep adding
+        tokens afterward, but they won't use the tokens before the flush as context,
+        so it's a good idea to call this at the end of each document.
+        """
+        if _f.mitie_streaming_ner_flush(self.__obj) != 0:
+            raise Exception("Unable to flush the stream.")
+        return self.__take_entities()
+
+    def clear(self):
+        """Throws away everything in the stream and starts over at position 0."""
+        _f.mitie_streaming_ner_clear(self.__obj)
+
+    def __take_entities(self):
+        ents = _f.mitie_streaming_ner_take_entities(self.__obj)
+        if ents is None:
+            raise Exception("Unable to create entity detections.")
+        temp = []
+        for i in xrange(_f.mitie_streaming_entities_size(ents)):
+            begin = _f.mitie_streaming_entity_begin(ents, i)
+            end = _f.mitie_streaming_entity_end(ents, i)
+            temp.append((xrange(begin, end),
+                         to_default_str_type(_f.mitie_streaming_entity_tagstr(ents, i)),
+                         _f.mitie_streaming_entity_score(ents, i),
+                         [to_default_str_type(_f.mitie_streaming_entity_token(ents, i, j))
+                          for j in xrange(end - begin)]))
+        _f.mitie_free(ents)
+        return temp
+
+
 ####################################################################################################
 
 _f.mitie_load_binary_relation_detector.restype = ctypes.c_void_p
@@ -385,6 +620,12 @@ class binary_relation_detector:
     @property
     def name_string(self):
         return to_default_str_type(_f.mitie_binary_relation_detector_name_string(self.__obj))
+
+    def get_memory_usage(self):
+        """Returns a dict mapping the name of each part of this model, like
+        "classifier_weights", to the number of bytes of memory it uses.  See
+        mitie_get_binary_relation_detector_memory_usage() in mitie.h for details."""
+        return _memory_usage_to_dict(_f.mitie_get_binary_relation_detector_memory_usage(self.__obj))
     
     def __call__(self, relation):
         """Classify a relation object.  The input should have been produced by 
@@ -419,6 +660,12 @@ _f.mitie_ner_trainer_get_beta.argtypes = ctypes.c_void_p,
 _f.mitie_ner_trainer_get_num_threads.restype = ctypes.c_ulong
 _f.mitie_ner_trainer_get_num_threads.argtypes = ctypes.c_void_p,
 
+_f.mitie_ner_trainer_get_gate_target_recall.restype = ctypes.c_double
+_f.mitie_ner_trainer_get_gate_target_recall.argtypes = ctypes.c_void_p,
+
+_f.mitie_ner_trainer_set_gate_target_recall.restype = None
+_f.mitie_ner_trainer_set_gate_target_recall.argtypes = ctypes.c_void_p, ctypes.c_double
+
 _f.mitie_ner_trainer_set_beta.restype = None
 _f.mitie_ner_trainer_set_beta.argtypes = ctypes.c_void_p, ctypes.c_double
 
@@ -508,6 +755,19 @@ class ner_trainer(object):
         if value < 0:
             raise Exception("Invalid beta value given.  beta can't be negative.")
         _f.mitie_ner_trainer_set_beta(self.__obj, value)
+
+    @property
+    def gate_target_recall(self):
+        """The fraction of the training entities the sentence gate trained along with
+        the model should let through.  The gate lets the model skip sentences that are
+        unlikely to contain entities.  0, the default, means no gate is trained."""
+        return _f.mitie_ner_trainer_get_gate_target_recall(self.__obj)
+
+    @gate_target_recall.setter
+    def gate_target_recall(self, value):
+        if value < 0 or value > 1:
+            raise Exception("Invalid gate_target_recall value given.  It must be between 0 and 1.")
+        _f.mitie_ner_trainer_set_gate_target_recall(self.__obj, value)
     
     @property
     def num_threads(self):
@@ -736,6 +996,12 @@ class text_categorizer:
             if (_f.mitie_save_text_categorizer(filename, self.__obj) != 0):
                 raise Exception("Unable to save text_categorizer to the file " + to_default_str_type(filename));
 
+    def get_memory_usage(self):
+        """Returns a dict mapping the name of each part of this model, like
+        "classifier_weights", to the number of bytes of memory it uses.  See
+        mitie_get_text_categorizer_memory_usage() in mitie.h for details."""
+        return _memory_usage_to_dict(_f.mitie_get_text_categorizer_memory_usage(self.__obj))
+
     def __call__(self, tokens, feature_extractor=None):
         """Categorise a piece of text. The input tokens should have been produced by 
         something like tokenize().  This function returns a predicted label and a confidence score."""
@@ -848,6 +1114,12 @@ class total_word_feature_extractor:
     def num_words_in_dictionary(self):
         return _f.mitie_total_word_feature_extractor_num_words_in_dictionary(self.__obj)
 
+    def get_memory_usage(self):
+        """Returns a dict mapping the name of each part of this model, like
+        "word_table.vectors", to the number of bytes of memory it uses.  See
+        mitie_get_total_word_feature_extractor_memory_usage() in mitie.h for details."""
+        return _memory_usage_to_dict(_f.mitie_get_total_word_feature_extractor_memory_usage(self.__obj))
+
     def get_feature_vector(self, word):
 
         word = to_bytes(word)
@@ -879,3 +1151,425 @@ class total_word_feature_extractor:
             i += 1
         _f.mitie_free(words)
         return res
+
+##############################################################################
+
+_f.mitie_create_word_similarity_index.restype = ctypes.c_void_p
+_f.mitie_create_word_similarity_index.argtypes = ctypes.c_void_p,
+
+_f.mitie_load_word_similarity_index.restype = ctypes.c_void_p
+_f.mitie_load_word_similarity_index.argtypes = ctypes.c_char_p,
+
+_f.mitie_save_word_similarity_index.restype = ctypes.c_int
+_f.mitie_save_word_similarity_index.argtypes = ctypes.c_char_p, ctypes.c_void_p
+
+_f.mitie_word_similarity_index_fingerprint.restype = ctypes.c_ulong
+_f.mitie_word_similarity_index_fingerprint.argtypes = ctypes.c_void_p,
+
+_f.mitie_word_similarity_index_num_dimensions.restype = ctypes.c_ulong
+_f.mitie_word_similarity_index_num_dimensions.argtypes = ctypes.c_void_p,
+
+_f.mitie_find_similar_words.restype = ctypes.c_void_p
+_f.mitie_find_similar_words.argtypes = ctypes.c_void_p, ctypes.c_void_p, ctypes.c_char_p, ctypes.c_ulong
+
+_f.mitie_find_nearest_words.restype = ctypes.c_void_p
+_f.mitie_find_nearest_words.argtypes = ctypes.c_void_p, ctypes.POINTER(ctypes.c_float), ctypes.c_ulong
+
+_f.mitie_similar_words_size.restype = ctypes.c_ulong
+_f.mitie_similar_words_size.argtypes = ctypes.c_void_p,
+
+_f.mitie_similar_words_get_word.restype = ctypes.c_char_p
+_f.mitie_similar_words_get_word.argtypes = ctypes.c_void_p, ctypes.c_ulong
+
+_f.mitie_similar_words_get_similarity.restype = ctypes.c_double
+_f.mitie_similar_words_get_similarity.argtypes = ctypes.c_void_p, ctypes.c_ulong
+
+
+def _similar_words_to_list(words):
+    if words is None:
+        raise Exception("Unable to find similar words.")
+    res = [(to_default_str_type(_f.mitie_similar_words_get_word(words, i)),
+            _f.mitie_similar_words_get_similarity(words, i))
+           for i in xrange(_f.mitie_similar_words_size(words))]
+    _f.mitie_free(words)
+    return res
+
+
+class word_similarity_index:
+    """Quickly finds the words in the dictionary of a total_word_feature_extractor that
+    are most similar to a word or vector.  You create one either from a
+    total_word_feature_extractor, which takes a while for big dictionaries, or by
+    loading one that was saved with save_to_disk()."""
+    def __init__(self, source):
+        self.__mitie_free = _f.mitie_free
+        if isinstance(source, total_word_feature_extractor):
+            self.__obj = _f.mitie_create_word_similarity_index(source._obj)
+            if self.__obj is None:
+                raise Exception("Unable to create word_similarity_index.")
+        else:
+            source = to_bytes(source)
+            self.__obj = _f.mitie_load_word_similarity_index(source)
+            if self.__obj is None:
+                raise Exception("Unable to load word_similarity_index from " + to_default_str_type(source))
+
+    def __del__(self):
+        self.__mitie_free(self.__obj)
+
+    @property
+    def fingerprint(self):
+        """The fingerprint of the total_word_feature_extractor this index was built from."""
+        return _f.mitie_word_similarity_index_fingerprint(self.__obj)
+
+    @property
+    def num_dimensions(self):
+        return _f.mitie_word_similarity_index_num_dimensions(self.__obj)
+
+    def save_to_disk(self, filename):
+        filename = to_bytes(filename)
+        if _f.mitie_save_word_similarity_index(filename, self.__obj) != 0:
+            raise Exception("Unable to save word_similarity_index to the file " + to_default_str_type(filename))
+
+    def find_similar_words(self, feature_extractor, word, k=10):
+        """Returns a list of (word, cosine similarity) pairs for the k dictionary words
+        most similar to word, most similar first.  word itself is not included.
+        feature_extractor must be the total_word_feature_extractor this index was built
+        from."""
+        words = _f.mitie_find_similar_words(self.__obj, feature_extractor._obj, to_bytes(word), k)
+        return _similar_words_to_list(words)
+
+    def find_nearest_words(self, vector, k=10):
+        """Returns a list of (word, cosine similarity) pairs for the k dictionary words
+        whose vectors are most similar to vector, most similar first."""
+        if len(vector) != self.num_dimensions:
+            raise Exception("The vector must have " + str(self.num_dimensions) + " dimensions.")
+        vect = (ctypes.c_float*len(vector))(*vector)
+        words = _f.mitie_find_nearest_words(self.__obj, vect, k)
+        return _similar_words_to_list(words)
+
+##############################################################################
+
+_f.mitie_set_pipeline_stats_enabled.restype = None
+_f.mitie_set_pipeline_stats_enabled.argtypes = ctypes.c_int,
+
+_f.mitie_pipeline_stats_enabled.restype = ctypes.c_int
+_f.mitie_pipeline_stats_enabled.argtypes = ()
+
+_f.mitie_reset_pipeline_stats.restype = None
+_f.mitie_reset_pipeline_stats.argtypes = ()
+
+_f.mitie_get_pipeline_stats.restype = ctypes.c_void_p
+_f.mitie_get_pipeline_stats.argtypes = ()
+
+_f.mitie_pipeline_stats_num_stages.restype = ctypes.c_ulong
+_f.mitie_pipeline_stats_num_stages.argtypes = ctypes.c_void_p,
+
+_f.mitie_pipeline_stats_stage_name.restype = ctypes.c_char_p
+_f.mitie_pipeline_stats_stage_name.argtypes = ctypes.c_void_p, ctypes.c_ulong
+
+_f.mitie_pipeline_stats_stage_count.restype = ctypes.c_ulong
+_f.mitie_pipeline_stats_stage_count.argtypes = ctypes.c_void_p, ctypes.c_ulong
+
+_f.mitie_pipeline_stats_stage_total_seconds.restype = ctypes.c_double
+_f.mitie_pipeline_stats_stage_total_seconds.argtypes = ctypes.c_void_p, ctypes.c_ulong
+
+_f.mitie_pipeline_stats_stage_max_seconds.restype = ctypes.c_double
+_f.mitie_pipeline_stats_stage_max_seconds.argtypes = ctypes.c_void_p, ctypes.c_ulong
+
+_f.mitie_pipeline_stats_stage_percentile_seconds.restype = ctypes.c_double
+_f.mitie_pipeline_stats_stage_percentile_seconds.argtypes = ctypes.c_void_p, ctypes.c_ulong, ctypes.c_double
+
+_f.mitie_pipeline_stats_num_histogram_buckets.restype = ctypes.c_ulong
+_f.mitie_pipeline_stats_num_histogram_buckets.argtypes = ctypes.c_void_p,
+
+_f.mitie_pipeline_stats_stage_histogram.restype = ctypes.c_ulong
+_f.mitie_pipeline_stats_stage_histogram.argtypes = ctypes.c_void_p, ctypes.c_ulong, ctypes.c_ulong
+
+_f.mitie_pipeline_stats_num_counters.restype = ctypes.c_ulong
+_f.mitie_pipeline_stats_num_counters.argtypes = ctypes.c_void_p,
+
+_f.mitie_pipeline_stats_counter_name.restype = ctypes.c_char_p
+_f.mitie_pipeline_stats_counter_name.argtypes = ctypes.c_void_p, ctypes.c_ulong
+
+_f.mitie_pipeline_stats_counter_value.restype = ctypes.c_ulong
+_f.mitie_pipeline_stats_counter_value.argtypes = ctypes.c_void_p, ctypes.c_ulong
+
+
+def set_pipeline_stats_enabled(enabled):
+    """Turns on or off the recording of how long each stage of MITIE's tokenizer,
+    named_entity_extractor, text_categorizer, and binary relation extraction takes.
+    It's off by default."""
+    _f.mitie_set_pipeline_stats_enabled(1 if enabled else 0)
+
+
+def pipeline_stats_enabled():
+    return _f.mitie_pipeline_stats_enabled() != 0
+
+
+def reset_pipeline_stats():
+    _f.mitie_reset_pipeline_stats()
+
+
+def get_pipeline_stats():
+    """Returns a dict with two entries.  "stages" maps the name of each pipeline stage
+    to a dict with its call count, total and max seconds, p50 and p99 latency in
+    seconds, and latency histogram.  Bucket i of the histogram counts the calls that
+    took between 2**i and 2**(i+1) nanoseconds.  "counters" maps the name of each
+    counter, like "ner.oov_tokens", to its value."""
+    stats = _f.mitie_get_pipeline_stats()
+    if stats is None:
+        raise Exception("Unable to get pipeline statistics.")
+    try:
+        num_buckets = _f.mitie_pipeline_stats_num_histogram_buckets(stats)
+        stages = {}
+        for i in xrange(_f.mitie_pipeline_stats_num_stages(stats)):
+            stages[to_default_str_type(_f.mitie_pipeline_stats_stage_name(stats, i))] = {
+                "count": _f.mitie_pipeline_stats_stage_count(stats, i),
+                "total_seconds": _f.mitie_pipeline_stats_stage_total_seconds(stats, i),
+                "max_seconds": _f.mitie_pipeline_stats_stage_max_seconds(stats, i),
+                "p50_seconds": _f.mitie_pipeline_stats_stage_percentile_seconds(stats, i, 0.5),
+                "p99_seconds": _f.mitie_pipeline_stats_stage_percentile_seconds(stats, i, 0.99),
+                "histogram": [_f.mitie_pipeline_stats_stage_histogram(stats, i, b) for b in xrange(num_buckets)]}
+        counters = {}
+        for i in xrange(_f.mitie_pipeline_stats_num_counters(stats)):
+            counters[to_default_str_type(_f.mitie_pipeline_stats_counter_name(stats, i))] = \
+                _f.mitie_pipeline_stats_counter_value(stats, i)
+        return {"stages": stages, "counters": counters}
+    finally:
+        _f.mitie_free(stats)
+
+##############################################################################
+
+_f.mitie_get_named_entity_extractor_memory_usage.restype = ctypes.c_void_p
+_f.mitie_get_named_entity_extractor_memory_usage.argtypes = ctypes.c_void_p,
+
+_f.mitie_get_text_categorizer_memory_usage.restype = ctypes.c_void_p
+_f.mitie_get_text_categorizer_memory_usage.argtypes = ctypes.c_void_p,
+
+_f.mitie_get_binary_relation_detector_memory_usage.restype = ctypes.c_void_p
+_f.mitie_get_binary_relation_detector_memory_usage.argtypes = ctypes.c_void_p,
+
+_f.mitie_get_total_word_feature_extractor_memory_usage.restype = ctypes.c_void_p
+_f.mitie_get_total_word_feature_extractor_memory_usage.argtypes = ctypes.c_void_p,
+
+_f.mitie_memory_usage_num_components.restype = ctypes.c_ulong
+_f.mitie_memory_usage_num_components.argtypes = ctypes.c_void_p,
+
+_f.mitie_memory_usage_component_name.restype = ctypes.c_char_p
+_f.mitie_memory_usage_component_name.argtypes = ctypes.c_void_p, ctypes.c_ulong
+
+_f.mitie_memory_usage_component_bytes.restype = ctypes.c_ulong
+_f.mitie_memory_usage_component_bytes.argtypes = ctypes.c_void_p, ctypes.c_ulong
+
+
+def _memory_usage_to_dict(usage):
+    if usage is None:
+        raise Exception("Unable to get memory usage.")
+    try:
+        result = {}
+        for i in xrange(_f.mitie_memory_usage_num_components(usage)):
+            result[to_default_str_type(_f.mitie_memory_usage_component_name(usage, i))] = \
+                _f.mitie_memory_usage_component_bytes(usage, i)
+        return result
+    finally:
+        _f.mitie_free(usage)
+
+##############################################################################
+
+import socket
+import struct
+
+# These must match tools/mitie_serverd/client/mitie_server_protocol.h
+_SERVER_SOCKET_NAME = "mitie_serverd.sock"
+_SERVER_FALLBACK_DIR = "/tmp/mitie_serverd-"
+_SERVER_PING = 0
+_SERVER_LIST_MODELS = 1
+_SERVER_EXTRACT_ENTITIES = 2
+_SERVER_CATEGORIZE = 3
+_SERVER_SCORE_RELATIONS = 4
+_SERVER_MAX_FRAME_SIZE = 64*1024*1024
+_SERVER_MODEL_TYPES = {1: "ner", 2: "categorizer", 3: "relation"}
+
+
+def _server_string(string):
+    string = to_bytes(string)
+    return struct.pack(">I", len(string)) + string
+
+
+def _server_tokens(tokens):
+    parts = [struct.pack(">I", len(tokens))]
+    for t in tokens:
+        if isinstance(t, tuple):
+            t = t[0]
+        parts.append(_server_string(t))
+    return b"".join(parts)
+
+
+def mitie_server_default_socket():
+    """Returns the path of the socket mitie_serverd listens on when it isn't given one.
+    It's in $XDG_RUNTIME_DIR, or in /tmp/mitie_serverd-<uid> if that isn't set."""
+    runtime_dir = os.environ.get("XDG_RUNTIME_DIR", "")
+    if runtime_dir.startswith("/"):
+        return runtime_dir + "/" + _SERVER_SOCKET_NAME
+    return _SERVER_FALLBACK_DIR + str(os.getuid()) + "/" + _SERVER_SOCKET_NAME
+
+
+class _server_reader(object):
+    def __init__(self, data):
+        self.data = data
+        self.pos = 0
+
+    def read(self, fmt):
+        size = struct.calcsize(fmt)
+        if self.pos + size > len(self.data):
+            raise Exception("Invalid response from mitie_serverd.")
+        vals = struct.unpack_from(fmt, self.data, self.pos)
+        self.pos += size
+        return vals[0]
+
+    def read_string(self):
+        size = self.read(">I")
+        if self.pos + size > len(self.data):
+            raise Exception("Invalid response from mitie_serverd.")
+        string = self.data[self.pos:self.pos+size]
+        self.pos += size
+        return to_default_str_type(string)
+
+    def read_tokens(self):
+        return [self.read_string() for i in xrange(self.read(">I"))]
+
+
+class mitie_server_client(object):
+    """A client for mitie_serverd, a program that loads MITIE models once and serves
+    them over a Unix domain socket.  This lets short lived programs use the models
+    without paying to load them.  The methods here work like the ones on
+    named_entity_extractor, text_categorizer, and binary_relation_detector.  Each one
+    takes the name of the model to use, which defaults to the first model of the right
+    type the server loaded.
+
+    A client sends one request at a time, so don't use one from several threads at
+    once.  If socket_path isn't given the client connects to the server's default
+    socket, see mitie_server_default_socket()."""
+    def __init__(self, socket_path=None):
+        if socket_path is None:
+            socket_path = mitie_server_default_socket()
+        self.__next_id = 0
+        self.__sock = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+        try:
+            self.__sock.connect(socket_path)
+        except:
+            self.__sock.close()
+            raise
+
+    def close(self):
+        self.__sock.close()
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, type, value, traceback):
+        self.close()
+
+    def __recv(self, size):
+        parts = []
+        while size > 0:
+            part = self.__sock.recv(min(size, 1024*1024))
+            if not part:
+                raise Exception("mitie_serverd closed the connection.")
+            parts.append(part)
+            size -= len(part)
+        return b"".join(parts)
+
+    def __request(self, op, body=b""):
+        request_id = self.__next_id
+        self.__next_id = (self.__next_id + 1) & 0xFFFFFFFF
+        self.__sock.sendall(struct.pack(">IIB", len(body)+5, request_id, op) + body)
+        size = struct.unpack(">I", self.__recv(4))[0]
+        if size < 5 or size > _SERVER_MAX_FRAME_SIZE:
+            raise Exception("Invalid response from mitie_serverd.")
+        response = _server_reader(self.__recv(size))
+        if response.read(">I") != request_id:
+            raise Exception("The response from mitie_serverd doesn't match the request.")
+        if response.read(">B") != 0:
+            raise Exception("mitie_serverd error: " + response.read_string())
+        return response
+
+    def ping(self):
+        """Checks that the server is answering requests.  Raises an exception if it
+        isn't."""
+        self.__request(_SERVER_PING)
+
+    def list_models(self):
+        """Returns a list with a dict for each model the server has.  Each dict has the
+        model's "type" ("ner", "categorizer", or "relation"), its "name", and its
+        "labels": the tags of a NER model, the categories of a text categorizer, or the
+        relation type of a binary relation detector."""
+        response = self.__request(_SERVER_LIST_MODELS)
+        models = []
+        for i in xrange(response.read(">I")):
+            model_type = response.read(">B")
+            models.append({"type": _SERVER_MODEL_TYPES.get(model_type, model_type),
+                           "name": response.read_string(),
+                           "labels": response.read_tokens()})
+        return models
+
+    def extract_entities(self, tokens, model=""):
+        """Like named_entity_extractor.extract_entities(), returns a list of
+        (xrange, tag, score) tuples, one for each entity in tokens."""
+        return self.extract_entities_batch([tokens], model)[0]
+
+    def extract_entities_batch(self, sentences, model=""):
+        """Runs NER on each of the given token lists in one request to the server.
+        Returns a list with the result of extract_entities() for each one."""
+        body = [_server_string(model), struct.pack(">I", len(sentences))]
+        body.extend(_server_tokens(s) for s in sentences)
+        response = self.__request(_SERVER_EXTRACT_ENTITIES, b"".join(body))
+        tags = response.read_tokens()
+        results = []
+        for i in xrange(len(sentences)):
+            entities = []
+            for j in xrange(response.read(">I")):
+                begin = response.read(">I")
+                end = response.read(">I")
+                tag = response.read(">I")
+                score = response.read(">d")
+                entities.append((xrange(begin, end), tags[tag], score))
+            results.append(entities)
+        return results
+
+    def categorize(self, tokens, model=""):
+        """Like calling a text_categorizer, returns a (label, score) tuple for
+        tokens."""
+        return self.categorize_batch([tokens], model)[0]
+
+    def categorize_batch(self, documents, model=""):
+        """Categorizes each of the given token lists in one request to the server.
+        Returns a list with the result of categorize() for each one."""
+        body = [_server_string(model), struct.pack(">I", len(documents))]
+        body.extend(_server_tokens(d) for d in documents)
+        response = self.__request(_SERVER_CATEGORIZE, b"".join(body))
+        results = []
+        for i in xrange(len(documents)):
+            label = response.read_string()
+            results.append((label, response.read(">d")))
+        return results
+
+    def score_relation(self, tokens, arg1, arg2, model=""):
+        """Returns the score the binary relation detector gives to the relation between
+        the ranges of tokens arg1 and arg2, like calling a binary_relation_detector on
+        the result of named_entity_extractor.extract_binary_relation(tokens, arg1,
+        arg2).  > 0 means the relation is likely present."""
+        return self.score_relations([(tokens, arg1, arg2)], model)[0]
+
+    def score_relations(self, relations, model=""):
+        """Scores a list of (tokens, arg1, arg2) tuples in one request to the server.
+        Returns a list with the result of score_relation() for each one."""
+        body = [_server_string(model), struct.pack(">I", len(relations))]
+        for tokens, arg1, arg2 in relations:
+            if not _range_is_valid(tokens, arg1):
+                raise Exception("arg1 is an invalid range")
+            if not _range_is_valid(tokens, arg2):
+                raise Exception("arg2 is an invalid range")
+            body.append(_server_tokens(tokens))
+            body.append(struct.pack(">IIII", min(arg1), max(arg1)+1, min(arg2), max(arg2)+1))
+        response = self.__request(_SERVER_SCORE_RELATIONS, b"".join(body))
+        return [response.read(">d") for i in xrange(len(relations))]
@@ -0,0 +1,392 @@
+// Copyright (C) 2014 Massachusetts Institute of Technology, Lincoln Laboratory
+// License: Boost Software License   See LICENSE.txt for the full license.
+// Authors: Davis E. King (davis@dlib.net)
+
+#include <mitie/async_queue.h>
+#include <cstring>
+#include <cerrno>
+#ifndef _WIN32
+#include <unistd.h>
+#include <fcntl.h>
+#endif
+
+using namespace dlib;
+
+namespace mitie
+{
+
+// ----------------------------------------------------------------------------------------
+
+    async_request::
+    async_request (
+        async_task* task_,
+        async_callback callback_,
+        void* context_
+    ) :
+        completed(m),
+        status(async_pending),
+        detached(false),
+        delivered(m),
+        delivering(false),
+        delivering_thread(0),
+        task(task_),
+        callback(callback_),
+        context(context_),
+        queue(0),
+        queued(false)
+    {
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    async_status async_request::
+    get_status (
+    ) const
+    {
+        auto_mutex lock(m);
+        return status;
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    async_status async_request::
+    wait (
+    ) const
+    {
+        auto_mutex lock(m);
+        while (status == async_pending)
+            completed.wait();
+        return status;
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    std::string async_request::
+    get_error (
+    ) const
+    {
+        auto_mutex lock(m);
+        return error;
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    void async_request::
+    detach (
+    )
+    {
+        auto_mutex lock(m);
+        detached = true;
+        // The callback may free the context, which detaches the request, so don't wait
+        // for ourselves.
+        while (delivering && delivering_thread != get_thread_id())
+            delivered.wait();
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    bool async_request::
+    finish (
+        async_status new_status,
+        const std::string& new_error
+    )
+    /*!
+        ensures
+            - completes this request and returns true if it still needs to be delivered
+              to the submitter.
+    !*/
+    {
+        auto_mutex lock(m);
+        status = new_status;
+        error = new_error;
+        completed.broadcast();
+        return !detached;
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    bool async_request::
+    begin_delivery (
+    )
+    /*!
+        ensures
+            - if this request hasn't been detached then marks the calling thread as
+              calling the callback and returns true.  detach() waits until
+              end_delivery() is called.
+            - else returns false.
+    !*/
+    {
+        auto_mutex lock(m);
+        if (detached)
+            return false;
+        delivering = true;
+        delivering_thread = get_thread_id();
+        return true;
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    void async_request::
+    end_delivery (
+    )
+    {
+        auto_mutex lock(m);
+        delivering = false;
+        delivered.broadcast();
+    }
+
+// ----------------------------------------------------------------------------------------
+// ----------------------------------------------------------------------------------------
+
+    async_work_queue::
+    async_work_queue (
+        unsigned long num_threads,
+        unsigned long max_pending_,
+        bool block_when_full_
+    ) :
+        max_pending(max_pending_),
+        block_when_full(block_when_full_),
+        not_empty(m),
+        not_full(m),
+        stopping(false),
+        fd_signaled(false)
+    {
+        DLIB_CASSERT(num_threads > 0 && max_pending > 0,
+            "\t async_work_queue::async_work_queue()"
+            << "\n\t Invalid inputs were given to this function."
+            << "\n\t num_threads: " << num_threads
+            << "\n\t max_pending: " << max_pending
+            );
+
+        fds[0] = fds[1] = -1;
+#ifndef _WIN32
+        if (pipe(fds) != 0)
+            throw dlib::error("Unable to create the completion pipe for async_work_queue: " + std::string(std::strerror(errno)));
+        for (int i = 0; i < 2; ++i)
+        {
+            fcntl(fds[i], F_SETFL, fcntl(fds[i], F_GETFL) | O_NONBLOCK);
+            fcntl(fds[i], F_SETFD, fcntl(fds[i], F_GETFD) | FD_CLOEXEC);
+        }
+#endif
+
+        for (unsigned long i = 0; i < num_threads; ++i)
+            workers.push_back(dlib::shared_ptr<thread_function>(new thread_function(&async_work_queue::worker_thread, this)));
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    async_work_queue::
+    ~async_work_queue (
+    )
+    {
+        std::list<async_request_ptr> canceled;
+        {
+            auto_mutex lock(m);
+            stopping = true;
+            canceled.swap(pending);
+            for (std::list<async_request_ptr>::iterator i = canceled.begin(); i != canceled.end(); ++i)
+                (*i)->queued = false;
+            not_empty.broadcast();
+            not_full.broadcast();
+        }
+        for (std::list<async_request_ptr>::iterator i = canceled.begin(); i != canceled.end(); ++i)
+        {
+            if ((*i)->finish(async_canceled, ""))
+                deliver(*i);
+        }
+
+        // The thread_function destructors wait for the workers to finish what they are
+        // running.
+        workers.clear();
+
+#ifndef _WIN32
+        close(fds[0]);
+        close(fds[1]);
+#endif
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    unsigned long async_work_queue::
+    num_pending (
+    ) const
+    {
+        auto_mutex lock(m);
+        return pending.size();
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    bool async_work_queue::
+    submit (
+        const async_request_ptr& req
+    )
+    {
+        auto_mutex lock(m);
+        while (pending.size() >= max_pending && block_when_full && !stopping)
+            not_full.wait();
+        if (pending.size() >= max_pending || stopping)
+            return false;
+
+        req->queue = this;
+        req->queued = true;
+        req->position = pending.insert(pending.end(), req);
+        not_empty.signal();
+        return true;
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    bool async_work_queue::
+    cancel (
+        const async_request_ptr& req
+    )
+    {
+        {
+            auto_mutex lock(m);
+            if (req->queue != this || !req->queued)
+                return false;
+            pending.erase(req->position);
+            req->queued = false;
+            not_full.signal();
+        }
+        if (req->finish(async_canceled, ""))
+            deliver(req);
+        return true;
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    bool async_work_queue::
+    next_completed (
+        void*& context
+    )
+    {
+        auto_mutex lock(m);
+        while (completed.size() != 0)
+        {
+            async_request_ptr req = completed.front();
+            completed.pop_front();
+            bool detached;
+            {
+                auto_mutex lock2(req->m);
+                detached = req->detached;
+            }
+            if (!detached)
+            {
+                context = req->context;
+                if (completed.size() == 0)
+                    drain_completion_fd();
+                return true;
+            }
+        }
+        drain_completion_fd();
+        return false;
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    void async_work_queue::
+    drain_completion_fd (
+    )
+    /*!
+        requires
+            - m is locked
+    !*/
+    {
+#ifndef _WIN32
+        if (fd_signaled)
+        {
+            char buf[64];
+            while (read(fds[0], buf, sizeof(buf)) > 0) {}
+            fd_signaled = false;
+        }
+#endif
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    void async_work_queue::
+    deliver (
+        const async_request_ptr& req
+    )
+    /*!
+        requires
+            - req has finished and wasn't detached.
+        ensures
+            - calls req's callback or puts it where next_completed() will find it.
+    !*/
+    {
+        if (req->callback)
+        {
+            // The request might have been detached since it finished, in which case the
+            // context may already be gone.
+            if (req->begin_delivery())
+            {
+                req->callback(req->context);
+                req->end_delivery();
+            }
+            return;
+        }
+
+        auto_mutex lock(m);
+        completed.push_back(req);
+#ifndef _WIN32
+        if (!fd_signaled)
+        {
+            const char byte = 1;
+            if (write(fds[1], &byte, 1) == 1)
+                fd_signaled = true;
+        }
+#endif
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    void async_work_queue::
+    worker_thread (
+        async_work_queue* self
+    )
+    {
+        sentence_features scratch;
+        while (true)
+        {
+            async_request_ptr req;
+            {
+                auto_mutex lock(self->m);
+                while (self->pending.size() == 0 && !self->stopping)
+                    self->not_empty.wait();
+                if (self->pending.size() == 0)
+                    return;
+                req = self->pending.front();
+                self->pending.pop_front();
+                req->queued = false;
+                self->not_full.signal();
+            }
+
+            async_status status = async_done;
+            std::string error;
+            try
+            {
+                req->task->run(scratch);
+            }
+            catch (std::exception& e)
+            {
+                status = async_failed;
+                error = e.what();
+            }
+            catch (...)
+            {
+                status = async_failed;
+                error = "Unknown error.";
+            }
+
+            if (req->finish(status, error))
+                self->deliver(req);
+        }
+    }
+
+// ----------------------------------------------------------------------------------------
+
+}
+
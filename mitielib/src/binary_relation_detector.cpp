@@ -117,6 +117,7 @@ namespace mitie
     {
         DLIB_CASSERT(rel_arg1.first < rel_arg1.second && rel_arg1.second <= tokens.size(),"invalid inputs");
         DLIB_CASSERT(rel_arg2.first < rel_arg2.second && rel_arg2.second <= tokens.size(),"invalid inputs");
+        pipeline_stage_timer timer(stage_relation_features);
 
         // get dense word features for the two arguments.
         matrix<float,0,1> arg1, arg2, temp;
@@ -5,6 +5,7 @@
 #include <mitie/binary_relation_detector_trainer.h>
 #include <dlib/svm_threaded.h>
 #include <dlib/optimization.h>
+#include <dlib/string.h>
 
 using namespace dlib;
 using namespace std;
@@ -146,12 +147,15 @@ namespace mitie
             const int cv_folds_,
             const double beta_,
             const std::vector<sparse_vector_type>& samples_,
-            const std::vector<double>& labels_
-        ) : num_threads(num_threads_), cv_folds(cv_folds_), beta(beta_), samples(samples_), labels(labels_) {}
+            const std::vector<double>& labels_,
+            std::vector<training_phase>& phases_
+        ) : num_threads(num_threads_), cv_folds(cv_folds_), beta(beta_), samples(samples_), labels(labels_), phases(phases_) {}
 
         double operator()(matrix<double,2,1> params) const
         {
             params = exp(params);
+            training_phase_timer timer(phases, "classifier cross-validation",
+                "C1=" + cast_to_string(params(0)) + " C2=" + cast_to_string(params(1)));
             svm_c_linear_dcd_trainer<sparse_linear_kernel<sparse_vector_type> > trainer;
             trainer.set_c_class1(params(0));
             trainer.set_c_class2(params(1));
@@ -171,33 +175,47 @@ namespace mitie
         const double beta;
         const std::vector<sparse_vector_type>& samples;
         const std::vector<double>& labels;
+        std::vector<training_phase>& phases;
     };
 
     binary_relation_detector binary_relation_detector_trainer::
     train (
     ) const
+    {
+        std::vector<training_phase> phases;
+        return train(phases);
+    }
+
+    binary_relation_detector binary_relation_detector_trainer::
+    train (
+        std::vector<training_phase>& phases
+    ) const
     {
         DLIB_CASSERT(num_positive_examples() > 0, "Not enough training data given.");
         DLIB_CASSERT(num_negative_examples() > 0, "Not enough training data given.");
+        phases.clear();
 
         std::vector<sparse_vector_type> samples;
         std::vector<double> labels;
 
-        for (unsigned long i = 0; i < pos_sentences.size(); ++i)
-        {
-            samples.push_back(extract_binary_relation(pos_sentences[i], pos_arg1s[i], pos_arg2s[i], tfe).feats);
-            labels.push_back(+1);
-        }
-        for (unsigned long i = 0; i < neg_sentences.size(); ++i)
         {
-            samples.push_back(extract_binary_relation(neg_sentences[i], neg_arg1s[i], neg_arg2s[i], tfe).feats);
-            labels.push_back(-1);
+            training_phase_timer timer(phases, "classifier feature extraction");
+            for (unsigned long i = 0; i < pos_sentences.size(); ++i)
+            {
+                samples.push_back(extract_binary_relation(pos_sentences[i], pos_arg1s[i], pos_arg2s[i], tfe).feats);
+                labels.push_back(+1);
+            }
+            for (unsigned long i = 0; i < neg_sentences.size(); ++i)
+            {
+                samples.push_back(extract_binary_relation(neg_sentences[i], neg_arg1s[i], neg_arg2s[i], tfe).feats);
+                labels.push_back(-1);
+            }
         }
 
         randomize_samples(samples, labels);
 
         const int cv_folds = 6;
-        brdt_cv_objective obj(num_threads, cv_folds, beta, samples, labels);
+        brdt_cv_objective obj(num_threads, cv_folds, beta, samples, labels, phases);
 
         matrix<double,2,1> params;
         params = 5000.0/samples.size(), 5000.0/samples.size();
@@ -228,10 +246,8 @@ namespace mitie
         trainer.set_c_class2(params(1));
         cout << "using parameters of: " << trans(params);
         cout << "now doing training..." << endl;
-        binary_relation_detector bd;
-        bd.df = trainer.train(samples, labels);
-        bd.relation_type = relation_name;
-        bd.total_word_feature_extractor_fingerprint = tfe.get_fingerprint();
+        binary_relation_detector bd(relation_name, tfe.get_fingerprint(),
+            timed_train(phases, "classifier final fit", trainer, samples, labels));
 
         cout << "test on train: " << test_binary_decision_function(bd.df, samples, labels) << endl;
         return bd;
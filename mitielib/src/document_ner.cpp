@@ -0,0 +1,350 @@
+// Copyright (C) 2014 Massachusetts Institute of Technology, Lincoln Laboratory
+// License: Boost Software License   See LICENSE.txt for the full license.
+// Authors: Davis E. King (davis@dlib.net)
+
+#include <mitie/document_ner.h>
+#include <mitie/conll_tokenizer.h>
+#include <mitie/pipeline_stats.h>
+#include <dlib/threads.h>
+#include <sstream>
+#include <cctype>
+
+using namespace dlib;
+
+namespace mitie
+{
+
+// ----------------------------------------------------------------------------------------
+
+    namespace
+    {
+        unsigned long token_end (
+            const std::string& text,
+            const unsigned long offset,
+            const std::string& token
+        )
+        /*!
+            ensures
+                - returns the end of the bytes in text that token, which starts at offset,
+                  came from.
+        !*/
+        {
+            if (offset >= text.size())
+                return text.size();
+            if (text.compare(offset, token.size(), token) == 0)
+                return offset + token.size();
+
+            // The tokenizer turns a UTF-8 ’ at the start of a token into a single '.
+            if (token.size() != 0 && token[0] == '\'' && offset+3 <= text.size() &&
+                (unsigned char)text[offset]   == 0xE2 &&
+                (unsigned char)text[offset+1] == 0x80 &&
+                (unsigned char)text[offset+2] == 0x99)
+            {
+                return std::min<unsigned long>(offset + token.size() + 2, text.size());
+            }
+
+            return std::min<unsigned long>(offset + token.size(), text.size());
+        }
+    }
+
+    void tokenize_document (
+        const std::string& text,
+        std::vector<std::string>& tokens,
+        std::vector<std::pair<unsigned long,unsigned long> >& token_spans
+    )
+    {
+        tokens.clear();
+        token_spans.clear();
+
+        std::istringstream sin(text);
+        conll_tokenizer tok(sin);
+        std::string word;
+        unsigned long offset;
+        {
+            pipeline_stage_timer timer(stage_tokenize);
+            while (tok(word, offset))
+            {
+                token_spans.push_back(std::make_pair(offset, token_end(text, offset, word)));
+                tokens.push_back(word);
+            }
+        }
+        if (pipeline_stats_enabled())
+            add_to_pipeline_counter(counter_tokenized_tokens, tokens.size());
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    namespace
+    {
+        bool is_sentence_terminator (
+            const std::string& token
+        )
+        {
+            if (token.size() == 0)
+                return false;
+            for (unsigned long i = 0; i < token.size(); ++i)
+            {
+                if (token[i] != '.' && token[i] != '!' && token[i] != '?')
+                    return false;
+            }
+            return true;
+        }
+
+        bool is_closing_punctuation (
+            const std::string& token
+        )
+        {
+            return token == "\"" || token == "'" || token == "''" || token == ")" ||
+                   token == "]" || token == "\xE2\x80\x9D" || token == "\xE2\x80\x99";
+        }
+
+        bool is_abbreviation (
+            const std::string& token
+        )
+        /*!
+            ensures
+                - returns true if token is an abbreviation that's usually followed by a
+                  period that doesn't end the sentence.  Two letter abbreviations like Mr
+                  and Dr don't need to be listed since the tokenizer already drops their
+                  periods.
+        !*/
+        {
+            static const char* const abbreviations[] = {
+                "Mrs", "Prof", "Gen", "Sen", "Rep", "Gov", "Capt", "Col", "Lt", "Sgt",
+                "Cpl", "Maj", "Adm", "Rev", "Hon", "Pres", "vs", "Jan", "Feb", "Mar",
+                "Apr", "Jun", "Jul", "Aug", "Sep", "Sept", "Oct", "Nov", "Dec", "Mt",
+                "Ft", "Ave", "Blvd"
+            };
+            for (unsigned long i = 0; i < sizeof(abbreviations)/sizeof(abbreviations[0]); ++i)
+            {
+                if (token == abbreviations[i])
+                    return true;
+            }
+            return false;
+        }
+
+        bool has_blank_line (
+            const std::string& text,
+            unsigned long begin,
+            unsigned long end
+        )
+        /*!
+            ensures
+                - returns true if text[begin,end) contains two newlines with nothing but
+                  whitespace between them.
+        !*/
+        {
+            bool seen_newline = false;
+            for (unsigned long i = begin; i < end && i < text.size(); ++i)
+            {
+                if (text[i] == '\n')
+                {
+                    if (seen_newline)
+                        return true;
+                    seen_newline = true;
+                }
+                else if (text[i] != ' ' && text[i] != '\t' && text[i] != '\r')
+                {
+                    seen_newline = false;
+                }
+            }
+            return false;
+        }
+
+        bool starts_sentence_continuation (
+            const std::string& token
+        )
+        {
+            return token.size() != 0 && (std::islower((unsigned char)token[0]) ||
+                                         std::isdigit((unsigned char)token[0]));
+        }
+    }
+
+    void split_into_sentences (
+        const std::string& text,
+        const std::vector<std::string>& tokens,
+        const std::vector<std::pair<unsigned long,unsigned long> >& token_spans,
+        const unsigned long max_sentence_length,
+        std::vector<std::pair<unsigned long,unsigned long> >& sentences
+    )
+    {
+        DLIB_CASSERT(tokens.size() == token_spans.size() && max_sentence_length > 0,
+            "\t void split_into_sentences()"
+            << "\n\t Invalid inputs were given to this function."
+            << "\n\t tokens.size():       " << tokens.size()
+            << "\n\t token_spans.size():  " << token_spans.size()
+            << "\n\t max_sentence_length: " << max_sentence_length
+            );
+
+        sentences.clear();
+        unsigned long begin = 0;
+        unsigned long i = 0;
+        while (i < tokens.size())
+        {
+            // Break before tokens that start a new paragraph.
+            if (i > begin && has_blank_line(text, token_spans[i-1].second, token_spans[i].first))
+            {
+                sentences.push_back(std::make_pair(begin, i));
+                begin = i;
+            }
+
+            // Break overly long sentences, preferably after a comma, semicolon, or colon.
+            if (i - begin == max_sentence_length)
+            {
+                unsigned long end = i;
+                for (unsigned long j = i; j > begin + max_sentence_length/2; --j)
+                {
+                    const std::string& t = tokens[j-1];
+                    if (t == "," || t == ";" || t == ":")
+                    {
+                        end = j;
+                        break;
+                    }
+                }
+                sentences.push_back(std::make_pair(begin, end));
+                begin = end;
+                continue;
+            }
+
+            if (is_sentence_terminator(tokens[i]))
+            {
+                // A period after an abbreviation usually doesn't end the sentence.
+                const bool after_abbreviation = tokens[i] == "." && i > begin && is_abbreviation(tokens[i-1]);
+                unsigned long end = i+1;
+                while (end < tokens.size() && is_closing_punctuation(tokens[end]) && end - begin < max_sentence_length)
+                    ++end;
+                if (!after_abbreviation && (end == tokens.size() || !starts_sentence_continuation(tokens[end])))
+                {
+                    sentences.push_back(std::make_pair(begin, end));
+                    begin = end;
+                    i = end;
+                    continue;
+                }
+            }
+            ++i;
+        }
+
+        if (begin < tokens.size())
+            sentences.push_back(std::make_pair(begin, (unsigned long)tokens.size()));
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    namespace
+    {
+        unsigned long count_utf8_characters (
+            const std::string& text,
+            unsigned long begin,
+            unsigned long end
+        )
+        {
+            unsigned long count = 0;
+            for (unsigned long i = begin; i < end; ++i)
+            {
+                // Count every byte except UTF-8 continuation bytes.
+                if (((unsigned char)text[i] & 0xC0) != 0x80)
+                    ++count;
+            }
+            return count;
+        }
+
+        struct document_ner_job
+        {
+            document_ner_job (
+                const named_entity_extractor& ner_,
+                const std::vector<std::string>& tokens_,
+                const std::vector<std::pair<unsigned long,unsigned long> >& sentences_
+            ) : ner(ner_), tokens(tokens_), sentences(sentences_),
+                chunks(sentences_.size()), tags(sentences_.size()), scores(sentences_.size())
+            {}
+
+            void process (
+                long begin,
+                long end
+            )
+            {
+                // Each block of sentences reuses one word feature buffer.
+                sentence_features feats;
+                std::vector<std::string> sentence;
+                for (long i = begin; i < end; ++i)
+                {
+                    try
+                    {
+                        sentence.assign(tokens.begin() + sentences[i].first,
+                                        tokens.begin() + sentences[i].second);
+                        ner.predict(sentence, chunks[i], tags[i], scores[i],
+                                    ner.get_total_word_feature_extractor(), feats);
+                    }
+                    catch (std::exception& e)
+                    {
+                        auto_mutex lock(m);
+                        error_message = e.what();
+                    }
+                }
+            }
+
+            const named_entity_extractor& ner;
+            const std::vector<std::string>& tokens;
+            const std::vector<std::pair<unsigned long,unsigned long> >& sentences;
+            std::vector<std::vector<std::pair<unsigned long,unsigned long> > > chunks;
+            std::vector<std::vector<unsigned long> > tags;
+            std::vector<std::vector<double> > scores;
+
+            mutex m;
+            std::string error_message;
+        };
+    }
+
+    void extract_document_entities (
+        const named_entity_extractor& ner,
+        const std::string& text,
+        std::vector<document_entity>& entities,
+        std::vector<std::pair<unsigned long,unsigned long> >& sentence_spans,
+        const unsigned long max_sentence_length,
+        const unsigned long num_threads
+    )
+    {
+        entities.clear();
+        sentence_spans.clear();
+
+        std::vector<std::string> tokens;
+        std::vector<std::pair<unsigned long,unsigned long> > token_spans, sentences;
+        tokenize_document(text, tokens, token_spans);
+        split_into_sentences(text, tokens, token_spans, max_sentence_length, sentences);
+
+        document_ner_job job(ner, tokens, sentences);
+        if (num_threads > 1 && sentences.size() > 1)
+            parallel_for_blocked(num_threads, 0, sentences.size(), job, &document_ner_job::process);
+        else
+            job.process(0, sentences.size());
+        if (job.error_message.size() != 0)
+            throw dlib::error(job.error_message);
+
+        // Convert the token ranges into byte and character ranges.  We walk through the
+        // text once, counting characters as we go, since the entities are in order.
+        unsigned long pos = 0, chars = 0;
+        for (unsigned long i = 0; i < sentences.size(); ++i)
+        {
+            sentence_spans.push_back(std::make_pair(token_spans[sentences[i].first].first,
+                                                    token_spans[sentences[i].second-1].second));
+            for (unsigned long j = 0; j < job.chunks[i].size(); ++j)
+            {
+                document_entity e;
+                e.begin = token_spans[sentences[i].first + job.chunks[i][j].first].first;
+                e.end = token_spans[sentences[i].first + job.chunks[i][j].second-1].second;
+                chars += count_utf8_characters(text, pos, e.begin);
+                e.char_begin = chars;
+                e.char_end = chars + count_utf8_characters(text, e.begin, e.end);
+                pos = e.begin;
+                e.tag = job.tags[i][j];
+                e.score = job.scores[i][j];
+                e.sentence = i;
+                entities.push_back(e);
+            }
+        }
+    }
+
+// ----------------------------------------------------------------------------------------
+
+}
+
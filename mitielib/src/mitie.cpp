@@ -19,6 +19,13 @@
 #include <mitie/text_categorizer.h>
 #include <mitie/text_categorizer_trainer.h>
 #include <mitie/total_word_feature_extractor.h>
+#include <mitie/word_similarity_index.h>
+#include <mitie/ner_result_cache.h>
+#include <mitie/pipeline_stats.h>
+#include <mitie/memory_usage.h>
+#include <mitie/document_ner.h>
+#include <mitie/streaming_ner.h>
+#include <mitie/async_queue.h>
 
 using namespace mitie;
 
@@ -46,7 +53,17 @@ namespace
         MITIE_NER_TRAINER,
         MITIE_TEXT_CATEGORIZER,
         MITIE_TEXT_CATEGORIZER_TRAINER,
-        MITIE_TOTAL_WORD_FEATURE_EXTRACTOR       
+        MITIE_TOTAL_WORD_FEATURE_EXTRACTOR,
+        MITIE_WORD_SIMILARITY_INDEX,
+        MITIE_SIMILAR_WORDS,
+        MITIE_NER_RESULT_CACHE,
+        MITIE_PIPELINE_STATS,
+        MITIE_MEMORY_USAGE,
+        MITIE_DOCUMENT_ENTITIES,
+        MITIE_STREAMING_NER,
+        MITIE_STREAMING_ENTITIES,
+        MITIE_ASYNC_QUEUE,
+        MITIE_ASYNC_REQUEST
     };
 
     template <typename T>
@@ -63,6 +80,16 @@ namespace
     template <> struct allocatable_types<text_categorizer>              { const static mitie_object_type type = MITIE_TEXT_CATEGORIZER; };
     template <> struct allocatable_types<text_categorizer_trainer>      { const static mitie_object_type type = MITIE_TEXT_CATEGORIZER_TRAINER; };
     template <> struct allocatable_types<total_word_feature_extractor>      { const static mitie_object_type type = MITIE_TOTAL_WORD_FEATURE_EXTRACTOR; };
+    template <> struct allocatable_types<word_similarity_index>         { const static mitie_object_type type = MITIE_WORD_SIMILARITY_INDEX; };
+    template <> struct allocatable_types<mitie_similar_words>           { const static mitie_object_type type = MITIE_SIMILAR_WORDS; };
+    template <> struct allocatable_types<ner_result_cache>              { const static mitie_object_type type = MITIE_NER_RESULT_CACHE; };
+    template <> struct allocatable_types<mitie_pipeline_stats>          { const static mitie_object_type type = MITIE_PIPELINE_STATS; };
+    template <> struct allocatable_types<mitie_memory_usage>            { const static mitie_object_type type = MITIE_MEMORY_USAGE; };
+    template <> struct allocatable_types<mitie_document_entities>       { const static mitie_object_type type = MITIE_DOCUMENT_ENTITIES; };
+    template <> struct allocatable_types<streaming_named_entity_extractor>{ const static mitie_object_type type = MITIE_STREAMING_NER; };
+    template <> struct allocatable_types<mitie_streaming_entities>      { const static mitie_object_type type = MITIE_STREAMING_ENTITIES; };
+    template <> struct allocatable_types<async_work_queue>              { const static mitie_object_type type = MITIE_ASYNC_QUEUE; };
+    template <> struct allocatable_types<mitie_async_request>           { const static mitie_object_type type = MITIE_ASYNC_REQUEST; };
 
 
 // ----------------------------------------------------------------------------------------
@@ -309,8 +336,13 @@ extern "C"
             conll_tokenizer tok(sin);
             std::vector<std::string> words;
             string word;
-            while(tok(word))
-                words.push_back(word);
+            {
+                pipeline_stage_timer timer(stage_tokenize);
+                while(tok(word))
+                    words.push_back(word);
+            }
+            if (pipeline_stats_enabled())
+                add_to_pipeline_counter(counter_tokenized_tokens, words.size());
 
             return std_vector_to_double_ptr(words);
         }
@@ -339,11 +371,16 @@ extern "C"
             std::vector<unsigned long> offsets;
             string word;
             unsigned long offset;
-            while(tok(word,offset))
             {
-                words.push_back(word);
-                offsets.push_back(offset);
+                pipeline_stage_timer timer(stage_tokenize);
+                while(tok(word,offset))
+                {
+                    words.push_back(word);
+                    offsets.push_back(offset);
+                }
             }
+            if (pipeline_stats_enabled())
+                add_to_pipeline_counter(counter_tokenized_tokens, words.size());
 
             tokens = std_vector_to_double_ptr(words);
 
@@ -385,6 +422,51 @@ extern "C"
         std::vector<std::string> tags;
     };
 
+    struct mitie_similar_words
+    {
+        std::vector<std::pair<std::string,float> > words;
+    };
+
+    struct mitie_pipeline_stats
+    {
+        pipeline_stats_snapshot stats;
+    };
+
+    struct mitie_memory_usage
+    {
+        memory_usage usage;
+    };
+
+    struct mitie_document_entities
+    {
+        std::vector<document_entity> entities;
+        std::vector<std::pair<unsigned long,unsigned long> > sentences;
+        std::vector<std::string> tags;
+    };
+
+    struct mitie_streaming_entities
+    {
+        std::vector<streaming_entity> entities;
+        std::vector<std::string> tags;
+    };
+
+    struct mitie_async_request
+    {
+        mitie_async_request() : queue(0), callback(0), user_data(0) {}
+
+        // Freeing the handle means the submitter has lost interest in the request, so it
+        // must never be handed back to them.  The async_request itself lives on until the
+        // queue is done with it.  detach() also waits for a callback running in another
+        // thread, so the callback never sees this object after it's freed.
+        ~mitie_async_request() { if (req) req->detach(); }
+
+        async_work_queue* queue;
+        async_request_ptr req;
+        mitie_async_callback callback;
+        void* user_data;
+        std::string error;
+    };
+
 
     void mitie_free (
         void* object 
@@ -428,6 +510,36 @@ extern "C"
             case MITIE_TOTAL_WORD_FEATURE_EXTRACTOR:
                 destroy<total_word_feature_extractor>(object);
                 break; 
+            case MITIE_WORD_SIMILARITY_INDEX:
+                destroy<word_similarity_index>(object);
+                break;
+            case MITIE_SIMILAR_WORDS:
+                destroy<mitie_similar_words>(object);
+                break;
+            case MITIE_NER_RESULT_CACHE:
+                destroy<ner_result_cache>(object);
+                break;
+            case MITIE_PIPELINE_STATS:
+                destroy<mitie_pipeline_stats>(object);
+                break;
+            case MITIE_MEMORY_USAGE:
+                destroy<mitie_memory_usage>(object);
+                break;
+            case MITIE_DOCUMENT_ENTITIES:
+                destroy<mitie_document_entities>(object);
+                break;
+            case MITIE_STREAMING_NER:
+                destroy<streaming_named_entity_extractor>(object);
+                break;
+            case MITIE_STREAMING_ENTITIES:
+                destroy<mitie_streaming_entities>(object);
+                break;
+            case MITIE_ASYNC_QUEUE:
+                destroy<async_work_queue>(object);
+                break;
+            case MITIE_ASYNC_REQUEST:
+                destroy<mitie_async_request>(object);
+                break;
             default:
                 std::cerr << "ERROR, mitie_free() called on non-MITIE object or called twice." << std::endl;
                 assert(false);
@@ -695,6 +807,93 @@ extern "C"
         return dets->tags[tag].c_str();
     }
 
+// ----------------------------------------------------------------------------------------
+
+    mitie_ner_result_cache* mitie_create_ner_result_cache (
+        unsigned long capacity
+    )
+    {
+        assert(capacity > 0);
+        try
+        {
+            return (mitie_ner_result_cache*)allocate<ner_result_cache>(capacity);
+        }
+        catch (...)
+        {
+            return NULL;
+        }
+    }
+
+    mitie_named_entity_detections* mitie_extract_entities_with_cache (
+        const mitie_named_entity_extractor* ner_,
+        char** tokens,
+        mitie_ner_result_cache* cache_,
+        const mitie_total_word_feature_extractor* fe
+    )
+    {
+        const named_entity_extractor& ner = checked_cast<named_entity_extractor>(ner_);
+        ner_result_cache& cache = checked_cast<ner_result_cache>(cache_);
+        assert(tokens != NULL);
+
+        mitie_named_entity_detections* impl = 0;
+
+        try
+        {
+            impl = allocate<mitie_named_entity_detections>();
+
+            std::vector<std::string> words;
+            for (unsigned long i = 0; tokens[i]; ++i)
+                words.push_back(tokens[i]);
+
+            if (fe)
+                cache.predict(ner, words, impl->ranges, impl->predicted_labels, impl->predicted_scores, checked_cast<total_word_feature_extractor>(fe));
+            else
+                cache.predict(ner, words, impl->ranges, impl->predicted_labels, impl->predicted_scores);
+            impl->tags = ner.get_tag_name_strings();
+            return impl;
+        }
+        catch(...)
+        {
+            mitie_free(impl);
+            return NULL;
+        }
+    }
+
+    unsigned long mitie_ner_result_cache_size (
+        const mitie_ner_result_cache* cache
+    )
+    {
+        return checked_cast<ner_result_cache>(cache).size();
+    }
+
+    unsigned long mitie_ner_result_cache_capacity (
+        const mitie_ner_result_cache* cache
+    )
+    {
+        return checked_cast<ner_result_cache>(cache).get_capacity();
+    }
+
+    unsigned long mitie_ner_result_cache_num_hits (
+        const mitie_ner_result_cache* cache
+    )
+    {
+        return checked_cast<ner_result_cache>(cache).get_num_hits();
+    }
+
+    unsigned long mitie_ner_result_cache_num_misses (
+        const mitie_ner_result_cache* cache
+    )
+    {
+        return checked_cast<ner_result_cache>(cache).get_num_misses();
+    }
+
+    void mitie_ner_result_cache_clear (
+        mitie_ner_result_cache* cache
+    )
+    {
+        checked_cast<ner_result_cache>(cache).clear();
+    }
+
 // ----------------------------------------------------------------------------------------
 // ----------------------------------------------------------------------------------------
 // ----------------------------------------------------------------------------------------
@@ -1357,6 +1556,26 @@ extern "C"
         return checked_cast<ner_trainer>(trainer_).get_beta();
     }
 
+// ----------------------------------------------------------------------------------------
+
+    void mitie_ner_trainer_set_gate_target_recall (
+        mitie_ner_trainer* trainer_,
+        double recall
+    )
+    {
+        assert(0 <= recall && recall <= 1);
+        checked_cast<ner_trainer>(trainer_).set_gate_target_recall(recall);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    double mitie_ner_trainer_get_gate_target_recall (
+        const mitie_ner_trainer* trainer_
+    )
+    {
+        return checked_cast<ner_trainer>(trainer_).get_gate_target_recall();
+    }
+
 // ----------------------------------------------------------------------------------------
 
     void mitie_ner_trainer_set_num_threads (
@@ -1767,3 +1986,1333 @@ extern "C"
             return NULL;
         }
     }
+
+// ----------------------------------------------------------------------------------------
+
+    mitie_word_similarity_index* mitie_create_word_similarity_index (
+        const mitie_total_word_feature_extractor* twfe
+    )
+    {
+        try
+        {
+            return (mitie_word_similarity_index*)allocate<word_similarity_index>(checked_cast<total_word_feature_extractor>(twfe));
+        }
+        catch (std::exception& e)
+        {
+#ifndef NDEBUG
+            cerr << "Error creating word similarity index: " << e.what() << endl;
+#endif
+            return NULL;
+        }
+        catch (...)
+        {
+            return NULL;
+        }
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    mitie_word_similarity_index* mitie_load_word_similarity_index (
+        const char* filename
+    )
+    {
+        assert(filename != NULL);
+
+        word_similarity_index* impl = 0;
+        try
+        {
+            string classname;
+            impl = allocate<word_similarity_index>();
+            dlib::deserialize(filename) >> classname;
+            if (classname != "mitie::word_similarity_index")
+                throw dlib::error("This file does not contain a mitie::word_similarity_index. Contained: " + classname);
+            dlib::deserialize(filename) >> classname >> *impl;
+            return (mitie_word_similarity_index*)impl;
+        }
+        catch(std::exception& e)
+        {
+#ifndef NDEBUG
+            cerr << "Error loading MITIE model file: " << filename << "\n" << e.what() << endl;
+#endif
+            mitie_free(impl);
+            return NULL;
+        }
+        catch(...)
+        {
+            mitie_free(impl);
+            return NULL;
+        }
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    int mitie_save_word_similarity_index (
+        const char* filename,
+        const mitie_word_similarity_index* index
+    )
+    {
+        assert(filename);
+
+        try
+        {
+            dlib::serialize(filename) << "mitie::word_similarity_index" << checked_cast<word_similarity_index>(index);
+            return 0;
+        }
+        catch (std::exception& e)
+        {
+#ifndef NDEBUG
+            cerr << "Error saving MITIE model file: " << filename << "\n" << e.what() << endl;
+#endif
+            return 1;
+        }
+        catch (...)
+        {
+#ifndef NDEBUG
+            cerr << "Error saving MITIE model file: " << filename << endl;
+#endif
+            return 1;
+        }
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    unsigned long mitie_word_similarity_index_fingerprint (
+        const mitie_word_similarity_index* index
+    )
+    {
+        return checked_cast<word_similarity_index>(index).get_fingerprint();
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    unsigned long mitie_word_similarity_index_num_dimensions (
+        const mitie_word_similarity_index* index
+    )
+    {
+        return checked_cast<word_similarity_index>(index).get_num_dimensions();
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    mitie_similar_words* mitie_find_similar_words (
+        const mitie_word_similarity_index* index,
+        const mitie_total_word_feature_extractor* twfe,
+        const char* word,
+        unsigned long k
+    )
+    {
+        assert(word);
+
+        mitie_similar_words* results = 0;
+        try
+        {
+            results = allocate<mitie_similar_words>();
+            checked_cast<word_similarity_index>(index).find_similar_words(
+                checked_cast<total_word_feature_extractor>(twfe), word, k, results->words);
+            return results;
+        }
+        catch (std::exception& e)
+        {
+#ifndef NDEBUG
+            cerr << "Error finding similar words: " << e.what() << endl;
+#endif
+            mitie_free(results);
+            return NULL;
+        }
+        catch (...)
+        {
+            mitie_free(results);
+            return NULL;
+        }
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    mitie_similar_words* mitie_find_nearest_words (
+        const mitie_word_similarity_index* index_,
+        const float* vect,
+        unsigned long k
+    )
+    {
+        assert(vect);
+
+        mitie_similar_words* results = 0;
+        try
+        {
+            const word_similarity_index& index = checked_cast<word_similarity_index>(index_);
+            dlib::matrix<float,0,1> query = dlib::mat(vect, index.get_num_dimensions());
+            results = allocate<mitie_similar_words>();
+            index.find_nearest_words(query, k, results->words);
+            return results;
+        }
+        catch (std::exception& e)
+        {
+#ifndef NDEBUG
+            cerr << "Error finding nearest words: " << e.what() << endl;
+#endif
+            mitie_free(results);
+            return NULL;
+        }
+        catch (...)
+        {
+            mitie_free(results);
+            return NULL;
+        }
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    unsigned long mitie_similar_words_size (
+        const mitie_similar_words* words
+    )
+    {
+        assert(words);
+        return words->words.size();
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    const char* mitie_similar_words_get_word (
+        const mitie_similar_words* words,
+        unsigned long idx
+    )
+    {
+        assert(words);
+        assert(idx < mitie_similar_words_size(words));
+        return words->words[idx].first.c_str();
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    double mitie_similar_words_get_similarity (
+        const mitie_similar_words* words,
+        unsigned long idx
+    )
+    {
+        assert(words);
+        assert(idx < mitie_similar_words_size(words));
+        return words->words[idx].second;
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    void mitie_set_pipeline_stats_enabled (
+        int enabled
+    )
+    {
+        set_pipeline_stats_enabled(enabled != 0);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    int mitie_pipeline_stats_enabled (
+    )
+    {
+        return pipeline_stats_enabled() ? 1 : 0;
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    void mitie_reset_pipeline_stats (
+    )
+    {
+        reset_pipeline_stats();
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    mitie_pipeline_stats* mitie_get_pipeline_stats (
+    )
+    {
+        try
+        {
+            mitie_pipeline_stats* results = allocate<mitie_pipeline_stats>();
+            results->stats = get_pipeline_stats();
+            return results;
+        }
+        catch (...)
+        {
+            return NULL;
+        }
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    unsigned long mitie_pipeline_stats_num_stages (
+        const mitie_pipeline_stats* stats
+    )
+    {
+        assert(stats);
+        return sizeof(stats->stats.stages)/sizeof(stats->stats.stages[0]);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    const char* mitie_pipeline_stats_stage_name (
+        const mitie_pipeline_stats* stats,
+        unsigned long idx
+    )
+    {
+        assert(stats);
+        assert(idx < mitie_pipeline_stats_num_stages(stats));
+        if (idx >= mitie_pipeline_stats_num_stages(stats))
+            return NULL;
+        return pipeline_stage_name((pipeline_stage)idx);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    unsigned long mitie_pipeline_stats_stage_count (
+        const mitie_pipeline_stats* stats,
+        unsigned long idx
+    )
+    {
+        assert(stats);
+        assert(idx < mitie_pipeline_stats_num_stages(stats));
+        return stats->stats.stages[idx].count;
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    double mitie_pipeline_stats_stage_total_seconds (
+        const mitie_pipeline_stats* stats,
+        unsigned long idx
+    )
+    {
+        assert(stats);
+        assert(idx < mitie_pipeline_stats_num_stages(stats));
+        return stats->stats.stages[idx].total_ns/1e9;
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    double mitie_pipeline_stats_stage_max_seconds (
+        const mitie_pipeline_stats* stats,
+        unsigned long idx
+    )
+    {
+        assert(stats);
+        assert(idx < mitie_pipeline_stats_num_stages(stats));
+        return stats->stats.stages[idx].max_ns/1e9;
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    double mitie_pipeline_stats_stage_percentile_seconds (
+        const mitie_pipeline_stats* stats,
+        unsigned long idx,
+        double p
+    )
+    {
+        assert(stats);
+        assert(idx < mitie_pipeline_stats_num_stages(stats));
+        assert(0 <= p && p <= 1);
+        return stats->stats.stages[idx].percentile_ns(p)/1e9;
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    unsigned long mitie_pipeline_stats_num_histogram_buckets (
+        const mitie_pipeline_stats* stats
+    )
+    {
+        assert(stats);
+        return sizeof(stats->stats.stages[0].histogram)/sizeof(stats->stats.stages[0].histogram[0]);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    unsigned long mitie_pipeline_stats_stage_histogram (
+        const mitie_pipeline_stats* stats,
+        unsigned long idx,
+        unsigned long bucket
+    )
+    {
+        assert(stats);
+        assert(idx < mitie_pipeline_stats_num_stages(stats));
+        assert(bucket < mitie_pipeline_stats_num_histogram_buckets(stats));
+        return stats->stats.stages[idx].histogram[bucket];
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    unsigned long mitie_pipeline_stats_num_counters (
+        const mitie_pipeline_stats* stats
+    )
+    {
+        assert(stats);
+        return sizeof(stats->stats.counters)/sizeof(stats->stats.counters[0]);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    const char* mitie_pipeline_stats_counter_name (
+        const mitie_pipeline_stats* stats,
+        unsigned long idx
+    )
+    {
+        assert(stats);
+        assert(idx < mitie_pipeline_stats_num_counters(stats));
+        if (idx >= mitie_pipeline_stats_num_counters(stats))
+            return NULL;
+        return pipeline_counter_name((pipeline_counter)idx);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    unsigned long mitie_pipeline_stats_counter_value (
+        const mitie_pipeline_stats* stats,
+        unsigned long idx
+    )
+    {
+        assert(stats);
+        assert(idx < mitie_pipeline_stats_num_counters(stats));
+        return stats->stats.counters[idx];
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    namespace
+    {
+        template <typename T>
+        mitie_memory_usage* make_memory_usage (
+            const void* model
+        )
+        {
+            try
+            {
+                mitie_memory_usage* results = allocate<mitie_memory_usage>();
+                results->usage = checked_cast<T>(model).get_memory_usage();
+                return results;
+            }
+            catch (...)
+            {
+                return NULL;
+            }
+        }
+    }
+
+    mitie_memory_usage* mitie_get_named_entity_extractor_memory_usage (
+        const mitie_named_entity_extractor* ner
+    )
+    {
+        return make_memory_usage<named_entity_extractor>(ner);
+    }
+
+    mitie_memory_usage* mitie_get_text_categorizer_memory_usage (
+        const mitie_text_categorizer* tcat
+    )
+    {
+        return make_memory_usage<text_categorizer>(tcat);
+    }
+
+    mitie_memory_usage* mitie_get_binary_relation_detector_memory_usage (
+        const mitie_binary_relation_detector* detector
+    )
+    {
+        return make_memory_usage<binary_relation_detector>(detector);
+    }
+
+    mitie_memory_usage* mitie_get_total_word_feature_extractor_memory_usage (
+        const mitie_total_word_feature_extractor* twfe
+    )
+    {
+        return make_memory_usage<total_word_feature_extractor>(twfe);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    unsigned long mitie_memory_usage_num_components (
+        const mitie_memory_usage* usage
+    )
+    {
+        assert(usage);
+        return usage->usage.size();
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    const char* mitie_memory_usage_component_name (
+        const mitie_memory_usage* usage,
+        unsigned long idx
+    )
+    {
+        assert(usage);
+        assert(idx < mitie_memory_usage_num_components(usage));
+        return usage->usage.name(idx).c_str();
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    unsigned long mitie_memory_usage_component_bytes (
+        const mitie_memory_usage* usage,
+        unsigned long idx
+    )
+    {
+        assert(usage);
+        assert(idx < mitie_memory_usage_num_components(usage));
+        return usage->usage.bytes(idx);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    unsigned long mitie_memory_usage_total_bytes (
+        const mitie_memory_usage* usage
+    )
+    {
+        assert(usage);
+        return usage->usage.total_bytes();
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    mitie_document_entities* mitie_extract_document_entities (
+        const mitie_named_entity_extractor* ner_,
+        const char* text,
+        unsigned long max_sentence_length,
+        unsigned long num_threads
+    )
+    {
+        const named_entity_extractor& ner = checked_cast<named_entity_extractor>(ner_);
+        assert(text != NULL);
+        assert(max_sentence_length > 0);
+
+        mitie_document_entities* impl = 0;
+        try
+        {
+            impl = allocate<mitie_document_entities>();
+            extract_document_entities(ner, text, impl->entities, impl->sentences,
+                max_sentence_length, num_threads);
+            impl->tags = ner.get_tag_name_strings();
+            return impl;
+        }
+        catch (...)
+        {
+            mitie_free(impl);
+            return NULL;
+        }
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    unsigned long mitie_document_entities_size (
+        const mitie_document_entities* dets
+    )
+    {
+        assert(dets);
+        return dets->entities.size();
+    }
+
+    unsigned long mitie_document_entity_begin (
+        const mitie_document_entities* dets,
+        unsigned long idx
+    )
+    {
+        assert(dets);
+        assert(idx < mitie_document_entities_size(dets));
+        return dets->entities[idx].begin;
+    }
+
+    unsigned long mitie_document_entity_end (
+        const mitie_document_entities* dets,
+        unsigned long idx
+    )
+    {
+        assert(dets);
+        assert(idx < mitie_document_entities_size(dets));
+        return dets->entities[idx].end;
+    }
+
+    unsigned long mitie_document_entity_char_begin (
+        const mitie_document_entities* dets,
+        unsigned long idx
+    )
+    {
+        assert(dets);
+        assert(idx < mitie_document_entities_size(dets));
+        return dets->entities[idx].char_begin;
+    }
+
+    unsigned long mitie_document_entity_char_end (
+        const mitie_document_entities* dets,
+        unsigned long idx
+    )
+    {
+        assert(dets);
+        assert(idx < mitie_document_entities_size(dets));
+        return dets->entities[idx].char_end;
+    }
+
+    unsigned long mitie_document_entity_tag (
+        const mitie_document_entities* dets,
+        unsigned long idx
+    )
+    {
+        assert(dets);
+        assert(idx < mitie_document_entities_size(dets));
+        return dets->entities[idx].tag;
+    }
+
+    const char* mitie_document_entity_tagstr (
+        const mitie_document_entities* dets,
+        unsigned long idx
+    )
+    {
+        assert(dets);
+        assert(idx < mitie_document_entities_size(dets));
+        return dets->tags[dets->entities[idx].tag].c_str();
+    }
+
+    double mitie_document_entity_score (
+        const mitie_document_entities* dets,
+        unsigned long idx
+    )
+    {
+        assert(dets);
+        assert(idx < mitie_document_entities_size(dets));
+        return dets->entities[idx].score;
+    }
+
+    unsigned long mitie_document_entity_sentence (
+        const mitie_document_entities* dets,
+        unsigned long idx
+    )
+    {
+        assert(dets);
+        assert(idx < mitie_document_entities_size(dets));
+        return dets->entities[idx].sentence;
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    unsigned long mitie_document_num_sentences (
+        const mitie_document_entities* dets
+    )
+    {
+        assert(dets);
+        return dets->sentences.size();
+    }
+
+    unsigned long mitie_document_sentence_begin (
+        const mitie_document_entities* dets,
+        unsigned long idx
+    )
+    {
+        assert(dets);
+        assert(idx < mitie_document_num_sentences(dets));
+        return dets->sentences[idx].first;
+    }
+
+    unsigned long mitie_document_sentence_end (
+        const mitie_document_entities* dets,
+        unsigned long idx
+    )
+    {
+        assert(dets);
+        assert(idx < mitie_document_num_sentences(dets));
+        return dets->sentences[idx].second;
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    mitie_streaming_ner* mitie_create_streaming_ner (
+        const mitie_named_entity_extractor* ner_,
+        unsigned long window_size,
+        unsigned long overlap
+    )
+    {
+        const named_entity_extractor& ner = checked_cast<named_entity_extractor>(ner_);
+        assert(window_size > 0);
+        assert(overlap < window_size);
+
+        try
+        {
+            return (mitie_streaming_ner*)allocate<streaming_named_entity_extractor>(ner, window_size, overlap);
+        }
+        catch (...)
+        {
+            return NULL;
+        }
+    }
+
+    int mitie_streaming_ner_add_token (
+        mitie_streaming_ner* stream,
+        const char* token
+    )
+    {
+        assert(token != NULL);
+        try
+        {
+            checked_cast<streaming_named_entity_extractor>(stream).add_token(token);
+            return 0;
+        }
+        catch (...)
+        {
+            return 1;
+        }
+    }
+
+    int mitie_streaming_ner_add_tokens (
+        mitie_streaming_ner* stream,
+        char** tokens
+    )
+    {
+        assert(tokens != NULL);
+        try
+        {
+            streaming_named_entity_extractor& impl = checked_cast<streaming_named_entity_extractor>(stream);
+            for (unsigned long i = 0; tokens[i]; ++i)
+                impl.add_token(tokens[i]);
+            return 0;
+        }
+        catch (...)
+        {
+            return 1;
+        }
+    }
+
+    int mitie_streaming_ner_flush (
+        mitie_streaming_ner* stream
+    )
+    {
+        try
+        {
+            checked_cast<streaming_named_entity_extractor>(stream).flush();
+            return 0;
+        }
+        catch (...)
+        {
+            return 1;
+        }
+    }
+
+    unsigned long mitie_streaming_ner_num_tokens (
+        const mitie_streaming_ner* stream
+    )
+    {
+        return checked_cast<streaming_named_entity_extractor>(stream).get_num_tokens();
+    }
+
+    unsigned long mitie_streaming_ner_finalized_position (
+        const mitie_streaming_ner* stream
+    )
+    {
+        return checked_cast<streaming_named_entity_extractor>(stream).get_finalized_position();
+    }
+
+    void mitie_streaming_ner_clear (
+        mitie_streaming_ner* stream
+    )
+    {
+        checked_cast<streaming_named_entity_extractor>(stream).clear();
+    }
+
+    mitie_streaming_entities* mitie_streaming_ner_take_entities (
+        mitie_streaming_ner* stream_
+    )
+    {
+        streaming_named_entity_extractor& stream = checked_cast<streaming_named_entity_extractor>(stream_);
+
+        mitie_streaming_entities* impl = 0;
+        try
+        {
+            impl = allocate<mitie_streaming_entities>();
+            impl->entities.resize(stream.num_ready_entities());
+            for (unsigned long i = 0; i < impl->entities.size(); ++i)
+                stream.next_entity(impl->entities[i]);
+            impl->tags = stream.get_named_entity_extractor().get_tag_name_strings();
+            return impl;
+        }
+        catch (...)
+        {
+            mitie_free(impl);
+            return NULL;
+        }
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    unsigned long mitie_streaming_entities_size (
+        const mitie_streaming_entities* ents
+    )
+    {
+        assert(ents);
+        return ents->entities.size();
+    }
+
+    unsigned long mitie_streaming_entity_begin (
+        const mitie_streaming_entities* ents,
+        unsigned long idx
+    )
+    {
+        assert(ents);
+        assert(idx < mitie_streaming_entities_size(ents));
+        return ents->entities[idx].begin;
+    }
+
+    unsigned long mitie_streaming_entity_end (
+        const mitie_streaming_entities* ents,
+        unsigned long idx
+    )
+    {
+        assert(ents);
+        assert(idx < mitie_streaming_entities_size(ents));
+        return ents->entities[idx].end;
+    }
+
+    unsigned long mitie_streaming_entity_tag (
+        const mitie_streaming_entities* ents,
+        unsigned long idx
+    )
+    {
+        assert(ents);
+        assert(idx < mitie_streaming_entities_size(ents));
+        return ents->entities[idx].tag;
+    }
+
+    const char* mitie_streaming_entity_tagstr (
+        const mitie_streaming_entities* ents,
+        unsigned long idx
+    )
+    {
+        assert(ents);
+        assert(idx < mitie_streaming_entities_size(ents));
+        return ents->tags[ents->entities[idx].tag].c_str();
+    }
+
+    double mitie_streaming_entity_score (
+        const mitie_streaming_entities* ents,
+        unsigned long idx
+    )
+    {
+        assert(ents);
+        assert(idx < mitie_streaming_entities_size(ents));
+        return ents->entities[idx].score;
+    }
+
+    const char* mitie_streaming_entity_token (
+        const mitie_streaming_entities* ents,
+        unsigned long idx,
+        unsigned long token_idx
+    )
+    {
+        assert(ents);
+        assert(idx < mitie_streaming_entities_size(ents));
+        assert(token_idx < ents->entities[idx].tokens.size());
+        return ents->entities[idx].tokens[token_idx].c_str();
+    }
+
+// ----------------------------------------------------------------------------------------
+
+
+    namespace
+    {
+        class async_tokens_task : public async_task
+        {
+            /*!
+                WHAT THIS OBJECT REPRESENTS
+                    This is the part of the NER and text categorization tasks that
+                    gets their tokens.  If they were given text instead of tokens then
+                    the text is tokenized by the worker thread, the same way
+                    mitie_tokenize() does it, so the submitter isn't kept waiting.
+            !*/
+        public:
+            std::vector<std::string> words;
+
+        protected:
+            async_tokens_task (
+                char** tokens
+            )
+            {
+                for (unsigned long i = 0; tokens[i]; ++i)
+                    words.push_back(tokens[i]);
+            }
+
+            async_tokens_task (
+                const char* text_
+            ) : text(text_) {}
+
+            void tokenize_text (
+            )
+            {
+                if (text.size() == 0)
+                    return;
+                istringstream sin(text);
+                conll_tokenizer tok(sin);
+                string word;
+                {
+                    pipeline_stage_timer timer(stage_tokenize);
+                    while(tok(word))
+                        words.push_back(word);
+                }
+                if (pipeline_stats_enabled())
+                    add_to_pipeline_counter(counter_tokenized_tokens, words.size());
+                text.clear();
+            }
+
+        private:
+            std::string text;
+        };
+
+        class async_ner_task : public async_tokens_task
+        {
+        public:
+            async_ner_task (
+                const named_entity_extractor& ner_,
+                char** tokens
+            ) : async_tokens_task(tokens), ner(ner_), dets(0) {}
+
+            async_ner_task (
+                const named_entity_extractor& ner_,
+                const char* text
+            ) : async_tokens_task(text), ner(ner_), dets(0) {}
+
+            ~async_ner_task() { mitie_free(dets); }
+
+            virtual void run (
+                sentence_features& scratch
+            )
+            {
+                tokenize_text();
+                dets = allocate<mitie_named_entity_detections>();
+                ner.predict(words, dets->ranges, dets->predicted_labels, dets->predicted_scores,
+                            ner.get_total_word_feature_extractor(), scratch);
+                dets->tags = ner.get_tag_name_strings();
+            }
+
+            const named_entity_extractor& ner;
+            mitie_named_entity_detections* dets;
+        };
+
+        class async_categorize_task : public async_tokens_task
+        {
+        public:
+            async_categorize_task (
+                const text_categorizer& tcat_,
+                char** tokens
+            ) : async_tokens_task(tokens), tcat(tcat_), score(0) {}
+
+            async_categorize_task (
+                const text_categorizer& tcat_,
+                const char* text
+            ) : async_tokens_task(text), tcat(tcat_), score(0) {}
+
+            virtual void run (
+                sentence_features& scratch
+            )
+            {
+                tokenize_text();
+                if (words.size() == 0)
+                    throw dlib::error("Documents given to a text categorizer can't be empty.");
+                tcat.predict(words, label, score, tcat.get_total_word_feature_extractor(), scratch);
+            }
+
+            const text_categorizer& tcat;
+            std::string label;
+            double score;
+        };
+
+        class async_relation_task : public async_task
+        {
+        public:
+            async_relation_task (
+                const named_entity_extractor& ner_,
+                const binary_relation_detector& detector_
+            ) : ner(ner_), detector(detector_), score(0) {}
+
+            virtual void run (
+                sentence_features&
+            )
+            {
+                score = detector(extract_binary_relation(words, arg1, arg2, ner.get_total_word_feature_extractor()));
+            }
+
+            const named_entity_extractor& ner;
+            const binary_relation_detector& detector;
+            std::vector<std::string> words;
+            std::pair<unsigned long,unsigned long> arg1, arg2;
+            double score;
+        };
+
+        void call_async_callback (
+            void* context
+        )
+        {
+            mitie_async_request* request = (mitie_async_request*)context;
+            // The callback is allowed to free the request, so don't touch it afterwards.
+            request->callback(request, request->user_data);
+        }
+
+        mitie_async_request* submit_async_task (
+            mitie_async_queue* queue_,
+            async_task* task,
+            mitie_async_callback callback,
+            void* user_data
+        )
+        /*!
+            ensures
+                - takes ownership of task and submits it to the queue.
+                - returns NULL if the queue is full and doesn't block, or on any other
+                  error.
+        !*/
+        {
+            async_work_queue& queue = checked_cast<async_work_queue>(queue_);
+            mitie_async_request* impl = 0;
+            try
+            {
+                impl = allocate<mitie_async_request>();
+            }
+            catch (...)
+            {
+                delete task;
+                return NULL;
+            }
+
+            try
+            {
+                impl->queue = &queue;
+                impl->callback = callback;
+                impl->user_data = user_data;
+                async_request* req = 0;
+                try
+                {
+                    req = new async_request(task, callback ? call_async_callback : 0, impl);
+                }
+                catch (...)
+                {
+                    delete task;
+                    throw;
+                }
+                // req must be in place before it's submitted since a worker could finish
+                // it and call the callback before submit() even returns.
+                impl->req.reset(req);
+                if (!queue.submit(impl->req))
+                {
+                    mitie_free(impl);
+                    return NULL;
+                }
+                return impl;
+            }
+            catch (...)
+            {
+                mitie_free(impl);
+                return NULL;
+            }
+        }
+
+        template <typename T>
+        const T* get_finished_task (
+            const mitie_async_request* request
+        )
+        /*!
+            ensures
+                - returns the request's task if it's a T and it's done, otherwise
+                  returns NULL.
+        !*/
+        {
+            const mitie_async_request& impl = checked_cast<mitie_async_request>(request);
+            if (impl.req->get_status() != async_done)
+                return NULL;
+            return dynamic_cast<const T*>(&impl.req->get_task());
+        }
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    mitie_async_queue* mitie_create_async_queue (
+        unsigned long num_threads,
+        unsigned long max_pending,
+        int block_when_full
+    )
+    {
+        assert(num_threads > 0);
+        assert(max_pending > 0);
+        try
+        {
+            return (mitie_async_queue*)allocate<async_work_queue>(num_threads, max_pending, block_when_full != 0);
+        }
+        catch (...)
+        {
+            return NULL;
+        }
+    }
+
+    int mitie_async_queue_get_fd (
+        const mitie_async_queue* queue
+    )
+    {
+        return checked_cast<async_work_queue>(queue).get_completion_fd();
+    }
+
+    unsigned long mitie_async_queue_num_pending (
+        const mitie_async_queue* queue
+    )
+    {
+        return checked_cast<async_work_queue>(queue).num_pending();
+    }
+
+    mitie_async_request* mitie_async_queue_next_completed (
+        mitie_async_queue* queue
+    )
+    {
+        void* context = 0;
+        if (checked_cast<async_work_queue>(queue).next_completed(context))
+            return (mitie_async_request*)context;
+        return NULL;
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    mitie_async_request* mitie_async_extract_entities (
+        mitie_async_queue* queue,
+        const mitie_named_entity_extractor* ner,
+        char** tokens,
+        mitie_async_callback callback,
+        void* user_data
+    )
+    {
+        if (tokens == NULL)
+            return NULL;
+        try
+        {
+            return submit_async_task(queue, new async_ner_task(checked_cast<named_entity_extractor>(ner), tokens),
+                callback, user_data);
+        }
+        catch (...)
+        {
+            return NULL;
+        }
+    }
+
+    mitie_async_request* mitie_async_extract_entities_from_text (
+        mitie_async_queue* queue,
+        const mitie_named_entity_extractor* ner,
+        const char* text,
+        mitie_async_callback callback,
+        void* user_data
+    )
+    {
+        if (text == NULL)
+            return NULL;
+        try
+        {
+            return submit_async_task(queue, new async_ner_task(checked_cast<named_entity_extractor>(ner), text),
+                callback, user_data);
+        }
+        catch (...)
+        {
+            return NULL;
+        }
+    }
+
+    mitie_async_request* mitie_async_categorize_text (
+        mitie_async_queue* queue,
+        const mitie_text_categorizer* tcat,
+        char** tokens,
+        mitie_async_callback callback,
+        void* user_data
+    )
+    {
+        if (tokens == NULL)
+            return NULL;
+        try
+        {
+            return submit_async_task(queue, new async_categorize_task(checked_cast<text_categorizer>(tcat), tokens),
+                callback, user_data);
+        }
+        catch (...)
+        {
+            return NULL;
+        }
+    }
+
+    mitie_async_request* mitie_async_categorize_text_from_text (
+        mitie_async_queue* queue,
+        const mitie_text_categorizer* tcat,
+        const char* text,
+        mitie_async_callback callback,
+        void* user_data
+    )
+    {
+        if (text == NULL)
+            return NULL;
+        try
+        {
+            return submit_async_task(queue, new async_categorize_task(checked_cast<text_categorizer>(tcat), text),
+                callback, user_data);
+        }
+        catch (...)
+        {
+            return NULL;
+        }
+    }
+
+    mitie_async_request* mitie_async_score_binary_relation (
+        mitie_async_queue* queue,
+        const mitie_named_entity_extractor* ner,
+        const mitie_binary_relation_detector* detector,
+        char** tokens,
+        unsigned long arg1_start,
+        unsigned long arg1_length,
+        unsigned long arg2_start,
+        unsigned long arg2_length,
+        mitie_async_callback callback,
+        void* user_data
+    )
+    {
+        if (tokens == NULL)
+            return NULL;
+        assert(arg1_length > 0);
+        assert(arg2_length > 0);
+        assert(mitie_entities_overlap(arg1_start,arg1_length,arg2_start,arg2_length) == 0);
+
+        async_relation_task* task = 0;
+        try
+        {
+            task = new async_relation_task(checked_cast<named_entity_extractor>(ner),
+                                           checked_cast<binary_relation_detector>(detector));
+
+            // Crop out the tokens around the two arguments just like
+            // mitie_extract_binary_relation() does.
+            const unsigned long window_size = 5;
+            unsigned long begin = std::min(arg1_start, arg2_start);
+            if (begin > window_size)
+                begin -= window_size;
+            else
+                begin = 0;
+            const unsigned long end = std::max(arg1_start+arg1_length, arg2_start+arg2_length)+window_size;
+            for (unsigned long i = 0; tokens[i] && i < end; ++i)
+            {
+                if (i >= begin)
+                    task->words.push_back(tokens[i]);
+            }
+
+            arg1_start -= begin;
+            arg2_start -= begin;
+            task->arg1 = std::make_pair(arg1_start, arg1_start+arg1_length);
+            task->arg2 = std::make_pair(arg2_start, arg2_start+arg2_length);
+            // Check the arguments here since a bad range would trip an assert in a
+            // worker thread.
+            if (task->arg1.second > task->words.size() || task->arg2.second > task->words.size())
+            {
+                delete task;
+                return NULL;
+            }
+        }
+        catch (...)
+        {
+            delete task;
+            return NULL;
+        }
+        return submit_async_task(queue, task, callback, user_data);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    int mitie_async_get_status (
+        const mitie_async_request* request
+    )
+    {
+        return checked_cast<mitie_async_request>(request).req->get_status();
+    }
+
+    int mitie_async_wait (
+        const mitie_async_request* request
+    )
+    {
+        return checked_cast<mitie_async_request>(request).req->wait();
+    }
+
+    int mitie_async_cancel (
+        mitie_async_request* request
+    )
+    {
+        mitie_async_request& impl = checked_cast<mitie_async_request>(request);
+        // Canceling calls the callback right here and it might free request, so hold
+        // our own references.
+        async_work_queue* queue = impl.queue;
+        const async_request_ptr req = impl.req;
+        return queue->cancel(req) ? 0 : 1;
+    }
+
+    void* mitie_async_get_user_data (
+        const mitie_async_request* request
+    )
+    {
+        return checked_cast<mitie_async_request>(request).user_data;
+    }
+
+    const char* mitie_async_get_error (
+        mitie_async_request* request
+    )
+    {
+        mitie_async_request& impl = checked_cast<mitie_async_request>(request);
+        try
+        {
+            impl.error = impl.req->get_error();
+        }
+        catch (...)
+        {
+            impl.error.clear();
+        }
+        return impl.error.c_str();
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    const mitie_named_entity_detections* mitie_async_get_entities (
+        const mitie_async_request* request
+    )
+    {
+        const async_ner_task* task = get_finished_task<async_ner_task>(request);
+        return task ? task->dets : NULL;
+    }
+
+    unsigned long mitie_async_get_num_tokens (
+        const mitie_async_request* request
+    )
+    {
+        const async_tokens_task* task = get_finished_task<async_tokens_task>(request);
+        return task ? task->words.size() : 0;
+    }
+
+    const char* mitie_async_get_token (
+        const mitie_async_request* request,
+        unsigned long idx
+    )
+    {
+        assert(idx < mitie_async_get_num_tokens(request));
+        return get_finished_task<async_tokens_task>(request)->words[idx].c_str();
+    }
+
+    int mitie_async_get_category (
+        const mitie_async_request* request,
+        const char** label,
+        double* score
+    )
+    {
+        assert(label);
+        assert(score);
+        const async_categorize_task* task = get_finished_task<async_categorize_task>(request);
+        if (!task)
+            return 1;
+        *label = task->label.c_str();
+        *score = task->score;
+        return 0;
+    }
+
+    int mitie_async_get_relation_score (
+        const mitie_async_request* request,
+        double* score
+    )
+    {
+        assert(score);
+        const async_relation_task* task = get_finished_task<async_relation_task>(request);
+        if (!task)
+            return 1;
+        *score = task->score;
+        return 0;
+    }
+
+// ----------------------------------------------------------------------------------------
+
@@ -3,6 +3,7 @@
 // Authors: Davis E. King (davis@dlib.net)
 
 #include <mitie/named_entity_extractor.h>
+#include <mitie/pipeline_stats.h>
 
 using namespace dlib;
 
@@ -18,7 +19,7 @@ namespace mitie
         const dlib::sequence_segmenter<ner_feature_extractor>& segmenter_,
         const dlib::multiclass_linear_decision_function<dlib::sparse_linear_kernel<ner_sample_type>,unsigned long>& df_
     ) : tag_name_strings(tag_name_strings_), fe(fe_), segmenter(segmenter_), df(df_),
-        pure_model_version(get_max_supported_pure_model_version())
+        pure_model_version(get_max_supported_pure_model_version()), save_sparse(false)
     { 
         // make sure the requirements are not violated.
         DLIB_CASSERT(df.number_of_classes() >= tag_name_strings.size(),"invalid inputs"); 
@@ -29,13 +30,14 @@ namespace mitie
             DLIB_CASSERT(df_tags.count(i) == 1, "The classifier must be capable of predicting each possible tag as output.");
         }
         tfe_fingerprint = fe.get_fingerprint();
+        dense_fe = dense_chunk_feature_extractor(segmenter.get_feature_extractor().num_features());
         compute_fingerprint();
     }
 
     named_entity_extractor::
     named_entity_extractor(const std::string& pureModelName,
                            const std::string& extractorName
-    )
+    ) : save_sparse(false)
     {
         std::string classname;
         dlib::proxy_deserialize stream_wrap = dlib::deserialize(pureModelName);
@@ -79,12 +81,13 @@ namespace mitie
                     "Fingerprint mismatch. "
                     "Feature extractor must be same as the one used for training the model");
 
+        dense_fe = dense_chunk_feature_extractor(segmenter.get_feature_extractor().num_features());
         compute_fingerprint();
     }
 
     named_entity_extractor::
     named_entity_extractor(const std::string& pureModelName
-    )
+    ) : save_sparse(false)
     {
         std::string classname;
         dlib::proxy_deserialize stream_wrap = dlib::deserialize(pureModelName);
@@ -114,6 +117,7 @@ namespace mitie
                         "Found: " + dlib::cast_to_string(pure_model_version) +
                         "Supported upto : " + dlib::cast_to_string(get_max_supported_pure_model_version()));
         }
+        dense_fe = dense_chunk_feature_extractor(segmenter.get_feature_extractor().num_features());
         compute_fingerprint();
     }
 // ----------------------------------------------------------------------------------------
@@ -137,6 +141,20 @@ namespace mitie
         std::vector<double>& chunk_scores,
         const total_word_feature_extractor& fe
     ) const
+    {
+        sentence_features sent;
+        predict(sentence, chunks, chunk_tags, chunk_scores, fe, sent);
+    }
+
+    void named_entity_extractor::
+    predict (
+        const std::vector<std::string>& sentence,
+        std::vector<std::pair<unsigned long, unsigned long> >& chunks,
+        std::vector<unsigned long>& chunk_tags,
+        std::vector<double>& chunk_scores,
+        const total_word_feature_extractor& fe,
+        sentence_features& sent
+    ) const
     {
         if(pure_model_version != pure_model_version_0 && this->tfe_fingerprint != fe.get_fingerprint())
         {
@@ -144,18 +162,70 @@ namespace mitie
                     "Fingerprint mismatch. "
                     "Feature extractor must be same as the one used for training the model");
         }
-        const std::vector<matrix<float,0,1> >& sent = sentence_to_feats(fe, sentence);
+        pipeline_stage_timer total_timer(stage_ner);
+        const bool record_stats = pipeline_stats_enabled();
+
+        uint64 t = record_stats ? pipeline_stats_clock_ns() : 0;
+        if (gate.is_enabled())
+        {
+            const bool skip = gate.should_skip(sentence, fe);
+            if (record_stats)
+            {
+                const uint64 now = pipeline_stats_clock_ns();
+                record_pipeline_stage(stage_ner_gate, now - t);
+                t = now;
+                add_to_pipeline_counter(counter_ner_gate_sentences, 1);
+                if (skip)
+                    add_to_pipeline_counter(counter_ner_gate_skipped_sentences, 1);
+            }
+            if (skip)
+            {
+                chunks.clear();
+                chunk_tags.clear();
+                chunk_scores.clear();
+                return;
+            }
+        }
+
+        sentence_to_feats(fe, sentence, sent);
+        if (record_stats)
+        {
+            const uint64 now = pipeline_stats_clock_ns();
+            record_pipeline_stage(stage_ner_word_features, now - t);
+            t = now;
+        }
         segmenter.segment_sequence(sent, chunks);
+        if (record_stats)
+        {
+            const uint64 now = pipeline_stats_clock_ns();
+            record_pipeline_stage(stage_ner_segmentation, now - t);
+            t = now;
+        }
 
 
         std::vector<std::pair<unsigned long, unsigned long> > final_chunks;
         final_chunks.reserve(chunks.size());
         chunk_tags.clear();
         chunk_scores.clear();
+        uint64 chunk_features_ns = 0;
+        uint64 chunk_classification_ns = 0;
         // now label each chunk
         for (unsigned long j = 0; j < chunks.size(); ++j)
         {
-            const std::pair<unsigned long, double> temp = df.predict(extract_ner_chunk_features(sentence, sent, chunks[j]));
+            const ner_sample_type& feats = extract_ner_chunk_features(sentence, sent, chunks[j], dense_fe);
+            if (record_stats)
+            {
+                const uint64 now = pipeline_stats_clock_ns();
+                chunk_features_ns += now - t;
+                t = now;
+            }
+            const std::pair<unsigned long, double> temp = df.predict(feats);
+            if (record_stats)
+            {
+                const uint64 now = pipeline_stats_clock_ns();
+                chunk_classification_ns += now - t;
+                t = now;
+            }
             const unsigned long tag = temp.first;
             const double score = temp.second;
 
@@ -170,6 +240,30 @@ namespace mitie
             }
         }
 
+        if (record_stats)
+        {
+            if (chunks.size() != 0)
+            {
+                record_pipeline_stage(stage_ner_chunk_features, chunk_features_ns);
+                record_pipeline_stage(stage_ner_chunk_classification, chunk_classification_ns);
+            }
+            // Words outside the dictionary are marked by a 1 in the first dimension of
+            // their feature vectors.
+            unsigned long num_oov = 0;
+            if (fe.get_num_dimensions() != 0)
+            {
+                for (unsigned long i = 0; i < sent.size(); ++i)
+                {
+                    if (sent[i][0] != 0)
+                        ++num_oov;
+                }
+            }
+            add_to_pipeline_counter(counter_ner_tokens, sentence.size());
+            add_to_pipeline_counter(counter_ner_oov_tokens, num_oov);
+            add_to_pipeline_counter(counter_ner_candidate_chunks, chunks.size());
+            add_to_pipeline_counter(counter_ner_entities, final_chunks.size());
+        }
+
         final_chunks.swap(chunks);
     }
 
@@ -193,35 +287,36 @@ namespace mitie
         const total_word_feature_extractor& fe
     ) const
     {
-        if(pure_model_version != pure_model_version_0 && this->tfe_fingerprint != fe.get_fingerprint())
-        {
-            throw dlib::error(
-                    "Fingerprint mismatch. "
-                    "Feature extractor must be same as the one used for training the model");
-        }
-        const std::vector<matrix<float,0,1> >& sent = sentence_to_feats(fe, sentence);
-        segmenter.segment_sequence(sent, chunks);
+        // df(x) is the same as df.predict(x).first, so this gives the same tags as
+        // predict().
+        std::vector<double> chunk_scores;
+        predict(sentence, chunks, chunk_tags, chunk_scores, fe);
+    }
 
+// ----------------------------------------------------------------------------------------
 
-        std::vector<std::pair<unsigned long, unsigned long> > final_chunks;
-        final_chunks.reserve(chunks.size());
-        chunk_tags.clear();
-        // now label each chunk
-        for (unsigned long j = 0; j < chunks.size(); ++j)
-        {
-            const unsigned long tag = df(extract_ner_chunk_features(sentence, sent, chunks[j]));
+    void named_entity_extractor::
+    set_gate (
+        const ner_gate& new_gate
+    )
+    {
+        gate = new_gate;
+        compute_fingerprint();
+    }
 
-            // Only output this chunk if it is predicted to be an entity.  Recall that if
-            // the classifier outputs a ID outside the range of our labels then it's
-            // predicting "this isn't an entity at all".
-            if (tag < tag_name_strings.size())
-            {
-                final_chunks.push_back(chunks[j]);
-                chunk_tags.push_back(tag);
-            }
-        }
+// ----------------------------------------------------------------------------------------
 
-        final_chunks.swap(chunks);
+    memory_usage named_entity_extractor::
+    get_memory_usage (
+    ) const
+    {
+        memory_usage result;
+        result.add("tag_strings", heap_bytes(tag_name_strings));
+        result.add("segmenter_weights", heap_bytes(segmenter.get_weights()));
+        result.add("classifier_weights", heap_bytes(df.weights) + heap_bytes(df.b) + heap_bytes(df.labels));
+        result.add("", gate.get_memory_usage());
+        result.add("feature_extractor", fe.get_memory_usage());
+        return result;
     }
 
 // ----------------------------------------------------------------------------------------
@@ -5,20 +5,30 @@
 
 #include <mitie/ner_feature_extraction.h>
 #include <mitie/stemmer.h>
+#include <cmath>
 
 using namespace dlib;
 
 namespace mitie
 {
-    std::vector<matrix<float,0,1> > sentence_to_feats (
+    void sentence_to_feats (
         const total_word_feature_extractor& fe,
-        const std::vector<std::string>& sentence
+        const std::vector<std::string>& sentence,
+        sentence_features& feats
     )
     {
-        std::vector<matrix<float,0,1> > temp;
-        temp.resize(sentence.size());
+        feats.set_size(sentence.size(), fe.get_num_dimensions());
         for (unsigned long i = 0; i < sentence.size(); ++i)
-            fe.get_feature_vector(sentence[i], temp[i]);
+            fe.get_feature_vector(sentence[i], feats[i]);
+    }
+
+    sentence_features sentence_to_feats (
+        const total_word_feature_extractor& fe,
+        const std::vector<std::string>& sentence
+    )
+    {
+        sentence_features temp;
+        sentence_to_feats(fe, sentence, temp);
         return temp;
     }
 
@@ -164,10 +174,139 @@ namespace mitie
 
     typedef std::vector<std::pair<dlib::uint32,double> > ner_sample_type;
 
+// ----------------------------------------------------------------------------------------
+
+    namespace
+    {
+        template <long N>
+        struct dense_chunk_features
+        {
+            /*!
+                This computes the dense chunk features for N dimensional word vectors.
+                If N == 0 it works for any number of dimensions.  The arithmetic is done
+                exactly the way dlib does it for a matrix<float,0,1>, so every version
+                gives the same outputs.
+            !*/
+
+            static void append (
+                const sentence_features& feats,
+                const std::pair<unsigned long, unsigned long>& chunk_range,
+                ner_sample_type& result
+            )
+            {
+                // When N != 0 this is a compile time constant.
+                const unsigned long num_dims = (N != 0) ? N : feats.get_num_dimensions();
+                if (num_dims == 0)
+                    return;
+
+                const float* first = feats[chunk_range.first];
+                const float* last = feats[chunk_range.second-1];
+                const float* before = (chunk_range.first != 0) ? feats[chunk_range.first-1] : 0;
+                const float* after = (chunk_range.second < feats.size()) ? feats[chunk_range.second] : 0;
+
+                // Find the average of the word vectors in the chunk and the squared
+                // lengths of all the vectors in one pass.  Each sum is still added up in
+                // the same order as dlib's length() would, but since the sums don't
+                // depend on each other the CPU can work on all of them at once.
+                matrix<float,N,1> avg;
+                avg.set_size(num_dims);
+                const float inv_chunk_size = 1.0f/static_cast<float>(chunk_range.second-chunk_range.first);
+                float first_sqr = 0, last_sqr = 0, avg_sqr = 0, before_sqr = 0, after_sqr = 0;
+                for (unsigned long j = 0; j < num_dims; ++j)
+                {
+                    float sum = first[j];
+                    for (unsigned long i = chunk_range.first+1; i < chunk_range.second; ++i)
+                        sum += feats[i][j];
+                    avg(j) = sum*inv_chunk_size;
+
+                    first_sqr += first[j]*first[j];
+                    last_sqr += last[j]*last[j];
+                    avg_sqr += avg(j)*avg(j);
+                    if (before)
+                        before_sqr += before[j]*before[j];
+                    if (after)
+                        after_sqr += after[j]*after[j];
+                }
+
+                const unsigned long start = result.size();
+                result.resize(start + 5*num_dims);
+                std::pair<dlib::uint32,double>* out = &result[start];
+                append_normalized(first, first_sqr, num_dims, MAX_FEAT, out);
+                append_normalized(last, last_sqr, num_dims, MAX_FEAT+num_dims, out+num_dims);
+                append_normalized(&avg(0), avg_sqr, num_dims, MAX_FEAT+2*num_dims, out+2*num_dims);
+                append_normalized(before, before_sqr, num_dims, MAX_FEAT+3*num_dims, out+3*num_dims);
+                append_normalized(after, after_sqr, num_dims, MAX_FEAT+4*num_dims, out+4*num_dims);
+            }
+
+        private:
+
+            static void append_normalized (
+                const float* vect,
+                const float sum_sqr,
+                const unsigned long num_dims,
+                const dlib::uint32 first_idx,
+                std::pair<dlib::uint32,double>* out
+            )
+            /*!
+                requires
+                    - sum_sqr == the squared length of vect
+                ensures
+                    - stores vect/(0.5*length(vect)+1e-10) into out[0] through
+                      out[num_dims-1] with feature indices starting at first_idx.  If
+                      vect == 0 then it stores a vector of zeros.
+            !*/
+            {
+                if (vect == 0)
+                {
+                    for (unsigned long i = 0; i < num_dims; ++i)
+                        out[i] = std::make_pair(first_idx+i, 0.0);
+                    return;
+                }
+
+                const double lnorm = 0.5;
+                const float scale = 1.0f/static_cast<float>(lnorm*std::sqrt(sum_sqr)+1e-10);
+                for (unsigned long i = 0; i < num_dims; ++i)
+                    out[i] = std::make_pair(first_idx+i, static_cast<double>(vect[i]*scale));
+            }
+        };
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    dense_chunk_feature_extractor::
+    dense_chunk_feature_extractor (
+    ) : num_dims(0), append_features(&dense_chunk_features<0>::append)
+    {
+    }
+
+    dense_chunk_feature_extractor::
+    dense_chunk_feature_extractor (
+        unsigned long num_dims_
+    ) : num_dims(num_dims_)
+    {
+        switch (num_dims)
+        {
+            // This is the size of the word vectors made by wordrep and used by all the
+            // models that come with MITIE.
+            case 271: append_features = &dense_chunk_features<271>::append; break;
+            default:  append_features = &dense_chunk_features<0>::append; break;
+        }
+    }
+
+    bool dense_chunk_feature_extractor::
+    is_specialized (
+    ) const
+    {
+        return append_features != &dense_chunk_features<0>::append;
+    }
+
+// ----------------------------------------------------------------------------------------
+
     ner_sample_type extract_ner_chunk_features (
         const std::vector<std::string>& words,
-        const std::vector<matrix<float,0,1> >& feats,
-        const std::pair<unsigned long, unsigned long>& chunk_range
+        const sentence_features& feats,
+        const std::pair<unsigned long, unsigned long>& chunk_range,
+        const dense_chunk_feature_extractor& dense_fe
     )
     {
         DLIB_CASSERT(words.size() == feats.size(), "range can't be empty");
@@ -185,10 +324,8 @@ namespace mitie
         for (unsigned long i = chunk_range.second; i < wide_range.second; ++i)
             result.push_back(make_feat(shash(words[i],1001)));
 
-        matrix<float,0,1> all_sum;
         for (unsigned long i = chunk_range.first; i < chunk_range.second; ++i)
         {
-            all_sum += feats[i];
             result.push_back(make_feat(shash(words[i],0)));
             result.push_back(make_feat(shash(stem_word(words[i]),10)));
 
@@ -211,13 +348,9 @@ namespace mitie
             result.push_back(make_feat(prefix(words[i],50)));
             result.push_back(make_feat(suffix(words[i],51)));
         }
-        all_sum /= chunk_range.second-chunk_range.first;
 
         result.push_back(make_feat(caps_pattern(words, chunk_range)));
 
-        matrix<float,0,1> first = feats[chunk_range.first];
-        matrix<float,0,1> last = feats[chunk_range.second-1];
-
         result.push_back(make_feat(shash(words[chunk_range.first],1)));
         result.push_back(make_feat(shash(words[chunk_range.second-1],2)));
         result.push_back(make_feat(shash(stem_word(words[chunk_range.first]),11)));
@@ -259,10 +392,8 @@ namespace mitie
         if (contains_hyphen(words[chunk_range.second-1]))              result.push_back(make_feat(ifeat(40)));
         if (alternating_caps_in_middle(words[chunk_range.second-1]))   result.push_back(make_feat(ifeat(502)));
 
-        matrix<float,0,1> before, after;
         if (chunk_range.first != 0)
         {
-            before = feats[chunk_range.first-1];
             result.push_back(make_feat(shash(words[chunk_range.first-1],3)));
             result.push_back(make_feat(shash(stem_word(words[chunk_range.first-1]),13)));
 
@@ -285,10 +416,6 @@ namespace mitie
             if (contains_hyphen(words[chunk_range.first-1]))              result.push_back(make_feat(ifeat(66)));
             if (alternating_caps_in_middle(words[chunk_range.first-1]))   result.push_back(make_feat(ifeat(503)));
         }
-        else
-        {
-            before = zeros_matrix<float>(first.size(),1);
-        }
 
         if (chunk_range.first > 1)
         {
@@ -342,7 +469,6 @@ namespace mitie
 
         if (chunk_range.second < feats.size())
         {
-            after = feats[chunk_range.second];
             result.push_back(make_feat(shash(words[chunk_range.second],4)));
             result.push_back(make_feat(shash(stem_word(words[chunk_range.second]),14)));
 
@@ -365,27 +491,75 @@ namespace mitie
             if (contains_hyphen(words[chunk_range.second]))              result.push_back(make_feat(ifeat(73)));
             if (alternating_caps_in_middle(words[chunk_range.second]))   result.push_back(make_feat(ifeat(506)));
         }
+
+        make_sparse_vector_inplace(result);
+        // append on the dense part of the feature space
+        if (dense_fe.get_num_dimensions() == feats.get_num_dimensions())
+            dense_fe(feats, chunk_range, result);
         else
-        {
-            after = zeros_matrix<float>(first.size(),1);
-        }
+            dense_chunk_feature_extractor(feats.get_num_dimensions())(feats, chunk_range, result);
+
+        return result;
+    }
+
+    ner_sample_type extract_ner_chunk_features (
+        const std::vector<std::string>& words,
+        const sentence_features& feats,
+        const std::pair<unsigned long, unsigned long>& chunk_range
+    )
+    {
+        return extract_ner_chunk_features(words, feats, chunk_range,
+            dense_chunk_feature_extractor(feats.get_num_dimensions()));
+    }
 
-        const double lnorm = 0.5;
-        first /= lnorm*length(first)+1e-10;
-        last /= lnorm*length(last)+1e-10;
-        all_sum /= lnorm*length(all_sum)+1e-10;
-        before /= lnorm*length(before)+1e-10;
-        after /= lnorm*length(after)+1e-10;
+// ----------------------------------------------------------------------------------------
 
-        matrix<double,0,1> temp = matrix_cast<double>(join_cols(join_cols(join_cols(join_cols(first,last),all_sum),before),after));
+    ner_gate_sample_type extract_ner_gate_features (
+        const std::vector<std::string>& words,
+        const total_word_feature_extractor& fe
+    )
+    {
+        ner_gate_sample_type result(num_ner_gate_shape_features + num_ner_gate_hash_features);
+        result = 0;
+        result(0) = 1;
+        if (words.size() == 0)
+            return result;
 
-        make_sparse_vector_inplace(result);
-        // append on the dense part of the feature space
-        for (long i = 0; i < temp.size(); ++i)
-            result.push_back(make_pair(i+MAX_FEAT, temp(i)));
+        for (unsigned long i = 0; i < words.size(); ++i)
+        {
+            const std::string& word = words[i];
+            const bool caps = is_caps(word);
+            const bool oov = !fe.is_in_dictionary(word);
+            if (caps)                                   result(1) += 1;
+            if (caps && i != 0)                         result(2) += 1;
+            if (word.size() > 1 && is_all_caps(word))   result(4) += 1;
+            if (contains_numbers(word))                 result(5) += 1;
+            if (oov)                                    result(6) += 1;
+            if (oov && caps)                            result(7) += 1;
+            if (contains_hyphen(word))                  result(8) += 1;
+            if (alternating_caps_in_middle(word))       result(9) += 1;
+            if (contains_letters(word))                 result(11) += 1;
+
+            // The words just before capitalized words say a lot about whether those are
+            // names or just the start of a sentence or title.
+            if (caps && i != 0)
+            {
+                const unsigned long bucket = shash(words[i-1], 0x1234).second%num_ner_gate_hash_features;
+                result(num_ner_gate_shape_features + bucket) += 1;
+            }
+        }
 
+        const double num_words = words.size();
+        result(3) = result(2) != 0 ? 1 : 0;
+        for (long i = 1; i < (long)num_ner_gate_shape_features; ++i)
+        {
+            if (i != 3)
+                result(i) /= num_words;
+        }
+        result(10) = std::log(1 + num_words)/5;
         return result;
     }
 
-}
+// ----------------------------------------------------------------------------------------
 
+}
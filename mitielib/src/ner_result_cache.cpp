@@ -0,0 +1,113 @@
+// Copyright (C) 2014 Massachusetts Institute of Technology, Lincoln Laboratory
+// License: Boost Software License   See LICENSE.txt for the full license.
+// Authors: Davis E. King (davis@dlib.net)
+
+#include <mitie/ner_result_cache.h>
+#include <mitie/hashing_ostream.h>
+
+using namespace dlib;
+
+namespace mitie
+{
+
+// ----------------------------------------------------------------------------------------
+
+    ner_result_cache::
+    ner_result_cache (
+        unsigned long capacity,
+        unsigned long num_shards
+    ) : results(capacity, num_shards)
+    {
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    void ner_result_cache::
+    predict (
+        const named_entity_extractor& ner,
+        const std::vector<std::string>& sentence,
+        std::vector<std::pair<unsigned long, unsigned long> >& chunks,
+        std::vector<unsigned long>& chunk_tags,
+        std::vector<double>& chunk_scores
+    )
+    {
+        const key_type key = hash_sentence(ner, sentence);
+        if (find(key, chunks, chunk_tags, chunk_scores))
+            return;
+
+        ner.predict(sentence, chunks, chunk_tags, chunk_scores);
+        insert(key, chunks, chunk_tags, chunk_scores);
+    }
+
+    void ner_result_cache::
+    predict (
+        const named_entity_extractor& ner,
+        const std::vector<std::string>& sentence,
+        std::vector<std::pair<unsigned long, unsigned long> >& chunks,
+        std::vector<unsigned long>& chunk_tags,
+        std::vector<double>& chunk_scores,
+        const total_word_feature_extractor& fe
+    )
+    {
+        const key_type key = hash_sentence(ner, sentence);
+        if (find(key, chunks, chunk_tags, chunk_scores))
+            return;
+
+        ner.predict(sentence, chunks, chunk_tags, chunk_scores, fe);
+        insert(key, chunks, chunk_tags, chunk_scores);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    ner_result_cache::key_type ner_result_cache::
+    hash_sentence (
+        const named_entity_extractor& ner,
+        const std::vector<std::string>& sentence
+    )
+    {
+        // Serializing the tokens records their lengths as well as their contents, so
+        // different ways of splitting the same text into tokens hash differently.
+        hashing_ostream sout;
+        dlib::serialize(ner.get_fingerprint(), sout);
+        dlib::serialize(sentence, sout);
+        return sout.get_hash();
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    bool ner_result_cache::
+    find (
+        const key_type& key,
+        std::vector<std::pair<unsigned long, unsigned long> >& chunks,
+        std::vector<unsigned long>& chunk_tags,
+        std::vector<double>& chunk_scores
+    )
+    {
+        cached_result r;
+        if (!results.find(key, r))
+            return false;
+        chunks.swap(r.chunks);
+        chunk_tags.swap(r.chunk_tags);
+        chunk_scores.swap(r.chunk_scores);
+        return true;
+    }
+
+    void ner_result_cache::
+    insert (
+        const key_type& key,
+        const std::vector<std::pair<unsigned long, unsigned long> >& chunks,
+        const std::vector<unsigned long>& chunk_tags,
+        const std::vector<double>& chunk_scores
+    )
+    {
+        cached_result r;
+        r.chunks = chunks;
+        r.chunk_tags = chunk_tags;
+        r.chunk_scores = chunk_scores;
+        results.insert(key, r);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+}
+
@@ -6,6 +6,9 @@
 #include <dlib/svm_threaded.h>
 #include <dlib/optimization.h>
 #include <dlib/misc_api.h>
+#include <dlib/string.h>
+#include <algorithm>
+#include <limits>
 
 using namespace std;
 using namespace dlib;
@@ -31,6 +34,70 @@ namespace mitie
             else
                 return false;
         }
+
+        double pick_gate_threshold (
+            const std::vector<double>& scores,
+            const std::vector<unsigned long>& num_chunks,
+            const double target_recall
+        )
+        /*!
+            requires
+                - scores.size() == num_chunks.size()
+                - scores[i] is the gate score of sentence i, which has num_chunks[i]
+                  entities in it.
+            ensures
+                - returns the threshold a gate should use so the sentences that score at
+                  least that much hold at least target_recall of the entities.
+        !*/
+        {
+            unsigned long num_entities = 0;
+            std::vector<std::pair<double,unsigned long> > pos_scores;
+            for (unsigned long i = 0; i < scores.size(); ++i)
+            {
+                num_entities += num_chunks[i];
+                if (num_chunks[i] != 0)
+                    pos_scores.push_back(std::make_pair(scores[i], num_chunks[i]));
+            }
+            if (pos_scores.size() == 0)
+                return -std::numeric_limits<double>::infinity();
+
+            // Find the largest threshold that keeps the sentences holding at least
+            // target_recall of the entities.
+            std::sort(pos_scores.rbegin(), pos_scores.rend());
+            double threshold = pos_scores.back().first;
+            unsigned long num_kept = 0;
+            for (unsigned long i = 0; i < pos_scores.size(); ++i)
+            {
+                num_kept += pos_scores[i].second;
+                if (num_kept >= target_recall*num_entities)
+                {
+                    threshold = pos_scores[i].first;
+                    break;
+                }
+            }
+            // Moving the threshold down to just above the best scoring sentence without
+            // entities that it skips doesn't skip any fewer such sentences, but it keeps
+            // any sentences with entities that score in between.  Putting it in the
+            // middle of that gap also leaves some margin for new data.
+            double max_skipped_neg = -std::numeric_limits<double>::infinity();
+            for (unsigned long i = 0; i < scores.size(); ++i)
+            {
+                if (num_chunks[i] == 0 && scores[i] < threshold)
+                    max_skipped_neg = std::max(max_skipped_neg, scores[i]);
+            }
+            if (max_skipped_neg == -std::numeric_limits<double>::infinity())
+            {
+                // Skipping sentences with entities doesn't buy anything here.
+                return pos_scores.back().first;
+            }
+            double next_score = threshold;
+            for (unsigned long i = 0; i < pos_scores.size(); ++i)
+            {
+                if (pos_scores[i].first > max_skipped_neg)
+                    next_score = std::min(next_score, pos_scores[i].first);
+            }
+            return (max_skipped_neg + next_score)/2;
+        }
     }
 
 // ----------------------------------------------------------------------------------------
@@ -119,7 +186,7 @@ namespace mitie
     ner_trainer::
     ner_trainer (
         const std::string& filename
-    ) : beta(0.5), num_threads(4)
+    ) : beta(0.5), num_threads(4), gate_target_recall(0)
     {
         string classname;
         dlib::deserialize(filename) >> classname >> tfe;
@@ -219,10 +286,38 @@ namespace mitie
         beta = new_beta;
     }
 
+// ----------------------------------------------------------------------------------------
+
+    double ner_trainer::
+    get_gate_target_recall (
+    ) const { return gate_target_recall; }
+
+// ----------------------------------------------------------------------------------------
+
+    void ner_trainer::
+    set_gate_target_recall (
+        double recall
+    )
+    {
+        DLIB_CASSERT(0 <= recall && recall <= 1, "Invalid gate target recall");
+        gate_target_recall = recall;
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    named_entity_extractor ner_trainer::
+    train (
+    ) const
+    {
+        std::vector<training_phase> phases;
+        return train(phases);
+    }
+
 // ----------------------------------------------------------------------------------------
 
     named_entity_extractor ner_trainer::
     train (
+        std::vector<training_phase>& phases
     ) const
     /*!
         requires
@@ -230,6 +325,7 @@ namespace mitie
     !*/
     {
         DLIB_CASSERT(size() > 0, "You can't train a named_entity_extractor if you don't give any training data.");
+        phases.clear();
 
 	// timestaper used for printouts
 	dlib::timestamper ts;
@@ -250,7 +346,7 @@ namespace mitie
 	dlib::uint64 start = ts.get_timestamp();
 
         sequence_segmenter<ner_feature_extractor> segmenter;
-        train_segmenter(segmenter);
+        train_segmenter(segmenter, phases);
 
 	dlib::uint64 stop = ts.get_timestamp();
 
@@ -258,13 +354,16 @@ namespace mitie
 
         std::vector<ner_sample_type> samples;
         std::vector<unsigned long> labels;
-        extract_ner_segment_feats(segmenter, samples, labels);
+        {
+            training_phase_timer timer(phases, "classifier feature extraction");
+            extract_ner_segment_feats(segmenter, samples, labels);
+        }
 
         cout << "Part II: train segment classifier" << endl;
 
 	start = ts.get_timestamp();
 
-        classifier_type df = train_ner_segment_classifier(samples, labels);
+        classifier_type df = train_ner_segment_classifier(samples, labels, phases);
 
 	stop = ts.get_timestamp();
 
@@ -272,7 +371,13 @@ namespace mitie
 
         cout << "df.number_of_classes(): "<< df.number_of_classes() << endl;
 
-        return named_entity_extractor(get_all_labels(), tfe, segmenter, df);
+        named_entity_extractor ner(get_all_labels(), tfe, segmenter, df);
+        if (gate_target_recall != 0)
+        {
+            cout << endl << "Part III: train sentence gate" << endl;
+            ner.set_gate(train_gate(phases));
+        }
+        return ner;
     }
 
 // ----------------------------------------------------------------------------------------
@@ -287,15 +392,17 @@ namespace mitie
             unsigned long num_threads_,
             double beta_,
             unsigned long num_labels_,
-            unsigned long max_iterations_
+            unsigned long max_iterations_,
+            std::vector<training_phase>& phases_
         ) : samples(samples_), labels(labels_), num_threads(num_threads_), beta(beta_), num_labels(num_labels_),
-            max_iterations(max_iterations_)
+            max_iterations(max_iterations_), phases(phases_)
         {}
 
         double operator() (
             const double C 
         ) const
         {
+            training_phase_timer timer(phases, "classifier cross-validation", "C=" + cast_to_string(C));
             svm_multiclass_linear_trainer<sparse_linear_kernel<ner_sample_type>,unsigned long> trainer;
 
             trainer.set_c(C);
@@ -333,6 +440,7 @@ namespace mitie
         const double beta;
         const unsigned long num_labels;
         const unsigned long max_iterations;
+        std::vector<training_phase>& phases;
     };
 
 // ----------------------------------------------------------------------------------------
@@ -360,7 +468,8 @@ namespace mitie
     ner_trainer::classifier_type ner_trainer::
     train_ner_segment_classifier (
         const std::vector<ner_sample_type>& samples,
-        const std::vector<unsigned long>& labels
+        const std::vector<unsigned long>& labels,
+        std::vector<training_phase>& phases
     ) const
     {
         cout << "now do training" << endl;
@@ -376,7 +485,7 @@ namespace mitie
 
         if (count_of_least_common_label(labels) > 1)
         {
-            train_ner_segment_classifier_objective obj(samples, labels, num_threads, beta, get_all_labels().size(), 2000);
+            train_ner_segment_classifier_objective obj(samples, labels, num_threads, beta, get_all_labels().size(), 2000, phases);
 
             double C = 300;
             const double min_C = 0.01;
@@ -396,7 +505,11 @@ namespace mitie
             trainer.set_c(C);
         }
 
-        classifier_type df = trainer.train(samples, labels);
+        classifier_type df;
+        {
+            training_phase_timer timer(phases, "classifier final fit");
+            df = trainer.train(samples, labels);
+        }
         matrix<double> res = test_multiclass_decision_function(df, samples, labels);
         cout << "test on train: \n" << res << endl;
         cout << "overall accuracy: "<< sum(diag(res))/sum(res) << endl;
@@ -434,9 +547,11 @@ namespace mitie
         labels.clear();
         const std::vector<std::string> ner_labels = get_all_labels();
 
+        const dense_chunk_feature_extractor dense_fe(tfe.get_num_dimensions());
+        sentence_features sent;
         for (unsigned long i = 0; i < sentences.size(); ++i)
         {
-            const std::vector<matrix<float,0,1> >& sent = sentence_to_feats(tfe, sentences[i]);
+            sentence_to_feats(tfe, sentences[i], sent);
             std::set<std::pair<unsigned long, unsigned long> > ranges;
             // put all the true chunks into ranges
             ranges.insert(chunks[i].begin(), chunks[i].end());
@@ -451,7 +566,7 @@ namespace mitie
             std::set<std::pair<unsigned long,unsigned long> >::const_iterator j;
             for (j = ranges.begin(); j != ranges.end(); ++j)
             {
-                samples.push_back(extract_ner_chunk_features(sentences[i], sent, *j));
+                samples.push_back(extract_ner_chunk_features(sentences[i], sent, *j, dense_fe));
                 labels.push_back(get_label(chunks[i], chunk_labels[i], *j, ner_labels.size()));
             }
         }
@@ -467,9 +582,10 @@ namespace mitie
     public:
         train_segmenter_bobyqa_objective (
             structural_sequence_segmentation_trainer<ner_feature_extractor>& trainer_,
-            const std::vector<std::vector<matrix<float,0,1> > >& samples_,
-            const std::vector<std::vector<std::pair<unsigned long, unsigned long> > >& local_chunks_
-        ) : trainer(trainer_), samples(samples_), local_chunks(local_chunks_)
+            const std::vector<sentence_features>& samples_,
+            const std::vector<std::vector<std::pair<unsigned long, unsigned long> > >& local_chunks_,
+            std::vector<training_phase>& phases_
+        ) : trainer(trainer_), samples(samples_), local_chunks(local_chunks_), phases(phases_)
         {}
 
         double operator() (
@@ -478,6 +594,8 @@ namespace mitie
         {
             const double C = params(0);
             const double loss = params(1)/LOSS_SCALE;
+            training_phase_timer timer(phases, "segmenter cross-validation",
+                "C=" + cast_to_string(C) + " loss=" + cast_to_string(loss));
 
             trainer.set_c(C);
             trainer.set_loss_per_missed_segment(loss);
@@ -489,15 +607,17 @@ namespace mitie
 
     private:
         structural_sequence_segmentation_trainer<ner_feature_extractor>& trainer;
-        const std::vector<std::vector<matrix<float,0,1> > >& samples;
+        const std::vector<sentence_features>& samples;
         const std::vector<std::vector<std::pair<unsigned long, unsigned long> > >& local_chunks;
+        std::vector<training_phase>& phases;
     };
 
 // ----------------------------------------------------------------------------------------
 
     void ner_trainer::
     train_segmenter (
-        sequence_segmenter<ner_feature_extractor>& segmenter
+        sequence_segmenter<ner_feature_extractor>& segmenter,
+        std::vector<training_phase>& phases
     ) const
     {
         cout << "words in dictionary: " << tfe.get_num_words_in_dictionary() << endl;
@@ -505,10 +625,13 @@ namespace mitie
 
 
         // do the feature extraction for all the sentences
-        std::vector<std::vector<matrix<float,0,1> > > samples;
-        samples.reserve(sentences.size());
-        for (unsigned long i = 0; i < sentences.size(); ++i)
-            samples.push_back(sentence_to_feats(tfe, sentences[i]));
+        std::vector<sentence_features> samples;
+        {
+            training_phase_timer timer(phases, "segmenter feature extraction");
+            samples.resize(sentences.size());
+            for (unsigned long i = 0; i < sentences.size(); ++i)
+                sentence_to_feats(tfe, sentences[i], samples[i]);
+        }
 
         std::vector<std::vector<std::pair<unsigned long, unsigned long> > > local_chunks(chunks);
         randomize_samples(samples, local_chunks);
@@ -546,7 +669,7 @@ namespace mitie
             min_params = 0.1, 1*LOSS_SCALE;
             max_params = 100, 10*LOSS_SCALE;
 
-            train_segmenter_bobyqa_objective obj(trainer, samples, local_chunks);
+            train_segmenter_bobyqa_objective obj(trainer, samples, local_chunks, phases);
             try
             {
                 find_max_bobyqa(obj, params, params.size()*2+1, min_params, max_params, 15, 1, 100);
@@ -565,12 +688,118 @@ namespace mitie
         }
 
 
-        segmenter = trainer.train(samples, local_chunks);
+        {
+            training_phase_timer timer(phases, "segmenter final fit");
+            segmenter = trainer.train(samples, local_chunks);
+        }
 
         cout << "num feats in chunker model: "<< segmenter.get_weights().size() << endl;
         cout << "train: precision, recall, f1-score: "<< test_sequence_segmenter(segmenter, samples, local_chunks);
     }
 
+// ----------------------------------------------------------------------------------------
+
+    ner_gate ner_trainer::
+    train_gate (
+        std::vector<training_phase>& phases
+    ) const
+    {
+        typedef svm_c_linear_trainer<linear_kernel<ner_gate_sample_type> > gate_trainer_type;
+
+        std::vector<ner_gate_sample_type> samples;
+        std::vector<double> labels;
+        std::vector<unsigned long> num_chunks;
+        unsigned long num_pos = 0, num_neg = 0, num_entities = 0;
+        {
+            training_phase_timer timer(phases, "gate feature extraction");
+            for (unsigned long i = 0; i < sentences.size(); ++i)
+            {
+                samples.push_back(extract_ner_gate_features(sentences[i], tfe));
+                labels.push_back(chunks[i].size() != 0 ? +1 : -1);
+                num_chunks.push_back(chunks[i].size());
+                if (chunks[i].size() != 0)
+                    ++num_pos;
+                else
+                    ++num_neg;
+                num_entities += chunks[i].size();
+            }
+        }
+        cout << "sentences with entities: " << num_pos << " of " << sentences.size() << endl;
+        if (num_pos < 2 || num_neg < 2)
+        {
+            cout << "Not enough sentences with and without entities to train a gate." << endl;
+            return ner_gate();
+        }
+
+        // Weight the two classes so they count equally no matter how unbalanced the
+        // training data is.
+        gate_trainer_type trainer;
+        trainer.set_c_class1(0.5*sentences.size()/num_pos);
+        trainer.set_c_class2(0.5*sentences.size()/num_neg);
+
+        // The returned gate's threshold is picked on the scores of the sentences it was
+        // trained on, which is optimistic about recall.  So estimate the recall of that
+        // procedure by running it on all but one fold and checking the sentences in the
+        // fold it didn't see.
+        const unsigned long num_folds = std::min<unsigned long>(5, std::min(num_pos, num_neg));
+        unsigned long num_skipped = 0, num_entities_kept = 0;
+        {
+            training_phase_timer timer(phases, "gate cross-validation");
+            for (unsigned long fold = 0; fold < num_folds; ++fold)
+            {
+                std::vector<ner_gate_sample_type> train_samples;
+                std::vector<double> train_labels;
+                std::vector<unsigned long> train_num_chunks;
+                for (unsigned long i = 0; i < samples.size(); ++i)
+                {
+                    if (i%num_folds != fold)
+                    {
+                        train_samples.push_back(samples[i]);
+                        train_labels.push_back(labels[i]);
+                        train_num_chunks.push_back(num_chunks[i]);
+                    }
+                }
+                const decision_function<linear_kernel<ner_gate_sample_type> > df = trainer.train(train_samples, train_labels);
+                std::vector<double> train_scores(train_samples.size());
+                for (unsigned long i = 0; i < train_samples.size(); ++i)
+                    train_scores[i] = df(train_samples[i]);
+                const double threshold = pick_gate_threshold(train_scores, train_num_chunks, gate_target_recall);
+                for (unsigned long i = fold; i < samples.size(); i += num_folds)
+                {
+                    if (df(samples[i]) < threshold)
+                        ++num_skipped;
+                    else
+                        num_entities_kept += num_chunks[i];
+                }
+            }
+        }
+        cout << "cross-validated entity recall: " << (double)num_entities_kept/num_entities << endl;
+        cout << "cross-validated skip rate: " << (double)num_skipped/samples.size() << endl;
+
+        const decision_function<linear_kernel<ner_gate_sample_type> > df =
+            timed_train(phases, "gate final fit", trainer, samples, labels);
+        std::vector<double> scores(samples.size());
+        for (unsigned long i = 0; i < samples.size(); ++i)
+            scores[i] = df(samples[i]);
+        const double threshold = pick_gate_threshold(scores, num_chunks, gate_target_recall);
+
+        num_skipped = 0;
+        num_entities_kept = 0;
+        for (unsigned long i = 0; i < samples.size(); ++i)
+        {
+            if (scores[i] < threshold)
+                ++num_skipped;
+            else
+                num_entities_kept += num_chunks[i];
+        }
+        cout << "gate entity recall on the training data: " << (double)num_entities_kept/num_entities << endl;
+        cout << "gate skip rate on the training data: " << (double)num_skipped/samples.size() << endl;
+
+        // df(x) == dot(w,x) - b, and the gate only computes dot(w,x), so b moves over to
+        // the threshold.
+        return ner_gate(df.basis_vectors(0), threshold + df.b);
+    }
+
 // ----------------------------------------------------------------------------------------
 
     unsigned long ner_trainer::
@@ -0,0 +1,352 @@
+// Copyright (C) 2014 Massachusetts Institute of Technology, Lincoln Laboratory
+// License: Boost Software License   See LICENSE.txt for the full license.
+// Authors: Davis E. King (davis@dlib.net)
+
+#include <mitie/pipeline_stats.h>
+#include <dlib/threads.h>
+#include <dlib/smart_pointers.h>
+#include <dlib/general_hash/murmur_hash3.h>
+#include <algorithm>
+#include <vector>
+#include <cstring>
+
+#if defined(_WIN32)
+#include <dlib/windows_magic.h>
+#include <windows.h>
+#elif defined(__APPLE__)
+#include <mach/mach_time.h>
+#else
+#include <time.h>
+#endif
+
+using namespace dlib;
+
+namespace mitie
+{
+
+// ----------------------------------------------------------------------------------------
+
+    namespace impl
+    {
+        volatile bool pipeline_stats_on = false;
+    }
+
+    const char* pipeline_stage_name (
+        pipeline_stage stage
+    )
+    {
+        switch (stage)
+        {
+            case stage_tokenize: return "tokenize";
+            case stage_ner: return "ner";
+            case stage_ner_gate: return "ner.gate";
+            case stage_ner_word_features: return "ner.word_features";
+            case stage_ner_segmentation: return "ner.segmentation";
+            case stage_ner_chunk_features: return "ner.chunk_features";
+            case stage_ner_chunk_classification: return "ner.chunk_classification";
+            case stage_text_categorizer: return "text_categorizer";
+            case stage_text_categorizer_features: return "text_categorizer.features";
+            case stage_text_categorizer_classification: return "text_categorizer.classification";
+            case stage_relation_features: return "relation.features";
+            case stage_relation_classification: return "relation.classification";
+            default: return "unknown";
+        }
+    }
+
+    const char* pipeline_counter_name (
+        pipeline_counter counter
+    )
+    {
+        switch (counter)
+        {
+            case counter_tokenized_tokens: return "tokenize.tokens";
+            case counter_ner_tokens: return "ner.tokens";
+            case counter_ner_oov_tokens: return "ner.oov_tokens";
+            case counter_ner_candidate_chunks: return "ner.candidate_chunks";
+            case counter_ner_entities: return "ner.entities";
+            case counter_ner_gate_sentences: return "ner.gate_sentences";
+            case counter_ner_gate_skipped_sentences: return "ner.gate_skipped_sentences";
+            case counter_text_categorizer_tokens: return "text_categorizer.tokens";
+            case counter_text_categorizer_oov_tokens: return "text_categorizer.oov_tokens";
+            default: return "unknown";
+        }
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    double stage_stats::
+    mean_ns (
+    ) const
+    {
+        if (count == 0)
+            return 0;
+        return (double)total_ns/count;
+    }
+
+    uint64 stage_stats::
+    percentile_ns (
+        double p
+    ) const
+    {
+        if (count == 0)
+            return 0;
+        const double target = p*count;
+        uint64 seen = 0;
+        for (unsigned long i = 0; i < num_latency_buckets; ++i)
+        {
+            seen += histogram[i];
+            if (seen >= target && seen != 0)
+            {
+                if (i+1 == num_latency_buckets)
+                    return max_ns;
+                return std::min<uint64>(((uint64)1)<<(i+1), max_ns);
+            }
+        }
+        return max_ns;
+    }
+
+    double pipeline_stats_snapshot::
+    ner_oov_rate (
+    ) const
+    {
+        if (counters[counter_ner_tokens] == 0)
+            return 0;
+        return (double)counters[counter_ner_oov_tokens]/counters[counter_ner_tokens];
+    }
+
+    double pipeline_stats_snapshot::
+    ner_gate_skip_rate (
+    ) const
+    {
+        if (counters[counter_ner_gate_sentences] == 0)
+            return 0;
+        return (double)counters[counter_ner_gate_skipped_sentences]/counters[counter_ner_gate_sentences];
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    namespace
+    {
+        void clear (
+            stage_stats& s
+        )
+        {
+            s.count = 0;
+            s.total_ns = 0;
+            s.min_ns = 0;
+            s.max_ns = 0;
+            for (unsigned long i = 0; i < num_latency_buckets; ++i)
+                s.histogram[i] = 0;
+        }
+
+        void clear (
+            pipeline_stats_snapshot& stats
+        )
+        {
+            for (unsigned long i = 0; i < num_pipeline_stages; ++i)
+                clear(stats.stages[i]);
+            for (unsigned long i = 0; i < num_pipeline_counters; ++i)
+                stats.counters[i] = 0;
+        }
+
+        void add (
+            stage_stats& s,
+            uint64 elapsed_ns
+        )
+        {
+            if (s.count == 0 || elapsed_ns < s.min_ns)
+                s.min_ns = elapsed_ns;
+            if (s.count == 0 || elapsed_ns > s.max_ns)
+                s.max_ns = elapsed_ns;
+            ++s.count;
+            s.total_ns += elapsed_ns;
+
+            unsigned long bucket = 0;
+            while (elapsed_ns > 1 && bucket+1 < num_latency_buckets)
+            {
+                elapsed_ns >>= 1;
+                ++bucket;
+            }
+            ++s.histogram[bucket];
+        }
+
+        void merge (
+            stage_stats& dest,
+            const stage_stats& src
+        )
+        {
+            if (src.count == 0)
+                return;
+            if (dest.count == 0 || src.min_ns < dest.min_ns)
+                dest.min_ns = src.min_ns;
+            if (dest.count == 0 || src.max_ns > dest.max_ns)
+                dest.max_ns = src.max_ns;
+            dest.count += src.count;
+            dest.total_ns += src.total_ns;
+            for (unsigned long i = 0; i < num_latency_buckets; ++i)
+                dest.histogram[i] += src.histogram[i];
+        }
+
+        class sharded_pipeline_stats : noncopyable
+        {
+            /*!
+                WHAT THIS OBJECT REPRESENTS
+                    This object holds the statistics recorded by every thread.  They are
+                    split into shards, each with its own mutex, and each thread always
+                    records into the shard picked by a hash of its thread ID.  So
+                    threads rarely contend for a mutex unless there are a lot more
+                    threads than shards.
+            !*/
+        public:
+            sharded_pipeline_stats (
+            )
+            {
+                shards.resize(64);
+                for (unsigned long i = 0; i < shards.size(); ++i)
+                {
+                    shards[i].reset(new shard);
+                    clear(shards[i]->stats);
+                }
+            }
+
+            void record (
+                pipeline_stage stage,
+                uint64 elapsed_ns
+            )
+            {
+                shard& s = get_shard();
+                auto_mutex lock(s.m);
+                add(s.stats.stages[stage], elapsed_ns);
+            }
+
+            void add_to_counter (
+                pipeline_counter counter,
+                uint64 amount
+            )
+            {
+                shard& s = get_shard();
+                auto_mutex lock(s.m);
+                s.stats.counters[counter] += amount;
+            }
+
+            pipeline_stats_snapshot snapshot (
+            ) const
+            {
+                pipeline_stats_snapshot result;
+                clear(result);
+                for (unsigned long i = 0; i < shards.size(); ++i)
+                {
+                    auto_mutex lock(shards[i]->m);
+                    for (unsigned long j = 0; j < num_pipeline_stages; ++j)
+                        merge(result.stages[j], shards[i]->stats.stages[j]);
+                    for (unsigned long j = 0; j < num_pipeline_counters; ++j)
+                        result.counters[j] += shards[i]->stats.counters[j];
+                }
+                return result;
+            }
+
+            void reset (
+            )
+            {
+                for (unsigned long i = 0; i < shards.size(); ++i)
+                {
+                    auto_mutex lock(shards[i]->m);
+                    clear(shards[i]->stats);
+                }
+            }
+
+        private:
+
+            struct shard
+            {
+                mutex m;
+                pipeline_stats_snapshot stats;
+            };
+
+            shard& get_shard (
+            )
+            {
+                // thread_id_type isn't an integer on every platform, so hash its bytes.
+                const thread_id_type id = get_thread_id();
+                uint32 words[2] = {0, 0};
+                std::memcpy(words, &id, std::min(sizeof(id), sizeof(words)));
+                return *shards[murmur_hash3_2(words[0], words[1])%shards.size()];
+            }
+
+            std::vector<shared_ptr<shard> > shards;
+        };
+
+        sharded_pipeline_stats global_pipeline_stats;
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    void set_pipeline_stats_enabled (
+        bool enabled
+    )
+    {
+#ifndef MITIE_DISABLE_PIPELINE_STATS
+        impl::pipeline_stats_on = enabled;
+#endif
+    }
+
+    void reset_pipeline_stats (
+    )
+    {
+        global_pipeline_stats.reset();
+    }
+
+    pipeline_stats_snapshot get_pipeline_stats (
+    )
+    {
+        return global_pipeline_stats.snapshot();
+    }
+
+    void record_pipeline_stage (
+        pipeline_stage stage,
+        uint64 elapsed_ns
+    )
+    {
+        global_pipeline_stats.record(stage, elapsed_ns);
+    }
+
+    void add_to_pipeline_counter (
+        pipeline_counter counter,
+        uint64 amount
+    )
+    {
+        global_pipeline_stats.add_to_counter(counter, amount);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    uint64 pipeline_stats_clock_ns (
+    )
+    {
+#if defined(_WIN32)
+        static LARGE_INTEGER freq;
+        static bool have_freq = false;
+        if (!have_freq)
+        {
+            QueryPerformanceFrequency(&freq);
+            have_freq = true;
+        }
+        LARGE_INTEGER now;
+        QueryPerformanceCounter(&now);
+        return (uint64)(now.QuadPart*(1e9/freq.QuadPart));
+#elif defined(__APPLE__)
+        static mach_timebase_info_data_t timebase;
+        if (timebase.denom == 0)
+            mach_timebase_info(&timebase);
+        return mach_absolute_time()*timebase.numer/timebase.denom;
+#else
+        timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (uint64)ts.tv_sec*1000000000 + ts.tv_nsec;
+#endif
+    }
+
+// ----------------------------------------------------------------------------------------
+
+}
+
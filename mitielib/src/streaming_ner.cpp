@@ -0,0 +1,187 @@
+// Copyright (C) 2014 Massachusetts Institute of Technology, Lincoln Laboratory
+// License: Boost Software License   See LICENSE.txt for the full license.
+// Authors: Davis E. King (davis@dlib.net)
+
+#include <mitie/streaming_ner.h>
+#include <mitie/pipeline_stats.h>
+#include <algorithm>
+
+using namespace dlib;
+
+namespace mitie
+{
+
+// ----------------------------------------------------------------------------------------
+
+    streaming_named_entity_extractor::
+    streaming_named_entity_extractor (
+        const named_entity_extractor& ner_,
+        unsigned long window_size_,
+        unsigned long overlap_
+    ) :
+        ner(ner_),
+        fe(ner_.get_total_word_feature_extractor()),
+        dense_fe(ner_.get_segmenter().get_feature_extractor().num_features()),
+        window_size(window_size_),
+        overlap(overlap_),
+        buffer_start(0),
+        committed(0)
+    {
+        DLIB_CASSERT(window_size > 0 && overlap < window_size,
+            "\t streaming_named_entity_extractor::streaming_named_entity_extractor()"
+            << "\n\t Invalid inputs were given to this function."
+            << "\n\t window_size: " << window_size
+            << "\n\t overlap:     " << overlap
+            );
+
+        if (fe.get_num_dimensions() != ner.get_segmenter().get_feature_extractor().num_features())
+            throw dlib::error("The named_entity_extractor given to streaming_named_entity_extractor doesn't have a usable total_word_feature_extractor.");
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    void streaming_named_entity_extractor::
+    add_token (
+        const std::string& token
+    )
+    {
+        const unsigned long num_dims = fe.get_num_dimensions();
+        buffer.push_back(token);
+        buffer_feats.resize(buffer.size()*num_dims);
+        if (num_dims != 0)
+            fe.get_feature_vector(token, &buffer_feats[(buffer.size()-1)*num_dims]);
+
+        if (buffer.size() == window_size)
+            process_window(false);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    void streaming_named_entity_extractor::
+    flush (
+    )
+    {
+        if (buffer.size() != 0)
+            process_window(true);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    bool streaming_named_entity_extractor::
+    next_entity (
+        streaming_entity& entity
+    )
+    {
+        if (ready.size() == 0)
+            return false;
+        entity.begin = ready.front().begin;
+        entity.end = ready.front().end;
+        entity.tag = ready.front().tag;
+        entity.score = ready.front().score;
+        entity.tokens.swap(ready.front().tokens);
+        ready.pop_front();
+        return true;
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    void streaming_named_entity_extractor::
+    clear (
+    )
+    {
+        buffer.clear();
+        buffer_feats.clear();
+        buffer_start = 0;
+        committed = 0;
+        ready.clear();
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    void streaming_named_entity_extractor::
+    process_window (
+        bool at_end
+    )
+    {
+        pipeline_stage_timer timer(stage_ner);
+
+        const unsigned long n = buffer.size();
+        const unsigned long num_dims = fe.get_num_dimensions();
+        window_feats.set_size(n, num_dims);
+        if (num_dims != 0)
+            std::copy(buffer_feats.begin(), buffer_feats.end(), window_feats[0]);
+        ner.get_segmenter().segment_sequence(window_feats, chunks);
+
+        // Everything in this window before cut is made final by it.  Except at the end
+        // of the stream, that's everything up to the middle of the region the next
+        // window will share with this one.  The overlap is split into the tokens before
+        // the middle and the ones after it, rounding the second part up, so that the
+        // windows share exactly overlap tokens even when it's odd.  Here and below,
+        // positions are relative to the start of the window.
+        const unsigned long overlap_before_cut = overlap/2;
+        const unsigned long overlap_after_cut = (overlap+1)/2;
+        unsigned long cut = at_end ? n : n - overlap_after_cut;
+
+        // A chunk that runs into the end of the window might be cut short, since the
+        // segmenter can't see where it really ends.  So leave it for the next window,
+        // which starts early enough to see it along with some context before it.  We
+        // can only do that if the next window still starts after this one though,
+        // otherwise we would never make progress, so very long chunks are taken as is.
+        if (!at_end && chunks.size() != 0)
+        {
+            const std::pair<unsigned long,unsigned long>& last = chunks.back();
+            if (last.second == n && last.first < cut && buffer_start + last.first >= committed &&
+                last.first > overlap_before_cut)
+            {
+                cut = last.first;
+            }
+        }
+
+        const std::vector<std::string>& tags = ner.get_tag_name_strings();
+        dlib::uint64 new_committed = std::max<dlib::uint64>(committed, buffer_start + cut);
+        unsigned long num_entities = 0;
+        for (unsigned long i = 0; i < chunks.size(); ++i)
+        {
+            // Chunks that start before committed overlap the entities an earlier window
+            // already decided on, and chunks that start at or after cut are left for the
+            // next window.
+            if (buffer_start + chunks[i].first < committed || chunks[i].first >= cut)
+                continue;
+
+            const ner_sample_type& feats = extract_ner_chunk_features(buffer, window_feats, chunks[i], dense_fe);
+            const std::pair<unsigned long, double> temp = ner.get_df().predict(feats);
+            // A tag outside the range of our labels means "this isn't an entity".
+            if (temp.first < tags.size())
+            {
+                streaming_entity e;
+                e.begin = buffer_start + chunks[i].first;
+                e.end = buffer_start + chunks[i].second;
+                e.tag = temp.first;
+                e.score = temp.second;
+                e.tokens.assign(buffer.begin() + chunks[i].first, buffer.begin() + chunks[i].second);
+                ready.push_back(e);
+                ++num_entities;
+            }
+            new_committed = std::max<dlib::uint64>(new_committed, buffer_start + chunks[i].second);
+        }
+        committed = new_committed;
+
+        if (pipeline_stats_enabled())
+        {
+            add_to_pipeline_counter(counter_ner_tokens, n);
+            add_to_pipeline_counter(counter_ner_candidate_chunks, chunks.size());
+            add_to_pipeline_counter(counter_ner_entities, num_entities);
+        }
+
+        // Keep the tokens the next window shares with this one.  At the end of the
+        // stream there is no next window so nothing is kept.
+        const unsigned long keep_from = at_end ? n : cut - overlap_before_cut;
+        buffer.erase(buffer.begin(), buffer.begin() + keep_from);
+        buffer_feats.erase(buffer_feats.begin(), buffer_feats.begin() + keep_from*num_dims);
+        buffer_start += keep_from;
+    }
+
+// ----------------------------------------------------------------------------------------
+
+}
+
@@ -1,6 +1,7 @@
 
 #include <mitie/text_feature_extraction.h>
 #include <mitie/text_categorizer.h>
+#include <mitie/pipeline_stats.h>
 
 using namespace dlib;
 
@@ -132,6 +133,19 @@ namespace mitie
         double& text_score,
         const total_word_feature_extractor& fe
     ) const
+    {
+        sentence_features sent;
+        predict(sentence, text_tag, text_score, fe, sent);
+    }
+
+    void text_categorizer::
+    predict (
+        const std::vector<std::string>& sentence,
+        string& text_tag,
+        double& text_score,
+        const total_word_feature_extractor& fe,
+        sentence_features& sent
+    ) const
     {
         if(pure_model_version != pure_model_version_0 && this->tfe_fingerprint != fe.get_fingerprint())
         {
@@ -140,14 +154,43 @@ namespace mitie
                     "Feature extractor must be same as the one used for training the model");
         }
 
+        pipeline_stage_timer total_timer(stage_text_categorizer);
+        const bool record_stats = pipeline_stats_enabled();
+        const uint64 start = record_stats ? pipeline_stats_clock_ns() : 0;
+
         std::pair<unsigned long, double> temp;
 
         if (fe.get_num_dimensions() == 0) {
-            temp = df.predict(extract_BoW_features(sentence));
+            const text_sample_type& feats = extract_BoW_features(sentence);
+            const uint64 stop = record_stats ? pipeline_stats_clock_ns() : 0;
+            temp = df.predict(feats);
+            if (record_stats)
+            {
+                record_pipeline_stage(stage_text_categorizer_features, stop - start);
+                record_pipeline_stage(stage_text_categorizer_classification, pipeline_stats_clock_ns() - stop);
+            }
         } else {
-            const std::vector<matrix<float, 0, 1> > &sent = sentence_to_feats(fe, sentence);
-            temp = df.predict(extract_combined_features(sentence, sent));
+            sentence_to_feats(fe, sentence, sent);
+            const text_sample_type& feats = extract_combined_features(sentence, sent);
+            const uint64 stop = record_stats ? pipeline_stats_clock_ns() : 0;
+            temp = df.predict(feats);
+            if (record_stats)
+            {
+                record_pipeline_stage(stage_text_categorizer_features, stop - start);
+                record_pipeline_stage(stage_text_categorizer_classification, pipeline_stats_clock_ns() - stop);
+                // Words outside the dictionary are marked by a 1 in the first dimension
+                // of their feature vectors.
+                unsigned long num_oov = 0;
+                for (unsigned long i = 0; i < sent.size(); ++i)
+                {
+                    if (sent[i][0] != 0)
+                        ++num_oov;
+                }
+                add_to_pipeline_counter(counter_text_categorizer_oov_tokens, num_oov);
+            }
         }
+        if (record_stats)
+            add_to_pipeline_counter(counter_text_categorizer_tokens, sentence.size());
 
         // now label the document
         unsigned long text_tag_id = temp.first;
@@ -172,28 +215,23 @@ namespace mitie
         const total_word_feature_extractor& fe
     ) const
     {
-        if(pure_model_version != pure_model_version_0 && this->tfe_fingerprint != fe.get_fingerprint())
-        {
-            throw dlib::error(
-                    "Fingerprint mismatch. "
-                    "Feature extractor must be same as the one used for training the model");
-        }
-        std::pair<unsigned long, double> temp;
         string text_tag;
+        double text_score;
+        predict(sentence, text_tag, text_score, fe);
+        return text_tag;
+    }
 
-        if (fe.get_num_dimensions() == 0) {
-            temp = df.predict(extract_BoW_features(sentence));
-        } else {
-            const std::vector<matrix<float, 0, 1> > &sent = sentence_to_feats(fe, sentence);
-            temp = df.predict(extract_combined_features(sentence, sent));
-        }
-
-        // now label the document
-        unsigned long text_tag_id = temp.first;
-        if(text_tag_id < tag_name_strings.size()) text_tag = tag_name_strings[text_tag_id];
-        else text_tag = "Unseen";
+// ----------------------------------------------------------------------------------------
 
-        return text_tag;
+    memory_usage text_categorizer::
+    get_memory_usage (
+    ) const
+    {
+        memory_usage result;
+        result.add("tag_strings", heap_bytes(tag_name_strings));
+        result.add("classifier_weights", heap_bytes(df.weights) + heap_bytes(df.b) + heap_bytes(df.labels));
+        result.add("feature_extractor", fe.get_memory_usage());
+        return result;
     }
 
 // ----------------------------------------------------------------------------------------
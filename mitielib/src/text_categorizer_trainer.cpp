@@ -4,6 +4,7 @@
 
 #include <mitie/text_categorizer_trainer.h>
 #include <dlib/svm_threaded.h>
+#include <dlib/string.h>
 
 using namespace std;
 using namespace dlib;
@@ -106,12 +107,24 @@ namespace mitie
     text_categorizer text_categorizer_trainer::
     train (
     ) const
+    {
+        std::vector<training_phase> phases;
+        return train(phases);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    text_categorizer text_categorizer_trainer::
+    train (
+        std::vector<training_phase>& phases
+    ) const
     /*!
         requires
             - size() > 0
     !*/
     {
         DLIB_CASSERT(size() > 0, "You can't train a text_categorizer if you don't give any training data.");
+        phases.clear();
 
         // timestaper used for printouts
         dlib::timestamper ts;
@@ -130,7 +143,7 @@ namespace mitie
         cout << "Train classifier" << endl;
 
         dlib::uint64 start = ts.get_timestamp();
-        classifier_type df = train_text_categorizer_classifier();
+        classifier_type df = train_text_categorizer_classifier(phases);
         dlib::uint64 stop = ts.get_timestamp();
         cout << "Training time: " << (stop - start)/1000/1000 << " seconds." << endl;
         cout << "df.number_of_classes(): "<< df.number_of_classes() << endl << endl;
@@ -150,14 +163,17 @@ namespace mitie
             unsigned long num_threads_,
             double beta_,
             unsigned long num_labels_,
-            unsigned long max_iterations_
-        ) : samples(samples_), labels(labels_), num_threads(num_threads_), beta(beta_), num_labels(num_labels_), max_iterations(max_iterations_)
+            unsigned long max_iterations_,
+            std::vector<training_phase>& phases_
+        ) : samples(samples_), labels(labels_), num_threads(num_threads_), beta(beta_), num_labels(num_labels_), max_iterations(max_iterations_),
+            phases(phases_)
         {}
 
         double operator() (
             const double C 
         ) const
         {
+            training_phase_timer timer(phases, "classifier cross-validation", "C=" + cast_to_string(C));
             svm_multiclass_linear_trainer<sparse_linear_kernel<text_sample_type>,unsigned long> trainer;
 
             trainer.set_c(C);
@@ -195,6 +211,7 @@ namespace mitie
         const double beta;
         const unsigned long num_labels;
         const unsigned long max_iterations;
+        std::vector<training_phase>& phases;
     };
 
 // ----------------------------------------------------------------------------------------
@@ -221,18 +238,23 @@ namespace mitie
 
     text_categorizer_trainer::classifier_type text_categorizer_trainer::
     train_text_categorizer_classifier (
+        std::vector<training_phase>& phases
     ) const
     {
         cout << "extracting text features" << endl;
         // do the feature extraction for all the texts
         std::vector<text_sample_type> samples;
         std::vector<unsigned long> labels;
-        samples.reserve(contents.size());
-        labels.reserve(text_labels.size());
-        for (unsigned long i = 0; i < contents.size(); ++i) {
-            const std::vector<matrix<float,0,1> >& sent = sentence_to_feats(tfe, contents[i]);
-            samples.push_back( extract_combined_features(contents[i], sent) );
-            labels.push_back( text_labels[i] );
+        {
+            training_phase_timer timer(phases, "classifier feature extraction");
+            samples.reserve(contents.size());
+            labels.reserve(text_labels.size());
+            sentence_features sent;
+            for (unsigned long i = 0; i < contents.size(); ++i) {
+                sentence_to_feats(tfe, contents[i], sent);
+                samples.push_back( extract_combined_features(contents[i], sent) );
+                labels.push_back( text_labels[i] );
+            }
         }
         randomize_samples(samples, labels);
 
@@ -249,7 +271,7 @@ namespace mitie
 
         if (count_of_least_common_label(labels) > 1)
         {
-            train_text_classifier_objective obj(samples, labels, num_threads, beta, get_all_labels().size(), 2000);
+            train_text_classifier_objective obj(samples, labels, num_threads, beta, get_all_labels().size(), 2000, phases);
 
             double C = 300;
             const double min_C = 0.01;
@@ -269,7 +291,11 @@ namespace mitie
             trainer.set_c(C);
         }
 
-        classifier_type df = trainer.train(samples, labels);
+        classifier_type df;
+        {
+            training_phase_timer timer(phases, "classifier final fit");
+            df = trainer.train(samples, labels);
+        }
         matrix<double> res = test_multiclass_decision_function(df, samples, labels);
         cout << "test on train: \n" << res << endl;
         cout << "overall accuracy: "<< sum(diag(res))/sum(res) << endl;
@@ -10,7 +10,7 @@ namespace mitie
 
     text_sample_type extract_text_features (
             const std::vector<std::string>& words,
-            const std::vector<matrix<float,0,1> >& feats
+            const sentence_features& feats
     )
     {
         DLIB_CASSERT(words.size() == feats.size(), "range can't be empty");
@@ -21,15 +21,21 @@ namespace mitie
         /*
          * Here, we use the average word vector to represent the doc vector
          */
-        matrix<float,0,1> all_sum;
-        for (unsigned long i = 0L; i < words.size(); ++i)
+        if (words.size() == 0)
+            return result;
+
+        const unsigned long num_dims = feats.get_num_dimensions();
+        std::vector<float> all_sum(feats[0], feats[0]+num_dims);
+        for (unsigned long i = 1L; i < words.size(); ++i)
         {
-            all_sum += feats[i];
+            const float* f = feats[i];
+            for (unsigned long j = 0; j < num_dims; ++j)
+                all_sum[j] += f[j];
         }
-        all_sum /= words.size();
+        const float inv_num_words = 1.0f/static_cast<float>(words.size());
 
-        for (long i = 0; i < all_sum.size(); ++i)
-            result.push_back(make_pair(i+MAX_FEAT, all_sum(i)));
+        for (unsigned long i = 0; i < num_dims; ++i)
+            result.push_back(make_pair(i+MAX_FEAT, all_sum[i]*inv_num_words));
 
         return result;
     }
@@ -62,7 +68,7 @@ namespace mitie
     // ----------------------------------------------------------------------------------------
     text_sample_type extract_combined_features (
             const std::vector<std::string>& words,
-            const std::vector<matrix<float,0,1> >& feats
+            const sentence_features& feats
     )
     {
         text_sample_type result_BoW = extract_BoW_features(words);
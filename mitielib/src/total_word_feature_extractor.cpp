@@ -0,0 +1,100 @@
+// Copyright (C) 2014 Massachusetts Institute of Technology, Lincoln Laboratory
+// License: Boost Software License   See LICENSE.txt for the full license.
+// Authors: Davis E. King (davis@dlib.net)
+
+#include <mitie/total_word_feature_extractor.h>
+#include <dlib/threads.h>
+
+using namespace dlib;
+
+namespace mitie
+{
+
+// ----------------------------------------------------------------------------------------
+
+    namespace
+    {
+        typedef std::map<std::string, matrix<float,0,1> > word_table_type;
+
+        struct word_table_registry
+        {
+            /*!
+                WHAT THIS OBJECT REPRESENTS
+                    This is the record of which word table is used by the
+                    total_word_feature_extractor objects with each fingerprint.  The
+                    registry holds a reference to each table, so a table whose
+                    use_count() is 1 isn't used by anything else and can be freed.  Since
+                    new references to a registered table are only ever made while holding
+                    m, a use_count() of 1 seen while holding m can't go back up.
+            !*/
+            mutex m;
+            std::map<uint64, shared_ptr_thread_safe<const word_table_type> > tables;
+
+            void remove_unused_tables (
+            )
+            {
+                std::map<uint64, shared_ptr_thread_safe<const word_table_type> >::iterator i = tables.begin();
+                while (i != tables.end())
+                {
+                    if (i->second.use_count() == 1)
+                        tables.erase(i++);
+                    else
+                        ++i;
+                }
+            }
+        };
+
+        word_table_registry& get_registry (
+        )
+        {
+            // This is deliberately never deleted.  That way total_word_feature_extractor
+            // objects with static storage duration can still use it while the program is
+            // shutting down.
+            static word_table_registry* registry = new word_table_registry;
+            return *registry;
+        }
+
+        // Make sure the registry is created before main() starts and therefore before
+        // there are multiple threads that might race to create it.
+        struct registry_initializer { registry_initializer() { get_registry(); } } init_registry;
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    void total_word_feature_extractor::
+    share_word_table (
+    )
+    {
+        word_table_registry& registry = get_registry();
+        auto_mutex lock(registry.m);
+        shared_ptr_thread_safe<const word_table_type>& table = registry.tables[fingerprint];
+        if (table && table.use_count() > 1)
+        {
+            total_word_vectors = table;
+        }
+        else
+        {
+            table = total_word_vectors;
+            registry.remove_unused_tables();
+        }
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    void total_word_feature_extractor::
+    release_word_table (
+    )
+    {
+        if (!total_word_vectors)
+            return;
+
+        total_word_vectors.reset();
+        word_table_registry& registry = get_registry();
+        auto_mutex lock(registry.m);
+        registry.remove_unused_tables();
+    }
+
+// ----------------------------------------------------------------------------------------
+
+}
+
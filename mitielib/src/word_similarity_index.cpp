@@ -0,0 +1,360 @@
+// Copyright (C) 2014 Massachusetts Institute of Technology, Lincoln Laboratory
+// License: Boost Software License   See LICENSE.txt for the full license.
+// Authors: Davis E. King (davis@dlib.net)
+
+#include <mitie/word_similarity_index.h>
+#include <dlib/rand.h>
+#include <algorithm>
+#include <functional>
+#include <queue>
+#include <cmath>
+
+using namespace dlib;
+
+namespace mitie
+{
+
+// ----------------------------------------------------------------------------------------
+
+    namespace
+    {
+        void normalize (
+            const matrix<float,0,1>& v,
+            float* dest
+        )
+        {
+            const float len = std::sqrt(dot(v,v));
+            const float scale = (len != 0) ? 1/len : 0;
+            for (long i = 0; i < v.size(); ++i)
+                dest[i] = v(i)*scale;
+        }
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    word_similarity_index::
+    word_similarity_index (
+    ) : fingerprint(0), num_dims(0), max_links(16), search_size(64), entry_point(0)
+    {
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    word_similarity_index::
+    word_similarity_index (
+        const total_word_feature_extractor& fe,
+        unsigned long max_links_,
+        unsigned long build_search_size
+    ) :
+        fingerprint(fe.get_fingerprint()),
+        num_dims(fe.get_num_dimensions()),
+        max_links(max_links_),
+        search_size(64),
+        words(fe.get_words_in_dictionary()),
+        entry_point(0)
+    {
+        DLIB_CASSERT(max_links > 1 && build_search_size > 0,
+            "\t word_similarity_index::word_similarity_index()"
+            << "\n\t Invalid inputs were given to this function."
+            << "\n\t max_links:         " << max_links
+            << "\n\t build_search_size: " << build_search_size
+        );
+
+        vects.resize(words.size()*num_dims);
+        matrix<float,0,1> v;
+        for (unsigned long i = 0; i < words.size(); ++i)
+        {
+            fe.get_feature_vector(words[i], v);
+            normalize(v, &vects[i*num_dims]);
+        }
+
+        // Each word is put into levels 0 through L of the graph where L is drawn from a
+        // geometric distribution.  So each level has about 1/max_links as many words as
+        // the one below it.
+        links.resize(words.size());
+        dlib::rand rnd;
+        const double level_mult = 1/std::log((double)max_links);
+        std::vector<bool> visited(words.size());
+        std::vector<candidate> neighbors;
+        for (unsigned long i = 0; i < words.size(); ++i)
+        {
+            const long level = std::min<long>(30, static_cast<long>(-std::log(1-rnd.get_random_double())*level_mult));
+            links[i].resize(level+1);
+            if (i == 0)
+                continue;
+
+            const long top_level = links[entry_point].size()-1;
+            const float* query = vect(i);
+            neighbors.assign(1, candidate(distance(query, entry_point), entry_point));
+            for (long l = top_level; l > level; --l)
+                search_level(query, neighbors, 1, l, visited);
+
+            for (long l = std::min(level, top_level); l >= 0; --l)
+            {
+                search_level(query, neighbors, build_search_size, l, visited);
+                std::vector<candidate> selected(neighbors);
+                select_links(selected, max_links);
+                for (unsigned long j = 0; j < selected.size(); ++j)
+                {
+                    links[i][l].push_back(selected[j].second);
+                    add_link(selected[j].second, i, l);
+                }
+            }
+
+            if (level > top_level)
+                entry_point = i;
+        }
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    void word_similarity_index::
+    set_search_size (
+        unsigned long size
+    )
+    {
+        DLIB_CASSERT(size > 0, "Invalid inputs were given to this function");
+        search_size = size;
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    void word_similarity_index::
+    find_nearest_words (
+        const matrix<float,0,1>& query,
+        unsigned long k,
+        std::vector<std::pair<std::string,float> >& results
+    ) const
+    {
+        DLIB_CASSERT(query.size() == (long)get_num_dimensions(),
+            "\t word_similarity_index::find_nearest_words()"
+            << "\n\t Invalid inputs were given to this function."
+            << "\n\t query.size():           " << query.size()
+            << "\n\t get_num_dimensions(): " << get_num_dimensions()
+        );
+
+        std::vector<float> q(num_dims);
+        if (num_dims != 0)
+            normalize(query, &q[0]);
+
+        std::vector<candidate> found;
+        search(num_dims != 0 ? &q[0] : 0, k, found);
+        results.clear();
+        for (unsigned long i = 0; i < found.size(); ++i)
+            results.push_back(std::make_pair(words[found[i].second], 1-found[i].first));
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    void word_similarity_index::
+    find_similar_words (
+        const total_word_feature_extractor& fe,
+        const std::string& word,
+        unsigned long k,
+        std::vector<std::pair<std::string,float> >& results
+    ) const
+    {
+        if (fe.get_fingerprint() != get_fingerprint())
+        {
+            throw dlib::error(
+                    "Fingerprint mismatch. "
+                    "Feature extractor must be same as the one used to build the word_similarity_index");
+        }
+
+        matrix<float,0,1> v;
+        fe.get_feature_vector(word, v);
+        // The total_word_feature_extractor looks up numbers with their digits replaced
+        // by #, so that's the form in which word would appear in the dictionary.
+        std::string dict_word(word);
+        for (unsigned long i = 0; i < dict_word.size(); ++i)
+        {
+            if ('0' <= dict_word[i] && dict_word[i] <= '9')
+                dict_word[i] = '#';
+        }
+
+        find_nearest_words(v, k+1, results);
+        for (unsigned long i = 0; i < results.size(); ++i)
+        {
+            if (results[i].first == dict_word)
+            {
+                results.erase(results.begin()+i);
+                break;
+            }
+        }
+        if (results.size() > k)
+            results.resize(k);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    float word_similarity_index::
+    distance (
+        const float* a,
+        dlib::uint32 b
+    ) const
+    {
+        const float* bb = vect(b);
+        float sum = 0;
+        for (unsigned long i = 0; i < num_dims; ++i)
+            sum += a[i]*bb[i];
+        return 1-sum;
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    void word_similarity_index::
+    search_level (
+        const float* query,
+        std::vector<candidate>& entry_points,
+        unsigned long num_candidates,
+        unsigned long level,
+        std::vector<bool>& visited
+    ) const
+    /*!
+        requires
+            - all elements of visited are false
+            - entry_points contains words that are in the given level of the graph.
+        ensures
+            - Does a best first search of the given level of the graph, starting at the
+              entry points, for the num_candidates words nearest to query.
+            - #entry_points == the nearest words found, sorted by increasing distance.
+            - #visited is left with all elements set to false.
+    !*/
+    {
+        std::priority_queue<candidate, std::vector<candidate>, std::greater<candidate> > to_visit;
+        std::priority_queue<candidate> found;
+        std::vector<dlib::uint32> touched;
+        for (unsigned long i = 0; i < entry_points.size(); ++i)
+        {
+            visited[entry_points[i].second] = true;
+            touched.push_back(entry_points[i].second);
+            to_visit.push(entry_points[i]);
+            found.push(entry_points[i]);
+        }
+        while (found.size() > num_candidates)
+            found.pop();
+
+        while (!to_visit.empty())
+        {
+            const candidate c = to_visit.top();
+            // Nothing left to visit can get us a better set of words.
+            if (found.size() >= num_candidates && c.first > found.top().first)
+                break;
+            to_visit.pop();
+
+            const std::vector<dlib::uint32>& nbrs = links[c.second][level];
+            for (unsigned long i = 0; i < nbrs.size(); ++i)
+            {
+                const dlib::uint32 id = nbrs[i];
+                if (visited[id])
+                    continue;
+                visited[id] = true;
+                touched.push_back(id);
+
+                const float d = distance(query, id);
+                if (found.size() < num_candidates || d < found.top().first)
+                {
+                    to_visit.push(candidate(d,id));
+                    found.push(candidate(d,id));
+                    if (found.size() > num_candidates)
+                        found.pop();
+                }
+            }
+        }
+
+        for (unsigned long i = 0; i < touched.size(); ++i)
+            visited[touched[i]] = false;
+
+        entry_points.resize(found.size());
+        for (unsigned long i = entry_points.size(); i > 0; --i)
+        {
+            entry_points[i-1] = found.top();
+            found.pop();
+        }
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    void word_similarity_index::
+    select_links (
+        std::vector<candidate>& candidates,
+        unsigned long max_num
+    ) const
+    /*!
+        requires
+            - candidates is sorted by increasing distance
+        ensures
+            - Picks at most max_num of the candidates to link to.  A candidate is skipped
+              if it is closer to one of the already picked candidates than to the word
+              being linked.  This spreads the links out in different directions which
+              makes the graph much easier to navigate than if we just kept the nearest
+              max_num words.
+    !*/
+    {
+        std::vector<candidate> selected;
+        for (unsigned long i = 0; i < candidates.size() && selected.size() < max_num; ++i)
+        {
+            const float* c = vect(candidates[i].second);
+            bool keep = true;
+            for (unsigned long j = 0; j < selected.size() && keep; ++j)
+                keep = distance(c, selected[j].second) >= candidates[i].first;
+            if (keep)
+                selected.push_back(candidates[i]);
+        }
+        candidates.swap(selected);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    void word_similarity_index::
+    add_link (
+        dlib::uint32 from,
+        dlib::uint32 to,
+        unsigned long level
+    )
+    {
+        std::vector<dlib::uint32>& nbrs = links[from][level];
+        nbrs.push_back(to);
+        // The bottom level holds every word so we let it be a bit more densely linked.
+        const unsigned long max_num = (level == 0) ? 2*max_links : max_links;
+        if (nbrs.size() <= max_num)
+            return;
+
+        std::vector<candidate> candidates;
+        for (unsigned long i = 0; i < nbrs.size(); ++i)
+            candidates.push_back(candidate(distance(vect(from), nbrs[i]), nbrs[i]));
+        std::sort(candidates.begin(), candidates.end());
+        select_links(candidates, max_num);
+        nbrs.clear();
+        for (unsigned long i = 0; i < candidates.size(); ++i)
+            nbrs.push_back(candidates[i].second);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+    void word_similarity_index::
+    search (
+        const float* query,
+        unsigned long k,
+        std::vector<candidate>& results
+    ) const
+    {
+        results.clear();
+        if (size() == 0 || k == 0)
+            return;
+
+        std::vector<bool> visited(size());
+        results.assign(1, candidate(distance(query, entry_point), entry_point));
+        // Walk greedily down through the sparse upper levels to find a good place to
+        // start the real search in the bottom level.
+        for (long l = links[entry_point].size()-1; l > 0; --l)
+            search_level(query, results, 1, l, visited);
+        search_level(query, results, std::max(k, search_size), 0, visited);
+        if (results.size() > k)
+            results.resize(k);
+    }
+
+// ----------------------------------------------------------------------------------------
+
+}
+
@@ -10,6 +10,7 @@
 #include <mitie/conll_tokenizer.h>
 #include <mitie/named_entity_extractor.h>
 #include <mitie/ner_trainer.h>
+#include <dlib/threads.h>
 
 #include <Rcpp.h>
 
@@ -183,6 +184,143 @@ RcppExport SEXP mitie_extract_entities_R (
     VOID_END_RCPP
 }
 
+namespace
+{
+    struct batch_ner_job
+    {
+        /*
+            Runs a named_entity_extractor over a whole batch of documents.  Each document
+            is either raw text, which is tokenized here, or an already tokenized sentence.
+            Nothing in here touches the R API, so process() can be run from any thread.
+            Each block of documents given to process() reuses one word feature buffer.
+        */
+        batch_ner_job (
+            const named_entity_extractor& ner_,
+            const bool tokenized_
+        ) : ner(ner_), tokenized(tokenized_) {}
+
+        const named_entity_extractor& ner;
+        const bool tokenized;
+
+        vector<string> texts;
+        vector<vector<string> > tokens;
+        vector<vector<pair<unsigned long, unsigned long> > > ranges;
+        vector<vector<unsigned long> > labels;
+        vector<vector<double> > scores;
+
+        dlib::mutex m;
+        string error_message;
+
+        void resize (unsigned long num_docs)
+        {
+            tokens.resize(num_docs);
+            ranges.resize(num_docs);
+            labels.resize(num_docs);
+            scores.resize(num_docs);
+        }
+
+        void process (long begin, long end)
+        {
+            sentence_features feats;
+            for (long i = begin; i < end; ++i)
+            {
+                try
+                {
+                    if (!tokenized)
+                    {
+                        istringstream sin(texts[i]);
+                        conll_tokenizer tok(sin);
+                        string token;
+                        while (tok(token))
+                            tokens[i].push_back(token);
+                    }
+                    ner.predict(tokens[i], ranges[i], labels[i], scores[i],
+                                ner.get_total_word_feature_extractor(), feats);
+                }
+                catch (std::exception& e)
+                {
+                    dlib::auto_mutex lock(m);
+                    error_message = e.what();
+                }
+            }
+        }
+    };
+}
+
+RcppExport SEXP mitie_extract_entities_batch_R (
+    SEXP _ner,
+    SEXP _docs,
+    SEXP _num_threads
+)
+{
+    BEGIN_RCPP
+    named_entity_extractor* ner = Rcpp::XPtr<named_entity_extractor>(_ner);
+    const unsigned long num_threads = Rcpp::as<unsigned long>(_num_threads);
+
+    // Pull everything out of R objects up front since the R API must only be used from
+    // this thread.
+    const bool tokenized = !Rf_isString(_docs);
+    batch_ner_job job(*ner, tokenized);
+    if (tokenized)
+    {
+        Rcpp::List docs(_docs);
+        job.resize(docs.size());
+        for (long i = 0; i < docs.size(); ++i)
+            job.tokens[i] = Rcpp::as<vector<string> >(docs[i]);
+    }
+    else
+    {
+        job.texts = Rcpp::as<vector<string> >(_docs);
+        job.resize(job.texts.size());
+    }
+
+    dlib::parallel_for_blocked(num_threads, 0, job.ranges.size(), job, &batch_ner_job::process);
+    if (job.error_message.size() != 0)
+        throw std::runtime_error(job.error_message);
+
+    vector<string> tags = ner->get_tag_name_strings();
+
+    // build a long format data frame with one row per entity
+    vector<int> doc_col, start_col, end_col, tag_col;
+    vector<double> score_col;
+    vector<string> tag_name_col, text_col;
+    for (unsigned long i = 0; i < job.ranges.size(); ++i)
+    {
+        for (unsigned long j = 0; j < job.ranges[i].size(); ++j)
+        {
+            const pair<unsigned long, unsigned long>& r = job.ranges[i][j];
+            string text;
+            for (unsigned long k = r.first; k < r.second; ++k)
+            {
+                if (k != r.first)
+                    text += " ";
+                text += job.tokens[i][k];
+            }
+
+            // same 1-based index conventions as mitie_extract_entities_R()
+            doc_col.push_back(i + 1);
+            start_col.push_back(r.first + 1);
+            end_col.push_back(r.second);
+            tag_col.push_back(job.labels[i][j] + 1);
+            tag_name_col.push_back(tags[job.labels[i][j]]);
+            score_col.push_back(job.scores[i][j]);
+            text_col.push_back(text);
+        }
+    }
+
+    return Rcpp::DataFrame::create(
+        Rcpp::Named("doc") = doc_col,
+        Rcpp::Named("start") = start_col,
+        Rcpp::Named("end") = end_col,
+        Rcpp::Named("tag") = tag_col,
+        Rcpp::Named("tag_name") = tag_name_col,
+        Rcpp::Named("score") = score_col,
+        Rcpp::Named("text") = text_col,
+        Rcpp::Named("stringsAsFactors") = false
+    );
+    VOID_END_RCPP
+}
+
 // ------------------------------------------------------------------------------------------------
 // binary relation detection
 // ------------------------------------------------------------------------------------------------
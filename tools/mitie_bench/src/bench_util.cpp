@@ -0,0 +1,259 @@
+// Copyright (C) 2014 Massachusetts Institute of Technology, Lincoln Laboratory
+// License: Boost Software License   See LICENSE.txt for the full license.
+// Authors: Davis E. King (davis@dlib.net)
+
+#include "bench_util.h"
+#include <iostream>
+#include <fstream>
+#include <map>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <mitie/conll_tokenizer.h>
+#include <dlib/rand.h>
+#include <dlib/serialize.h>
+#ifndef _WIN32
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+using namespace dlib;
+using namespace mitie;
+
+// ----------------------------------------------------------------------------------------
+
+static std::string make_temp_filename (
+)
+/*!
+    ensures
+        - creates a new empty file with a unique name in the temporary directory and
+          returns its name.
+!*/
+{
+#ifndef _WIN32
+    const char* dir = getenv("TMPDIR");
+    const std::string name = std::string(dir && *dir ? dir : "/tmp") + "/mitie_bench_fe_XXXXXX";
+    std::vector<char> buf(name.begin(), name.end());
+    buf.push_back('\0');
+    const int fd = mkstemp(&buf[0]);
+    if (fd == -1)
+        throw dlib::error("Unable to create a temporary file in " + name.substr(0, name.rfind('/')) +
+            ": " + std::strerror(errno));
+    close(fd);
+    return &buf[0];
+#else
+    char buf[L_tmpnam];
+    if (std::tmpnam(buf) == 0)
+        throw dlib::error("Unable to make a temporary file name.");
+    return buf;
+#endif
+}
+
+// ----------------------------------------------------------------------------------------
+
+trainer_setup::
+trainer_setup (
+    const total_word_feature_extractor& fe
+) :
+    fe_filename(make_temp_filename())
+{
+    try
+    {
+        serialize(fe_filename) << "mitie::total_word_feature_extractor" << fe;
+    }
+    catch (...)
+    {
+        std::remove(fe_filename.c_str());
+        throw;
+    }
+    cout_buf = cout.rdbuf(cerr.rdbuf());
+}
+
+trainer_setup::
+~trainer_setup (
+)
+{
+    cout.rdbuf(cout_buf);
+    std::remove(fe_filename.c_str());
+}
+
+// ----------------------------------------------------------------------------------------
+
+std::vector<std::string> tokenize (
+    const std::string& text
+)
+{
+    istringstream sin(text);
+    conll_tokenizer tok(sin);
+    std::vector<std::string> words;
+    string word;
+    while(tok(word))
+        words.push_back(word);
+
+    return words;
+}
+
+// ----------------------------------------------------------------------------------------
+
+static std::string convert_numbers (
+    std::string str
+)
+{
+    // total_word_feature_extractor looks up words with their digits replaced by #.
+    for (unsigned long i = 0; i < str.size(); ++i)
+    {
+        if ('0' <= str[i] && str[i] <= '9')
+            str[i] = '#';
+    }
+    return str;
+}
+
+static matrix<float,0,1> random_vector (
+    const std::string& word,
+    long dims
+)
+{
+    dlib::rand rnd(word);
+    matrix<float,0,1> v(dims);
+    for (long j = 0; j < v.size(); ++j)
+        v(j) = rnd.get_random_gaussian();
+    return v;
+}
+
+total_word_feature_extractor make_word_feature_extractor (
+    const std::vector<std::vector<std::string> >& sentences,
+    approximate_substring_set& substrings
+)
+{
+    std::map<std::string, matrix<float,0,1> > word_vectors;
+    for (unsigned long i = 0; i < sentences.size(); ++i)
+    {
+        for (unsigned long j = 0; j < sentences[i].size(); ++j)
+        {
+            const std::string word = convert_numbers(sentences[i][j]);
+            matrix<float,0,1>& v = word_vectors[word];
+            if (v.size() == 0)
+                v = 0.1*random_vector(word, num_word_dims);
+
+            const std::string left = j > 0 ? convert_numbers(sentences[i][j-1]) : "<s>";
+            const std::string right = j+1 < sentences[i].size() ? convert_numbers(sentences[i][j+1]) : "</s>";
+            set_rowm(v, range(0, num_word_dims/2-1)) += random_vector(left, num_word_dims/2);
+            set_rowm(v, range(num_word_dims/2, num_word_dims-1)) += random_vector(right, num_word_dims/2);
+        }
+    }
+
+    std::map<std::string, matrix<float,0,1> >::const_iterator i;
+    for (i = word_vectors.begin(); i != word_vectors.end(); ++i)
+    {
+        const std::string word = "*" + i->first + "*";
+        for (unsigned long len = 2; len <= 4; ++len)
+        {
+            for (unsigned long pos = 0; pos + len <= word.size(); ++pos)
+                substrings.add_substring(word.substr(pos, len));
+        }
+    }
+
+    dlib::rand rnd("mitie_bench morphology");
+    matrix<float> morph_trans(substrings.max_substring_id()+1, num_morph_dims);
+    for (long r = 0; r < morph_trans.nr(); ++r)
+    {
+        for (long c = 0; c < morph_trans.nc(); ++c)
+            morph_trans(r,c) = rnd.get_random_gaussian();
+    }
+
+    return total_word_feature_extractor(word_vectors, word_morphology_feature_extractor(substrings, morph_trans));
+}
+
+// ----------------------------------------------------------------------------------------
+
+bool reset_peak_rss (
+)
+{
+    // Writing 5 to clear_refs resets the VmHWM field of /proc/self/status.
+    ofstream fout("/proc/self/clear_refs");
+    fout << "5" << flush;
+    return fout.good();
+}
+
+unsigned long peak_rss_kb (
+)
+{
+    ifstream fin("/proc/self/status");
+    string line;
+    while (getline(fin, line))
+    {
+        if (line.compare(0, 6, "VmHWM:") == 0)
+        {
+            istringstream sin(line.substr(6));
+            unsigned long kb = 0;
+            sin >> kb;
+            return kb;
+        }
+    }
+
+#ifndef _WIN32
+    // There isn't a /proc file system so fall back to getrusage(), which reports the
+    // peak over the whole life of the process.
+    rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) == 0)
+    {
+#ifdef __APPLE__
+        // OS X reports bytes rather than kilobytes.
+        return usage.ru_maxrss/1024;
+#else
+        return usage.ru_maxrss;
+#endif
+    }
+#endif
+    return 0;
+}
+
+// ----------------------------------------------------------------------------------------
+
+std::string json_string (
+    const std::string& str
+)
+{
+    std::string out = "\"";
+    for (unsigned long i = 0; i < str.size(); ++i)
+    {
+        if (str[i] == '"' || str[i] == '\\')
+            out += '\\';
+        out += str[i];
+    }
+    return out + "\"";
+}
+
+void add_build_info (
+    std::vector<std::pair<std::string,std::string> >& items
+)
+{
+#ifdef ENABLE_ASSERTS
+    items.push_back(json_item("asserts_enabled", "true"));
+#else
+    items.push_back(json_item("asserts_enabled", "false"));
+#endif
+#ifdef __VERSION__
+    items.push_back(json_item("compiler", json_string(__VERSION__)));
+#endif
+}
+
+void write_json_object (
+    std::ostream& out,
+    const std::vector<std::pair<std::string,std::string> >& items,
+    const std::string& indent
+)
+{
+    out << "{\n";
+    for (unsigned long i = 0; i < items.size(); ++i)
+    {
+        out << indent << "  " << json_string(items[i].first) << ": " << items[i].second;
+        out << (i+1 < items.size() ? ",\n" : "\n");
+    }
+    out << indent << "}";
+}
+
+// ----------------------------------------------------------------------------------------
+
@@ -0,0 +1,155 @@
+// Copyright (C) 2014 Massachusetts Institute of Technology, Lincoln Laboratory
+// License: Boost Software License   See LICENSE.txt for the full license.
+// Authors: Davis E. King (davis@dlib.net)
+#ifndef MIT_LL_BENCH_UTiL_H_
+#define MIT_LL_BENCH_UTiL_H_
+
+#include <string>
+#include <vector>
+#include <sstream>
+#include <utility>
+#include <dlib/noncopyable.h>
+#include <mitie/total_word_feature_extractor.h>
+#include <mitie/approximate_substring_set.h>
+
+// ----------------------------------------------------------------------------------------
+
+// The standard MITIE English models have 180 word dimensions, 1 OOV indicator, and 90
+// morphology dimensions.  We use the same sizes so the benchmarks run the same code
+// paths as the real models.
+const long num_word_dims = 180;
+const long num_morph_dims = 90;
+
+// ----------------------------------------------------------------------------------------
+
+class trainer_setup : dlib::noncopyable
+{
+    /*!
+        WHAT THIS OBJECT REPRESENTS
+            The trainers load their feature extractor from a file and print their
+            progress to cout.  While this object exists, it keeps a feature extractor
+            saved in a uniquely named temporary file for the trainers to load and sends
+            cout to cerr so the progress messages stay out of the JSON output.  Its
+            destructor deletes the file and restores cout, even when a trainer throws.
+    !*/
+
+public:
+
+    explicit trainer_setup (
+        const mitie::total_word_feature_extractor& fe
+    );
+    /*!
+        ensures
+            - saves fe to the file get_fe_filename().
+            - sends cout to cerr until this object is destructed.
+        throws
+            - dlib::error if the file can't be created.
+    !*/
+
+    ~trainer_setup (
+    );
+
+    const std::string& get_fe_filename (
+    ) const { return fe_filename; }
+
+private:
+    std::string fe_filename;
+    std::streambuf* cout_buf;
+};
+
+// ----------------------------------------------------------------------------------------
+
+std::vector<std::string> tokenize (
+    const std::string& text
+);
+/*!
+    ensures
+        - returns the tokens conll_tokenizer finds in text.
+!*/
+
+mitie::total_word_feature_extractor make_word_feature_extractor (
+    const std::vector<std::vector<std::string> >& sentences,
+    mitie::approximate_substring_set& substrings
+);
+/*!
+    ensures
+        - Builds a total_word_feature_extractor for the words in sentences.  The word
+          vectors are random projections of the words that appear to the left and right
+          of each word, so words used in similar contexts get similar vectors.  The
+          morphology features come from a random projection of the 2 to 4 character
+          substrings of the words.  The random numbers are seeded by the words, so the
+          same sentences always give the same feature extractor.
+        - #substrings == the substring set used by the returned object's morphology
+          feature extractor.
+!*/
+
+// ----------------------------------------------------------------------------------------
+
+bool reset_peak_rss (
+);
+/*!
+    ensures
+        - Tries to reset the peak resident set size of this process to its current size,
+          so the next call to peak_rss_kb() only reports the memory used after this
+          call.  Returns true if it worked.  This only works on Linux.
+!*/
+
+unsigned long peak_rss_kb (
+);
+/*!
+    ensures
+        - returns the peak resident set size of this process in kilobytes, or 0 if it
+          can't be found.
+!*/
+
+// ----------------------------------------------------------------------------------------
+
+std::string json_string (
+    const std::string& str
+);
+/*!
+    ensures
+        - returns str as a quoted and escaped JSON string.
+!*/
+
+template <typename T>
+std::pair<std::string,std::string> json_item (
+    const std::string& name,
+    const T& value
+)
+/*!
+    ensures
+        - returns a name and value pair where the value has been converted to a string.
+          The string is written into the JSON output as is, so non-numeric values should
+          be passed through json_string() first.
+!*/
+{
+    std::ostringstream sout;
+    sout.precision(10);
+    sout << value;
+    return std::make_pair(name, sout.str());
+}
+
+void add_build_info (
+    std::vector<std::pair<std::string,std::string> >& items
+);
+/*!
+    ensures
+        - adds JSON items describing how this program was compiled to items.
+!*/
+
+void write_json_object (
+    std::ostream& out,
+    const std::vector<std::pair<std::string,std::string> >& items,
+    const std::string& indent
+);
+/*!
+    ensures
+        - writes items to out as a JSON object, one item per line, with each line
+          starting with indent.
+!*/
+
+// ----------------------------------------------------------------------------------------
+
+#endif // MIT_LL_BENCH_UTiL_H_
+
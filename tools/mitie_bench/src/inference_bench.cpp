@@ -0,0 +1,600 @@
+// Copyright (C) 2014 Massachusetts Institute of Technology, Lincoln Laboratory
+// License: Boost Software License   See LICENSE.txt for the full license.
+// Authors: Davis E. King (davis@dlib.net)
+
+#include "inference_bench.h"
+#include "bench_util.h"
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <mitie/named_entity_extractor.h>
+#include <mitie/ner_trainer.h>
+#include <mitie/text_categorizer.h>
+#include <mitie/text_categorizer_trainer.h>
+#include <mitie/binary_relation_detector.h>
+#include <dlib/misc_api.h>
+#include <dlib/serialize.h>
+
+using namespace std;
+using namespace dlib;
+using namespace mitie;
+
+// ----------------------------------------------------------------------------------------
+
+// Everything the benchmarks compute gets added into this so the compiler can't optimize
+// the work away.
+static volatile double bench_sink = 0;
+
+// ----------------------------------------------------------------------------------------
+
+struct labeled_sentence
+{
+    std::vector<std::string> tokens;
+    std::vector<std::pair<unsigned long,unsigned long> > ranges;
+    std::vector<std::string> labels;
+    unsigned long paragraph;
+};
+std::vector<std::string> read_lines (
+    const std::string& filename
+)
+/*!
+    ensures
+        - returns all the non-empty lines in the given file.
+!*/
+{
+    ifstream fin(filename.c_str());
+    if (!fin)
+        throw dlib::error("Unable to open file " + filename);
+
+    std::vector<std::string> lines;
+    string line;
+    while (getline(fin, line))
+    {
+        if (line.find_first_not_of(" \t\r") != string::npos)
+            lines.push_back(line);
+    }
+    return lines;
+}
+
+std::vector<labeled_sentence> parse_reference_output (
+    const std::vector<std::string>& lines
+)
+/*!
+    ensures
+        - Parses text in the format output by ner_stream, where each entity is written
+          as [TAG word word].  Each line is split into sentences at sentence ending
+          punctuation and the sentences are returned.
+!*/
+{
+    std::vector<labeled_sentence> sentences;
+    for (unsigned long p = 0; p < lines.size(); ++p)
+    {
+        istringstream sin(lines[p]);
+        labeled_sentence sent;
+        sent.paragraph = p;
+        string word;
+        bool in_entity = false;
+        while (sin >> word)
+        {
+            if (!in_entity && word.size() > 1 && word[0] == '[')
+            {
+                in_entity = true;
+                sent.labels.push_back(word.substr(1));
+                sent.ranges.push_back(make_pair(sent.tokens.size(), sent.tokens.size()));
+                continue;
+            }
+
+            bool end_entity = false;
+            if (in_entity && word.size() > 1 && word[word.size()-1] == ']')
+            {
+                word.resize(word.size()-1);
+                end_entity = true;
+            }
+            else if (in_entity && word == "]")
+            {
+                in_entity = false;
+                continue;
+            }
+
+            sent.tokens.push_back(word);
+            if (in_entity)
+                sent.ranges.back().second = sent.tokens.size();
+            if (end_entity)
+                in_entity = false;
+
+            if (!in_entity && (word == "." || word == "?" || word == "!"))
+            {
+                sentences.push_back(sent);
+                sent = labeled_sentence();
+                sent.paragraph = p;
+            }
+        }
+        if (sent.tokens.size() != 0)
+            sentences.push_back(sent);
+    }
+    return sentences;
+}
+// ----------------------------------------------------------------------------------------
+
+struct bench_options
+{
+    double min_time;
+    unsigned long repeats;
+};
+
+struct bench_result
+{
+    std::string name;
+    std::string unit;
+    unsigned long items_per_op;
+    unsigned long iterations;
+    double ns_per_op_median;
+    double ns_per_op_min;
+};
+
+std::vector<bench_result> results;
+
+template <typename benchmark>
+void run_benchmark (
+    const std::string& name,
+    const std::string& unit,
+    unsigned long items_per_op,
+    benchmark& op,
+    const bench_options& opts
+)
+/*!
+    ensures
+        - Calls op() enough times to measure how long one call takes and adds the
+          result to results.  op() is called in opts.repeats batches of equal size and
+          each batch runs for at least opts.min_time/opts.repeats seconds.  The median
+          and fastest batches are reported.
+!*/
+{
+    timestamper ts;
+    const double batch_time = 1e6*opts.min_time/opts.repeats;
+
+    // warm up the caches and find how many calls make a batch long enough.
+    op();
+    unsigned long iterations = 1;
+    while (true)
+    {
+        const uint64 start = ts.get_timestamp();
+        for (unsigned long i = 0; i < iterations; ++i)
+            op();
+        const double elapsed = ts.get_timestamp() - start;
+        if (elapsed >= batch_time)
+            break;
+        if (elapsed < batch_time/10)
+            iterations *= 10;
+        else
+            iterations = static_cast<unsigned long>(iterations*1.2*batch_time/elapsed) + 1;
+    }
+
+    std::vector<double> ns_per_op;
+    for (unsigned long r = 0; r < opts.repeats; ++r)
+    {
+        const uint64 start = ts.get_timestamp();
+        for (unsigned long i = 0; i < iterations; ++i)
+            op();
+        ns_per_op.push_back(1000.0*(ts.get_timestamp() - start)/iterations);
+    }
+    std::sort(ns_per_op.begin(), ns_per_op.end());
+
+    bench_result res;
+    res.name = name;
+    res.unit = unit;
+    res.items_per_op = items_per_op;
+    res.iterations = iterations;
+    res.ns_per_op_median = ns_per_op[ns_per_op.size()/2];
+    res.ns_per_op_min = ns_per_op[0];
+    results.push_back(res);
+
+    cerr << "  " << name << ": " << res.ns_per_op_median/items_per_op << " ns per " << unit << endl;
+}
+
+// ----------------------------------------------------------------------------------------
+//                                   The benchmarks
+// ----------------------------------------------------------------------------------------
+
+struct bench_tokenizer
+{
+    const std::vector<std::string>& lines;
+    bench_tokenizer(const std::vector<std::string>& lines_) : lines(lines_) {}
+
+    void operator() ()
+    {
+        for (unsigned long i = 0; i < lines.size(); ++i)
+            bench_sink += tokenize(lines[i]).size();
+    }
+};
+
+struct bench_word_features
+{
+    const total_word_feature_extractor& fe;
+    const std::vector<std::string>& words;
+    matrix<float,0,1> feats;
+    bench_word_features(const total_word_feature_extractor& fe_, const std::vector<std::string>& words_) : fe(fe_), words(words_) {}
+
+    void operator() ()
+    {
+        for (unsigned long i = 0; i < words.size(); ++i)
+        {
+            fe.get_feature_vector(words[i], feats);
+            bench_sink += feats(0);
+        }
+    }
+};
+
+struct bench_find_substrings
+{
+    const approximate_substring_set& substrings;
+    const std::vector<std::string>& words;
+    std::vector<uint16> hits;
+    bench_find_substrings(const approximate_substring_set& substrings_, const std::vector<std::string>& words_) : substrings(substrings_), words(words_) {}
+
+    void operator() ()
+    {
+        for (unsigned long i = 0; i < words.size(); ++i)
+        {
+            substrings.find_substrings(words[i], hits);
+            bench_sink += hits.size();
+        }
+    }
+};
+
+struct bench_sentence_to_feats
+{
+    const total_word_feature_extractor& fe;
+    const std::vector<std::vector<std::string> >& sentences;
+    sentence_features feats;
+    bench_sentence_to_feats(const total_word_feature_extractor& fe_, const std::vector<std::vector<std::string> >& sentences_) : fe(fe_), sentences(sentences_) {}
+
+    void operator() ()
+    {
+        for (unsigned long i = 0; i < sentences.size(); ++i)
+        {
+            sentence_to_feats(fe, sentences[i], feats);
+            bench_sink += feats.size();
+        }
+    }
+};
+
+struct bench_segment_sequence
+{
+    const named_entity_extractor& ner;
+    const std::vector<sentence_features>& feats;
+    std::vector<std::pair<unsigned long,unsigned long> > chunks;
+    bench_segment_sequence(const named_entity_extractor& ner_, const std::vector<sentence_features>& feats_) : ner(ner_), feats(feats_) {}
+
+    void operator() ()
+    {
+        for (unsigned long i = 0; i < feats.size(); ++i)
+        {
+            ner.get_segmenter().segment_sequence(feats[i], chunks);
+            bench_sink += chunks.size();
+        }
+    }
+};
+
+struct chunk_location
+{
+    unsigned long sentence;
+    std::pair<unsigned long,unsigned long> range;
+};
+
+struct bench_chunk_features
+{
+    const std::vector<std::vector<std::string> >& sentences;
+    const std::vector<sentence_features>& feats;
+    const std::vector<chunk_location>& chunks;
+    const dense_chunk_feature_extractor dense_fe;
+    bench_chunk_features(
+        const std::vector<std::vector<std::string> >& sentences_,
+        const std::vector<sentence_features>& feats_,
+        const std::vector<chunk_location>& chunks_,
+        unsigned long num_dims
+    ) : sentences(sentences_), feats(feats_), chunks(chunks_), dense_fe(num_dims) {}
+
+    void operator() ()
+    {
+        for (unsigned long i = 0; i < chunks.size(); ++i)
+        {
+            const unsigned long s = chunks[i].sentence;
+            bench_sink += extract_ner_chunk_features(sentences[s], feats[s], chunks[i].range, dense_fe).size();
+        }
+    }
+};
+
+struct bench_chunk_classification
+{
+    const named_entity_extractor& ner;
+    const std::vector<ner_sample_type>& samples;
+    bench_chunk_classification(const named_entity_extractor& ner_, const std::vector<ner_sample_type>& samples_) : ner(ner_), samples(samples_) {}
+
+    void operator() ()
+    {
+        for (unsigned long i = 0; i < samples.size(); ++i)
+            bench_sink += ner.get_df().predict(samples[i]).second;
+    }
+};
+
+struct bench_text_categorizer
+{
+    const text_categorizer& tcat;
+    const std::vector<std::vector<std::string> >& sentences;
+    std::string tag;
+    double score;
+    bench_text_categorizer(const text_categorizer& tcat_, const std::vector<std::vector<std::string> >& sentences_) : tcat(tcat_), sentences(sentences_) {}
+
+    void operator() ()
+    {
+        for (unsigned long i = 0; i < sentences.size(); ++i)
+        {
+            tcat.predict(sentences[i], tag, score);
+            bench_sink += score;
+        }
+    }
+};
+
+struct relation_location
+{
+    unsigned long sentence;
+    std::pair<unsigned long,unsigned long> arg1;
+    std::pair<unsigned long,unsigned long> arg2;
+};
+
+struct bench_binary_relation
+{
+    const total_word_feature_extractor& fe;
+    const std::vector<std::vector<std::string> >& sentences;
+    const std::vector<relation_location>& relations;
+    bench_binary_relation(
+        const total_word_feature_extractor& fe_,
+        const std::vector<std::vector<std::string> >& sentences_,
+        const std::vector<relation_location>& relations_
+    ) : fe(fe_), sentences(sentences_), relations(relations_) {}
+
+    void operator() ()
+    {
+        for (unsigned long i = 0; i < relations.size(); ++i)
+        {
+            const relation_location& r = relations[i];
+            bench_sink += extract_binary_relation(sentences[r.sentence], r.arg1, r.arg2, fe).feats.size();
+        }
+    }
+};
+
+struct bench_end_to_end
+{
+    const named_entity_extractor& ner;
+    const std::vector<std::string>& lines;
+    std::vector<std::pair<unsigned long,unsigned long> > chunks;
+    std::vector<unsigned long> chunk_tags;
+    bench_end_to_end(const named_entity_extractor& ner_, const std::vector<std::string>& lines_) : ner(ner_), lines(lines_) {}
+
+    void operator() ()
+    {
+        // This is what ner_stream does with each line of its input.
+        for (unsigned long i = 0; i < lines.size(); ++i)
+        {
+            ner(tokenize(lines[i]), chunks, chunk_tags);
+            bench_sink += chunks.size();
+        }
+    }
+};
+
+// ----------------------------------------------------------------------------------------
+
+void write_inference_json (
+    std::ostream& out,
+    const std::vector<std::pair<std::string,std::string> >& context
+)
+{
+    out.precision(10);
+    out << "{\n";
+    out << "  \"context\": ";
+    write_json_object(out, context, "  ");
+    out << ",\n";
+    out << "  \"benchmarks\": [\n";
+    for (unsigned long i = 0; i < results.size(); ++i)
+    {
+        const bench_result& r = results[i];
+        out << "    {";
+        out << "\"name\": " << json_string(r.name) << ", ";
+        out << "\"unit\": " << json_string(r.unit) << ", ";
+        out << "\"items_per_op\": " << r.items_per_op << ", ";
+        out << "\"iterations\": " << r.iterations << ", ";
+        out << "\"ns_per_op\": " << r.ns_per_op_median << ", ";
+        out << "\"ns_per_op_min\": " << r.ns_per_op_min << ", ";
+        out << "\"ns_per_item\": " << r.ns_per_op_median/r.items_per_op << ", ";
+        out << "\"items_per_second\": " << 1e9*r.items_per_op/r.ns_per_op_median;
+        out << (i+1 < results.size() ? "},\n" : "}\n");
+    }
+    out << "  ]\n";
+    out << "}\n";
+}
+
+// ----------------------------------------------------------------------------------------
+
+named_entity_extractor train_ner (
+    const total_word_feature_extractor& fe,
+    const std::vector<labeled_sentence>& labeled,
+    unsigned long num_threads
+)
+/*!
+    ensures
+        - returns a named_entity_extractor trained on labeled with fe.
+!*/
+{
+    const trainer_setup setup(fe);
+    ner_trainer ner_train(setup.get_fe_filename());
+    ner_train.set_num_threads(num_threads);
+    for (unsigned long i = 0; i < labeled.size(); ++i)
+        ner_train.add(labeled[i].tokens, labeled[i].ranges, labeled[i].labels);
+    return ner_train.train();
+}
+
+text_categorizer train_text_categorizer (
+    const total_word_feature_extractor& fe,
+    const std::vector<labeled_sentence>& labeled,
+    unsigned long num_threads
+)
+/*!
+    ensures
+        - returns a text_categorizer trained with fe to tell which paragraph each
+          sentence in labeled came from.
+!*/
+{
+    const trainer_setup setup(fe);
+    text_categorizer_trainer tcat_train(setup.get_fe_filename());
+    tcat_train.set_num_threads(num_threads);
+    for (unsigned long i = 0; i < labeled.size(); ++i)
+        tcat_train.add(labeled[i].tokens, "paragraph " + cast_to_string(labeled[i].paragraph));
+    return tcat_train.train();
+}
+
+// ----------------------------------------------------------------------------------------
+
+void inference_bench (
+    const command_line_parser& parser,
+    std::ostream& out
+)
+{
+    const std::string text_file = get_option(parser, "text", "sample_text.txt");
+    const std::string labels_file = get_option(parser, "labels", "sample_text.reference-output");
+    const unsigned long num_threads = get_option(parser, "threads", 4);
+    bench_options opts;
+    opts.min_time = get_option(parser, "min-time", 1.0);
+    opts.repeats = get_option(parser, "repeats", 5);
+
+    // Load the text and build the models.
+    const std::vector<std::string> lines = read_lines(text_file);
+    const std::vector<labeled_sentence> labeled = parse_reference_output(read_lines(labels_file));
+    if (labeled.size() < 2)
+        throw dlib::error("There must be at least 2 sentences in " + labels_file);
+
+    std::vector<std::vector<std::string> > sentences;
+    for (unsigned long i = 0; i < labeled.size(); ++i)
+        sentences.push_back(labeled[i].tokens);
+    std::vector<std::vector<std::string> > tokenized_lines;
+    unsigned long num_tokens = 0;
+    for (unsigned long i = 0; i < lines.size(); ++i)
+    {
+        tokenized_lines.push_back(tokenize(lines[i]));
+        num_tokens += tokenized_lines.back().size();
+    }
+    std::vector<std::vector<std::string> > all_text = tokenized_lines;
+    all_text.insert(all_text.end(), sentences.begin(), sentences.end());
+
+    cerr << "Building word feature extractor..." << endl;
+    approximate_substring_set substrings;
+    const total_word_feature_extractor fe = make_word_feature_extractor(all_text, substrings);
+
+    cerr << "Training named_entity_extractor..." << endl;
+    const named_entity_extractor ner = train_ner(fe, labeled, num_threads);
+
+    cerr << "Training text_categorizer..." << endl;
+    const text_categorizer tcat = train_text_categorizer(fe, labeled, num_threads);
+
+    // Gather the inputs for the benchmarks of the individual steps.
+    std::vector<std::string> in_vocab_words, oov_words;
+    for (unsigned long i = 0; i < sentences.size(); ++i)
+    {
+        for (unsigned long j = 0; j < sentences[i].size(); ++j)
+        {
+            in_vocab_words.push_back(sentences[i][j]);
+            // No word in the text ends in "qz" so these are all out of dictionary.
+            oov_words.push_back(sentences[i][j] + "qz");
+        }
+    }
+
+    std::vector<sentence_features> feats(sentences.size());
+    std::vector<chunk_location> chunks;
+    std::vector<relation_location> relations;
+    for (unsigned long i = 0; i < sentences.size(); ++i)
+    {
+        sentence_to_feats(fe, sentences[i], feats[i]);
+        std::vector<std::pair<unsigned long,unsigned long> > ranges;
+        ner.get_segmenter().segment_sequence(feats[i], ranges);
+        for (unsigned long j = 0; j < ranges.size(); ++j)
+        {
+            chunk_location c;
+            c.sentence = i;
+            c.range = ranges[j];
+            chunks.push_back(c);
+        }
+
+        const std::vector<std::pair<unsigned long,unsigned long> >& ents = labeled[i].ranges;
+        for (unsigned long a = 0; a < ents.size(); ++a)
+        {
+            for (unsigned long b = 0; b < ents.size(); ++b)
+            {
+                if (a == b)
+                    continue;
+                relation_location r;
+                r.sentence = i;
+                r.arg1 = ents[a];
+                r.arg2 = ents[b];
+                relations.push_back(r);
+            }
+        }
+    }
+    if (chunks.size() == 0 || relations.size() == 0)
+        throw dlib::error("The text doesn't contain enough entities to run the benchmarks.");
+
+    std::vector<ner_sample_type> chunk_samples;
+    const dense_chunk_feature_extractor dense_fe(fe.get_num_dimensions());
+    for (unsigned long i = 0; i < chunks.size(); ++i)
+    {
+        const unsigned long s = chunks[i].sentence;
+        chunk_samples.push_back(extract_ner_chunk_features(sentences[s], feats[s], chunks[i].range, dense_fe));
+    }
+
+    total_word_feature_extractor cached_fe = fe;
+    cached_fe.set_oov_cache_capacity(oov_words.size());
+
+    cerr << "Running benchmarks..." << endl;
+    bench_tokenizer b1(lines);
+    run_benchmark("conll_tokenizer", "token", num_tokens, b1, opts);
+    bench_word_features b2(fe, in_vocab_words);
+    run_benchmark("word_features_in_vocab", "word", in_vocab_words.size(), b2, opts);
+    bench_word_features b3(fe, oov_words);
+    run_benchmark("word_features_oov", "word", oov_words.size(), b3, opts);
+    bench_word_features b4(cached_fe, oov_words);
+    run_benchmark("word_features_oov_cached", "word", oov_words.size(), b4, opts);
+    bench_find_substrings b5(substrings, oov_words);
+    run_benchmark("find_substrings", "word", oov_words.size(), b5, opts);
+    bench_sentence_to_feats b6(fe, sentences);
+    run_benchmark("sentence_to_feats", "token", in_vocab_words.size(), b6, opts);
+    bench_segment_sequence b7(ner, feats);
+    run_benchmark("segment_sequence", "token", in_vocab_words.size(), b7, opts);
+    bench_chunk_features b8(sentences, feats, chunks, fe.get_num_dimensions());
+    run_benchmark("extract_ner_chunk_features", "chunk", chunks.size(), b8, opts);
+    bench_chunk_classification b9(ner, chunk_samples);
+    run_benchmark("chunk_classification", "chunk", chunk_samples.size(), b9, opts);
+    bench_text_categorizer b10(tcat, sentences);
+    run_benchmark("text_categorizer_predict", "sentence", sentences.size(), b10, opts);
+    bench_binary_relation b11(fe, sentences, relations);
+    run_benchmark("extract_binary_relation", "relation", relations.size(), b11, opts);
+    bench_end_to_end b12(ner, lines);
+    run_benchmark("ner_end_to_end", "token", num_tokens, b12, opts);
+
+    std::vector<std::pair<std::string,std::string> > context;
+    context.push_back(json_item("text_file", json_string(text_file)));
+    context.push_back(json_item("labels_file", json_string(labels_file)));
+    context.push_back(json_item("num_lines", lines.size()));
+    context.push_back(json_item("num_tokens", num_tokens));
+    context.push_back(json_item("num_sentences", sentences.size()));
+    context.push_back(json_item("num_chunks", chunks.size()));
+    context.push_back(json_item("num_relations", relations.size()));
+    context.push_back(json_item("feature_dimensions", fe.get_num_dimensions()));
+    context.push_back(json_item("ner_fingerprint", ner.get_fingerprint()));
+    context.push_back(json_item("min_time", opts.min_time));
+    context.push_back(json_item("repeats", opts.repeats));
+    add_build_info(context);
+
+    write_inference_json(out, context);
+}
+
+// ----------------------------------------------------------------------------------------
+
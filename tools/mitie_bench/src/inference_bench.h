@@ -0,0 +1,21 @@
+// Copyright (C) 2014 Massachusetts Institute of Technology, Lincoln Laboratory
+// License: Boost Software License   See LICENSE.txt for the full license.
+// Authors: Davis E. King (davis@dlib.net)
+#ifndef MIT_LL_INFERENCE_BEnCH_H_
+#define MIT_LL_INFERENCE_BEnCH_H_
+
+#include <ostream>
+#include <dlib/cmd_line_parser.h>
+
+void inference_bench (
+    const dlib::command_line_parser& parser,
+    std::ostream& out
+);
+/*!
+    ensures
+        - Trains small models on the sample text, times each step of running them, and
+          writes the results to out as JSON.
+!*/
+
+#endif // MIT_LL_INFERENCE_BEnCH_H_
+
@@ -0,0 +1,117 @@
+// Copyright (C) 2014 Massachusetts Institute of Technology, Lincoln Laboratory
+// License: Boost Software License   See LICENSE.txt for the full license.
+// Authors: Davis E. King (davis@dlib.net)
+
+/*
+    This program runs repeatable benchmarks of MITIE and prints the results as JSON so
+    they can be compared across versions.  It doesn't need any of the downloadable MITIE
+    models.
+
+    By default it benchmarks running models.  It builds a small
+    total_word_feature_extractor from the words in sample_text.txt, trains a
+    named_entity_extractor and text_categorizer on the entities marked in
+    sample_text.reference-output, and then times each step of running them.  Everything
+    is seeded, so two runs on the same text build exactly the same models.  Run it from
+    the top level MITIE folder like this:
+        ./tools/mitie_bench/mitie_bench -o bench.json
+
+    With the --train option it benchmarks training models instead.  It generates a
+    synthetic corpus and times each phase of ner_trainer, text_categorizer_trainer, and
+    binary_relation_detector_trainer with several different numbers of threads:
+        ./tools/mitie_bench/mitie_bench --train --sentences 1000 --thread-counts 1,2,4,8
+*/
+
+#include <iostream>
+#include <fstream>
+#include "inference_bench.h"
+#include "train_bench.h"
+#include <dlib/cmd_line_parser.h>
+
+using namespace std;
+using namespace dlib;
+
+// ----------------------------------------------------------------------------------------
+
+int main(int argc, char** argv)
+{
+    try
+    {
+        command_line_parser parser;
+        parser.add_option("h", "Display this help information.");
+        parser.add_option("o", "Save the JSON results to a file named <arg> instead of printing them.",1);
+
+        parser.set_group_name("Model Benchmark Options");
+        parser.add_option("text", "Benchmark on the text in file <arg>.  The default is sample_text.txt.",1);
+        parser.add_option("labels", "Train the models on the entities marked in file <arg>.  The default "
+            "is sample_text.reference-output.",1);
+        parser.add_option("min-time", "Spend at least <arg> seconds timing each benchmark.  The default is 1.",1);
+        parser.add_option("repeats", "Time each benchmark in <arg> batches and report the median.  The default is 5.",1);
+        parser.add_option("threads", "Use <arg> threads when training the models.  The default is 4.",1);
+
+        parser.set_group_name("Training Benchmark Options");
+        parser.add_option("train", "Benchmark the trainers on a synthetic corpus instead of benchmarking models.");
+        parser.add_option("sentences", "Make a synthetic corpus with <arg> sentences.  The default is 300.",1);
+        parser.add_option("entity-density", "Make about <arg> of the tokens in the synthetic corpus part of "
+            "an entity.  The default is 0.15.",1);
+        parser.add_option("seed", "Seed the random number generator that makes the synthetic corpus with <arg>.",1);
+        parser.add_option("thread-counts", "Train with each of the comma separated numbers of threads in <arg>.  "
+            "The default is 1,2,4.",1);
+        parser.add_option("save-corpus", "Save the synthetic corpus in CoNLL format to the file <arg>.",1);
+
+        parser.parse(argc, argv);
+        const char* one_time_ops[] = {"h", "o", "text", "labels", "min-time", "repeats", "threads",
+            "train", "sentences", "entity-density", "seed", "thread-counts", "save-corpus"};
+        parser.check_one_time_options(one_time_ops);
+        parser.check_option_arg_range("min-time", 0.001, 1000.0);
+        parser.check_option_arg_range("repeats", 1, 1000);
+        parser.check_option_arg_range("threads", 1, 1000);
+        parser.check_option_arg_range("sentences", 2, 100000000);
+        parser.check_option_arg_range("entity-density", 0.0, 0.6);
+        const char* train_ops[] = {"sentences", "entity-density", "seed", "thread-counts", "save-corpus"};
+        const char* model_ops[] = {"text", "labels", "min-time", "repeats", "threads"};
+        parser.check_sub_options("train", train_ops);
+        for (unsigned long i = 0; i < sizeof(model_ops)/sizeof(model_ops[0]); ++i)
+            parser.check_incompatible_options("train", model_ops[i]);
+        if (parser.option("h"))
+        {
+            cout << "Usage: mitie_bench [options]" << endl;
+            cout << "Run this from the top level MITIE folder so it can find the sample text." << endl;
+            parser.print_options();
+            return 0;
+        }
+        if (parser.number_of_arguments() != 0)
+        {
+            cerr << "mitie_bench doesn't take any arguments besides its options.  Run it with -h for help." << endl;
+            return 1;
+        }
+
+        ofstream fout;
+        if (parser.option("o"))
+        {
+            fout.open(parser.option("o").argument().c_str());
+            if (!fout)
+                throw dlib::error("Unable to create file " + parser.option("o").argument());
+        }
+        std::ostream& out = parser.option("o") ? fout : cout;
+
+        if (parser.option("train"))
+            train_bench(parser, out);
+        else
+            inference_bench(parser, out);
+
+        if (parser.option("o"))
+        {
+            if (!fout)
+                throw dlib::error("Unable to write to file " + parser.option("o").argument());
+            cerr << "Results saved to " << parser.option("o").argument() << endl;
+        }
+    }
+    catch (std::exception& e)
+    {
+        cerr << e.what() << endl;
+        return 1;
+    }
+}
+
+// ----------------------------------------------------------------------------------------
+
@@ -0,0 +1,221 @@
+// Copyright (C) 2014 Massachusetts Institute of Technology, Lincoln Laboratory
+// License: Boost Software License   See LICENSE.txt for the full license.
+// Authors: Davis E. King (davis@dlib.net)
+
+#include "synthetic_corpus.h"
+#include <fstream>
+#include <dlib/rand.h>
+#include <dlib/error.h>
+#include <dlib/string.h>
+
+using namespace std;
+using namespace dlib;
+
+// ----------------------------------------------------------------------------------------
+
+unsigned long synthetic_corpus::
+num_tokens (
+) const
+{
+    unsigned long total = 0;
+    for (unsigned long i = 0; i < sentences.size(); ++i)
+        total += sentences[i].size();
+    return total;
+}
+
+unsigned long synthetic_corpus::
+num_entities (
+) const
+{
+    unsigned long total = 0;
+    for (unsigned long i = 0; i < ranges.size(); ++i)
+        total += ranges[i].size();
+    return total;
+}
+
+unsigned long synthetic_corpus::
+num_entity_tokens (
+) const
+{
+    unsigned long total = 0;
+    for (unsigned long i = 0; i < ranges.size(); ++i)
+    {
+        for (unsigned long j = 0; j < ranges[i].size(); ++j)
+            total += ranges[i][j].second - ranges[i][j].first;
+    }
+    return total;
+}
+
+// ----------------------------------------------------------------------------------------
+
+static std::string make_word (
+    dlib::rand& rnd,
+    bool capitalized
+)
+{
+    const char consonants[] = "bcdfghjklmnprstvwz";
+    const char vowels[] = "aeiou";
+    const unsigned long num_syllables = 1 + rnd.get_random_32bit_number()%3;
+    std::string word;
+    for (unsigned long i = 0; i < num_syllables; ++i)
+    {
+        word += consonants[rnd.get_random_32bit_number()%(sizeof(consonants)-1)];
+        word += vowels[rnd.get_random_32bit_number()%(sizeof(vowels)-1)];
+    }
+    if (capitalized)
+        word[0] = word[0] - 'a' + 'A';
+    return word;
+}
+
+static std::vector<std::string> make_words (
+    dlib::rand& rnd,
+    unsigned long num,
+    bool capitalized
+)
+{
+    std::vector<std::string> words;
+    for (unsigned long i = 0; i < num; ++i)
+        words.push_back(make_word(rnd, capitalized));
+    return words;
+}
+
+static const std::string& pick (
+    dlib::rand& rnd,
+    const std::vector<std::string>& words
+)
+{
+    return words[rnd.get_random_32bit_number()%words.size()];
+}
+
+// ----------------------------------------------------------------------------------------
+
+synthetic_corpus make_synthetic_corpus (
+    unsigned long num_sentences,
+    double entity_density,
+    const std::string& seed
+)
+{
+    DLIB_CASSERT(0 <= entity_density && entity_density <= 0.6, "Invalid entity density");
+
+    dlib::rand rnd(seed);
+    const unsigned long num_topics = 4;
+    const char* entity_types[] = {"PERSON", "LOCATION", "ORGANIZATION", "MISC"};
+    const unsigned long num_entity_types = 4;
+
+    std::vector<std::string> common_words = make_words(rnd, 100, false);
+    std::vector<std::vector<std::string> > topic_words(num_topics);
+    for (unsigned long t = 0; t < num_topics; ++t)
+        topic_words[t] = make_words(rnd, 500, false);
+    std::vector<std::vector<std::string> > entity_words(num_entity_types);
+    for (unsigned long t = 0; t < num_entity_types; ++t)
+        entity_words[t] = make_words(rnd, 300, true);
+
+    // Each entity is followed by a non-entity word and entities are 2 words long on
+    // average.  So if we start an entity with probability p before each word then the
+    // fraction of tokens in entities is 2p/(1+2p).  Solve for p.
+    const double p = entity_density/(2 - 2*entity_density);
+
+    synthetic_corpus corpus;
+    for (unsigned long i = 0; i < num_sentences; ++i)
+    {
+        const unsigned long topic = rnd.get_random_32bit_number()%num_topics;
+        const unsigned long length = 8 + rnd.get_random_32bit_number()%23;
+        std::vector<std::string> tokens;
+        std::vector<std::pair<unsigned long,unsigned long> > ranges;
+        std::vector<std::string> labels;
+        std::vector<bool> after_in;
+
+        while (tokens.size() < length)
+        {
+            if (rnd.get_random_double() < p)
+            {
+                const unsigned long type = rnd.get_random_32bit_number()%num_entity_types;
+                if (entity_types[type] == std::string("LOCATION"))
+                    tokens.push_back(rnd.get_random_double() < 0.5 ? "in" : "near");
+                after_in.push_back(tokens.size() != 0 && tokens.back() == "in");
+
+                const unsigned long entity_length = 1 + rnd.get_random_32bit_number()%3;
+                const unsigned long start = tokens.size();
+                for (unsigned long j = 0; j < entity_length; ++j)
+                    tokens.push_back(pick(rnd, entity_words[type]));
+                ranges.push_back(std::make_pair(start, tokens.size()));
+                labels.push_back(entity_types[type]);
+            }
+
+            if (rnd.get_random_double() < 0.3)
+                tokens.push_back(pick(rnd, common_words));
+            else
+                tokens.push_back(pick(rnd, topic_words[topic]));
+        }
+        tokens.push_back(".");
+
+        for (unsigned long a = 0; a < ranges.size(); ++a)
+        {
+            if (labels[a] != "PERSON")
+                continue;
+            for (unsigned long b = a+1; b < ranges.size(); ++b)
+            {
+                if (labels[b] != "LOCATION")
+                    continue;
+                synthetic_relation rel;
+                rel.sentence = corpus.sentences.size();
+                rel.arg1 = ranges[a];
+                rel.arg2 = ranges[b];
+                rel.positive = after_in[b];
+                corpus.relations.push_back(rel);
+            }
+        }
+
+        corpus.sentences.push_back(tokens);
+        corpus.ranges.push_back(ranges);
+        corpus.labels.push_back(labels);
+        corpus.topics.push_back("topic " + cast_to_string(topic));
+    }
+
+    return corpus;
+}
+
+// ----------------------------------------------------------------------------------------
+
+void save_as_conll (
+    const synthetic_corpus& corpus,
+    const std::string& filename
+)
+{
+    ofstream fout(filename.c_str());
+    if (!fout)
+        throw dlib::error("Unable to create file " + filename);
+
+    for (unsigned long i = 0; i < corpus.sentences.size(); ++i)
+    {
+        std::vector<std::string> tags(corpus.sentences[i].size(), "O");
+        for (unsigned long j = 0; j < corpus.ranges[i].size(); ++j)
+        {
+            std::string type = corpus.labels[i][j];
+            if (type == "PERSON")
+                type = "PER";
+            else if (type == "LOCATION")
+                type = "LOC";
+            else if (type == "ORGANIZATION")
+                type = "ORG";
+
+            // CoNLL 2003 uses I- tags except for an entity that directly follows
+            // another entity of the same type.  That one starts with a B- tag.
+            const unsigned long start = corpus.ranges[i][j].first;
+            const bool follows_same_type = j > 0 && corpus.ranges[i][j-1].second == start &&
+                                           corpus.labels[i][j-1] == corpus.labels[i][j];
+            for (unsigned long k = start; k < corpus.ranges[i][j].second; ++k)
+                tags[k] = ((k == start && follows_same_type) ? "B-" : "I-") + type;
+        }
+
+        for (unsigned long j = 0; j < corpus.sentences[i].size(); ++j)
+            fout << corpus.sentences[i][j] << " X X " << tags[j] << "\n";
+        fout << "\n";
+    }
+
+    if (!fout)
+        throw dlib::error("Error writing to file " + filename);
+}
+
+// ----------------------------------------------------------------------------------------
+
@@ -0,0 +1,91 @@
+// Copyright (C) 2014 Massachusetts Institute of Technology, Lincoln Laboratory
+// License: Boost Software License   See LICENSE.txt for the full license.
+// Authors: Davis E. King (davis@dlib.net)
+#ifndef MIT_LL_SYNTHETIC_CoRPUS_H_
+#define MIT_LL_SYNTHETIC_CoRPUS_H_
+
+#include <string>
+#include <vector>
+#include <utility>
+
+// ----------------------------------------------------------------------------------------
+
+struct synthetic_relation
+{
+    unsigned long sentence;
+    std::pair<unsigned long,unsigned long> arg1;
+    std::pair<unsigned long,unsigned long> arg2;
+    bool positive;
+};
+
+struct synthetic_corpus
+{
+    /*!
+        WHAT THIS OBJECT REPRESENTS
+            This object holds a randomly generated corpus of labeled sentences for
+            benchmarking the MITIE trainers.  The words are made up, but the labels
+            follow simple patterns that the trainers can learn:
+                - Each entity type (PERSON, LOCATION, ORGANIZATION, MISC) draws its words
+                  from its own pool of capitalized names.
+                - Every sentence belongs to a topic and most of its other words come
+                  from that topic's part of the vocabulary.
+                - A LOCATION is always preceded by either "in" or "near".  A PERSON
+                  followed later in the sentence by a LOCATION after "in" is a positive
+                  example of the relation, after "near" it's a negative one.
+
+        CONVENTION
+            - sentences.size() == ranges.size() == labels.size() == topics.size()
+            - ranges[i].size() == labels[i].size()
+            - ranges[i][j] is a half open range of tokens in sentences[i] that is an
+              entity of type labels[i][j].
+            - each element of relations refers to two of the entities in
+              sentences[relations[k].sentence].
+    !*/
+
+    std::vector<std::vector<std::string> > sentences;
+    std::vector<std::vector<std::pair<unsigned long,unsigned long> > > ranges;
+    std::vector<std::vector<std::string> > labels;
+    std::vector<std::string> topics;
+    std::vector<synthetic_relation> relations;
+
+    unsigned long num_tokens (
+    ) const;
+
+    unsigned long num_entities (
+    ) const;
+
+    unsigned long num_entity_tokens (
+    ) const;
+};
+
+// ----------------------------------------------------------------------------------------
+
+synthetic_corpus make_synthetic_corpus (
+    unsigned long num_sentences,
+    double entity_density,
+    const std::string& seed
+);
+/*!
+    requires
+        - 0 <= entity_density <= 0.6
+    ensures
+        - returns a synthetic_corpus C such that:
+            - C.sentences.size() == num_sentences
+            - About entity_density of the tokens in C are part of an entity.
+        - The same arguments always produce the same corpus.
+!*/
+
+void save_as_conll (
+    const synthetic_corpus& corpus,
+    const std::string& filename
+);
+/*!
+    ensures
+        - Saves the sentences and entities in corpus to the given file in the CoNLL 2003
+          format read by mitie::parse_conll_data().
+!*/
+
+// ----------------------------------------------------------------------------------------
+
+#endif // MIT_LL_SYNTHETIC_CoRPUS_H_
+
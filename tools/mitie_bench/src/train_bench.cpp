@@ -0,0 +1,283 @@
+// Copyright (C) 2014 Massachusetts Institute of Technology, Lincoln Laboratory
+// License: Boost Software License   See LICENSE.txt for the full license.
+// Authors: Davis E. King (davis@dlib.net)
+
+#include "train_bench.h"
+#include "bench_util.h"
+#include "synthetic_corpus.h"
+#include <iostream>
+#include <map>
+#include <mitie/ner_trainer.h>
+#include <mitie/text_categorizer_trainer.h>
+#include <mitie/binary_relation_detector_trainer.h>
+#include <dlib/misc_api.h>
+#include <dlib/serialize.h>
+#include <dlib/string.h>
+
+using namespace std;
+using namespace dlib;
+using namespace mitie;
+
+// ----------------------------------------------------------------------------------------
+
+struct training_run
+{
+    std::string trainer;
+    unsigned long num_threads;
+    double seconds;
+    unsigned long peak_rss_kb;
+    std::vector<training_phase> phases;
+};
+
+class training_run_timer
+{
+    /*!
+        WHAT THIS OBJECT REPRESENTS
+            This object measures the time and peak memory use of one call to a
+            trainer's train() routine.
+    !*/
+public:
+    training_run_timer (
+        const std::string& trainer,
+        unsigned long num_threads
+    )
+    {
+        run.trainer = trainer;
+        run.num_threads = num_threads;
+        cerr << "Training " << trainer << " with " << num_threads << " threads..." << endl;
+        reset_peak_rss();
+        start = ts.get_timestamp();
+    }
+
+    training_run finish (
+    )
+    {
+        run.seconds = (ts.get_timestamp() - start)/1e6;
+        run.peak_rss_kb = peak_rss_kb();
+        cerr << "  " << run.seconds << " seconds, peak RSS " << run.peak_rss_kb << " KB" << endl;
+        return run;
+    }
+
+    std::vector<training_phase>& phases (
+    ) { return run.phases; }
+
+private:
+    training_run run;
+    timestamper ts;
+    uint64 start;
+};
+
+// ----------------------------------------------------------------------------------------
+
+std::vector<unsigned long> parse_thread_counts (
+    const std::string& str
+)
+{
+    std::vector<unsigned long> counts;
+    const std::vector<std::string> items = split(str, ",");
+    for (unsigned long i = 0; i < items.size(); ++i)
+    {
+        const unsigned long num = string_cast<unsigned long>(trim(items[i]));
+        if (num == 0)
+            throw dlib::error("Thread counts must be positive.");
+        counts.push_back(num);
+    }
+    if (counts.size() == 0)
+        throw dlib::error("No thread counts were given.");
+    return counts;
+}
+
+std::map<std::string,double> total_phase_times (
+    const training_run& run
+)
+/*!
+    ensures
+        - returns a map from each phase name in run to the total time spent in phases
+          with that name.  The total time of the run is included under the name "total".
+!*/
+{
+    std::map<std::string,double> totals;
+    for (unsigned long i = 0; i < run.phases.size(); ++i)
+        totals[run.phases[i].name] += run.phases[i].seconds;
+    totals["total"] = run.seconds;
+    return totals;
+}
+
+// ----------------------------------------------------------------------------------------
+
+void write_training_json (
+    std::ostream& out,
+    const std::vector<std::pair<std::string,std::string> >& context,
+    const std::vector<training_run>& runs
+)
+{
+    out.precision(10);
+    out << "{\n";
+    out << "  \"context\": ";
+    write_json_object(out, context, "  ");
+    out << ",\n";
+
+    out << "  \"runs\": [\n";
+    for (unsigned long i = 0; i < runs.size(); ++i)
+    {
+        const training_run& r = runs[i];
+        out << "    {\"trainer\": " << json_string(r.trainer) << ", ";
+        out << "\"threads\": " << r.num_threads << ", ";
+        out << "\"seconds\": " << r.seconds << ", ";
+        out << "\"peak_rss_kb\": " << r.peak_rss_kb << ", ";
+        out << "\"phases\": [\n";
+        for (unsigned long j = 0; j < r.phases.size(); ++j)
+        {
+            out << "      {\"name\": " << json_string(r.phases[j].name) << ", ";
+            out << "\"params\": " << json_string(r.phases[j].params) << ", ";
+            out << "\"seconds\": " << r.phases[j].seconds;
+            out << (j+1 < r.phases.size() ? "},\n" : "}\n");
+        }
+        out << (i+1 < runs.size() ? "    ]},\n" : "    ]}\n");
+    }
+    out << "  ],\n";
+
+    // Compare each run to the run of the same trainer with the first thread count.  If
+    // the work were perfectly parallel then speedup would equal the ratio of thread
+    // counts and efficiency would be 1.
+    std::vector<std::string> scaling;
+    std::map<std::string,const training_run*> base_runs;
+    for (unsigned long i = 0; i < runs.size(); ++i)
+    {
+        if (base_runs.count(runs[i].trainer) == 0)
+            base_runs[runs[i].trainer] = &runs[i];
+
+        const training_run& base = *base_runs[runs[i].trainer];
+        const std::map<std::string,double> base_times = total_phase_times(base);
+        const std::map<std::string,double> times = total_phase_times(runs[i]);
+        std::map<std::string,double>::const_iterator j;
+        for (j = times.begin(); j != times.end(); ++j)
+        {
+            std::map<std::string,double>::const_iterator k = base_times.find(j->first);
+            if (k == base_times.end() || j->second <= 0)
+                continue;
+            const double speedup = k->second/j->second;
+            const double efficiency = speedup*base.num_threads/runs[i].num_threads;
+            ostringstream sout;
+            sout.precision(10);
+            sout << "{\"trainer\": " << json_string(runs[i].trainer) << ", ";
+            sout << "\"phase\": " << json_string(j->first) << ", ";
+            sout << "\"threads\": " << runs[i].num_threads << ", ";
+            sout << "\"base_threads\": " << base.num_threads << ", ";
+            sout << "\"seconds\": " << j->second << ", ";
+            sout << "\"speedup\": " << speedup << ", ";
+            sout << "\"efficiency\": " << efficiency << "}";
+            scaling.push_back(sout.str());
+        }
+    }
+    out << "  \"scaling\": [\n";
+    for (unsigned long i = 0; i < scaling.size(); ++i)
+        out << "    " << scaling[i] << (i+1 < scaling.size() ? ",\n" : "\n");
+    out << "  ]\n";
+    out << "}\n";
+}
+
+// ----------------------------------------------------------------------------------------
+
+void train_bench (
+    const command_line_parser& parser,
+    std::ostream& out
+)
+{
+    const unsigned long num_sentences = get_option(parser, "sentences", 300);
+    const double entity_density = get_option(parser, "entity-density", 0.15);
+    const std::string seed = get_option(parser, "seed", "mitie_bench");
+    const std::vector<unsigned long> thread_counts = parse_thread_counts(get_option(parser, "thread-counts", "1,2,4"));
+
+    cerr << "Generating synthetic corpus..." << endl;
+    const synthetic_corpus corpus = make_synthetic_corpus(num_sentences, entity_density, seed);
+    if (parser.option("save-corpus"))
+    {
+        save_as_conll(corpus, parser.option("save-corpus").argument());
+        cerr << "Corpus saved to " << parser.option("save-corpus").argument() << endl;
+    }
+
+    unsigned long num_positive_relations = 0;
+    for (unsigned long i = 0; i < corpus.relations.size(); ++i)
+    {
+        if (corpus.relations[i].positive)
+            ++num_positive_relations;
+    }
+    const unsigned long num_negative_relations = corpus.relations.size() - num_positive_relations;
+
+    // Leave the words that only appear in the last fifth of the corpus out of the
+    // dictionary so the trainers also see some out of dictionary words.
+    cerr << "Building word feature extractor..." << endl;
+    const std::vector<std::vector<std::string> > dictionary_text(corpus.sentences.begin(),
+        corpus.sentences.begin() + (corpus.sentences.size()*4 + 4)/5);
+    approximate_substring_set substrings;
+    const total_word_feature_extractor fe = make_word_feature_extractor(dictionary_text, substrings);
+
+    // The trainers print their progress to cout, which trainer_setup sends to cerr
+    // until the end of this block.
+    std::vector<training_run> runs;
+    {
+        const trainer_setup setup(fe);
+
+        for (unsigned long t = 0; t < thread_counts.size(); ++t)
+        {
+            const unsigned long num_threads = thread_counts[t];
+
+            ner_trainer ner_train(setup.get_fe_filename());
+            ner_train.set_num_threads(num_threads);
+            for (unsigned long i = 0; i < corpus.sentences.size(); ++i)
+                ner_train.add(corpus.sentences[i], corpus.ranges[i], corpus.labels[i]);
+            training_run_timer ner_timer("ner_trainer", num_threads);
+            const named_entity_extractor ner = ner_train.train(ner_timer.phases());
+            runs.push_back(ner_timer.finish());
+
+            text_categorizer_trainer tcat_train(setup.get_fe_filename());
+            tcat_train.set_num_threads(num_threads);
+            tcat_train.add(corpus.sentences, corpus.topics);
+            training_run_timer tcat_timer("text_categorizer_trainer", num_threads);
+            tcat_train.train(tcat_timer.phases());
+            runs.push_back(tcat_timer.finish());
+
+            if (num_positive_relations != 0 && num_negative_relations != 0)
+            {
+                binary_relation_detector_trainer rel_train("synthetic.person.location", ner);
+                rel_train.set_num_threads(num_threads);
+                for (unsigned long i = 0; i < corpus.relations.size(); ++i)
+                {
+                    const synthetic_relation& rel = corpus.relations[i];
+                    if (rel.positive)
+                        rel_train.add_positive_binary_relation(corpus.sentences[rel.sentence], rel.arg1, rel.arg2);
+                    else
+                        rel_train.add_negative_binary_relation(corpus.sentences[rel.sentence], rel.arg1, rel.arg2);
+                }
+                training_run_timer rel_timer("binary_relation_detector_trainer", num_threads);
+                rel_train.train(rel_timer.phases());
+                runs.push_back(rel_timer.finish());
+            }
+            else if (t == 0)
+            {
+                cerr << "The corpus doesn't have both positive and negative relation examples, "
+                     << "so binary_relation_detector_trainer won't be benchmarked." << endl;
+            }
+        }
+    }
+
+    std::vector<std::pair<std::string,std::string> > context;
+    context.push_back(json_item("num_sentences", corpus.sentences.size()));
+    context.push_back(json_item("num_tokens", corpus.num_tokens()));
+    context.push_back(json_item("num_entities", corpus.num_entities()));
+    context.push_back(json_item("requested_entity_density", entity_density));
+    context.push_back(json_item("entity_density", corpus.num_entity_tokens()/(double)corpus.num_tokens()));
+    context.push_back(json_item("num_positive_relations", num_positive_relations));
+    context.push_back(json_item("num_negative_relations", num_negative_relations));
+    context.push_back(json_item("seed", json_string(seed)));
+    context.push_back(json_item("feature_dimensions", fe.get_num_dimensions()));
+    context.push_back(json_item("words_in_dictionary", fe.get_num_words_in_dictionary()));
+    context.push_back(json_item("peak_rss_resets", reset_peak_rss() ? "true" : "false"));
+    add_build_info(context);
+
+    write_training_json(out, context, runs);
+}
+
+// ----------------------------------------------------------------------------------------
+
@@ -0,0 +1,22 @@
+// Copyright (C) 2014 Massachusetts Institute of Technology, Lincoln Laboratory
+// License: Boost Software License   See LICENSE.txt for the full license.
+// Authors: Davis E. King (davis@dlib.net)
+#ifndef MIT_LL_TRAIN_BEnCH_H_
+#define MIT_LL_TRAIN_BEnCH_H_
+
+#include <ostream>
+#include <dlib/cmd_line_parser.h>
+
+void train_bench (
+    const dlib::command_line_parser& parser,
+    std::ostream& out
+);
+/*!
+    ensures
+        - Generates a synthetic corpus, times each phase of training MITIE's models on
+          it with several different numbers of threads, and writes the results to out
+          as JSON.
+!*/
+
+#endif // MIT_LL_TRAIN_BEnCH_H_
+
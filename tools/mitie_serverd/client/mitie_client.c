@@ -0,0 +1,693 @@
+// Copyright (C) 2014 Massachusetts Institute of Technology, Lincoln Laboratory
+// License: Boost Software License   See LICENSE.txt for the full license.
+// Authors: Davis E. King (davis@dlib.net)
+
+#include "mitie_client.h"
+#include <stdlib.h>
+#include <string.h>
+#include <stdio.h>
+#include <errno.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+// ----------------------------------------------------------------------------------------
+
+struct mitie_client
+{
+    int fd;
+    unsigned long next_request_id;
+    char error[256];
+};
+
+enum { CLIENT_ENTITIES = 1, CLIENT_CATEGORIES = 2 };
+
+struct client_entity
+{
+    unsigned long sentence;
+    unsigned long begin;
+    unsigned long end;
+    unsigned long tag;
+    double score;
+};
+
+struct mitie_client_entities
+{
+    int type;
+    unsigned long num_tags;
+    char** tags;
+    unsigned long num_entities;
+    struct client_entity* entities;
+};
+
+struct mitie_client_categories
+{
+    int type;
+    unsigned long num_documents;
+    char** labels;
+    double* scores;
+};
+
+// ----------------------------------------------------------------------------------------
+
+/* A growing buffer for building a request frame.  If an allocation fails then failed is
+   set and later writes are ignored. */
+struct request_buffer
+{
+    unsigned char* data;
+    size_t size;
+    size_t capacity;
+    int failed;
+};
+
+static void put_bytes (struct request_buffer* buf, const void* data, size_t size)
+{
+    if (buf->failed)
+        return;
+    if (buf->size + size > buf->capacity)
+    {
+        size_t new_capacity = buf->capacity*2 + size + 256;
+        unsigned char* temp = (unsigned char*)realloc(buf->data, new_capacity);
+        if (!temp)
+        {
+            buf->failed = 1;
+            return;
+        }
+        buf->data = temp;
+        buf->capacity = new_capacity;
+    }
+    memcpy(buf->data + buf->size, data, size);
+    buf->size += size;
+}
+
+static void put_u8 (struct request_buffer* buf, unsigned char val)
+{
+    put_bytes(buf, &val, 1);
+}
+
+static void put_u32 (struct request_buffer* buf, unsigned long val)
+{
+    unsigned char bytes[4];
+    bytes[0] = (unsigned char)((val>>24)&0xFF);
+    bytes[1] = (unsigned char)((val>>16)&0xFF);
+    bytes[2] = (unsigned char)((val>>8)&0xFF);
+    bytes[3] = (unsigned char)(val&0xFF);
+    put_bytes(buf, bytes, 4);
+}
+
+static void put_string (struct request_buffer* buf, const char* str)
+{
+    size_t size = str ? strlen(str) : 0;
+    put_u32(buf, size);
+    put_bytes(buf, str, size);
+}
+
+static void put_tokens (struct request_buffer* buf, char** tokens)
+{
+    unsigned long num = 0;
+    unsigned long i;
+    while (tokens[num])
+        ++num;
+    put_u32(buf, num);
+    for (i = 0; i < num; ++i)
+        put_string(buf, tokens[i]);
+}
+
+// ----------------------------------------------------------------------------------------
+
+/* Reads the fields of a response body.  If the body is too short then failed is set and
+   the reads return zeros. */
+struct response_reader
+{
+    const unsigned char* data;
+    size_t size;
+    size_t pos;
+    int failed;
+};
+
+static int have_bytes (struct response_reader* in, size_t size)
+{
+    if (in->failed || in->size - in->pos < size)
+    {
+        in->failed = 1;
+        return 0;
+    }
+    return 1;
+}
+
+static unsigned long get_u32 (struct response_reader* in)
+{
+    unsigned long val = 0;
+    int i;
+    if (!have_bytes(in, 4))
+        return 0;
+    for (i = 0; i < 4; ++i)
+        val = (val<<8) | in->data[in->pos++];
+    return val;
+}
+
+static double get_double (struct response_reader* in)
+{
+    unsigned long long bits = 0;
+    double val;
+    int i;
+    if (!have_bytes(in, 8))
+        return 0;
+    for (i = 0; i < 8; ++i)
+        bits = (bits<<8) | in->data[in->pos++];
+    memcpy(&val, &bits, sizeof(val));
+    return val;
+}
+
+static char* get_string (struct response_reader* in)
+{
+    unsigned long size = get_u32(in);
+    char* str;
+    if (!have_bytes(in, size))
+        return NULL;
+    str = (char*)malloc(size+1);
+    if (!str)
+    {
+        in->failed = 1;
+        return NULL;
+    }
+    memcpy(str, in->data + in->pos, size);
+    str[size] = 0;
+    in->pos += size;
+    return str;
+}
+
+static void free_strings (char** strs, unsigned long num)
+{
+    unsigned long i;
+    if (!strs)
+        return;
+    for (i = 0; i < num; ++i)
+        free(strs[i]);
+    free(strs);
+}
+
+// ----------------------------------------------------------------------------------------
+
+static void set_error (mitie_client* client, const char* message)
+{
+    strncpy(client->error, message, sizeof(client->error)-1);
+    client->error[sizeof(client->error)-1] = 0;
+}
+
+static int send_all (int fd, const unsigned char* data, size_t size)
+{
+    while (size != 0)
+    {
+        ssize_t num = send(fd, data, size, 0);
+        if (num < 0 && errno == EINTR)
+            continue;
+        if (num <= 0)
+            return -1;
+        data += num;
+        size -= num;
+    }
+    return 0;
+}
+
+static int recv_all (int fd, unsigned char* data, size_t size)
+{
+    while (size != 0)
+    {
+        ssize_t num = recv(fd, data, size, 0);
+        if (num < 0 && errno == EINTR)
+            continue;
+        if (num <= 0)
+            return -1;
+        data += num;
+        size -= num;
+    }
+    return 0;
+}
+
+static void begin_request (mitie_client* client, struct request_buffer* buf, unsigned char op)
+{
+    memset(buf, 0, sizeof(*buf));
+    put_u32(buf, 0);
+    put_u32(buf, client->next_request_id);
+    put_u8(buf, op);
+}
+
+static unsigned char* send_request (
+    mitie_client* client,
+    struct request_buffer* buf,
+    struct response_reader* in
+)
+/*!
+    ensures
+        - sends the request in buf, frees buf, and waits for the response.
+        - On success, returns the response frame, which the caller must free(), and
+          sets #in to read its body.
+        - returns NULL on failure.
+!*/
+{
+    unsigned char header[4];
+    unsigned long size, request_id;
+    unsigned char* frame;
+
+    client->error[0] = 0;
+    if (buf->failed)
+    {
+        free(buf->data);
+        set_error(client, "Out of memory.");
+        return NULL;
+    }
+    size = buf->size - 4;
+    buf->data[0] = (unsigned char)((size>>24)&0xFF);
+    buf->data[1] = (unsigned char)((size>>16)&0xFF);
+    buf->data[2] = (unsigned char)((size>>8)&0xFF);
+    buf->data[3] = (unsigned char)(size&0xFF);
+    if (send_all(client->fd, buf->data, buf->size) != 0)
+    {
+        free(buf->data);
+        set_error(client, "Unable to send the request to the server.");
+        return NULL;
+    }
+    free(buf->data);
+
+    if (recv_all(client->fd, header, 4) != 0)
+    {
+        set_error(client, "The server closed the connection.");
+        return NULL;
+    }
+    size = ((unsigned long)header[0]<<24) | ((unsigned long)header[1]<<16) |
+           ((unsigned long)header[2]<<8) | header[3];
+    if (size < 5 || size > MITIE_SERVER_MAX_FRAME_SIZE)
+    {
+        set_error(client, "Invalid response from the server.");
+        return NULL;
+    }
+    frame = (unsigned char*)malloc(size);
+    if (!frame)
+    {
+        set_error(client, "Out of memory.");
+        return NULL;
+    }
+    if (recv_all(client->fd, frame, size) != 0)
+    {
+        free(frame);
+        set_error(client, "The server closed the connection.");
+        return NULL;
+    }
+
+    in->data = frame;
+    in->size = size;
+    in->pos = 0;
+    in->failed = 0;
+    request_id = get_u32(in);
+    if (request_id != (client->next_request_id&0xFFFFFFFFUL))
+    {
+        free(frame);
+        set_error(client, "The server's response doesn't match the request.");
+        return NULL;
+    }
+    ++client->next_request_id;
+
+    if (in->data[in->pos++] != MITIE_SERVER_OK)
+    {
+        char* message = get_string(in);
+        set_error(client, message ? message : "The server returned an error.");
+        free(message);
+        free(frame);
+        return NULL;
+    }
+    return frame;
+}
+
+// ----------------------------------------------------------------------------------------
+
+int mitie_client_get_default_socket_path (
+    char* path,
+    unsigned long size
+)
+{
+    const char* dir = getenv("XDG_RUNTIME_DIR");
+    int length;
+    if (dir && dir[0] == '/')
+        length = snprintf(path, size, "%s/%s", dir, MITIE_SERVER_SOCKET_NAME);
+    else
+        length = snprintf(path, size, "%s%lu/%s", MITIE_SERVER_FALLBACK_DIR,
+                          (unsigned long)getuid(), MITIE_SERVER_SOCKET_NAME);
+    return length < 0 || (unsigned long)length >= size;
+}
+
+// ----------------------------------------------------------------------------------------
+
+mitie_client* mitie_client_connect (
+    const char* socket_path
+)
+{
+    mitie_client* client;
+    struct sockaddr_un addr;
+    char default_path[sizeof(addr.sun_path)];
+
+    if (!socket_path)
+    {
+        if (mitie_client_get_default_socket_path(default_path, sizeof(default_path)))
+            return NULL;
+        socket_path = default_path;
+    }
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (strlen(socket_path) >= sizeof(addr.sun_path))
+        return NULL;
+    strcpy(addr.sun_path, socket_path);
+
+    client = (mitie_client*)malloc(sizeof(mitie_client));
+    if (!client)
+        return NULL;
+    client->next_request_id = 0;
+    client->error[0] = 0;
+    client->fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (client->fd < 0)
+    {
+        free(client);
+        return NULL;
+    }
+    if (connect(client->fd, (struct sockaddr*)&addr, sizeof(addr)) != 0)
+    {
+        close(client->fd);
+        free(client);
+        return NULL;
+    }
+    return client;
+}
+
+void mitie_client_close (
+    mitie_client* client
+)
+{
+    if (!client)
+        return;
+    close(client->fd);
+    free(client);
+}
+
+const char* mitie_client_get_error (
+    const mitie_client* client
+)
+{
+    return client->error;
+}
+
+void mitie_client_free (
+    void* object
+)
+{
+    if (!object)
+        return;
+    switch (*(int*)object)
+    {
+        case CLIENT_ENTITIES:
+            {
+                mitie_client_entities* ents = (mitie_client_entities*)object;
+                free_strings(ents->tags, ents->num_tags);
+                free(ents->entities);
+            } break;
+        case CLIENT_CATEGORIES:
+            {
+                mitie_client_categories* cats = (mitie_client_categories*)object;
+                free_strings(cats->labels, cats->num_documents);
+                free(cats->scores);
+            } break;
+    }
+    free(object);
+}
+
+int mitie_client_ping (
+    mitie_client* client
+)
+{
+    struct request_buffer buf;
+    struct response_reader in;
+    unsigned char* frame;
+
+    begin_request(client, &buf, MITIE_SERVER_PING);
+    frame = send_request(client, &buf, &in);
+    if (!frame)
+        return -1;
+    free(frame);
+    return 0;
+}
+
+// ----------------------------------------------------------------------------------------
+
+mitie_client_entities* mitie_client_extract_entities (
+    mitie_client* client,
+    const char* model,
+    char*** sentences,
+    unsigned long num_sentences
+)
+{
+    struct request_buffer buf;
+    struct response_reader in;
+    unsigned char* frame;
+    mitie_client_entities* ents;
+    unsigned long i, j, num, capacity = 0;
+
+    begin_request(client, &buf, MITIE_SERVER_EXTRACT_ENTITIES);
+    put_string(&buf, model);
+    put_u32(&buf, num_sentences);
+    for (i = 0; i < num_sentences; ++i)
+        put_tokens(&buf, sentences[i]);
+    frame = send_request(client, &buf, &in);
+    if (!frame)
+        return NULL;
+
+    ents = (mitie_client_entities*)calloc(1, sizeof(mitie_client_entities));
+    if (!ents)
+    {
+        free(frame);
+        set_error(client, "Out of memory.");
+        return NULL;
+    }
+    ents->type = CLIENT_ENTITIES;
+
+    num = get_u32(&in);
+    if (!in.failed && num <= in.size/4)
+        ents->tags = (char**)calloc(num+1, sizeof(char*));
+    if (!ents->tags)
+        in.failed = 1;
+    for (i = 0; i < num && !in.failed; ++i)
+    {
+        ents->tags[i] = get_string(&in);
+        ents->num_tags = i+1;
+    }
+
+    for (i = 0; i < num_sentences && !in.failed; ++i)
+    {
+        num = get_u32(&in);
+        for (j = 0; j < num && !in.failed; ++j)
+        {
+            struct client_entity* e;
+            if (ents->num_entities == capacity)
+            {
+                struct client_entity* temp;
+                capacity = capacity*2 + 16;
+                temp = (struct client_entity*)realloc(ents->entities, capacity*sizeof(struct client_entity));
+                if (!temp)
+                {
+                    in.failed = 1;
+                    break;
+                }
+                ents->entities = temp;
+            }
+            e = &ents->entities[ents->num_entities];
+            e->sentence = i;
+            e->begin = get_u32(&in);
+            e->end = get_u32(&in);
+            e->tag = get_u32(&in);
+            e->score = get_double(&in);
+            if (e->begin >= e->end || e->tag >= ents->num_tags)
+                in.failed = 1;
+            else
+                ++ents->num_entities;
+        }
+    }
+
+    free(frame);
+    if (in.failed)
+    {
+        mitie_client_free(ents);
+        set_error(client, "Invalid response from the server.");
+        return NULL;
+    }
+    return ents;
+}
+
+unsigned long mitie_client_num_entities (
+    const mitie_client_entities* ents
+)
+{
+    return ents->num_entities;
+}
+
+unsigned long mitie_client_entity_sentence (
+    const mitie_client_entities* ents,
+    unsigned long idx
+)
+{
+    return ents->entities[idx].sentence;
+}
+
+unsigned long mitie_client_entity_position (
+    const mitie_client_entities* ents,
+    unsigned long idx
+)
+{
+    return ents->entities[idx].begin;
+}
+
+unsigned long mitie_client_entity_length (
+    const mitie_client_entities* ents,
+    unsigned long idx
+)
+{
+    return ents->entities[idx].end - ents->entities[idx].begin;
+}
+
+unsigned long mitie_client_entity_tag (
+    const mitie_client_entities* ents,
+    unsigned long idx
+)
+{
+    return ents->entities[idx].tag;
+}
+
+const char* mitie_client_entity_tagstr (
+    const mitie_client_entities* ents,
+    unsigned long idx
+)
+{
+    return ents->tags[ents->entities[idx].tag];
+}
+
+double mitie_client_entity_score (
+    const mitie_client_entities* ents,
+    unsigned long idx
+)
+{
+    return ents->entities[idx].score;
+}
+
+// ----------------------------------------------------------------------------------------
+
+mitie_client_categories* mitie_client_categorize (
+    mitie_client* client,
+    const char* model,
+    char*** documents,
+    unsigned long num_documents
+)
+{
+    struct request_buffer buf;
+    struct response_reader in;
+    unsigned char* frame;
+    mitie_client_categories* cats;
+    unsigned long i;
+
+    begin_request(client, &buf, MITIE_SERVER_CATEGORIZE);
+    put_string(&buf, model);
+    put_u32(&buf, num_documents);
+    for (i = 0; i < num_documents; ++i)
+        put_tokens(&buf, documents[i]);
+    frame = send_request(client, &buf, &in);
+    if (!frame)
+        return NULL;
+
+    cats = (mitie_client_categories*)calloc(1, sizeof(mitie_client_categories));
+    if (cats)
+    {
+        cats->type = CLIENT_CATEGORIES;
+        cats->labels = (char**)calloc(num_documents+1, sizeof(char*));
+        cats->scores = (double*)calloc(num_documents+1, sizeof(double));
+    }
+    if (!cats || !cats->labels || !cats->scores)
+    {
+        mitie_client_free(cats);
+        free(frame);
+        set_error(client, "Out of memory.");
+        return NULL;
+    }
+
+    cats->num_documents = num_documents;
+    for (i = 0; i < num_documents && !in.failed; ++i)
+    {
+        cats->labels[i] = get_string(&in);
+        cats->scores[i] = get_double(&in);
+    }
+
+    free(frame);
+    if (in.failed)
+    {
+        mitie_client_free(cats);
+        set_error(client, "Invalid response from the server.");
+        return NULL;
+    }
+    return cats;
+}
+
+const char* mitie_client_category_label (
+    const mitie_client_categories* cats,
+    unsigned long idx
+)
+{
+    return cats->labels[idx];
+}
+
+double mitie_client_category_score (
+    const mitie_client_categories* cats,
+    unsigned long idx
+)
+{
+    return cats->scores[idx];
+}
+
+// ----------------------------------------------------------------------------------------
+
+int mitie_client_score_relations (
+    mitie_client* client,
+    const char* model,
+    const mitie_client_relation* relations,
+    unsigned long num_relations,
+    double* scores
+)
+{
+    struct request_buffer buf;
+    struct response_reader in;
+    unsigned char* frame;
+    unsigned long i;
+
+    begin_request(client, &buf, MITIE_SERVER_SCORE_RELATIONS);
+    put_string(&buf, model);
+    put_u32(&buf, num_relations);
+    for (i = 0; i < num_relations; ++i)
+    {
+        put_tokens(&buf, relations[i].tokens);
+        put_u32(&buf, relations[i].arg1_position);
+        put_u32(&buf, relations[i].arg1_position + relations[i].arg1_length);
+        put_u32(&buf, relations[i].arg2_position);
+        put_u32(&buf, relations[i].arg2_position + relations[i].arg2_length);
+    }
+    frame = send_request(client, &buf, &in);
+    if (!frame)
+        return -1;
+
+    for (i = 0; i < num_relations; ++i)
+        scores[i] = get_double(&in);
+    free(frame);
+    if (in.failed)
+    {
+        set_error(client, "Invalid response from the server.");
+        return -1;
+    }
+    return 0;
+}
+
+// ----------------------------------------------------------------------------------------
+
@@ -0,0 +1,294 @@
+// Copyright (C) 2014 Massachusetts Institute of Technology, Lincoln Laboratory
+// License: Boost Software License   See LICENSE.txt for the full license.
+// Authors: Davis E. King (davis@dlib.net)
+#ifndef MITLL_MITIE_CLIENt_H_
+#define MITLL_MITIE_CLIENt_H_
+
+#include "mitie_server_protocol.h"
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+    /*!
+        WHAT THIS LIBRARY DOES
+            This is a small C library for talking to mitie_serverd.  It only depends on
+            the C library and POSIX sockets, not on MITIE itself, so programs using it
+            don't load any models.  Instead they send their tokens to the server which
+            has the models loaded already.
+
+        RESOURCE MANAGEMENT POLICY
+            The objects returned by mitie_client_extract_entities() and
+            mitie_client_categorize() must be freed by calling mitie_client_free().  A
+            mitie_client must be freed by calling mitie_client_close().
+
+        THREAD SAFETY
+            A mitie_client sends one request at a time and waits for its response, so
+            it must only be used by one thread at a time.  Use one mitie_client per
+            thread to make requests from several threads at once.
+    !*/
+
+    typedef struct mitie_client mitie_client;
+    typedef struct mitie_client_entities mitie_client_entities;
+    typedef struct mitie_client_categories mitie_client_categories;
+
+// ----------------------------------------------------------------------------------------
+
+    int mitie_client_get_default_socket_path (
+        char* path,
+        unsigned long size
+    );
+    /*!
+        requires
+            - path points to a buffer of size bytes
+        ensures
+            - Writes the path of the socket mitie_serverd listens on when it isn't given
+              one into path.  It depends on the user and on $XDG_RUNTIME_DIR, as
+              described in mitie_server_protocol.h.
+            - returns 0 on success and nonzero if the path doesn't fit in size bytes.
+    !*/
+
+    mitie_client* mitie_client_connect (
+        const char* socket_path
+    );
+    /*!
+        ensures
+            - Connects to the mitie_serverd listening on the Unix domain socket at
+              socket_path, or at the default one given by
+              mitie_client_get_default_socket_path() if socket_path is NULL.
+            - returns the new connection, or NULL if it couldn't be made.
+    !*/
+
+    void mitie_client_close (
+        mitie_client* client
+    );
+    /*!
+        ensures
+            - Closes the connection and frees client.  Does nothing if client is NULL.
+    !*/
+
+    const char* mitie_client_get_error (
+        const mitie_client* client
+    );
+    /*!
+        requires
+            - client != NULL
+        ensures
+            - returns a message describing why the last call on client failed, or an
+              empty string if it didn't.
+            - The returned pointer is valid until the next call on client.
+    !*/
+
+    void mitie_client_free (
+        void* object
+    );
+    /*!
+        ensures
+            - Frees an object returned by mitie_client_extract_entities() or
+              mitie_client_categorize().  Does nothing if object is NULL.
+    !*/
+
+    int mitie_client_ping (
+        mitie_client* client
+    );
+    /*!
+        requires
+            - client != NULL
+        ensures
+            - Checks that the server is answering requests.
+            - returns 0 on success and nonzero otherwise.
+    !*/
+
+// ----------------------------------------------------------------------------------------
+
+    mitie_client_entities* mitie_client_extract_entities (
+        mitie_client* client,
+        const char* model,
+        char*** sentences,
+        unsigned long num_sentences
+    );
+    /*!
+        requires
+            - client != NULL
+            - sentences == an array of num_sentences token arrays.  Each token array is
+              terminated by a NULL, just like the ones returned by mitie_tokenize().
+        ensures
+            - Has the server run the NER model named model on each of the sentences.  If
+              model is NULL or "" the server's first NER model is used.
+            - returns the entities found in all the sentences, or NULL on failure, in
+              which case mitie_client_get_error() says why.
+    !*/
+
+    unsigned long mitie_client_num_entities (
+        const mitie_client_entities* ents
+    );
+    /*!
+        requires
+            - ents != NULL
+        ensures
+            - returns the number of entities in ents.  They are ordered by sentence and
+              then by position in their sentence.
+    !*/
+
+    unsigned long mitie_client_entity_sentence (
+        const mitie_client_entities* ents,
+        unsigned long idx
+    );
+    /*!
+        requires
+            - ents != NULL
+            - idx < mitie_client_num_entities(ents)
+        ensures
+            - returns the index of the sentence the idx-th entity is in.
+    !*/
+
+    unsigned long mitie_client_entity_position (
+        const mitie_client_entities* ents,
+        unsigned long idx
+    );
+    /*!
+        requires
+            - ents != NULL
+            - idx < mitie_client_num_entities(ents)
+        ensures
+            - returns the index of the first token of the idx-th entity within its
+              sentence.
+    !*/
+
+    unsigned long mitie_client_entity_length (
+        const mitie_client_entities* ents,
+        unsigned long idx
+    );
+    /*!
+        requires
+            - ents != NULL
+            - idx < mitie_client_num_entities(ents)
+        ensures
+            - returns the number of tokens in the idx-th entity.
+    !*/
+
+    unsigned long mitie_client_entity_tag (
+        const mitie_client_entities* ents,
+        unsigned long idx
+    );
+    /*!
+        requires
+            - ents != NULL
+            - idx < mitie_client_num_entities(ents)
+        ensures
+            - returns the numeric ID of the idx-th entity's tag.
+    !*/
+
+    const char* mitie_client_entity_tagstr (
+        const mitie_client_entities* ents,
+        unsigned long idx
+    );
+    /*!
+        requires
+            - ents != NULL
+            - idx < mitie_client_num_entities(ents)
+        ensures
+            - returns the name of the idx-th entity's tag, e.g. "PERSON".
+            - The returned pointer is valid until mitie_client_free(ents) is called.
+    !*/
+
+    double mitie_client_entity_score (
+        const mitie_client_entities* ents,
+        unsigned long idx
+    );
+    /*!
+        requires
+            - ents != NULL
+            - idx < mitie_client_num_entities(ents)
+        ensures
+            - returns the NER model's confidence in the idx-th entity's tag.  > 0 means
+              it's likely correct.
+    !*/
+
+// ----------------------------------------------------------------------------------------
+
+    mitie_client_categories* mitie_client_categorize (
+        mitie_client* client,
+        const char* model,
+        char*** documents,
+        unsigned long num_documents
+    );
+    /*!
+        requires
+            - client != NULL
+            - documents == an array of num_documents NULL terminated token arrays.
+        ensures
+            - Has the server run the text categorizer named model on each document.  If
+              model is NULL or "" the server's first text categorizer is used.
+            - returns the label of each document, or NULL on failure, in which case
+              mitie_client_get_error() says why.
+    !*/
+
+    const char* mitie_client_category_label (
+        const mitie_client_categories* cats,
+        unsigned long idx
+    );
+    /*!
+        requires
+            - cats != NULL
+            - idx < the number of documents given to mitie_client_categorize()
+        ensures
+            - returns the label of the idx-th document.
+            - The returned pointer is valid until mitie_client_free(cats) is called.
+    !*/
+
+    double mitie_client_category_score (
+        const mitie_client_categories* cats,
+        unsigned long idx
+    );
+    /*!
+        requires
+            - cats != NULL
+            - idx < the number of documents given to mitie_client_categorize()
+        ensures
+            - returns the categorizer's confidence in the idx-th document's label.
+    !*/
+
+// ----------------------------------------------------------------------------------------
+
+    typedef struct
+    {
+        char** tokens;
+        unsigned long arg1_position;
+        unsigned long arg1_length;
+        unsigned long arg2_position;
+        unsigned long arg2_length;
+    } mitie_client_relation;
+
+    int mitie_client_score_relations (
+        mitie_client* client,
+        const char* model,
+        const mitie_client_relation* relations,
+        unsigned long num_relations,
+        double* scores
+    );
+    /*!
+        requires
+            - client != NULL
+            - relations == an array of num_relations relations.  Each one is a NULL
+              terminated token array and the positions and lengths of the relation's
+              two arguments in it.
+            - scores == an array with room for num_relations values.
+        ensures
+            - Has the server run the binary relation detector named model on each
+              relation.  If model is NULL or "" the server's first relation detector is
+              used.
+            - On success, #scores[i] is the score of relations[i], where > 0 means the
+              relation is likely present, and this function returns 0.
+            - returns nonzero on failure, in which case mitie_client_get_error() says
+              why.
+    !*/
+
+// ----------------------------------------------------------------------------------------
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // MITLL_MITIE_CLIENt_H_
+
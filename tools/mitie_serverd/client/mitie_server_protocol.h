@@ -0,0 +1,100 @@
+// Copyright (C) 2014 Massachusetts Institute of Technology, Lincoln Laboratory
+// License: Boost Software License   See LICENSE.txt for the full license.
+// Authors: Davis E. King (davis@dlib.net)
+#ifndef MITLL_MITIE_SERVER_PROTOCOl_H_
+#define MITLL_MITIE_SERVER_PROTOCOl_H_
+
+/*!
+    MITIE SERVER PROTOCOL
+        This file defines the protocol spoken over the Unix domain socket of
+        mitie_serverd.  It is shared by the server and by the C client library in this
+        folder.
+
+        A client sends request frames and the server answers each one with a response
+        frame.  A client may send several requests before reading the responses, which
+        can come back in any order, so each request carries an ID chosen by the client
+        that the server copies into its response.  Such a client must keep reading
+        responses while it sends, since a busy server stops reading requests until it
+        has caught up.
+
+        All integers are unsigned and sent in big-endian byte order.  Scores are IEEE
+        754 doubles, also sent in big-endian byte order.  The compound types are:
+            string:     u32 length, then that many bytes of UTF-8 (not NULL terminated)
+            tokens:     u32 count, then that many strings
+
+        A request frame is:
+            u32 length of everything after this field
+            u32 request ID
+            u8  operation
+            the body for that operation
+
+        A response frame is:
+            u32 length of everything after this field
+            u32 request ID
+            u8  status, MITIE_SERVER_OK or MITIE_SERVER_ERROR
+            if status is MITIE_SERVER_OK then the body for the operation, otherwise a
+            string with the error message.
+
+        The operations and their request and response bodies are:
+            MITIE_SERVER_PING
+                request:  empty
+                response: empty
+            MITIE_SERVER_LIST_MODELS
+                request:  empty
+                response: u32 number of models, then for each model a u8 model type
+                          (one of the MITIE_SERVER_*_MODEL values), its name string, and
+                          a tokens list with its labels: the tags of a NER model, the
+                          categories of a text categorizer, or the relation type of a
+                          binary relation detector.
+            MITIE_SERVER_EXTRACT_ENTITIES
+                request:  model name string, u32 number of sentences, then the tokens of
+                          each sentence.
+                response: the tags of the model as a tokens list, then for each sentence
+                          a u32 number of entities and for each entity its u32 first
+                          token, u32 one past its last token, u32 tag index, and double
+                          score.
+            MITIE_SERVER_CATEGORIZE
+                request:  model name string, u32 number of documents, then the tokens
+                          of each document.
+                response: for each document its label string and double score.
+            MITIE_SERVER_SCORE_RELATIONS
+                request:  model name string, u32 number of relations, then for each one
+                          the tokens of its sentence and the u32 begin and end of its
+                          first argument followed by those of its second argument.  The
+                          arguments are half open ranges of token indices.
+                response: the double score of each relation.
+
+        An empty model name means the first model of the right type the server loaded.
+!*/
+
+/*
+    By default the server listens on MITIE_SERVER_SOCKET_NAME inside $XDG_RUNTIME_DIR,
+    a folder only its user can get into.  If XDG_RUNTIME_DIR isn't set it uses the
+    folder MITIE_SERVER_FALLBACK_DIR followed by the user's numeric id instead, e.g.
+    /tmp/mitie_serverd-1000, which the server creates with mode 0700.  Either way the
+    socket itself gets mode 0600 unless the server is told otherwise.
+*/
+#define MITIE_SERVER_SOCKET_NAME "mitie_serverd.sock"
+#define MITIE_SERVER_FALLBACK_DIR "/tmp/mitie_serverd-"
+
+/* The largest frame either side will accept, in bytes. */
+#define MITIE_SERVER_MAX_FRAME_SIZE (64*1024*1024)
+
+/* Operations */
+#define MITIE_SERVER_PING               0
+#define MITIE_SERVER_LIST_MODELS        1
+#define MITIE_SERVER_EXTRACT_ENTITIES   2
+#define MITIE_SERVER_CATEGORIZE         3
+#define MITIE_SERVER_SCORE_RELATIONS    4
+
+/* Response status values */
+#define MITIE_SERVER_OK     0
+#define MITIE_SERVER_ERROR  1
+
+/* Model types */
+#define MITIE_SERVER_NER_MODEL          1
+#define MITIE_SERVER_CATEGORIZER_MODEL  2
+#define MITIE_SERVER_RELATION_MODEL     3
+
+#endif // MITLL_MITIE_SERVER_PROTOCOl_H_
+
@@ -0,0 +1,172 @@
+// Copyright (C) 2014 Massachusetts Institute of Technology, Lincoln Laboratory
+// License: Boost Software License   See LICENSE.txt for the full license.
+// Authors: Davis E. King (davis@dlib.net)
+
+/*
+    mitie_serverd loads a set of MITIE models once and serves them to other processes
+    over a Unix domain socket, so short lived programs don't have to pay to load the
+    models every time they run.  See ../client for the protocol definition and a C
+    client library.  mitie.py also has a client, the mitie_server_client class.
+*/
+
+#include <iostream>
+#include <csignal>
+#include <cstdlib>
+#include <dlib/cmd_line_parser.h>
+#include "server.h"
+#include "../client/mitie_server_protocol.h"
+
+using namespace std;
+using namespace dlib;
+
+// ----------------------------------------------------------------------------------------
+
+namespace
+{
+    volatile std::sig_atomic_t stop_requested = 0;
+
+    extern "C" void handle_stop_signal (int)
+    {
+        stop_requested = 1;
+    }
+
+    void parse_model_argument (
+        const std::string& arg,
+        std::string& name,
+        std::string& filename
+    )
+    /*!
+        ensures
+            - splits a model argument of the form name=filename.  If there is no name
+              then the name is the file's name without its folder or extension.
+    !*/
+    {
+        const std::string::size_type eq = arg.find('=');
+        if (eq != std::string::npos)
+        {
+            name = arg.substr(0, eq);
+            filename = arg.substr(eq+1);
+            return;
+        }
+
+        filename = arg;
+        name = arg;
+        const std::string::size_type slash = name.find_last_of('/');
+        if (slash != std::string::npos)
+            name = name.substr(slash+1);
+        const std::string::size_type dot = name.find_last_of('.');
+        if (dot != std::string::npos && dot != 0)
+            name = name.substr(0, dot);
+    }
+
+    unsigned long parse_socket_mode (
+        const command_line_parser& parser
+    )
+    {
+        if (!parser.option("socket-mode"))
+            return 0600;
+        const std::string arg = parser.option("socket-mode").argument();
+        char* end = 0;
+        const unsigned long mode = std::strtoul(arg.c_str(), &end, 8);
+        if (arg.empty() || *end != 0 || mode > 0777)
+            throw error("Error, --socket-mode must be octal permissions such as 600 or 660, not " + arg);
+        return mode;
+    }
+
+    void load_models (
+        const command_line_parser& parser,
+        const char* option,
+        void (model_set::*add)(const std::string&, const std::string&),
+        model_set& models
+    )
+    {
+        for (unsigned long i = 0; i < parser.option(option).count(); ++i)
+        {
+            std::string name, filename;
+            parse_model_argument(parser.option(option).argument(0,i), name, filename);
+            cerr << "Loading " << filename << " as " << name << endl;
+            (models.*add)(name, filename);
+        }
+    }
+}
+
+// ----------------------------------------------------------------------------------------
+
+int main(int argc, char** argv)
+{
+    try
+    {
+        command_line_parser parser;
+        parser.add_option("h", "Display this help information.");
+        parser.add_option("socket", "Listen on the Unix domain socket <arg> (default: "
+            MITIE_SERVER_SOCKET_NAME " in $XDG_RUNTIME_DIR, or in " MITIE_SERVER_FALLBACK_DIR
+            "<uid> if that isn't set).",1);
+        parser.add_option("socket-mode", "Give the socket the octal permissions <arg> (default: 600).  "
+            "Any user with write permission can use the served models.",1);
+        parser.add_option("ner", "Serve the NER model in file <arg>.  <arg> may be given as name=file to "
+            "choose the name clients use for the model, otherwise the name is the file name without "
+            "its extension.  May be given more than once.",1);
+        parser.add_option("cat", "Serve the text categorizer in file <arg>, named like --ner models.  "
+            "May be given more than once.",1);
+        parser.add_option("rel", "Serve the binary relation detector in file <arg>, named like --ner "
+            "models.  It's used with the word features of the first --ner model that has the ones it "
+            "was trained with.  May be given more than once.",1);
+        parser.add_option("threads", "Use <arg> worker threads (default: 4).",1);
+        parser.add_option("queue-size", "Queue at most <arg> requests before making clients wait "
+            "(default: 1024).",1);
+
+        parser.parse(argc, argv);
+        const char* one_time_ops[] = {"h", "socket", "socket-mode", "threads", "queue-size"};
+        parser.check_one_time_options(one_time_ops);
+        parser.check_option_arg_range("threads", 1, 1000);
+        parser.check_option_arg_range("queue-size", 1, 100000000);
+        if (parser.option("h"))
+        {
+            cout << "Usage: mitie_serverd --ner MITIE-models/english/ner_model.dat <options>" << endl;
+            parser.print_options();
+            return 0;
+        }
+        if (parser.number_of_arguments() != 0)
+        {
+            cerr << "Error, models must be given with the --ner, --cat, or --rel options." << endl;
+            return 1;
+        }
+
+        const unsigned long socket_mode = parse_socket_mode(parser);
+
+        model_set models;
+        load_models(parser, "ner", &model_set::add_ner_model, models);
+        load_models(parser, "cat", &model_set::add_text_categorizer, models);
+        load_models(parser, "rel", &model_set::add_relation_detector, models);
+        if (models.size() == 0)
+        {
+            cerr << "Error, you must give at least one model to serve." << endl;
+            return 1;
+        }
+
+        // Clients that hang up before reading their responses would otherwise kill
+        // the server.
+        signal(SIGPIPE, SIG_IGN);
+        signal(SIGINT, handle_stop_signal);
+        signal(SIGTERM, handle_stop_signal);
+
+        const std::string socket_path = parser.option("socket") ?
+            parser.option("socket").argument() : get_default_socket_path();
+        mitie_server server(models, socket_path, socket_mode,
+                            get_option(parser, "threads", 4),
+                            get_option(parser, "queue-size", 1024));
+        cerr << "Listening on " << socket_path << endl;
+        server.run(stop_requested);
+
+        cerr << "Shutting down after " << server.get_num_requests() << " requests ("
+             << server.get_num_coalesced_requests() << " coalesced)." << endl;
+    }
+    catch (std::exception& e)
+    {
+        cerr << e.what() << endl;
+        return 1;
+    }
+}
+
+// ----------------------------------------------------------------------------------------
+
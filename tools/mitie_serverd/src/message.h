@@ -0,0 +1,188 @@
+// Copyright (C) 2014 Massachusetts Institute of Technology, Lincoln Laboratory
+// License: Boost Software License   See LICENSE.txt for the full license.
+// Authors: Davis E. King (davis@dlib.net)
+#ifndef MITIE_SERVERD_MESSAGe_H_
+#define MITIE_SERVERD_MESSAGe_H_
+
+#include <string>
+#include <vector>
+#include <cstring>
+#include <dlib/error.h>
+#include <dlib/uintn.h>
+
+// ----------------------------------------------------------------------------------------
+
+class message_reader
+{
+    /*!
+        WHAT THIS OBJECT REPRESENTS
+            This object decodes the fields of a request body, as defined in
+            mitie_server_protocol.h, from the front of a string.  Every read_*() function
+            throws dlib::error if the message is too short, so a malformed request just
+            gets an error response.
+    !*/
+public:
+    message_reader (
+        const std::string& data_,
+        unsigned long pos_ = 0
+    ) : data(data_), pos(pos_) {}
+
+    unsigned char read_u8 (
+    )
+    {
+        need(1);
+        return (unsigned char)data[pos++];
+    }
+
+    dlib::uint32 read_u32 (
+    )
+    {
+        need(4);
+        dlib::uint32 val = 0;
+        for (int i = 0; i < 4; ++i)
+            val = (val<<8) | (unsigned char)data[pos++];
+        return val;
+    }
+
+    void read_string (
+        std::string& str
+    )
+    {
+        const dlib::uint32 size = read_u32();
+        need(size);
+        str.assign(data, pos, size);
+        pos += size;
+    }
+
+    void read_tokens (
+        std::vector<std::string>& tokens
+    )
+    {
+        const dlib::uint32 size = read_u32();
+        // Each token takes at least 4 bytes, so don't let a bogus count make us
+        // allocate a huge vector.
+        if (size > (data.size()-pos)/4)
+            throw dlib::error("Malformed request: token count is too large.");
+        tokens.resize(size);
+        for (unsigned long i = 0; i < tokens.size(); ++i)
+            read_string(tokens[i]);
+    }
+
+    dlib::uint32 read_count (
+        unsigned long min_item_size
+    )
+    /*!
+        ensures
+            - reads a u32 count of items and checks that the rest of the message is big
+              enough to hold that many items of at least min_item_size bytes each.
+    !*/
+    {
+        const dlib::uint32 size = read_u32();
+        if (size > (data.size()-pos)/min_item_size)
+            throw dlib::error("Malformed request: item count is too large.");
+        return size;
+    }
+
+    void check_done (
+    ) const
+    {
+        if (pos != data.size())
+            throw dlib::error("Malformed request: unexpected bytes at the end of the request.");
+    }
+
+private:
+    void need (
+        unsigned long size
+    ) const
+    {
+        if (data.size() - pos < size)
+            throw dlib::error("Malformed request: the request ended too soon.");
+    }
+
+    const std::string& data;
+    unsigned long pos;
+};
+
+// ----------------------------------------------------------------------------------------
+
+class message_writer
+{
+    /*!
+        WHAT THIS OBJECT REPRESENTS
+            This object builds a response frame, as defined in mitie_server_protocol.h.
+            It starts with room for the frame length, which finish() fills in.
+    !*/
+public:
+    message_writer (
+        dlib::uint32 request_id,
+        unsigned char status
+    )
+    {
+        write_u32(0);
+        write_u32(request_id);
+        write_u8(status);
+    }
+
+    void write_u8 (
+        unsigned char val
+    )
+    {
+        data += (char)val;
+    }
+
+    void write_u32 (
+        dlib::uint32 val
+    )
+    {
+        for (int i = 3; i >= 0; --i)
+            data += (char)((val>>(8*i))&0xFF);
+    }
+
+    void write_double (
+        double val
+    )
+    {
+        dlib::uint64 bits;
+        std::memcpy(&bits, &val, sizeof(bits));
+        for (int i = 7; i >= 0; --i)
+            data += (char)((bits>>(8*i))&0xFF);
+    }
+
+    void write_string (
+        const std::string& str
+    )
+    {
+        write_u32(str.size());
+        data += str;
+    }
+
+    void write_tokens (
+        const std::vector<std::string>& tokens
+    )
+    {
+        write_u32(tokens.size());
+        for (unsigned long i = 0; i < tokens.size(); ++i)
+            write_string(tokens[i]);
+    }
+
+    std::string& finish (
+    )
+    /*!
+        ensures
+            - fills in the frame length and returns the whole frame.
+    !*/
+    {
+        const dlib::uint32 size = data.size() - 4;
+        for (int i = 0; i < 4; ++i)
+            data[i] = (char)((size>>(8*(3-i)))&0xFF);
+        return data;
+    }
+
+private:
+    std::string data;
+};
+
+// ----------------------------------------------------------------------------------------
+
+#endif // MITIE_SERVERD_MESSAGe_H_
+
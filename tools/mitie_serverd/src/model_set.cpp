@@ -0,0 +1,194 @@
+// Copyright (C) 2014 Massachusetts Institute of Technology, Lincoln Laboratory
+// License: Boost Software License   See LICENSE.txt for the full license.
+// Authors: Davis E. King (davis@dlib.net)
+
+#include "model_set.h"
+#include "../client/mitie_server_protocol.h"
+#include <dlib/serialize.h>
+
+using namespace std;
+using namespace dlib;
+using namespace mitie;
+
+// ----------------------------------------------------------------------------------------
+
+namespace
+{
+    template <typename T>
+    void load_model (
+        const std::string& filename,
+        const std::string& expected_classname,
+        T& model
+    )
+    {
+        string classname;
+        deserialize(filename) >> classname;
+        if (classname != expected_classname)
+            throw dlib::error("The file " + filename + " does not contain a " + expected_classname + ". Contained: " + classname);
+        deserialize(filename) >> classname >> model;
+    }
+
+    template <typename list_type>
+    typename list_type::const_iterator find_model (
+        const list_type& models,
+        const std::string& name
+    )
+    {
+        if (name.size() == 0)
+            return models.begin();
+        for (typename list_type::const_iterator i = models.begin(); i != models.end(); ++i)
+        {
+            if (i->name == name)
+                return i;
+        }
+        return models.end();
+    }
+}
+
+// ----------------------------------------------------------------------------------------
+
+void model_set::
+add_ner_model (
+    const std::string& name,
+    const std::string& filename
+)
+{
+    if (find_model(ners, name) != ners.end())
+        throw dlib::error("There is already a NER model named " + name);
+    ners.push_back(named_model<named_entity_extractor>());
+    try
+    {
+        ners.back().name = name;
+        load_model(filename, "mitie::named_entity_extractor", ners.back().model);
+    }
+    catch (...)
+    {
+        ners.pop_back();
+        throw;
+    }
+}
+
+// ----------------------------------------------------------------------------------------
+
+void model_set::
+add_text_categorizer (
+    const std::string& name,
+    const std::string& filename
+)
+{
+    if (find_model(cats, name) != cats.end())
+        throw dlib::error("There is already a text categorizer named " + name);
+    cats.push_back(named_model<text_categorizer>());
+    try
+    {
+        cats.back().name = name;
+        load_model(filename, "mitie::text_categorizer", cats.back().model);
+    }
+    catch (...)
+    {
+        cats.pop_back();
+        throw;
+    }
+}
+
+// ----------------------------------------------------------------------------------------
+
+void model_set::
+add_relation_detector (
+    const std::string& name,
+    const std::string& filename
+)
+{
+    if (find_model(rels, name) != rels.end())
+        throw dlib::error("There is already a relation detector named " + name);
+
+    relation_model rel;
+    rel.name = name;
+    rel.fe = 0;
+    load_model(filename, "mitie::binary_relation_detector", rel.detector);
+    for (std::list<named_model<named_entity_extractor> >::const_iterator i = ners.begin(); i != ners.end(); ++i)
+    {
+        const total_word_feature_extractor& fe = i->model.get_total_word_feature_extractor();
+        if (fe.get_fingerprint() == rel.detector.total_word_feature_extractor_fingerprint)
+        {
+            rel.fe = &fe;
+            break;
+        }
+    }
+    if (rel.fe == 0)
+        throw dlib::error("The relation detector in " + filename + " doesn't use the word features of any of the loaded NER models.");
+    rels.push_back(rel);
+}
+
+// ----------------------------------------------------------------------------------------
+
+const named_entity_extractor& model_set::
+get_ner_model (
+    const std::string& name
+) const
+{
+    std::list<named_model<named_entity_extractor> >::const_iterator i = find_model(ners, name);
+    if (i == ners.end())
+        throw dlib::error("There is no NER model named '" + name + "'");
+    return i->model;
+}
+
+// ----------------------------------------------------------------------------------------
+
+const text_categorizer& model_set::
+get_text_categorizer (
+    const std::string& name
+) const
+{
+    std::list<named_model<text_categorizer> >::const_iterator i = find_model(cats, name);
+    if (i == cats.end())
+        throw dlib::error("There is no text categorizer named '" + name + "'");
+    return i->model;
+}
+
+// ----------------------------------------------------------------------------------------
+
+void model_set::
+get_relation_detector (
+    const std::string& name,
+    const binary_relation_detector*& detector,
+    const total_word_feature_extractor*& fe
+) const
+{
+    std::list<relation_model>::const_iterator i = find_model(rels, name);
+    if (i == rels.end())
+        throw dlib::error("There is no relation detector named '" + name + "'");
+    detector = &i->detector;
+    fe = i->fe;
+}
+
+// ----------------------------------------------------------------------------------------
+
+void model_set::
+write_model_list (
+    message_writer& out
+) const
+{
+    out.write_u32(size());
+    for (std::list<named_model<named_entity_extractor> >::const_iterator i = ners.begin(); i != ners.end(); ++i)
+    {
+        out.write_u8(MITIE_SERVER_NER_MODEL);
+        out.write_string(i->name);
+        out.write_tokens(i->model.get_tag_name_strings());
+    }
+    for (std::list<named_model<text_categorizer> >::const_iterator i = cats.begin(); i != cats.end(); ++i)
+    {
+        out.write_u8(MITIE_SERVER_CATEGORIZER_MODEL);
+        out.write_string(i->name);
+        out.write_tokens(i->model.get_tag_name_strings());
+    }
+    for (std::list<relation_model>::const_iterator i = rels.begin(); i != rels.end(); ++i)
+    {
+        out.write_u8(MITIE_SERVER_RELATION_MODEL);
+        out.write_string(i->name);
+        out.write_tokens(std::vector<std::string>(1, i->detector.relation_type));
+    }
+}
+
+// ----------------------------------------------------------------------------------------
+
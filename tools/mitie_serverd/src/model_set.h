@@ -0,0 +1,131 @@
+// Copyright (C) 2014 Massachusetts Institute of Technology, Lincoln Laboratory
+// License: Boost Software License   See LICENSE.txt for the full license.
+// Authors: Davis E. King (davis@dlib.net)
+#ifndef MITIE_SERVERD_MODEL_SeT_H_
+#define MITIE_SERVERD_MODEL_SeT_H_
+
+#include <string>
+#include <list>
+#include <mitie/named_entity_extractor.h>
+#include <mitie/text_categorizer.h>
+#include <mitie/binary_relation_detector.h>
+#include "message.h"
+
+// ----------------------------------------------------------------------------------------
+
+class model_set : dlib::noncopyable
+{
+    /*!
+        WHAT THIS OBJECT REPRESENTS
+            This object holds all the models mitie_serverd serves, each under a name
+            clients use to pick it.  Once loaded, the models are only read so any
+            number of threads may use them at once.
+    !*/
+public:
+
+    void add_ner_model (
+        const std::string& name,
+        const std::string& filename
+    );
+    /*!
+        ensures
+            - loads the mitie::named_entity_extractor saved in filename.
+        throws
+            - dlib::error if the file can't be loaded or the name is already used by
+              another NER model.
+    !*/
+
+    void add_text_categorizer (
+        const std::string& name,
+        const std::string& filename
+    );
+    /*!
+        ensures
+            - loads the mitie::text_categorizer saved in filename.
+        throws
+            - dlib::error if the file can't be loaded or the name is already used by
+              another text categorizer.
+    !*/
+
+    void add_relation_detector (
+        const std::string& name,
+        const std::string& filename
+    );
+    /*!
+        ensures
+            - loads the mitie::binary_relation_detector saved in filename.  Relation
+              detectors need the word features of the NER model they were trained with,
+              so the detector is paired with the first loaded NER model that has the
+              same total_word_feature_extractor.
+        throws
+            - dlib::error if the file can't be loaded, the name is already used by
+              another relation detector, or no loaded NER model has a matching
+              total_word_feature_extractor.
+    !*/
+
+    unsigned long size (
+    ) const { return ners.size() + cats.size() + rels.size(); }
+
+    const mitie::named_entity_extractor& get_ner_model (
+        const std::string& name
+    ) const;
+    /*!
+        ensures
+            - returns the NER model with the given name, or the first one if name is
+              empty.
+        throws
+            - dlib::error if there is no such model.
+    !*/
+
+    const mitie::text_categorizer& get_text_categorizer (
+        const std::string& name
+    ) const;
+
+    void get_relation_detector (
+        const std::string& name,
+        const mitie::binary_relation_detector*& detector,
+        const mitie::total_word_feature_extractor*& fe
+    ) const;
+    /*!
+        ensures
+            - #detector == the relation detector with the given name, or the first one if
+              name is empty.
+            - #fe == the word features #detector is used with.
+        throws
+            - dlib::error if there is no such model.
+    !*/
+
+    void write_model_list (
+        message_writer& out
+    ) const;
+    /*!
+        ensures
+            - writes the body of a MITIE_SERVER_LIST_MODELS response to out.
+    !*/
+
+private:
+
+    template <typename T>
+    struct named_model
+    {
+        std::string name;
+        T model;
+    };
+
+    struct relation_model
+    {
+        std::string name;
+        mitie::binary_relation_detector detector;
+        const mitie::total_word_feature_extractor* fe;
+    };
+
+    // These are lists so the models never move once loaded.
+    std::list<named_model<mitie::named_entity_extractor> > ners;
+    std::list<named_model<mitie::text_categorizer> > cats;
+    std::list<relation_model> rels;
+};
+
+// ----------------------------------------------------------------------------------------
+
+#endif // MITIE_SERVERD_MODEL_SeT_H_
+
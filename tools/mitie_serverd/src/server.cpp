@@ -0,0 +1,654 @@
+// Copyright (C) 2014 Massachusetts Institute of Technology, Lincoln Laboratory
+// License: Boost Software License   See LICENSE.txt for the full license.
+// Authors: Davis E. King (davis@dlib.net)
+
+#include "server.h"
+#include "../client/mitie_server_protocol.h"
+#include <dlib/general_hash/murmur_hash3.h>
+#include <dlib/string.h>
+#include <sys/types.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <cerrno>
+#include <cstring>
+#include <cstdlib>
+
+using namespace std;
+using namespace dlib;
+using namespace mitie;
+
+// ----------------------------------------------------------------------------------------
+
+namespace
+{
+    // run() stops reading requests from a client once this many bytes of responses
+    // are waiting for it to read them.
+    const unsigned long max_unsent_bytes = 1024*1024;
+
+    void set_nonblocking (
+        int fd
+    )
+    {
+        fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+        fcntl(fd, F_SETFD, fcntl(fd, F_GETFD) | FD_CLOEXEC);
+    }
+
+    void make_socket_address (
+        const std::string& path,
+        sockaddr_un& addr
+    )
+    {
+        memset(&addr, 0, sizeof(addr));
+        addr.sun_family = AF_UNIX;
+        if (path.size() >= sizeof(addr.sun_path))
+            throw dlib::error("The socket path " + path + " is too long.");
+        strcpy(addr.sun_path, path.c_str());
+    }
+
+    bool is_server_listening (
+        const std::string& path
+    )
+    {
+        sockaddr_un addr;
+        make_socket_address(path, addr);
+        const int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0)
+            return false;
+        const bool listening = connect(fd, (sockaddr*)&addr, sizeof(addr)) == 0;
+        close(fd);
+        return listening;
+    }
+
+    dlib::uint32 decode_u32 (
+        const std::string& data,
+        unsigned long pos
+    )
+    {
+        return ((dlib::uint32)(unsigned char)data[pos]<<24) |
+               ((dlib::uint32)(unsigned char)data[pos+1]<<16) |
+               ((dlib::uint32)(unsigned char)data[pos+2]<<8) |
+               ((dlib::uint32)(unsigned char)data[pos+3]);
+    }
+
+    void set_request_id (
+        std::string& frame,
+        dlib::uint32 request_id
+    )
+    {
+        for (int i = 0; i < 4; ++i)
+            frame[4+i] = (char)((request_id>>(8*(3-i)))&0xFF);
+    }
+
+    std::pair<unsigned long,unsigned long> read_range (
+        message_reader& in,
+        unsigned long num_tokens
+    )
+    {
+        std::pair<unsigned long,unsigned long> range;
+        range.first = in.read_u32();
+        range.second = in.read_u32();
+        if (!(range.first < range.second && range.second <= num_tokens))
+            throw dlib::error("Invalid relation argument range.");
+        return range;
+    }
+}
+
+// ----------------------------------------------------------------------------------------
+
+mitie_server::connection::
+~connection (
+)
+{
+    // Give the client whatever is left of the responses the socket will take.
+    flush();
+    close(fd);
+}
+
+// ----------------------------------------------------------------------------------------
+
+bool mitie_server::connection::
+send (
+    const std::string& frame
+)
+{
+    auto_mutex lock(write_mutex);
+    if (broken)
+        return false;
+    // If older responses are still waiting the new one has to go after them.
+    const bool was_empty = outbuf.size() == 0;
+    outbuf.append(frame);
+    if (was_empty)
+        write_outbuf();
+    return outbuf.size() != 0;
+}
+
+// ----------------------------------------------------------------------------------------
+
+void mitie_server::connection::
+flush (
+)
+{
+    auto_mutex lock(write_mutex);
+    write_outbuf();
+}
+
+// ----------------------------------------------------------------------------------------
+
+unsigned long mitie_server::connection::
+num_unsent_bytes (
+) const
+{
+    auto_mutex lock(write_mutex);
+    return outbuf.size();
+}
+
+// ----------------------------------------------------------------------------------------
+
+void mitie_server::connection::
+write_outbuf (
+)
+/*!
+    requires
+        - write_mutex is locked
+!*/
+{
+    unsigned long pos = 0;
+    while (pos < outbuf.size() && !broken)
+    {
+        const ssize_t num = ::send(fd, outbuf.data()+pos, outbuf.size()-pos, 0);
+        if (num < 0 && errno == EINTR)
+            continue;
+        if (num < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+            break;
+        // If the client went away there is nobody to tell, so the responses are
+        // thrown away and the connection is dropped once run() notices.
+        if (num <= 0)
+        {
+            broken = true;
+            outbuf.clear();
+            return;
+        }
+        pos += num;
+    }
+    outbuf.erase(0, pos);
+}
+
+// ----------------------------------------------------------------------------------------
+
+std::string get_default_socket_path (
+)
+{
+    const char* runtime_dir = getenv("XDG_RUNTIME_DIR");
+    if (runtime_dir && runtime_dir[0] == '/')
+        return string(runtime_dir) + "/" + MITIE_SERVER_SOCKET_NAME;
+
+    const uid_t uid = getuid();
+    const string dir = MITIE_SERVER_FALLBACK_DIR + dlib::cast_to_string((unsigned long)uid);
+    if (mkdir(dir.c_str(), 0700) != 0 && errno != EEXIST)
+        throw dlib::error("Unable to create the folder " + dir + ": " + string(strerror(errno)));
+
+    // The folder may have been made by someone else, so only trust it if it's ours
+    // and nobody else can get into it.
+    struct stat info;
+    if (lstat(dir.c_str(), &info) != 0)
+        throw dlib::error("Unable to check the folder " + dir + ": " + string(strerror(errno)));
+    if (!S_ISDIR(info.st_mode) || info.st_uid != uid || (info.st_mode & 077) != 0)
+        throw dlib::error("The folder " + dir + " isn't a private folder owned by this user.  "
+                          "Remove it or give a socket path with --socket.");
+    return dir + "/" + MITIE_SERVER_SOCKET_NAME;
+}
+
+// ----------------------------------------------------------------------------------------
+
+mitie_server::
+mitie_server (
+    const model_set& models_,
+    const std::string& socket_path_,
+    unsigned long socket_mode,
+    unsigned long num_threads,
+    unsigned long max_queued_requests_
+) :
+    models(models_),
+    socket_path(socket_path_),
+    max_queued_requests(max_queued_requests_),
+    listen_fd(-1),
+    not_empty(m),
+    not_full(m),
+    stopping(false),
+    num_requests(0),
+    num_coalesced(0)
+{
+    DLIB_CASSERT(socket_mode <= 0777 && num_threads > 0 && max_queued_requests > 0,
+        "\t mitie_server::mitie_server()"
+        << "\n\t Invalid inputs were given to this function."
+        << "\n\t socket_mode:         " << std::oct << socket_mode << std::dec
+        << "\n\t num_threads:         " << num_threads
+        << "\n\t max_queued_requests: " << max_queued_requests
+        );
+
+    sockaddr_un addr;
+    make_socket_address(socket_path, addr);
+
+    struct stat info;
+    if (lstat(socket_path.c_str(), &info) == 0)
+    {
+        if (!S_ISSOCK(info.st_mode))
+            throw dlib::error("The socket path " + socket_path + " already exists and isn't a socket.");
+        if (is_server_listening(socket_path))
+            throw dlib::error("Another server is already listening on " + socket_path);
+        unlink(socket_path.c_str());
+    }
+
+    if (pipe(wake_fds) != 0)
+        throw dlib::error("Unable to create a pipe: " + string(strerror(errno)));
+    set_nonblocking(wake_fds[0]);
+    set_nonblocking(wake_fds[1]);
+
+    listen_fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listen_fd < 0)
+    {
+        const string message = strerror(errno);
+        close(wake_fds[0]);
+        close(wake_fds[1]);
+        throw dlib::error("Unable to create a Unix domain socket: " + message);
+    }
+    // Nobody else can connect between bind() and chmod() since the socket starts out
+    // with no permissions for other users.  The umask is process wide, but no other
+    // threads are running yet.
+    const mode_t old_umask = umask(0177);
+    const bool bound = bind(listen_fd, (sockaddr*)&addr, sizeof(addr)) == 0;
+    umask(old_umask);
+    if (!bound || chmod(socket_path.c_str(), socket_mode) != 0 || listen(listen_fd, 128) != 0)
+    {
+        const string message = strerror(errno);
+        close(listen_fd);
+        close(wake_fds[0]);
+        close(wake_fds[1]);
+        throw dlib::error("Unable to listen on " + socket_path + ": " + message);
+    }
+
+    for (unsigned long i = 0; i < num_threads; ++i)
+        workers.push_back(dlib::shared_ptr<thread_function>(new thread_function(&mitie_server::worker_thread, this)));
+}
+
+// ----------------------------------------------------------------------------------------
+
+mitie_server::
+~mitie_server (
+)
+{
+    {
+        auto_mutex lock(m);
+        stopping = true;
+        not_empty.broadcast();
+        not_full.broadcast();
+    }
+    // The thread_function destructors wait for the workers to finish.
+    workers.clear();
+    close(listen_fd);
+    close(wake_fds[0]);
+    close(wake_fds[1]);
+    unlink(socket_path.c_str());
+}
+
+// ----------------------------------------------------------------------------------------
+
+dlib::uint64 mitie_server::
+get_num_requests (
+) const
+{
+    auto_mutex lock(m);
+    return num_requests;
+}
+
+dlib::uint64 mitie_server::
+get_num_coalesced_requests (
+) const
+{
+    auto_mutex lock(m);
+    return num_coalesced;
+}
+
+// ----------------------------------------------------------------------------------------
+
+void mitie_server::
+run (
+    const volatile std::sig_atomic_t& stop
+)
+{
+    std::vector<connection_ptr> conns;
+    std::vector<pollfd> fds;
+    while (!stop)
+    {
+        fds.resize(conns.size()+2);
+        fds[0].fd = listen_fd;
+        fds[0].events = POLLIN;
+        fds[0].revents = 0;
+        fds[1].fd = wake_fds[0];
+        fds[1].events = POLLIN;
+        fds[1].revents = 0;
+        for (unsigned long i = 0; i < conns.size(); ++i)
+        {
+            const unsigned long unsent = conns[i]->num_unsent_bytes();
+            fds[i+2].fd = conns[i]->fd;
+            fds[i+2].events = 0;
+            if (unsent < max_unsent_bytes)
+                fds[i+2].events |= POLLIN;
+            if (unsent != 0)
+                fds[i+2].events |= POLLOUT;
+            fds[i+2].revents = 0;
+        }
+
+        if (poll(&fds[0], fds.size(), 200) < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            throw dlib::error("poll() failed: " + string(strerror(errno)));
+        }
+
+        if (fds[1].revents & POLLIN)
+        {
+            char buf[64];
+            while (read(wake_fds[0], buf, sizeof(buf)) > 0) {}
+        }
+
+        // Go backwards so dropping a connection doesn't change the index of the ones
+        // we haven't looked at yet.
+        for (unsigned long i = conns.size(); i > 0; --i)
+        {
+            const short revents = fds[i+1].revents;
+            bool keep = (revents & (POLLERR|POLLHUP|POLLNVAL)) == 0;
+            if (keep && (revents & POLLOUT))
+                conns[i-1]->flush();
+            if (keep && (revents & POLLIN))
+                keep = read_requests(conns[i-1]);
+            if (!keep)
+                conns.erase(conns.begin() + (i-1));
+        }
+
+        if (fds[0].revents & POLLIN)
+        {
+            const int fd = accept(listen_fd, 0, 0);
+            if (fd >= 0)
+            {
+                set_nonblocking(fd);
+                conns.push_back(connection_ptr(new connection(fd)));
+            }
+        }
+    }
+}
+
+// ----------------------------------------------------------------------------------------
+
+bool mitie_server::
+read_requests (
+    connection_ptr& conn
+)
+{
+    char buf[64*1024];
+    const ssize_t num = recv(conn->fd, buf, sizeof(buf), 0);
+    if (num < 0 && (errno == EINTR || errno == EAGAIN || errno == EWOULDBLOCK))
+        return true;
+    if (num <= 0)
+        return false;
+    conn->inbuf.append(buf, num);
+
+    std::string& inbuf = conn->inbuf;
+    unsigned long pos = 0;
+    while (inbuf.size() - pos >= 4)
+    {
+        const dlib::uint32 size = decode_u32(inbuf, pos);
+        // A request has at least an ID and an operation.  Anything else means the
+        // client isn't speaking our protocol so we hang up on it.
+        if (size < 5 || size > MITIE_SERVER_MAX_FRAME_SIZE)
+            return false;
+        if (inbuf.size() - pos - 4 < size)
+            break;
+
+        const dlib::uint32 request_id = decode_u32(inbuf, pos+4);
+        const unsigned char op = inbuf[pos+8];
+        dispatch(conn, request_id, op, inbuf.substr(pos+9, size-5));
+        pos += 4 + size;
+    }
+    inbuf.erase(0, pos);
+    return true;
+}
+
+// ----------------------------------------------------------------------------------------
+
+void mitie_server::
+dispatch (
+    connection_ptr& conn,
+    dlib::uint32 request_id,
+    unsigned char op,
+    const std::string& body
+)
+{
+    switch (op)
+    {
+        case MITIE_SERVER_PING:
+        case MITIE_SERVER_LIST_MODELS:
+            {
+                message_writer out(request_id, MITIE_SERVER_OK);
+                if (op == MITIE_SERVER_LIST_MODELS)
+                    models.write_model_list(out);
+                conn->send(out.finish());
+                auto_mutex lock(m);
+                ++num_requests;
+            } break;
+
+        case MITIE_SERVER_EXTRACT_ENTITIES:
+        case MITIE_SERVER_CATEGORIZE:
+        case MITIE_SERVER_SCORE_RELATIONS:
+            enqueue(conn, request_id, op, body);
+            break;
+
+        default:
+            {
+                message_writer out(request_id, MITIE_SERVER_ERROR);
+                out.write_string("Unknown operation.");
+                conn->send(out.finish());
+                auto_mutex lock(m);
+                ++num_requests;
+            } break;
+    }
+}
+
+// ----------------------------------------------------------------------------------------
+
+void mitie_server::
+enqueue (
+    connection_ptr& conn,
+    dlib::uint32 request_id,
+    unsigned char op,
+    const std::string& body
+)
+{
+    waiter w;
+    w.conn = conn;
+    w.request_id = request_id;
+    const dlib::uint32 hash = murmur_hash3(body.data(), body.size(), op);
+
+    auto_mutex lock(m);
+    for (std::list<pending_request>::iterator i = queue.begin(); i != queue.end(); ++i)
+    {
+        if (i->op == op && i->hash == hash && i->body == body)
+        {
+            i->waiters.push_back(w);
+            ++num_coalesced;
+            return;
+        }
+    }
+
+    while (queue.size() >= max_queued_requests && !stopping)
+        not_full.wait();
+
+    queue.push_back(pending_request());
+    queue.back().op = op;
+    queue.back().body = body;
+    queue.back().hash = hash;
+    queue.back().waiters.push_back(w);
+    not_empty.signal();
+}
+
+// ----------------------------------------------------------------------------------------
+
+void mitie_server::
+worker_thread (
+    mitie_server* self
+)
+{
+    pending_request req;
+    // The word feature buffer this worker gives to the models.
+    sentence_features feats;
+    while (true)
+    {
+        {
+            auto_mutex lock(self->m);
+            while (self->queue.size() == 0 && !self->stopping)
+                self->not_empty.wait();
+            if (self->queue.size() == 0)
+                return;
+            req.op = self->queue.front().op;
+            req.body.swap(self->queue.front().body);
+            req.waiters.swap(self->queue.front().waiters);
+            self->queue.pop_front();
+            self->not_full.signal();
+        }
+
+        std::string frame;
+        try
+        {
+            message_writer out(0, MITIE_SERVER_OK);
+            self->handle_request(req.op, req.body, out, feats);
+            frame.swap(out.finish());
+        }
+        catch (std::exception& e)
+        {
+            message_writer out(0, MITIE_SERVER_ERROR);
+            out.write_string(e.what());
+            frame.swap(out.finish());
+        }
+
+        bool wake = false;
+        for (unsigned long i = 0; i < req.waiters.size(); ++i)
+        {
+            set_request_id(frame, req.waiters[i].request_id);
+            if (req.waiters[i].conn->send(frame))
+                wake = true;
+        }
+        if (wake)
+            self->wake_poll_thread();
+
+        {
+            auto_mutex lock(self->m);
+            self->num_requests += req.waiters.size();
+        }
+        // Let go of the connections now rather than when the next request comes.
+        req.waiters.clear();
+    }
+}
+
+// ----------------------------------------------------------------------------------------
+
+void mitie_server::
+wake_poll_thread (
+)
+{
+    // If the pipe is full run() is going to wake up anyway, so errors don't matter.
+    const char byte = 1;
+    if (write(wake_fds[1], &byte, 1) < 0) {}
+}
+
+// ----------------------------------------------------------------------------------------
+
+void mitie_server::
+handle_request (
+    unsigned char op,
+    const std::string& body,
+    message_writer& out,
+    sentence_features& feats
+) const
+{
+    message_reader in(body);
+    std::string model_name;
+    in.read_string(model_name);
+
+    if (op == MITIE_SERVER_EXTRACT_ENTITIES)
+    {
+        const named_entity_extractor& ner = models.get_ner_model(model_name);
+        std::vector<std::vector<std::string> > sentences(in.read_count(4));
+        for (unsigned long i = 0; i < sentences.size(); ++i)
+            in.read_tokens(sentences[i]);
+        in.check_done();
+
+        out.write_tokens(ner.get_tag_name_strings());
+        std::vector<std::pair<unsigned long,unsigned long> > chunks;
+        std::vector<unsigned long> tags;
+        std::vector<double> scores;
+        for (unsigned long i = 0; i < sentences.size(); ++i)
+        {
+            ner.predict(sentences[i], chunks, tags, scores, ner.get_total_word_feature_extractor(), feats);
+            out.write_u32(chunks.size());
+            for (unsigned long j = 0; j < chunks.size(); ++j)
+            {
+                out.write_u32(chunks[j].first);
+                out.write_u32(chunks[j].second);
+                out.write_u32(tags[j]);
+                out.write_double(scores[j]);
+            }
+        }
+    }
+    else if (op == MITIE_SERVER_CATEGORIZE)
+    {
+        const text_categorizer& cat = models.get_text_categorizer(model_name);
+        std::vector<std::vector<std::string> > documents(in.read_count(4));
+        for (unsigned long i = 0; i < documents.size(); ++i)
+        {
+            in.read_tokens(documents[i]);
+            // The text_categorizer asserts on empty documents, and dlib ends the
+            // program if a failed assert is caught and ignored twice, so this has to
+            // be caught here.
+            if (documents[i].size() == 0)
+                throw dlib::error("Documents given to a text categorizer can't be empty.");
+        }
+        in.check_done();
+
+        std::string label;
+        double score;
+        for (unsigned long i = 0; i < documents.size(); ++i)
+        {
+            cat.predict(documents[i], label, score, cat.get_total_word_feature_extractor(), feats);
+            out.write_string(label);
+            out.write_double(score);
+        }
+    }
+    else if (op == MITIE_SERVER_SCORE_RELATIONS)
+    {
+        const binary_relation_detector* detector;
+        const total_word_feature_extractor* fe;
+        models.get_relation_detector(model_name, detector, fe);
+        // Each relation is at least an empty token list and 4 range values.
+        const unsigned long num = in.read_count(4+4*4);
+        std::vector<std::string> tokens;
+        std::vector<double> scores;
+        for (unsigned long i = 0; i < num; ++i)
+        {
+            in.read_tokens(tokens);
+            const std::pair<unsigned long,unsigned long> arg1 = read_range(in, tokens.size());
+            const std::pair<unsigned long,unsigned long> arg2 = read_range(in, tokens.size());
+            scores.push_back((*detector)(extract_binary_relation(tokens, arg1, arg2, *fe)));
+        }
+        in.check_done();
+
+        for (unsigned long i = 0; i < scores.size(); ++i)
+            out.write_double(scores[i]);
+    }
+}
+
+// ----------------------------------------------------------------------------------------
+
@@ -0,0 +1,229 @@
+// Copyright (C) 2014 Massachusetts Institute of Technology, Lincoln Laboratory
+// License: Boost Software License   See LICENSE.txt for the full license.
+// Authors: Davis E. King (davis@dlib.net)
+#ifndef MITIE_SERVERD_SERVEr_H_
+#define MITIE_SERVERD_SERVEr_H_
+
+#include <string>
+#include <vector>
+#include <list>
+#include <csignal>
+#include <dlib/threads.h>
+#include <dlib/smart_pointers_thread_safe.h>
+#include <dlib/smart_pointers.h>
+#include "model_set.h"
+
+// ----------------------------------------------------------------------------------------
+
+std::string get_default_socket_path (
+);
+/*!
+    ensures
+        - returns the path of the socket to listen on when the user doesn't give one.
+          This is a file in $XDG_RUNTIME_DIR, or in a folder named after the user's id
+          under /tmp if XDG_RUNTIME_DIR isn't set (see mitie_server_protocol.h).
+        - In the second case the folder is created with mode 0700 if it doesn't exist.
+    throws
+        - dlib::error if the folder can't be created, or if it already exists but isn't
+          a folder that only the current user owns and can get into.  Otherwise another
+          user could put their own socket in it.
+!*/
+
+// ----------------------------------------------------------------------------------------
+
+class mitie_server : dlib::noncopyable
+{
+    /*!
+        WHAT THIS OBJECT REPRESENTS
+            This object serves the models in a model_set over a Unix domain socket using
+            the protocol in mitie_server_protocol.h.
+
+            One thread, the one that calls run(), accepts connections and reads requests
+            from all of them.  Cheap requests, like pings, are answered right away.  The
+            rest go into a queue that a pool of worker threads takes them from.  A
+            request that's identical to one still waiting in the queue, say because many
+            clients asked about the same text at about the same time, isn't queued
+            again.  Instead its client gets a copy of the response to the queued one.
+
+            The queue holds at most a fixed number of requests.  When it's full, the
+            reading thread waits for the workers to catch up, which in turn makes
+            clients wait rather than letting the server's memory use grow without
+            bound.
+
+            Responses are never written with a blocking call.  Whatever a client
+            isn't ready to take is kept in a buffer for that connection, which the
+            thread in run() writes out as the client reads.  So a client that stops
+            reading can't hold up the workers.  Once too much is waiting for it the
+            server also stops reading its requests until it catches up.
+    !*/
+public:
+
+    mitie_server (
+        const model_set& models,
+        const std::string& socket_path,
+        unsigned long socket_mode,
+        unsigned long num_threads,
+        unsigned long max_queued_requests
+    );
+    /*!
+        requires
+            - socket_mode <= 0777
+            - num_threads > 0
+            - max_queued_requests > 0
+        ensures
+            - Creates the socket at socket_path, replacing a stale socket file left
+              behind by a server that's no longer running, and starts the worker
+              threads.
+            - The socket's permissions are socket_mode.  It's created with none for
+              other users, so they can't connect before it gets that mode.
+        throws
+            - dlib::error if the socket can't be created, e.g. because another server is
+              already listening on it.
+    !*/
+
+    ~mitie_server (
+    );
+    /*!
+        ensures
+            - Waits for the worker threads to answer the requests already queued, then
+              closes all connections and removes the socket file.
+    !*/
+
+    void run (
+        const volatile std::sig_atomic_t& stop
+    );
+    /*!
+        ensures
+            - Serves clients until stop becomes nonzero, e.g. because a signal handler
+              set it.  stop is checked several times a second.
+    !*/
+
+    dlib::uint64 get_num_requests (
+    ) const;
+    /*!
+        ensures
+            - returns the number of requests answered so far.
+    !*/
+
+    dlib::uint64 get_num_coalesced_requests (
+    ) const;
+    /*!
+        ensures
+            - returns the number of requests that were answered with a copy of the
+              response to an identical request.
+    !*/
+
+private:
+
+    struct connection : dlib::noncopyable
+    {
+        connection (int fd_) : fd(fd_), broken(false) {}
+        ~connection ();
+
+        bool send (
+            const std::string& frame
+        );
+        /*!
+            ensures
+                - writes as much of frame as the socket takes right now and keeps the
+                  rest to be written by flush().
+                - returns true if some of the response is waiting for flush().
+        !*/
+
+        void flush (
+        );
+        /*!
+            ensures
+                - writes as much of the waiting output as the socket takes right now.
+        !*/
+
+        unsigned long num_unsent_bytes (
+        ) const;
+
+        const int fd;
+        // Bytes read from the client that don't make a whole request yet.  Only
+        // the thread in run() touches this.
+        std::string inbuf;
+
+    private:
+        void write_outbuf (
+        );
+
+        // Held while touching outbuf so responses from different threads don't get
+        // interleaved.
+        mutable dlib::mutex write_mutex;
+        // Bytes of responses the client hasn't taken yet.
+        std::string outbuf;
+        // Set once writing to the client fails.  After that responses are dropped.
+        bool broken;
+    };
+    typedef dlib::shared_ptr_thread_safe<connection> connection_ptr;
+
+    struct waiter
+    {
+        connection_ptr conn;
+        dlib::uint32 request_id;
+    };
+
+    struct pending_request
+    {
+        unsigned char op;
+        std::string body;
+        dlib::uint32 hash;
+        std::vector<waiter> waiters;
+    };
+
+    bool read_requests (
+        connection_ptr& conn
+    );
+
+    void dispatch (
+        connection_ptr& conn,
+        dlib::uint32 request_id,
+        unsigned char op,
+        const std::string& body
+    );
+
+    void enqueue (
+        connection_ptr& conn,
+        dlib::uint32 request_id,
+        unsigned char op,
+        const std::string& body
+    );
+
+    void handle_request (
+        unsigned char op,
+        const std::string& body,
+        message_writer& out,
+        mitie::sentence_features& feats
+    ) const;
+
+    static void worker_thread (
+        mitie_server* self
+    );
+
+    void wake_poll_thread (
+    );
+
+    const model_set& models;
+    const std::string socket_path;
+    const unsigned long max_queued_requests;
+    int listen_fd;
+    // Workers write to wake_fds[1] so run() starts writing the responses they
+    // couldn't send right away without waiting for poll() to time out.
+    int wake_fds[2];
+
+    mutable dlib::mutex m;
+    dlib::signaler not_empty;
+    dlib::signaler not_full;
+    std::list<pending_request> queue;
+    bool stopping;
+    dlib::uint64 num_requests;
+    dlib::uint64 num_coalesced;
+    std::vector<dlib::shared_ptr<dlib::thread_function> > workers;
+};
+
+// ----------------------------------------------------------------------------------------
+
+#endif // MITIE_SERVERD_SERVEr_H_
+
@@ -33,11 +33,15 @@ int main(int argc, char** argv)
         parser.add_option("train", "train named_entity_extractor on CoNLL data.");
         parser.add_option("test", "test named_entity_extractor on CoNLL data.");
         parser.add_option("threads", "Use <arg> threads when doing training (default: 4).",1);
+        parser.add_option("gate-recall", "Also train a sentence gate that lets the model skip sentences "
+            "unlikely to contain entities while keeping about <arg> of the training entities, e.g. 0.99.",1);
         parser.add_option("tag-conll-file", "Read in a CoNLL annotation file and output a copy that is tagged with a MITIE NER model.");
 
         parser.parse(argc,argv);
         parser.check_option_arg_range("threads", 1, 1000);
+        parser.check_option_arg_range("gate-recall", 0.0, 1.0);
         parser.check_sub_option("train", "threads");
+        parser.check_sub_option("train", "gate-recall");
 
         if (parser.option("h"))
         {
@@ -91,6 +95,7 @@ void train(const command_line_parser& parser)
     parse_conll_data(parser[0], sentences, chunks, chunk_labels);
     ner_trainer trainer(parser[1]);
     trainer.set_num_threads(num_threads);
+    trainer.set_gate_target_recall(get_option(parser, "gate-recall", 0.0));
     trainer.add(sentences, chunks, chunk_labels);
     named_entity_extractor ner = trainer.train();
     cout << "Saving learned named_entity_extractor to ner_model.dat" << endl;
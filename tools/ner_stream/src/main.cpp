@@ -6,8 +6,11 @@
 #include <iostream>
 #include <fstream>
 #include <sstream>
+#include <iomanip>
 #include <mitie/named_entity_extractor.h>
+#include <mitie/streaming_ner.h>
 #include <mitie/conll_tokenizer.h>
+#include <mitie/pipeline_stats.h>
 #include <dlib/time_this.h>
 #include <dlib/cmd_line_parser.h>
 #include <dlib/serialize.h>
@@ -24,14 +27,108 @@ std::vector<std::string> tokenize (
     conll_tokenizer tok(sin);
     std::vector<std::string> words;
     string word;
-    while(tok(word))
-        words.push_back(word);
+    {
+        pipeline_stage_timer timer(stage_tokenize);
+        while(tok(word))
+            words.push_back(word);
+    }
+    if (pipeline_stats_enabled())
+        add_to_pipeline_counter(counter_tokenized_tokens, words.size());
 
     return words;
 }
 
 // ----------------------------------------------------------------------------------------
 
+void print_pipeline_stats (
+    const pipeline_stats_snapshot& stats,
+    std::ostream& out
+)
+{
+    out << "Pipeline statistics (times in microseconds):" << endl;
+    out << "  stage                               calls        mean         p50         p99         max" << endl;
+    for (unsigned long i = 0; i < num_pipeline_stages; ++i)
+    {
+        const stage_stats& s = stats.stages[i];
+        if (s.count == 0)
+            continue;
+        out << "  " << left << setw(32) << pipeline_stage_name((pipeline_stage)i) << right
+            << setw(9) << s.count
+            << setw(12) << fixed << setprecision(2) << s.mean_ns()/1000
+            << setw(12) << s.percentile_ns(0.5)/1000.0
+            << setw(12) << s.percentile_ns(0.99)/1000.0
+            << setw(12) << s.max_ns/1000.0 << endl;
+    }
+    for (unsigned long i = 0; i < num_pipeline_counters; ++i)
+    {
+        if (stats.counters[i] != 0)
+            out << "  " << left << setw(32) << pipeline_counter_name((pipeline_counter)i) << right
+                << setw(9) << stats.counters[i] << endl;
+    }
+    out << "  NER OOV rate: " << setprecision(2) << 100*stats.ner_oov_rate() << "%" << endl;
+    if (stats.counters[counter_ner_gate_sentences] != 0)
+        out << "  NER gate skip rate: " << setprecision(2) << 100*stats.ner_gate_skip_rate() << "%" << endl;
+}
+
+// ----------------------------------------------------------------------------------------
+
+void print_streaming_entities (
+    streaming_named_entity_extractor& stream,
+    const std::vector<std::string>& tags
+)
+{
+    streaming_entity e;
+    while (stream.next_entity(e))
+    {
+        cout << e.begin << "\t" << e.end << "\t" << tags[e.tag] << "\t";
+        for (unsigned long i = 0; i < e.tokens.size(); ++i)
+        {
+            if (i != 0)
+                cout << " ";
+            cout << e.tokens[i];
+        }
+        cout << endl;
+    }
+}
+
+void run_streaming_ner (
+    const named_entity_extractor& ner,
+    const unsigned long window_size,
+    const unsigned long overlap
+)
+/*!
+    ensures
+        - Treats all of cin as one stream of tokens, ignoring line breaks, and prints
+          each entity as soon as it's final.  Each entity is printed on its own line
+          as its begin and end token positions in the stream, its tag, and its tokens,
+          separated by tabs.
+!*/
+{
+    streaming_named_entity_extractor stream(ner, window_size, overlap);
+    const std::vector<std::string>& tags = ner.get_tag_name_strings();
+    conll_tokenizer tok(cin);
+    string word;
+    while (true)
+    {
+        bool got_word;
+        {
+            pipeline_stage_timer timer(stage_tokenize);
+            got_word = tok(word);
+        }
+        if (!got_word)
+            break;
+        if (pipeline_stats_enabled())
+            add_to_pipeline_counter(counter_tokenized_tokens, 1);
+
+        stream.add_token(word);
+        print_streaming_entities(stream, tags);
+    }
+    stream.flush();
+    print_streaming_entities(stream, tags);
+}
+
+// ----------------------------------------------------------------------------------------
+
 int main(int argc, char** argv)
 {
     try
@@ -40,10 +137,24 @@ int main(int argc, char** argv)
         parser.add_option("h", "Display this help information.");
         parser.add_option("o", "Output the results to a file named <arg>.  The contents will be saved "
             "using dlib's serialization format. ",1);
+        parser.add_option("oov-cache", "Cache the feature vectors of up to <arg> out of dictionary words "
+            "and report the cache hit rate when done.",1);
+        parser.add_option("stats", "Record how long each stage of NER takes and print the statistics "
+            "when done.");
+        parser.add_option("stream", "Treat the input as one stream of tokens, ignoring line breaks, and "
+            "run NER over overlapping windows of <arg> tokens.  Each entity is printed as soon as it's "
+            "final, one per line, as its begin and end token positions, tag, and text.",1);
+        parser.add_option("overlap", "The number of tokens each window shares with the previous one when "
+            "using --stream (default: 20).",1);
 
         parser.parse(argc, argv);
-        const char* one_time_ops[] = {"o", "h"};
+        const char* one_time_ops[] = {"o", "h", "oov-cache", "stats", "stream", "overlap"};
         parser.check_one_time_options(one_time_ops);
+        parser.check_option_arg_range("oov-cache", 1, 100000000);
+        parser.check_option_arg_range("stream", 1, 100000000);
+        parser.check_option_arg_range("overlap", 0, 100000000);
+        parser.check_incompatible_options("o", "stream");
+        parser.check_sub_option("stream", "overlap");
         if (parser.option("h"))
         {
             cout << "Usage: cat input_file.txt | ner_stream <options> MITIE-models/english/ner_model.dat" << endl;
@@ -65,10 +176,30 @@ int main(int argc, char** argv)
         // and then the instance of that class.  So here we read those two things from the
         // given model file.
         TIME_THIS_TO(deserialize(parser[0]) >> classname >> ner, cerr);
+        if (parser.option("oov-cache"))
+            ner.set_oov_cache_capacity(get_option(parser, "oov-cache", 0));
+
+        if (parser.option("stats"))
+        {
+            set_pipeline_stats_enabled(true);
+            if (!pipeline_stats_enabled())
+                cerr << "MITIE was built with MITIE_DISABLE_PIPELINE_STATS so no statistics will be recorded." << endl;
+        }
 
         cerr << "Now running NER tool..." << endl;
 
-        if (parser.option("o"))
+        if (parser.option("stream"))
+        {
+            const unsigned long window_size = get_option(parser, "stream", default_streaming_window_size);
+            const unsigned long overlap = get_option(parser, "overlap", std::min(default_streaming_overlap, window_size-1));
+            if (overlap >= window_size)
+            {
+                cerr << "Error, the --overlap must be less than the --stream window size." << endl;
+                return 1;
+            }
+            run_streaming_ner(ner, window_size, overlap);
+        }
+        else if (parser.option("o"))
         {
             const string filename = parser.option("o").argument();
             cerr << "saving results to file " << filename << endl;
@@ -121,6 +252,18 @@ int main(int argc, char** argv)
             }
         }
 
+        if (parser.option("oov-cache"))
+        {
+            const total_word_feature_extractor& fe = ner.get_total_word_feature_extractor();
+            const dlib::uint64 lookups = fe.get_oov_cache_hits() + fe.get_oov_cache_misses();
+            cerr << "OOV cache hits: " << fe.get_oov_cache_hits() << " of " << lookups << " lookups";
+            if (lookups != 0)
+                cerr << " (" << 100.0*fe.get_oov_cache_hits()/lookups << "%)";
+            cerr << ", words cached: " << fe.get_oov_cache_size() << endl;
+        }
+
+        if (parser.option("stats"))
+            print_pipeline_stats(get_pipeline_stats(), cerr);
     }
     catch (std::exception& e)
     {
@@ -0,0 +1,236 @@
+// Copyright (C) 2014 Massachusetts Institute of Technology, Lincoln Laboratory
+// License: Boost Software License   See LICENSE.txt for the full license.
+// Authors: Davis E. King (davis@dlib.net)
+
+/*
+    This tool makes a smaller version of a MITIE named_entity_extractor that is adapted
+    to the text it will be used on.  It does two things:
+        - It removes all the words from the model's total_word_feature_extractor that
+          never appear in a corpus of text you give it.  Those words then get their
+          features from the word morphology features just like any other word that isn't
+          in the dictionary.  So the model still works on them, it just knows a bit less
+          about them.
+        - It sets the segmenter and entity classifier weights that are very close to 0
+          to exactly 0.  The pruned model's classifier weights are saved in a sparse
+          form when most of them are 0.
+
+    If you give it a CoNLL file of held out data it also tells you how the accuracy of
+    the pruned model compares to the original.
+*/
+
+#include <mitie/named_entity_extractor.h>
+#include <mitie/ner_trainer.h>
+#include <mitie/conll_parser.h>
+#include <mitie/conll_tokenizer.h>
+#include <mitie/group_tokenizer.h>
+#include <dlib/cmd_line_parser.h>
+#include <dlib/dir_nav.h>
+#include <iostream>
+#include <iomanip>
+#include <cmath>
+#include <map>
+#include <set>
+
+using namespace dlib;
+using namespace std;
+using namespace mitie;
+
+// ----------------------------------------------------------------------------------------
+
+typedef multiclass_linear_decision_function<sparse_linear_kernel<ner_sample_type>,unsigned long> classifier_type;
+
+std::set<std::string> get_corpus_vocabulary (
+    const std::vector<file>& files,
+    unsigned long min_count,
+    unsigned long num_threads
+);
+
+template <typename matrix_type>
+unsigned long zero_small_weights (
+    matrix_type& weights,
+    double threshold
+);
+
+void print_evaluation (
+    const std::string& conll_file,
+    const named_entity_extractor& ner,
+    const named_entity_extractor& pruned
+);
+
+// ----------------------------------------------------------------------------------------
+
+int main(int argc, char** argv)
+{
+    try
+    {
+        command_line_parser parser;
+        parser.add_option("h", "Display this help information.");
+        parser.add_option("out", "Save the pruned model to <arg> (default: pruned_ner_model.dat).",1);
+        parser.add_option("min-count", "Keep only dictionary words that appear at least <arg> times in the corpus (default: 1).",1);
+        parser.add_option("threshold", "Set the segmenter and classifier weights with magnitude less than <arg> to 0 (default: 0).",1);
+        parser.add_option("keep-dictionary", "Don't remove any words from the dictionary, only prune the weights.");
+        parser.add_option("test", "Report how the accuracy of the pruned model compares to the original on the CoNLL file <arg>.",1);
+        parser.add_option("threads", "Use <arg> threads when reading the corpus (default: 4).",1);
+
+        parser.parse(argc,argv);
+        parser.check_option_arg_range("min-count", 1, 1000000000);
+        parser.check_option_arg_range("threshold", 0.0, 1e30);
+        parser.check_option_arg_range("threads", 1, 1000);
+        parser.check_incompatible_options("keep-dictionary", "min-count");
+
+        if (parser.option("h") || parser.number_of_arguments() < 1 ||
+            (parser.number_of_arguments() == 1 && !parser.option("keep-dictionary")))
+        {
+            cout << "Usage: prune_model [options] ner_model.dat corpus_files...\n";
+            cout << "Makes a smaller version of ner_model.dat which knows only the words used in the\n";
+            cout << "corpus files.  The corpus files should be plain text that is representative\n";
+            cout << "of the text the model will be used on.\n\n";
+            parser.print_options();
+            return 0;
+        }
+
+        const std::string out_file = get_option(parser, "out", "pruned_ner_model.dat");
+        const unsigned long min_count = get_option(parser, "min-count", 1);
+        const double threshold = get_option(parser, "threshold", 0.0);
+        const unsigned long num_threads = get_option(parser, "threads", 4);
+
+        string classname;
+        named_entity_extractor ner;
+        deserialize(parser[0]) >> classname;
+        if (classname != "mitie::named_entity_extractor")
+            throw dlib::error("This file does not contain a mitie::named_entity_extractor. Contained: " + classname);
+        deserialize(parser[0]) >> classname >> ner;
+
+        total_word_feature_extractor fe = ner.get_total_word_feature_extractor();
+        if (!parser.option("keep-dictionary"))
+        {
+            std::vector<file> files;
+            for (unsigned long i = 1; i < parser.number_of_arguments(); ++i)
+                files.push_back(file(parser[i]));
+
+            const std::set<std::string> vocab = get_corpus_vocabulary(files, min_count, num_threads);
+            cout << "distinct words in corpus:      " << vocab.size() << endl;
+            cout << "words in original dictionary:  " << fe.get_num_words_in_dictionary() << endl;
+            fe.prune_dictionary(vocab);
+            cout << "words in pruned dictionary:    " << fe.get_num_words_in_dictionary() << endl;
+        }
+
+        matrix<double,0,1> seg_weights = ner.get_segmenter().get_weights();
+        const unsigned long seg_zeroed = zero_small_weights(seg_weights, threshold);
+        sequence_segmenter<ner_feature_extractor> segmenter(seg_weights, ner.get_segmenter().get_feature_extractor());
+
+        classifier_type df = ner.get_df();
+        const unsigned long df_zeroed = zero_small_weights(df.weights, threshold);
+
+        cout << "segmenter weights set to 0:    " << seg_zeroed << " of " << seg_weights.size() << endl;
+        cout << "classifier weights set to 0:   " << df_zeroed << " of " << df.weights.size() << endl;
+
+        named_entity_extractor pruned(ner.get_tag_name_strings(), fe, segmenter, df);
+        pruned.set_save_sparse_weights(true);
+        serialize(out_file) << "mitie::named_entity_extractor" << pruned;
+        cout << "Saved pruned model to " << out_file << endl;
+        cout << "original model size (bytes):   " << file(parser[0]).size() << endl;
+        cout << "pruned model size (bytes):     " << file(out_file).size() << endl;
+
+        if (parser.option("test"))
+            print_evaluation(parser.option("test").argument(), ner, pruned);
+
+        return 0;
+    }
+    catch (std::exception& e)
+    {
+        cout << e.what() << endl;
+        return 1;
+    }
+}
+
+// ----------------------------------------------------------------------------------------
+
+std::set<std::string> get_corpus_vocabulary (
+    const std::vector<file>& files,
+    unsigned long min_count,
+    unsigned long num_threads
+)
+{
+    // Tokenize the corpus the same way ner_stream does so we keep exactly the words
+    // the model will be asked about.
+    group_tokenizer<conll_tokenizer> tok(files, num_threads);
+    std::map<std::string,unsigned long> counts;
+    std::string word;
+    while (tok(word))
+        counts[word]++;
+
+    std::set<std::string> vocab;
+    for (std::map<std::string,unsigned long>::iterator i = counts.begin(); i != counts.end(); ++i)
+    {
+        if (i->second >= min_count)
+            vocab.insert(i->first);
+    }
+    return vocab;
+}
+
+// ----------------------------------------------------------------------------------------
+
+template <typename matrix_type>
+unsigned long zero_small_weights (
+    matrix_type& weights,
+    double threshold
+)
+/*!
+    ensures
+        - sets all the elements of weights with magnitude less than threshold to 0.
+        - returns the number of elements of weights that are now 0.
+!*/
+{
+    unsigned long num_zero = 0;
+    for (long r = 0; r < weights.nr(); ++r)
+    {
+        for (long c = 0; c < weights.nc(); ++c)
+        {
+            if (std::abs(weights(r,c)) < threshold)
+                weights(r,c) = 0;
+            if (weights(r,c) == 0)
+                ++num_zero;
+        }
+    }
+    return num_zero;
+}
+
+// ----------------------------------------------------------------------------------------
+
+double f1_score (
+    const ner_eval_metrics& m
+)
+{
+    if (m.overall_precision + m.overall_recall == 0)
+        return 0;
+    return 2*m.overall_precision*m.overall_recall/(m.overall_precision + m.overall_recall);
+}
+
+void print_evaluation (
+    const std::string& conll_file,
+    const named_entity_extractor& ner,
+    const named_entity_extractor& pruned
+)
+{
+    std::vector<std::vector<std::string> > sentences;
+    std::vector<std::vector<std::pair<unsigned long, unsigned long> > > chunks;
+    std::vector<std::vector<std::string> > chunk_labels;
+    parse_conll_data(conll_file, sentences, chunks, chunk_labels);
+
+    const ner_eval_metrics before = evaluate_named_entity_recognizer(ner, sentences, chunks, chunk_labels);
+    const ner_eval_metrics after = evaluate_named_entity_recognizer(pruned, sentences, chunks, chunk_labels);
+
+    cout << "\nOriginal model on " << conll_file << ":\n" << before << endl;
+    cout << "Pruned model on " << conll_file << ":\n" << after << endl;
+
+    cout.setf(std::ios_base::fixed, std::ios_base::floatfield);
+    cout << setprecision(4) << showpos;
+    cout << "change in precision: " << after.overall_precision - before.overall_precision << endl;
+    cout << "change in recall:    " << after.overall_recall - before.overall_recall << endl;
+    cout << "change in F1:        " << f1_score(after) - f1_score(before) << endl;
+    cout << noshowpos;
+}
+
+// ----------------------------------------------------------------------------------------
+
@@ -58,6 +58,7 @@ void get_most_common_substrings (
 {
     substrs.clear();
     mitie::count_min_sketch counts(10000000);
+    counts.set_conservative_update(true);
 
     // Note that we use * to denote the start or end of a string.
 
@@ -70,7 +70,12 @@ void cca_morph(const dlib::command_line_parser& parser)
 {
     const long num_morph_correlations = 90;
 
-    std::ifstream fin("word_vects.dat", ios::binary);
+    // --streaming-cca means the word vectors came from --word-vects --streaming-cca,
+    // which saves them under their own name.
+    const char* word_vects_file = parser.option("streaming-cca") ? "word_vects_approx.dat" : "word_vects.dat";
+    std::ifstream fin(word_vects_file, ios::binary);
+    if (!fin)
+        throw dlib::error(std::string("Unable to open ") + word_vects_file + ".  Run --word-vects first.");
     std::map<std::string, matrix<float,0,1> > word_vectors;
     deserialize(word_vectors, fin);
     cout << "num word vectors loaded: " << word_vectors.size() << endl;
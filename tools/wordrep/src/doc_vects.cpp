@@ -8,6 +8,10 @@
 #include <mitie/group_tokenizer.h>
 #include <mitie/gigaword_reader.h>
 #include <mitie/unigram_tokenizer.h>
+#include <dlib/threads.h>
+#include <dlib/general_hash/murmur_hash3.h>
+#include "streaming_cca.h"
+#include "word_index.h"
 
 using namespace std;
 using namespace dlib;
@@ -17,21 +21,6 @@ typedef std::vector<std::pair<dlib::uint32, float> > sparse_vector_type;
 
 // ----------------------------------------------------------------------------------------
 
-static unsigned long get_word_id (
-    const std::map<std::string, unsigned long>& vocab,
-    const std::string& word
-)
-{
-    std::map<std::string, unsigned long>::const_iterator i;
-    i = vocab.find(word);
-    if (i != vocab.end())
-        return i->second;
-    else
-        return vocab.size();
-}
-
-// ----------------------------------------------------------------------------------------
-
 static std::map<std::string, unsigned long> make_word_to_int_mapping (
     const std::map<std::string, unsigned long>& words,
     unsigned long num
@@ -57,22 +46,39 @@ static std::map<std::string, unsigned long> make_word_to_int_mapping (
 
 // ----------------------------------------------------------------------------------------
 
-void gigaword_doc_to_vects (
-    const std::map<std::string, unsigned long>& words,
-    const gigaword_document& doc,
+class string_streambuf : public std::streambuf
+{
+    /*
+        A read only streambuf over a std::string.  Unlike an istringstream it doesn't
+        make a copy of the string.
+    */
+public:
+    explicit string_streambuf (
+        const std::string& str
+    )
+    {
+        char* begin = const_cast<char*>(str.data());
+        setg(begin, begin, begin + str.size());
+    }
+};
+
+// ----------------------------------------------------------------------------------------
+
+static void add_words_to_vects (
+    const word_index& vocab,
+    const std::string& text,
     sparse_vector_type& lhs,
     sparse_vector_type& rhs,
     dlib::rand& rnd
 )
 {
-    lhs.clear();
-    rhs.clear();
-    istringstream sin(doc.text + " " + doc.headline);
+    string_streambuf buf(text);
+    std::istream sin(&buf);
     unigram_tokenizer tok(sin);
     string word;
     while (tok(word))
     {
-        const unsigned long id = get_word_id(words, word);
+        const unsigned long id = vocab(word);
         if (rnd.get_random_float() > 0.5)
         {
             lhs.push_back(make_pair(id, 1));
@@ -82,6 +88,20 @@ void gigaword_doc_to_vects (
             rhs.push_back(make_pair(id, 1));
         }
     }
+}
+
+void gigaword_doc_to_vects (
+    const word_index& vocab,
+    const gigaword_document& doc,
+    sparse_vector_type& lhs,
+    sparse_vector_type& rhs,
+    dlib::rand& rnd
+)
+{
+    lhs.clear();
+    rhs.clear();
+    add_words_to_vects(vocab, doc.text, lhs, rhs, rnd);
+    add_words_to_vects(vocab, doc.headline, lhs, rhs, rnd);
 
     make_sparse_vector_inplace(lhs);
     make_sparse_vector_inplace(rhs);
@@ -89,22 +109,105 @@ void gigaword_doc_to_vects (
 
 // ----------------------------------------------------------------------------------------
 
-void make_doc_vects(const dlib::command_line_parser& parser)
+static void seed_from_document (
+    dlib::rand& rnd,
+    const gigaword_document& doc
+)
+/*!
+    ensures
+        - seeds rnd from the contents of doc.  So how a document is split into halves
+          doesn't depend on which shard or thread read it.
+!*/
 {
-    const long vocab_size = 300000;
-    const long num_contexts = 40000000;
-    const long num_correlations = get_option(parser, "dims", 500);
+    rnd.set_seed(doc.id + ":" + cast_to_string(murmur_hash3(doc.text.data(), doc.text.size())));
+}
 
-    ifstream fin("top_word_counts.dat", ios::binary);
-    std::map<std::string, unsigned long> words;
-    deserialize(words, fin);
-    cout << "num words in dictionary: " << words.size() << endl;
+struct doc_cca_job
+{
+    /*
+        Sketches the CCA between the two random halves of each document in each shard of
+        files.  Each shard is sketched into its own float streaming_cca which is
+        periodically folded into the shared double precision one.  All the sums are
+        integers small enough to be exact, and the halves of each document are picked by
+        an RNG seeded from the document itself, so the final sketch doesn't depend on
+        the number of shards.
+    */
+    doc_cca_job (
+        const word_index& vocab_,
+        const long num_correlations_,
+        const std::vector<std::vector<dlib::file> >& shards_,
+        streaming_cca<double>& total_
+    ) : vocab(vocab_), num_correlations(num_correlations_), shards(shards_), total(total_) {}
 
-    words = make_word_to_int_mapping(words,vocab_size);
+    const word_index& vocab;
+    const long num_correlations;
+    const std::vector<std::vector<dlib::file> >& shards;
+    streaming_cca<double>& total;
+    dlib::mutex m;
 
-    std::vector<dlib::file> files = get_files_in_directory_tree(directory(parser[0]), match_all());
-    cout << "number of gigaword XML files found: " << files.size() << endl;
-    gigaword_reader reader(files);
+    void process_shard (long s)
+    {
+        const unsigned long dims = vocab.size()+1;
+        streaming_cca<float> local(dims, dims, num_correlations);
+        // Once sums get bigger than this a float can't exactly hold them anymore.
+        const double max_exact_float = 1<<24;
+
+        gigaword_reader reader(shards[s], 1);
+        dlib::rand rnd;
+        gigaword_document doc;
+        sparse_vector_type lhs, rhs;
+        while (reader(doc))
+        {
+            seed_from_document(rnd, doc);
+            gigaword_doc_to_vects(vocab, doc, lhs, rhs, rnd);
+            local.add(lhs, rhs);
+            if (local.get_magnitude_bound() > max_exact_float)
+            {
+                auto_mutex lock(m);
+                total.absorb(local);
+                local.clear();
+            }
+        }
+
+        auto_mutex lock(m);
+        total.absorb(local);
+    }
+};
+
+static matrix<float,0,1> do_streaming_doc_cca (
+    const word_index& vocab,
+    const long num_correlations,
+    const std::vector<dlib::file>& files,
+    const unsigned long num_threads,
+    matrix<float>& Ltrans,
+    matrix<float>& Rtrans
+)
+{
+    // Sketch the CCA of the document vectors in a single pass over the corpus.  This
+    // way we never need to hold the document vectors in RAM.
+    streaming_cca<double> sketch(vocab.size()+1, vocab.size()+1, num_correlations);
+    const std::vector<std::vector<dlib::file> > shards = split_into_shards(files, num_threads);
+    doc_cca_job job(vocab, num_correlations, shards, sketch);
+    parallel_for(num_threads, 0, shards.size(), job, &doc_cca_job::process_shard, 1);
+
+    cout << "Number of document vectors collected: " << sketch.size() << endl;
+    cout << "Done gathering data, now running CCA." << endl;
+    return sketch.solve(Ltrans, Rtrans, num_correlations);
+}
+
+// ----------------------------------------------------------------------------------------
+
+static matrix<float,0,1> do_doc_cca (
+    const word_index& vocab,
+    const long num_correlations,
+    const std::vector<dlib::file>& files,
+    const unsigned long num_threads,
+    matrix<float>& Ltrans,
+    matrix<float>& Rtrans
+)
+{
+    const long num_contexts = 40000000;
+    gigaword_reader reader(files, num_threads);
 
     random_subset_selector<sparse_vector_type> L, R;
     L.set_max_size(num_contexts);
@@ -116,32 +219,66 @@ void make_doc_vects(const dlib::command_line_parser& parser)
     dlib::rand rnd;
     while (reader(doc))
     {
-        gigaword_doc_to_vects(words, doc, lhs, rhs, rnd);
+        gigaword_doc_to_vects(vocab, doc, lhs, rhs, rnd);
         L.add(lhs);
         R.add(rhs);
     }
 
     cout << "Number of document vectors collected: " << L.size() << endl;
     cout << "Done gathering data, now running CCA." << endl;
+    return cca(L, R, Ltrans, Rtrans, num_correlations, 30);
+}
+
+// ----------------------------------------------------------------------------------------
+
+void make_doc_vects(const dlib::command_line_parser& parser)
+{
+    const long vocab_size = 300000;
+    const long num_correlations = get_option(parser, "dims", 500);
+    const unsigned long num_threads = get_option(parser, "threads", 4);
+
+    ifstream fin("top_word_counts.dat", ios::binary);
+    std::map<std::string, unsigned long> words;
+    deserialize(words, fin);
+    cout << "num words in dictionary: " << words.size() << endl;
+
+    words = make_word_to_int_mapping(words,vocab_size);
+    const word_index vocab(words);
+
+    std::vector<dlib::file> files = get_files_in_directory_tree(directory(parser[0]), match_all());
+    cout << "number of gigaword XML files found: " << files.size() << endl;
+
+    // The streaming CCA only approximates the exact one, and the vectors it makes have
+    // a different geometry.  So we save them under a different name so nothing mistakes
+    // them for the output of the exact CCA.
+    const bool approximate = parser.option("streaming-cca");
+    const std::string out_file = approximate ? "doc_vects_approx.dat" : "doc_vects.dat";
 
     matrix<float> Ltrans, Rtrans;
-    matrix<float> cors = cca(L, R, Ltrans, Rtrans, num_correlations, 30);
-    cout << "CCA correlations: "<< trans(cors) << endl;
+    if (approximate)
+    {
+        matrix<float> svals = do_streaming_doc_cca(vocab, num_correlations, files, num_threads, Ltrans, Rtrans);
+        cout << "whitened cross-covariance singular values: "<< trans(svals) << endl;
+    }
+    else
+    {
+        matrix<float> cors = do_doc_cca(vocab, num_correlations, files, num_threads, Ltrans, Rtrans);
+        cout << "CCA correlations: "<< trans(cors) << endl;
+    }
 
     // now build a map of words to their CCA reduced representation
     std::map<string, matrix<float,0,1> > word_vectors;
-    for (std::map<string,unsigned long>::const_iterator i = words.begin(); i != words.end(); ++i)
+    for (unsigned long i = 0; i < vocab.size(); ++i)
     {
         // Ltrans and Rtrans should really contain the same basic information.  So we just
         // use Ltrans and ignore the other since it should be redundant.
-        word_vectors[i->first] = trans(rowm(Ltrans, get_word_id(words, i->first)));
+        word_vectors[vocab.get_word(i)] = trans(rowm(Ltrans, i));
     }
 
-    cout << "Saving word to vector map to doc_vects.dat file..." << endl;
-    std::ofstream fout("doc_vects.dat", ios::binary);
+    cout << "Saving word to vector map to " << out_file << " file..." << endl;
+    std::ofstream fout(out_file.c_str(), ios::binary);
     serialize(word_vectors, fout);
 }
 
 // ----------------------------------------------------------------------------------------
 
-
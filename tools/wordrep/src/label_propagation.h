@@ -0,0 +1,201 @@
+// Copyright (C) 2014 Massachusetts Institute of Technology, Lincoln Laboratory
+// License: Boost Software License   See LICENSE.txt for the full license.
+// Authors: Davis E. King (davis@dlib.net)
+#ifndef MIT_LL_LABEL_PrOPAGATION_H_
+#define MIT_LL_LABEL_PrOPAGATION_H_
+
+#include <vector>
+#include <algorithm>
+#include <dlib/graph_utils.h>
+#include <dlib/threads.h>
+#include <dlib/general_hash/murmur_hash3.h>
+
+// ----------------------------------------------------------------------------------------
+
+class label_propagation_job
+{
+    /*!
+        WHAT THIS OBJECT REPRESENTS
+            This object does one round of label propagation over a block of nodes of a
+            graph in compressed sparse row form.  Each node reads the labels of the
+            previous round from labels and writes its new label into new_labels, so
+            all the blocks can be processed at the same time by parallel_for().
+    !*/
+public:
+
+    label_propagation_job (
+        const std::vector<unsigned long>& offsets_,
+        const std::vector<std::pair<unsigned long,double> >& neighbors_,
+        unsigned long block_size_
+    ) : offsets(offsets_), neighbors(neighbors_), block_size(block_size_) {}
+    /*!
+        requires
+            - offsets.size() == the number of nodes + 1
+            - The neighbors of node i, along with the weights of the edges to them, are
+              neighbors[offsets[i]] through neighbors[offsets[i+1]-1].
+            - block_size_ > 0
+        ensures
+            - This object will update the nodes in blocks of block_size_ nodes.
+            - The caller must size labels and new_labels to the number of nodes and
+              num_changed to the number of blocks, and set iteration, before calling
+              process_block().
+    !*/
+
+    const std::vector<unsigned long>& offsets;
+    const std::vector<std::pair<unsigned long,double> >& neighbors;
+    const unsigned long block_size;
+
+    dlib::uint32 iteration;
+    std::vector<unsigned long> labels;
+    std::vector<unsigned long> new_labels;
+    std::vector<unsigned long> num_changed;
+
+    void process_block (long b)
+    /*!
+        requires
+            - 0 <= b < num_changed.size()
+        ensures
+            - for all nodes i in block b:
+                - #new_labels[i] == the label node i has after this round.  That's its
+                  current label, or, if it's picked to update this round, the label with
+                  the most edge weight among its neighbors.
+            - #num_changed[b] == the number of nodes in block b whose label changed.
+    !*/
+    {
+        std::vector<std::pair<unsigned long,double> > votes;
+        const unsigned long end = std::min<unsigned long>(labels.size(), (b+1)*block_size);
+        num_changed[b] = 0;
+        for (unsigned long i = b*block_size; i < end; ++i)
+        {
+            new_labels[i] = labels[i];
+            // If every node updated at once, pairs of nodes could keep swapping labels
+            // forever.  So each round only a random half of the nodes get updated.
+            if ((dlib::murmur_hash3_2(i, iteration)&1) == 0 || offsets[i] == offsets[i+1])
+                continue;
+
+            votes.clear();
+            for (unsigned long j = offsets[i]; j < offsets[i+1]; ++j)
+                votes.push_back(std::make_pair(labels[neighbors[j].first], neighbors[j].second));
+            std::sort(votes.begin(), votes.end());
+
+            // Pick the label with the most total edge weight.  Ties go to the current
+            // label and then to the smallest label.
+            double best_weight = -1;
+            unsigned long best_label = labels[i];
+            for (unsigned long j = 0; j < votes.size();)
+            {
+                const unsigned long label = votes[j].first;
+                double weight = 0;
+                for (; j < votes.size() && votes[j].first == label; ++j)
+                    weight += votes[j].second;
+                if (weight > best_weight || (weight == best_weight && label == labels[i]))
+                {
+                    best_weight = weight;
+                    best_label = label;
+                }
+            }
+
+            if (best_label != labels[i])
+            {
+                new_labels[i] = best_label;
+                ++num_changed[b];
+            }
+        }
+    }
+};
+
+// ----------------------------------------------------------------------------------------
+
+inline unsigned long parallel_label_propagation (
+    const std::vector<dlib::sample_pair>& edges,
+    std::vector<unsigned long>& labels,
+    const unsigned long num_threads,
+    const unsigned long max_iterations = 100
+)
+/*!
+    requires
+        - num_threads > 0
+    ensures
+        - This function does the same job as dlib::chinese_whispers().  That is, it finds
+          clusters in the undirected weighted graph defined by edges by having each node
+          repeatedly take on the label with the most edge weight among its neighbors.
+          The difference is that it updates the nodes in parallel using num_threads
+          threads.  It stops when no label changes or after max_iterations rounds.
+        - #labels.size() == max_index_plus_one(edges)
+        - returns the number of clusters found.
+        - for all valid i:
+            - 0 <= #labels[i] < the number of clusters found
+            - #labels[i] == the cluster label of the node with index i in the graph.
+!*/
+{
+    using namespace dlib;
+    const unsigned long num_nodes = max_index_plus_one(edges);
+
+    // Put the graph into compressed sparse row form, listing each edge in both
+    // directions.
+    std::vector<unsigned long> offsets(num_nodes+1, 0);
+    for (unsigned long i = 0; i < edges.size(); ++i)
+    {
+        if (edges[i].index1() == edges[i].index2())
+            continue;
+        ++offsets[edges[i].index1()+1];
+        ++offsets[edges[i].index2()+1];
+    }
+    for (unsigned long i = 0; i < num_nodes; ++i)
+        offsets[i+1] += offsets[i];
+    std::vector<std::pair<unsigned long,double> > neighbors(offsets[num_nodes]);
+    std::vector<unsigned long> pos(offsets.begin(), offsets.end()-1);
+    for (unsigned long i = 0; i < edges.size(); ++i)
+    {
+        const unsigned long a = edges[i].index1();
+        const unsigned long b = edges[i].index2();
+        if (a == b)
+            continue;
+        neighbors[pos[a]++] = std::make_pair(b, edges[i].distance());
+        neighbors[pos[b]++] = std::make_pair(a, edges[i].distance());
+    }
+
+    const unsigned long block_size = 1024;
+    label_propagation_job job(offsets, neighbors, block_size);
+    job.labels.resize(num_nodes);
+    for (unsigned long i = 0; i < num_nodes; ++i)
+        job.labels[i] = i;
+    job.new_labels.resize(num_nodes);
+    const unsigned long num_blocks = (num_nodes + block_size - 1)/block_size;
+    job.num_changed.resize(num_blocks);
+
+    bool last_round_was_quiet = false;
+    for (unsigned long iter = 0; iter < max_iterations; ++iter)
+    {
+        job.iteration = iter;
+        parallel_for(num_threads, 0, num_blocks, job, &label_propagation_job::process_block);
+        job.labels.swap(job.new_labels);
+
+        unsigned long num_changed = 0;
+        for (unsigned long b = 0; b < num_blocks; ++b)
+            num_changed += job.num_changed[b];
+        // Only about half the nodes get a chance to change each round.  So we stop after
+        // two quiet rounds in a row.
+        if (num_changed == 0 && last_round_was_quiet)
+            break;
+        last_round_was_quiet = (num_changed == 0);
+    }
+
+    // Renumber the labels so they are contiguous.
+    std::vector<unsigned long> ids(num_nodes, num_nodes);
+    unsigned long num_clusters = 0;
+    labels.resize(num_nodes);
+    for (unsigned long i = 0; i < num_nodes; ++i)
+    {
+        const unsigned long l = job.labels[i];
+        if (ids[l] == num_nodes)
+            ids[l] = num_clusters++;
+        labels[i] = ids[l];
+    }
+    return num_clusters;
+}
+
+// ----------------------------------------------------------------------------------------
+
+#endif // MIT_LL_LABEL_PrOPAGATION_H_
+
@@ -6,18 +6,23 @@
 #include <dlib/cmd_line_parser.h>
 #include <mitie/gigaword_reader.h>
 #include <dlib/dir_nav.h>
-#include <mitie/count_min_sketch.h>
+#include <mitie/space_saving_sketch.h>
 #include <mitie/group_tokenizer.h>
 #include <mitie/unigram_tokenizer.h>
 #include "basic_morph.h"
 #include "word_vects.h"
 #include "cca_morph.h"
 #include "doc_vects.h"
+#include "label_propagation.h"
 
 #include <mitie/total_word_feature_extractor.h>
+#include <mitie/word_similarity_index.h>
 
+#include <dlib/threads.h>
 #include <dlib/graph_utils_threaded.h>
 #include <dlib/clustering.h>
+#include <dlib/misc_api.h>
+#include <set>
 
 using namespace std;
 using namespace dlib;
@@ -26,54 +31,69 @@ using namespace mitie;
 
 // ----------------------------------------------------------------------------------------
 
-template <typename tokenizer_type>
+struct shard_word_counter
+{
+    /*
+        Counts the words in each shard of files with a separate space_saving_sketch so
+        that the shards can be processed in parallel.
+    */
+    shard_word_counter (
+        const std::vector<std::vector<dlib::file> >& shards_,
+        unsigned long capacity
+    ) : shards(shards_), counts(shards_.size(), space_saving_sketch(capacity)) {}
+
+    const std::vector<std::vector<dlib::file> >& shards;
+    std::vector<space_saving_sketch> counts;
+
+    void count_shard (long i)
+    {
+        group_tokenizer<unigram_tokenizer> tok(shards[i], 1);
+        std::string token;
+        while (tok(token))
+            counts[i].increment(token);
+    }
+};
+
 void get_top_word_counts (
-    tokenizer_type& tok,
+    const std::vector<dlib::file>& files,
     std::map<std::string, unsigned long>& top_words,
-    const unsigned long max_top_words
+    const unsigned long max_top_words,
+    const unsigned long num_threads
 )
 {
-    count_min_sketch counts(5000000);
+    const std::vector<std::vector<dlib::file> > shards = split_into_shards(files, num_threads);
 
-    // get counts on all the words first
-    std::string token;
-    while (tok(token))
-    {
-        counts.increment(token);
-    }
+    // We track a few times more words than we need so that the words near the bottom of
+    // the top max_top_words list are counted accurately.  
+    shard_word_counter counter(shards, 4*max_top_words);
+    parallel_for(num_threads, 0, shards.size(), counter, &shard_word_counter::count_shard, 1);
 
-    std::priority_queue<std::pair<long, std::string> > best_words;
+    space_saving_sketch& counts = counter.counts[0];
+    for (unsigned long i = 1; i < counter.counts.size(); ++i)
+        counts.absorb(counter.counts[i]);
 
-    dlib::set<std::string>::kernel_1a cur_words;
+    std::vector<std::pair<dlib::uint64, std::string> > best_words;
+    counts.get_top_words(best_words, max_top_words);
 
-    // now pass over the data again and pick out only words with high counts
-    tok.reset();
-    while (tok(token))
+    cout << "total number of words: " << counts.get_total_count() << endl;
+    cout << "distinct words tracked: " << counts.size() << endl;
+    cout << "max overcount of any word count: " << counts.get_error_bound() << endl;
+    cout << "max count of any word not tracked: " << counts.get_min_count() << endl;
+    if (best_words.size() != 0)
     {
-        if (cur_words.is_member(token))
-            continue;
-
-        const long hits = counts.get_count(token);
-        if (best_words.size() < max_top_words || hits > -best_words.top().first)
-        {
-            if (best_words.size() >= max_top_words)
-            {
-                cur_words.destroy(best_words.top().second);
-                best_words.pop();
-            }
-
-            best_words.push(std::make_pair(-hits, token));
-            cur_words.add(token);
-        }
+        // Any word wrongly left out of, or put into, the output must have a real count
+        // somewhere in this range.
+        const dlib::uint64 cutoff = best_words.back().first;
+        const dlib::uint64 error = counts.get_error_bound();
+        cout << "top word list is exact except possibly for words with counts between "
+             << (cutoff > error ? cutoff-error : 0) << " and " 
+             << std::max(cutoff, counts.get_min_count()) << endl;
     }
 
     // now put the best words into top_words
     top_words.clear();
-    while (best_words.size() != 0)
-    {
-        top_words[best_words.top().second] = -best_words.top().first;
-        best_words.pop();
-    }
+    for (unsigned long i = 0; i < best_words.size(); ++i)
+        top_words[best_words[i].second] = best_words[i].first;
 }
 
 // ----------------------------------------------------------------------------------------
@@ -81,6 +101,7 @@ void get_top_word_counts (
 void count_words(const command_line_parser& parser);
 void test(const command_line_parser& parser);
 void cluster_words(const command_line_parser& parser);
+void make_similarity_index(const command_line_parser& parser);
 
 int main(int argc, char** argv)
 {
@@ -100,8 +121,11 @@ int main(int argc, char** argv)
         parser.add_option("cca-morph", "Make a CCA based word morphology extractor object as well as a total word "
                                         "feature extractor.");
         parser.add_option("word-vects", "Use CCA to create distributional word vectors.");
-        parser.add_option("test", "Print out the feature vectors for the word given on the command line.");
+        parser.add_option("test", "Print out the memory used by total_word_feature_extractor.dat and the feature vectors for the "
+            "word given on the command line.");
         parser.add_option("cluster-words", "Generate word clusters based on a saved total_word_feature_extractor.");
+        parser.add_option("similarity-index", "Build an index for quickly finding similar words in the dictionary of a saved "
+            "total_word_feature_extractor and save it to word_similarity_index.dat.");
 
         parser.set_group_name("Document Vector Level Features");
         parser.add_option("doc-vects", "Generate CCA based word features where we assume the important thing about a "
@@ -109,11 +133,35 @@ int main(int argc, char** argv)
             "as input.");
         parser.add_option("dims", "When doing --doc-vects, make the output vectors have <arg> dimensions (default: 500).",1);
 
+        parser.set_group_name("Word Clustering Options");
+        parser.add_option("cluster-k", "When doing --cluster-words, link each word to its <arg> nearest neighbors (default: 100).",1);
+        parser.add_option("cluster-hash", "When doing --cluster-words, find the nearest neighbors using <arg> bit locality "
+            "sensitive hashes.  <arg> can be 64, 128, 256, or 512 (default: 256).",1);
+        parser.add_option("cluster-iterations", "When doing --cluster-words, run at most <arg> rounds of clustering (default: 100).",1);
+        parser.add_option("label-propagation", "When doing --cluster-words, cluster the words with a multithreaded label "
+            "propagation method instead of chinese whispers.");
+
+        parser.set_group_name("Performance Options");
+        parser.add_option("threads", "Use <arg> threads when processing the input text (default: 4).",1);
+        parser.add_option("streaming-cca", "When doing --word-vects or --doc-vects, run a single pass randomized CCA over "
+            "the whole corpus using a fixed amount of RAM rather than doing an exact CCA on a random sample of 50 million "
+            "context windows or 40 million documents.  This CCA is approximate and its vectors have a different geometry "
+            "than the exact ones, so they are saved to word_vects_approx.dat or doc_vects_approx.dat instead of "
+            "word_vects.dat or doc_vects.dat.  Give it with --cca-morph, or with -e, to build the total word "
+            "feature extractor from word_vects_approx.dat.");
+
 
         parser.parse(argc,argv);
         parser.check_option_arg_range("count-words", 1, 1000000000);
         parser.check_option_arg_range("dims", 1, 100000);
+        parser.check_option_arg_range("threads", 1, 1000);
+        parser.check_option_arg_range("cluster-k", 1, 100000);
+        const unsigned long hash_sizes[] = {64, 128, 256, 512};
+        parser.check_option_arg_range("cluster-hash", hash_sizes);
+        parser.check_option_arg_range("cluster-iterations", 1, 1000000);
         parser.check_sub_option("doc-vects", "dims");
+        const char* cluster_options[] = {"cluster-k", "cluster-hash", "cluster-iterations", "label-propagation"};
+        parser.check_sub_options("cluster-words", cluster_options);
         parser.check_incompatible_options("e", "word-vects");
         parser.check_incompatible_options("e", "count-words");
         parser.check_incompatible_options("e", "basic-morph");
@@ -132,7 +180,7 @@ int main(int argc, char** argv)
             ofstream fout(parser.option("convert-gigaword").argument().c_str());
             std::vector<dlib::file> files = get_files_in_directory_tree(directory(parser[0]), match_all());
             cout << "number of gigaword files found: " << files.size() << endl;
-            mitie::gigaword_reader reader(files);
+            mitie::gigaword_reader reader(files, get_option(parser, "threads", 4));
             std::string data;
             while (reader(data))
                 fout << data << "\n\n";
@@ -178,6 +226,11 @@ int main(int argc, char** argv)
             cluster_words(parser);
         }
 
+        if (parser.option("similarity-index"))
+        {
+            make_similarity_index(parser);
+        }
+
         if (parser.option("doc-vects"))
         {
             make_doc_vects(parser);
@@ -194,8 +247,34 @@ int main(int argc, char** argv)
 
 // ----------------------------------------------------------------------------------------
 
+struct word_vector_job
+{
+    /*
+        Gets the feature vectors for a range of dictionary words.
+    */
+    word_vector_job (
+        const total_word_feature_extractor& fe_,
+        const std::vector<std::string>& words_,
+        std::vector<matrix<float,0,1> >& vects_
+    ) : fe(fe_), words(words_), vects(vects_) {}
+
+    const total_word_feature_extractor& fe;
+    const std::vector<std::string>& words;
+    std::vector<matrix<float,0,1> >& vects;
+
+    void get_vector (long i)
+    {
+        fe.get_feature_vector(words[i], vects[i]);
+    }
+};
+
 void cluster_words(const command_line_parser& parser)
 {
+    const unsigned long num_threads = get_option(parser, "threads", 4);
+    const unsigned long k = get_option(parser, "cluster-k", 100);
+    const unsigned long hash_size = get_option(parser, "cluster-hash", 256);
+    const unsigned long max_iterations = get_option(parser, "cluster-iterations", 100);
+
     string classname;
     total_word_feature_extractor fe;
     deserialize("total_word_feature_extractor.dat") >> classname >> fe;
@@ -205,12 +284,22 @@ void cluster_words(const command_line_parser& parser)
     const std::vector<std::string>& words = fe.get_words_in_dictionary();
     std::vector<matrix<float,0,1> > vects;
     vects.resize(words.size());
-    for (unsigned long i = 0; i < vects.size(); ++i)
-        fe.get_feature_vector(words[i], vects[i]);
+    word_vector_job vector_job(fe, words, vects);
+    parallel_for(num_threads, 0, vects.size(), vector_job, &word_vector_job::get_vector);
 
     cout << "Making graph" << endl;
+    // find_k_nearest_neighbors_lsh() hashes the words and searches for each word's
+    // neighbors with parallel_for(), so the graph is already built by all the threads.
+    // Splitting the dictionary into shards and searching each one alone would only find
+    // neighbors within the same shard.
     std::vector<sample_pair> edges;
-    find_k_nearest_neighbors_lsh(vects, cosine_distance(), hash_similar_angles_256(), 100, 4, edges);
+    switch (hash_size)
+    {
+        case 64:  find_k_nearest_neighbors_lsh(vects, cosine_distance(), hash_similar_angles_64(), k, num_threads, edges); break;
+        case 128: find_k_nearest_neighbors_lsh(vects, cosine_distance(), hash_similar_angles_128(), k, num_threads, edges); break;
+        case 256: find_k_nearest_neighbors_lsh(vects, cosine_distance(), hash_similar_angles_256(), k, num_threads, edges); break;
+        case 512: find_k_nearest_neighbors_lsh(vects, cosine_distance(), hash_similar_angles_512(), k, num_threads, edges); break;
+    }
     cout << "edges.size(): "<< edges.size() << endl;
 
     // change all the edge weights to use the formula from the unsupervised POS paper.
@@ -229,7 +318,11 @@ void cluster_words(const command_line_parser& parser)
     cout << "edges.size(): "<< edges.size() << endl;
 
     std::vector<unsigned long> labels;
-    const unsigned long num_clusters = chinese_whispers(edges, labels);
+    unsigned long num_clusters;
+    if (parser.option("label-propagation"))
+        num_clusters = parallel_label_propagation(edges, labels, num_threads, max_iterations);
+    else
+        num_clusters = chinese_whispers(edges, labels, max_iterations);
     //const unsigned long num_clusters = newman_cluster(edges, labels);
     cout << "num_clusters: "<< num_clusters << endl;
     cout << "labels.size(): "<< labels.size() << endl;
@@ -260,13 +353,13 @@ void cluster_words(const command_line_parser& parser)
 void count_words(const command_line_parser& parser)
 {
     const unsigned long num_top_words = get_option(parser, "count-words", 200000);
+    const unsigned long num_threads = get_option(parser, "threads", 4);
 
     std::vector<dlib::file> files = get_files_in_directory_tree(directory(parser[0]), match_all());
     cout << "number of raw ASCII files found: " << files.size() << endl;
 
-    group_tokenizer<unigram_tokenizer> tok(files);
     std::map<std::string, unsigned long> words;
-    get_top_word_counts(tok, words, num_top_words);
+    get_top_word_counts(files, words, num_top_words, num_threads);
 
     cout << "num words: "<< words.size() << endl;
     cout << "saving word counts to top_word_counts.dat" << endl;
@@ -298,11 +391,82 @@ void test(const command_line_parser& parser)
     cout << "words in dictionary: " << fe.get_num_words_in_dictionary() << endl;
     cout << "num features: " << fe.get_num_dimensions() << endl;
 
+    const memory_usage usage = fe.get_memory_usage();
+    cout << "memory usage: " << usage.total_bytes() << " bytes" << endl;
+    for (unsigned long i = 0; i < usage.size(); ++i)
+        cout << "   " << usage.name(i) << " \t" << usage.bytes(i) << endl;
+
     string word = parser[0];
 
     matrix<float,0,1> feats;
     fe.get_feature_vector(word,feats);
     cout << "feature vector: "<< trans(feats) << endl;
+
+    if (file_exists("word_similarity_index.dat"))
+    {
+        word_similarity_index index;
+        deserialize("word_similarity_index.dat") >> classname >> index;
+        std::vector<std::pair<std::string,float> > similar;
+        index.find_similar_words(fe, word, 10, similar);
+        cout << "most similar words: " << endl;
+        for (unsigned long i = 0; i < similar.size(); ++i)
+            cout << "   " << similar[i].first << " \t" << similar[i].second << endl;
+    }
+}
+
+// ----------------------------------------------------------------------------------------
+
+void make_similarity_index(const command_line_parser& )
+{
+    string classname;
+    total_word_feature_extractor fe;
+    deserialize("total_word_feature_extractor.dat") >> classname >> fe;
+    cout << "words in dictionary: " << fe.get_num_words_in_dictionary() << endl;
+
+    dlib::timestamper ts;
+    dlib::uint64 start = ts.get_timestamp();
+    const word_similarity_index index(fe);
+    cout << "build time: " << (ts.get_timestamp()-start)/1e6 << " seconds" << endl;
+
+    // Check the index against a brute force search for a sample of the words.
+    const std::vector<std::string> words = fe.get_words_in_dictionary();
+    std::vector<matrix<float,0,1> > vects(words.size());
+    for (unsigned long i = 0; i < words.size(); ++i)
+    {
+        fe.get_feature_vector(words[i], vects[i]);
+        const float len = length(vects[i]);
+        if (len != 0)
+            vects[i] /= len;
+    }
+    const unsigned long k = 10;
+    const unsigned long num_queries = std::min<unsigned long>(200, words.size());
+    dlib::rand rnd;
+    unsigned long num_found = 0, num_total = 0;
+    dlib::uint64 query_time = 0;
+    std::vector<std::pair<std::string,float> > results;
+    std::vector<std::pair<float,std::string> > exact;
+    for (unsigned long q = 0; q < num_queries; ++q)
+    {
+        const unsigned long i = rnd.get_random_32bit_number()%words.size();
+        start = ts.get_timestamp();
+        index.find_nearest_words(vects[i], k, results);
+        query_time += ts.get_timestamp()-start;
+
+        exact.clear();
+        for (unsigned long j = 0; j < words.size(); ++j)
+            exact.push_back(make_pair(-dot(vects[i], vects[j]), words[j]));
+        std::partial_sort(exact.begin(), exact.begin()+std::min(k,exact.size()), exact.end());
+        std::set<std::string> found;
+        for (unsigned long j = 0; j < results.size(); ++j)
+            found.insert(results[j].first);
+        for (unsigned long j = 0; j < std::min(k,exact.size()); ++j, ++num_total)
+            num_found += found.count(exact[j].second);
+    }
+    cout << "recall of the top " << k << " words: " << (double)num_found/std::max<unsigned long>(1,num_total) << endl;
+    cout << "average query time: " << query_time/std::max<unsigned long>(1,num_queries) << " microseconds" << endl;
+
+    cout << "saving index to word_similarity_index.dat" << endl;
+    serialize("word_similarity_index.dat") << "mitie::word_similarity_index" << index;
 }
 
 // ----------------------------------------------------------------------------------------
@@ -0,0 +1,316 @@
+// Copyright (C) 2014 Massachusetts Institute of Technology, Lincoln Laboratory
+// License: Boost Software License   See LICENSE.txt for the full license.
+// Authors: Davis E. King (davis@dlib.net)
+#ifndef MIT_LL_STREAMING_CcA_H_
+#define MIT_LL_STREAMING_CcA_H_
+
+#include <dlib/matrix.h>
+#include <dlib/uintn.h>
+#include <dlib/general_hash/murmur_hash3.h>
+#include <vector>
+
+// ----------------------------------------------------------------------------------------
+
+template <typename T>
+inline void add_random_signs (
+    dlib::uint64 row,
+    dlib::uint64 seed,
+    T scale,
+    T* dest,
+    long n
+)
+/*!
+    ensures
+        - Adds scale times row number row of a random +1/-1 matrix to the n elements of
+          dest.  The random matrix is never stored.  Its entries are recomputed from a hash
+          of (row, column, seed) each time they are needed.
+!*/
+{
+    for (long j = 0; j < n; j += 128)
+    {
+        const std::pair<dlib::uint64,dlib::uint64> h = dlib::murmur_hash3_128bit_3(row, j/128, seed);
+        const long end1 = std::min(n, j+64);
+        for (long c = j; c < end1; ++c)
+            dest[c] += ((h.first>>(c-j))&1) ? scale : -scale;
+        const long end2 = std::min(n, j+128);
+        for (long c = j+64; c < end2; ++c)
+            dest[c] += ((h.second>>(c-j-64))&1) ? scale : -scale;
+    }
+}
+
+// ----------------------------------------------------------------------------------------
+
+template <typename T>
+class streaming_cca
+{
+    /*!
+        WHAT THIS OBJECT REPRESENTS
+            This object computes a CCA between pairs of sparse vectors (L,R) in a single
+            pass and in an amount of RAM that doesn't depend on how many pairs you give
+            it.  It is meant for the kind of data wordrep uses, where each vector is a
+            bag of word indicator features.
+
+            To make that possible it makes two approximations:
+                - The covariance matrix of each view is approximated by its diagonal,
+                  i.e. the counts of each feature.  This is the usual approximation for
+                  CCA on word indicator features, see Two Step CCA: A new spectral method
+                  for estimating vector models of words by Dhillon et al.
+                - The whitened cross-covariance matrix is only kept as a pair of random
+                  sketches, a range sketch C*Omega and a co-range sketch trans(Psi)*C.
+                  After the pass its top singular vectors are recovered as described in
+                  Practical Sketching Algorithms for Low-Rank Matrix Approximation by
+                  Tropp, Yurtsever, Udell, and Cevher.
+
+            The RAM used is about (left_dims + right_dims)*(num_correlations +
+            2*extra_rank)*sizeof(T) bytes.  The random test matrices are never stored.
+
+            Objects with the same dimensions share the same test matrices.  So you can
+            split a data set into shards, sketch each shard in its own thread, and
+            combine the results with absorb().  T == float is a good choice for the
+            per-thread sketches, as long as they are absorbed into a streaming_cca<double>
+            before get_magnitude_bound() gets large.  With integer feature values the
+            float sums are exact while get_magnitude_bound() < 2^24.
+    !*/
+
+public:
+
+    streaming_cca (
+        unsigned long left_dims_,
+        unsigned long right_dims_,
+        unsigned long num_correlations,
+        unsigned long extra_rank = 40
+    ) :
+        left_dims(left_dims_),
+        right_dims(right_dims_),
+        range_rank(num_correlations + extra_rank),
+        corange_rank(num_correlations + 2*extra_rank)
+    /*!
+        requires
+            - left_dims_ > 0
+            - right_dims_ > 0
+            - num_correlations > 0
+        ensures
+            - #size() == 0
+            - This object will accept sparse vectors with indices less than left_dims_ for
+              the left view and less than right_dims_ for the right view.
+    !*/
+    {
+        DLIB_CASSERT(left_dims > 0 && right_dims > 0 && num_correlations > 0,
+            "Invalid inputs were given to this function");
+        Y.set_size(left_dims, range_rank);
+        Wt.set_size(right_dims, corange_rank);
+        left_counts.set_size(left_dims);
+        right_counts.set_size(right_dims);
+        clear();
+    }
+
+    void clear (
+    )
+    /*!
+        ensures
+            - #size() == 0
+            - #get_magnitude_bound() == 0
+    !*/
+    {
+        Y = 0;
+        Wt = 0;
+        left_counts = 0;
+        right_counts = 0;
+        num_pairs = 0;
+        magnitude_bound = 0;
+    }
+
+    dlib::uint64 size (
+    ) const { return num_pairs; }
+    /*!
+        ensures
+            - returns the number of vector pairs this object has seen.
+    !*/
+
+    double get_magnitude_bound (
+    ) const { return magnitude_bound; }
+    /*!
+        ensures
+            - returns an upper bound on the absolute value of any of the sums stored in
+              this object.
+    !*/
+
+    template <typename sparse_vector_type>
+    void add (
+        const sparse_vector_type& l,
+        const sparse_vector_type& r
+    )
+    /*!
+        requires
+            - l and r are sparse vectors with index values < left_dims and < right_dims
+              respectively.
+        ensures
+            - adds the pair (l,r) to the CCA problem.
+            - #size() == size() + 1
+    !*/
+    {
+        typedef typename sparse_vector_type::const_iterator iter;
+
+        // Y += l*trans(r)*Omega
+        temp.set_size(range_rank);
+        temp = 0;
+        T sum_r = 0, max_r = 0;
+        for (iter i = r.begin(); i != r.end(); ++i)
+        {
+            DLIB_ASSERT(i->first < right_dims, "invalid index: " << i->first);
+            add_random_signs<T>(i->first, omega_seed, i->second, &temp(0), range_rank);
+            right_counts(i->first) += i->second*i->second;
+            sum_r += std::abs(i->second);
+            max_r = std::max<T>(max_r, std::abs(i->second));
+        }
+        for (iter i = l.begin(); i != l.end(); ++i)
+        {
+            T* row = &Y(i->first,0);
+            for (long c = 0; c < range_rank; ++c)
+                row[c] += i->second*temp(c);
+        }
+
+        // trans(Wt) += trans(Psi)*l*trans(r)
+        temp.set_size(corange_rank);
+        temp = 0;
+        T sum_l = 0, max_l = 0;
+        for (iter i = l.begin(); i != l.end(); ++i)
+        {
+            DLIB_ASSERT(i->first < left_dims, "invalid index: " << i->first);
+            add_random_signs<T>(i->first, psi_seed, i->second, &temp(0), corange_rank);
+            left_counts(i->first) += i->second*i->second;
+            sum_l += std::abs(i->second);
+            max_l = std::max<T>(max_l, std::abs(i->second));
+        }
+        for (iter i = r.begin(); i != r.end(); ++i)
+        {
+            T* row = &Wt(i->first,0);
+            for (long c = 0; c < corange_rank; ++c)
+                row[c] += i->second*temp(c);
+        }
+
+        magnitude_bound += std::max(std::max(max_l*sum_r, max_r*sum_l), std::max(max_l*max_l, max_r*max_r));
+        ++num_pairs;
+    }
+
+    template <typename U>
+    void absorb (
+        const streaming_cca<U>& item
+    )
+    /*!
+        requires
+            - item has the same dimensions as *this
+        ensures
+            - #size() == size() + item.size()
+            - *this now contains all the pairs which were added to item.  That is, it is
+              as if each call to item.add() had also been made on *this.
+    !*/
+    {
+        DLIB_CASSERT(Y.nr() == item.Y.nr() && Y.nc() == item.Y.nc() &&
+                     Wt.nr() == item.Wt.nr() && Wt.nc() == item.Wt.nc(),
+                     "Invalid inputs were given to this function");
+        Y += dlib::matrix_cast<T>(item.Y);
+        Wt += dlib::matrix_cast<T>(item.Wt);
+        left_counts += dlib::matrix_cast<T>(item.left_counts);
+        right_counts += dlib::matrix_cast<T>(item.right_counts);
+        num_pairs += item.num_pairs;
+        magnitude_bound += item.magnitude_bound;
+    }
+
+    dlib::matrix<float,0,1> solve (
+        dlib::matrix<float>& Ltrans,
+        dlib::matrix<float>& Rtrans,
+        unsigned long num_correlations
+    ) const
+    /*!
+        requires
+            - size() != 0
+        ensures
+            - Computes the CCA of all the pairs given to add().  The outputs have the
+              same meaning as the outputs of dlib::cca().  That is:
+                - #Ltrans.nr() == left_dims, #Rtrans.nr() == right_dims
+                - #Ltrans.nc() == #Rtrans.nc() == the number of correlations found,
+                  which is at most num_correlations
+                - returns the singular values of the whitened cross-covariance matrix,
+                  largest first.  Since the whitening ignores the correlations between
+                  features within a view these aren't limited to [0,1] like real
+                  correlations.  For example, with 4 word positions in each view the
+                  top value is about 4.
+    !*/
+    {
+        using namespace dlib;
+        // Features that never showed up get a count of 1 so we don't divide by 0.
+        const matrix<float,0,1> dl = sqrt(matrix_cast<float>(left_counts) + 1);
+        const matrix<float,0,1> dr = sqrt(matrix_cast<float>(right_counts) + 1);
+
+        // Q spans the range of the whitened cross-covariance matrix
+        // A = inv(diagm(dl))*C*inv(diagm(dr)).
+        matrix<float> Q = scale_rows(matrix_cast<float>(Y), reciprocal(dl));
+        orthogonalize(Q);
+
+        // The co-range sketch is trans(Psi)*C*inv(diagm(dr)) == trans(diagm(dl)*Psi)*A.
+        // So we need M = trans(diagm(dl)*Psi)*Q to solve for the rest of A.
+        matrix<double> M(corange_rank, range_rank);
+        M = 0;
+        matrix<float,0,1> psi(corange_rank);
+        for (long i = 0; i < Q.nr(); ++i)
+        {
+            psi = 0;
+            add_random_signs<float>(i, psi_seed, dl(i), &psi(0), corange_rank);
+            const float* q = &Q(i,0);
+            for (long r = 0; r < corange_rank; ++r)
+            {
+                double* m = &M(r,0);
+                for (long c = 0; c < range_rank; ++c)
+                    m[c] += psi(r)*q[c];
+            }
+        }
+
+        // Now A == Q*trans(Xt)
+        const matrix<float> Xt = scale_rows(matrix_cast<float>(Wt), reciprocal(dr))*matrix_cast<float>(trans(pinv(M)));
+
+        // Do an SVD of trans(Xt) using the eigendecomposition of its small Gram matrix.
+        eigenvalue_decomposition<matrix<double> > eig(make_symmetric(matrix_cast<double>(trans(Xt)*Xt)));
+        matrix<double,0,1> D = sqrt(lowerbound(eig.get_real_eigenvalues(),0));
+        matrix<double> U = eig.get_pseudo_v();
+        rsort_columns(U, D);
+
+        long n = std::min<long>(num_correlations, D.size());
+        while (n > 0 && D(n-1) <= D(0)*1e-6)
+            --n;
+        DLIB_CASSERT(n > 0, "streaming_cca::solve() found no correlations");
+        U = colm(U, range(0,n-1));
+        D = rowm(D, range(0,n-1));
+
+        Ltrans = scale_rows(Q*matrix_cast<float>(U), reciprocal(dl));
+        Rtrans = scale_rows(Xt*matrix_cast<float>(U*inv(diagm(D))), reciprocal(dr));
+        return matrix_cast<float>(D);
+    }
+
+    template <typename U> friend class streaming_cca;
+
+private:
+
+    static const dlib::uint64 omega_seed = 1;
+    static const dlib::uint64 psi_seed = 2;
+
+    long left_dims;
+    long right_dims;
+    long range_rank;
+    long corange_rank;
+
+    dlib::matrix<T> Y;   // C*Omega, left_dims by range_rank
+    dlib::matrix<T> Wt;  // trans(C)*Psi, right_dims by corange_rank
+    dlib::matrix<T,0,1> left_counts;
+    dlib::matrix<T,0,1> right_counts;
+    dlib::uint64 num_pairs;
+    double magnitude_bound;
+
+    // scratch space for add()
+    dlib::matrix<T,0,1> temp;
+};
+
+// ----------------------------------------------------------------------------------------
+
+#endif // MIT_LL_STREAMING_CcA_H_
+
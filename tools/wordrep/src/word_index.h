@@ -0,0 +1,134 @@
+// Copyright (C) 2014 Massachusetts Institute of Technology, Lincoln Laboratory
+// License: Boost Software License   See LICENSE.txt for the full license.
+// Authors: Davis E. King (davis@dlib.net)
+#ifndef MIT_LL_WORD_InDEX_H_
+#define MIT_LL_WORD_InDEX_H_
+
+#include <map>
+#include <string>
+#include <vector>
+#include <dlib/uintn.h>
+#include <dlib/assert.h>
+#include <dlib/general_hash/murmur_hash3.h>
+
+// ----------------------------------------------------------------------------------------
+
+class word_index
+{
+    /*!
+        WHAT THIS OBJECT REPRESENTS
+            This is a read only mapping from words to integer IDs.  It does the same
+            thing as calling find() on the std::map<std::string,unsigned long> it was
+            made from.  However, it's a flat open addressing hash table so a lookup
+            costs one hash and usually one string comparison.  This matters because
+            wordrep looks up every token of the corpus.
+
+        THREAD SAFETY
+            All the member functions are const so any number of threads can use this
+            object at the same time.
+    !*/
+public:
+
+    word_index (
+    ) : table(16,0) {}
+    /*!
+        ensures
+            - #size() == 0
+    !*/
+
+    explicit word_index (
+        const std::map<std::string, unsigned long>& vocab
+    )
+    /*!
+        requires
+            - The IDs in vocab are the integers 0 through vocab.size()-1.
+        ensures
+            - #size() == vocab.size()
+            - for all words W in vocab:
+                - (*this)(W) == vocab[W]
+                - get_word(vocab[W]) == W
+    !*/
+    {
+        words.resize(vocab.size());
+        hashes.resize(vocab.size());
+        // Keep the table at most half full so probe sequences stay short.
+        unsigned long table_size = 16;
+        while (table_size < 2*vocab.size())
+            table_size *= 2;
+        table.assign(table_size, 0);
+
+        const unsigned long mask = table.size()-1;
+        for (std::map<std::string,unsigned long>::const_iterator i = vocab.begin(); i != vocab.end(); ++i)
+        {
+            DLIB_CASSERT(i->second < vocab.size(), "The word IDs must be contiguous.");
+            words[i->second] = i->first;
+            hashes[i->second] = hash(i->first);
+            unsigned long k = hashes[i->second]&mask;
+            while (table[k] != 0)
+                k = (k+1)&mask;
+            table[k] = i->second+1;
+        }
+    }
+
+    unsigned long size (
+    ) const { return words.size(); }
+    /*!
+        ensures
+            - returns the number of words in this index.
+    !*/
+
+    unsigned long operator() (
+        const std::string& word
+    ) const
+    /*!
+        ensures
+            - if (word is in this index) then
+                - returns the ID of word
+            - else
+                - returns size()
+    !*/
+    {
+        const dlib::uint32 h = hash(word);
+        const unsigned long mask = table.size()-1;
+        for (unsigned long k = h&mask; table[k] != 0; k = (k+1)&mask)
+        {
+            const unsigned long id = table[k]-1;
+            if (hashes[id] == h && words[id] == word)
+                return id;
+        }
+        return words.size();
+    }
+
+    const std::string& get_word (
+        unsigned long id
+    ) const
+    /*!
+        requires
+            - id < size()
+        ensures
+            - returns the word with the given ID.
+    !*/
+    {
+        return words[id];
+    }
+
+private:
+
+    static dlib::uint32 hash (
+        const std::string& word
+    )
+    {
+        if (word.size() == 0)
+            return 0;
+        return dlib::murmur_hash3(&word[0], word.size());
+    }
+
+    std::vector<std::string> words;
+    std::vector<dlib::uint32> hashes;
+    std::vector<dlib::uint32> table;
+};
+
+// ----------------------------------------------------------------------------------------
+
+#endif // MIT_LL_WORD_InDEX_H_
+
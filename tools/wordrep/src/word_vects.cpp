@@ -9,6 +9,9 @@
 #include <map>
 #include <mitie/group_tokenizer.h>
 #include <mitie/unigram_tokenizer.h>
+#include <dlib/threads.h>
+#include "streaming_cca.h"
+#include "word_index.h"
 
 using namespace std;
 using namespace dlib;
@@ -18,34 +21,24 @@ typedef std::vector<std::pair<dlib::uint32, float> > sparse_vector_type;
 
 // ----------------------------------------------------------------------------------------
 
-unsigned long get_word_id (
-    const std::map<std::string, unsigned long>& vocab,
-    const std::string& word
-)
-{
-    std::map<std::string, unsigned long>::const_iterator i;
-    i = vocab.find(word);
-    if (i != vocab.end())
-        return i->second;
-    else
-        return vocab.size();
-}
-
-// ----------------------------------------------------------------------------------------
-
 template <typename sparse_vector_type>
 void get_left_and_right_context_vectors (
-    const std::map<std::string, unsigned long>& vocab,
-    const dlib::circular_buffer<std::string>& buf,
+    const unsigned long vocab_size,
+    const dlib::circular_buffer<unsigned long>& buf,
     sparse_vector_type& left_context,
     sparse_vector_type& right_context
 )
+/*!
+    requires
+        - buf contains the word IDs of a window of text.  Words not in the vocabulary
+          have the ID vocab_size.
+!*/
 {
     // get the left context vector
     left_context.clear();
     for (unsigned long i = 0; i < buf.size()/2; ++i)
     {
-        left_context.push_back(make_pair(i*(vocab.size()+1) + get_word_id(vocab, buf[i]), 1));
+        left_context.push_back(make_pair(i*(vocab_size+1) + buf[i], 1));
     }
     make_sparse_vector_inplace(left_context);
 
@@ -55,7 +48,7 @@ void get_left_and_right_context_vectors (
     long k = 0;
     for (unsigned long i = buf.size()/2+1; i < buf.size(); ++i)
     {
-        right_context.push_back(make_pair(k*(vocab.size()+1) + get_word_id(vocab, buf[i]), 1));
+        right_context.push_back(make_pair(k*(vocab_size+1) + buf[i], 1));
         ++k;
     }
     make_sparse_vector_inplace(right_context);
@@ -65,7 +58,7 @@ void get_left_and_right_context_vectors (
 
 template <typename tokenizer_type>
 void do_cca_on_windows (
-    const std::map<std::string, unsigned long>& vocab,
+    const word_index& vocab,
     const long window_size,
     const long num_contexts,
     const long num_correlations,
@@ -81,7 +74,7 @@ void do_cca_on_windows (
     right_contexts.set_max_size(num_contexts);
 
 
-    dlib::circular_buffer<std::string> buf;
+    dlib::circular_buffer<unsigned long> buf;
     buf.resize(window_size);
 
     sparse_vector_type left_vect, right_vect;
@@ -91,7 +84,7 @@ void do_cca_on_windows (
     uint64 count = 0;
     while (tok(token))
     {
-        buf.push_back(token);
+        buf.push_back(vocab(token));
         // skip the rest of the loop if buf isn't full yet
         ++count;
         if (count < buf.size())
@@ -101,7 +94,7 @@ void do_cca_on_windows (
 
         if (left_contexts.next_add_accepts())
         {
-            get_left_and_right_context_vectors(vocab, buf, left_vect, right_vect);
+            get_left_and_right_context_vectors(vocab.size(), buf, left_vect, right_vect);
             left_contexts.add(left_vect);
             right_contexts.add(right_vect);
         }
@@ -125,56 +118,194 @@ void do_cca_on_windows (
 
 // ----------------------------------------------------------------------------------------
 
-template <typename tokenizer_type>
-void get_average_context_window_vector_per_word (
-    const std::map<std::string, unsigned long>& vocab,
+struct streaming_window_cca_job
+{
+    /*
+        Sketches the CCA between the left and right halves of every window of text in
+        each shard of files.  Each shard is sketched into its own float streaming_cca
+        which is periodically folded into the shared double precision one.
+    */
+    streaming_window_cca_job (
+        const word_index& vocab_,
+        const long window_size_,
+        const long num_correlations_,
+        const std::vector<std::vector<dlib::file> >& shards_,
+        streaming_cca<double>& total_
+    ) : vocab(vocab_), window_size(window_size_), num_correlations(num_correlations_),
+        shards(shards_), total(total_) {}
+
+    const word_index& vocab;
+    const long window_size;
+    const long num_correlations;
+    const std::vector<std::vector<dlib::file> >& shards;
+    streaming_cca<double>& total;
+    dlib::mutex m;
+
+    void process_shard (long s)
+    {
+        const unsigned long dims = (window_size/2)*(vocab.size()+1);
+        streaming_cca<float> local(dims, dims, num_correlations);
+        // Once sums get bigger than this a float can't exactly hold them anymore.
+        const double max_exact_float = 1<<24;
+
+        group_tokenizer<unigram_tokenizer> tok(shards[s], 1);
+        dlib::circular_buffer<unsigned long> buf;
+        buf.resize(window_size);
+        sparse_vector_type left_vect, right_vect;
+        std::string token;
+        uint64 count = 0;
+        while (tok(token))
+        {
+            buf.push_back(vocab(token));
+            // skip the rest of the loop if buf isn't full yet
+            ++count;
+            if (count < buf.size())
+                continue;
+
+            get_left_and_right_context_vectors(vocab.size(), buf, left_vect, right_vect);
+            local.add(left_vect, right_vect);
+            if (local.get_magnitude_bound() > max_exact_float)
+            {
+                auto_mutex lock(m);
+                total.absorb(local);
+                local.clear();
+            }
+        }
+
+        auto_mutex lock(m);
+        total.absorb(local);
+    }
+};
+
+void do_streaming_cca_on_windows (
+    const word_index& vocab,
     const long window_size,
-    tokenizer_type& tok,
-    const matrix<float>& Ltrans,
-    const matrix<float>& Rtrans,
-    std::map<std::string, matrix<float,0,1> >& word_vectors
+    const long num_correlations,
+    const std::vector<dlib::file>& files,
+    const unsigned long num_threads,
+    matrix<float>& Ltrans,
+    matrix<float>& Rtrans
 )
 {
-    tok.reset();
-    word_vectors.clear();
+    const unsigned long dims = (window_size/2)*(vocab.size()+1);
+    streaming_cca<double> sketch(dims, dims, num_correlations);
 
-    std::map<std::string,long> word_hits;
-    dlib::circular_buffer<std::string> buf;
-    buf.resize(window_size);
+    const std::vector<std::vector<dlib::file> > shards = split_into_shards(files, num_threads);
+    cout << "Sketch the CCA of all context windows using " << shards.size() << " shards" << endl;
+    streaming_window_cca_job job(vocab, window_size, num_correlations, shards, sketch);
+    parallel_for(num_threads, 0, shards.size(), job, &streaming_window_cca_job::process_shard, 1);
 
-    sparse_vector_type left_vect, right_vect;
+    cout << "Now solve for the CCA (number of contexts: " << sketch.size() << ")." << endl;
+    // These aren't correlations.  See streaming_cca::solve() for why.
+    cout << "whitened cross-covariance singular values: "<< trans(sketch.solve(Ltrans, Rtrans, num_correlations));
+}
 
-    std::string token;
-    unsigned long count = 1;
-    while (tok(token))
+// ----------------------------------------------------------------------------------------
+
+struct average_context_vector_job
+{
+    /*
+        Sums the CCA projected context vectors of each vocabulary word over one shard
+        of files.  Each shard gets its own dense accumulator, indexed by word ID, so the
+        shards can be processed in parallel and summed at the end.
+    */
+    average_context_vector_job (
+        const word_index& vocab_,
+        const long window_size_,
+        const std::vector<std::vector<dlib::file> >& shards_,
+        const matrix<float>& Ltrans_,
+        const matrix<float>& Rtrans_
+    ) : vocab(vocab_), window_size(window_size_), shards(shards_), Ltrans(Ltrans_), Rtrans(Rtrans_),
+        sums(shards_.size()), hits(shards_.size()) {}
+
+    const word_index& vocab;
+    const long window_size;
+    const std::vector<std::vector<dlib::file> >& shards;
+    const matrix<float>& Ltrans;
+    const matrix<float>& Rtrans;
+
+    std::vector<matrix<double> > sums;
+    std::vector<std::vector<uint64> > hits;
+
+    void process_shard (long s)
     {
-        buf.push_back(token);
-        // skip the rest of the loop if buf isn't full yet
-        if (count < buf.size())
+        const long dims = Ltrans.nc() + Rtrans.nc();
+        sums[s].set_size(vocab.size(), dims);
+        sums[s] = 0;
+        hits[s].assign(vocab.size(), 0);
+
+        group_tokenizer<unigram_tokenizer> tok(shards[s], 1);
+        dlib::circular_buffer<unsigned long> buf;
+        buf.resize(window_size);
+        sparse_vector_type left_vect, right_vect;
+        std::string token;
+        unsigned long count = 1;
+        while (tok(token))
         {
-            ++count;
-            continue;
+            buf.push_back(vocab(token));
+            // skip the rest of the loop if buf isn't full yet
+            if (count < buf.size())
+            {
+                ++count;
+                continue;
+            }
+
+            const unsigned long center_word = buf[buf.size()/2];
+            // only consider words in the vocab
+            if (center_word == vocab.size())
+                continue;
+
+            // Add trans(Ltrans)*left_vect and trans(Rtrans)*right_vect into this word's
+            // row.  Since the context vectors are just indicators we only need to add up
+            // some rows of Ltrans and Rtrans.
+            get_left_and_right_context_vectors(vocab.size(), buf, left_vect, right_vect);
+            double* dest = &sums[s](center_word,0);
+            for (unsigned long i = 0; i < left_vect.size(); ++i)
+            {
+                const float* src = &Ltrans(left_vect[i].first,0);
+                for (long c = 0; c < Ltrans.nc(); ++c)
+                    dest[c] += left_vect[i].second*src[c];
+            }
+            dest += Ltrans.nc();
+            for (unsigned long i = 0; i < right_vect.size(); ++i)
+            {
+                const float* src = &Rtrans(right_vect[i].first,0);
+                for (long c = 0; c < Rtrans.nc(); ++c)
+                    dest[c] += right_vect[i].second*src[c];
+            }
+            hits[s][center_word] += 1;
         }
-
-        const std::string& center_word = buf[buf.size()/2];
-        // only consider words in the vocab
-        if (vocab.count(center_word) == 0)
-            continue;
-
-        get_left_and_right_context_vectors(vocab, buf, left_vect, right_vect);
-        word_vectors[center_word] += join_cols(sparse_matrix_vector_multiply(trans(Ltrans), left_vect),
-                                               sparse_matrix_vector_multiply(trans(Rtrans), right_vect));
-        word_hits[center_word] += 1;
     }
+};
+
+void get_average_context_window_vector_per_word (
+    const word_index& vocab,
+    const long window_size,
+    const std::vector<dlib::file>& files,
+    const unsigned long num_threads,
+    const matrix<float>& Ltrans,
+    const matrix<float>& Rtrans,
+    std::map<std::string, matrix<float,0,1> >& word_vectors
+)
+{
+    word_vectors.clear();
 
+    const std::vector<std::vector<dlib::file> > shards = split_into_shards(files, num_threads);
+    average_context_vector_job job(vocab, window_size, shards, Ltrans, Rtrans);
+    parallel_for(num_threads, 0, shards.size(), job, &average_context_vector_job::process_shard, 1);
 
-    // Divide all the word vectors by their hits so they are mean vectors
-    for (std::map<std::string,long>::iterator i = word_hits.begin(); i != word_hits.end(); ++i)
+    // Reduce the per shard sums and turn them into mean vectors
+    for (unsigned long s = 1; s < shards.size(); ++s)
     {
-        if (i->second > 1)
-        {
-            word_vectors[i->first] /= i->second;
-        }
+        job.sums[0] += job.sums[s];
+        for (unsigned long i = 0; i < vocab.size(); ++i)
+            job.hits[0][i] += job.hits[s][i];
+        job.sums[s].set_size(0,0);
+    }
+    for (unsigned long i = 0; i < vocab.size(); ++i)
+    {
+        if (job.hits[0][i] != 0)
+            word_vectors[vocab.get_word(i)] = matrix_cast<float>(trans(rowm(job.sums[0],i))/job.hits[0][i]);
     }
 }
 
@@ -211,25 +342,41 @@ void word_vects(const dlib::command_line_parser& parser)
     const long window_size = 9;
     const long num_contexts = 50000000;
     const long num_correlations = 90;
+    const unsigned long num_threads = get_option(parser, "threads", 4);
 
     ifstream fin("top_word_counts.dat", ios::binary);
     std::map<std::string, unsigned long> words;
     deserialize(words, fin);
 
     words = make_word_to_int_mapping(words,vocab_size);
+    const word_index vocab(words);
 
     std::vector<dlib::file> files = get_files_in_directory_tree(directory(parser[0]), match_all());
     cout << "number of raw ASCII files found: " << files.size() << endl;
-    group_tokenizer<unigram_tokenizer> tok(files);
+
+    // The streaming CCA only approximates the exact one, and the vectors it makes have
+    // a different geometry.  So we save them under a different name so nothing mistakes
+    // them for the output of the exact CCA.
+    const bool approximate = parser.option("streaming-cca");
+    const std::string out_file = approximate ? "word_vects_approx.dat" : "word_vects.dat";
 
     matrix<float> Ltrans, Rtrans;
-    do_cca_on_windows(words, window_size,  num_contexts, num_correlations, tok, Ltrans, Rtrans);
+    if (approximate)
+    {
+        do_streaming_cca_on_windows(vocab, window_size, num_correlations, files, num_threads, Ltrans, Rtrans);
+    }
+    else
+    {
+        group_tokenizer<unigram_tokenizer> tok(files, num_threads);
+        do_cca_on_windows(vocab, window_size,  num_contexts, num_correlations, tok, Ltrans, Rtrans);
+    }
     cout << "CCA done, now build up average word vectors" << endl;
 
     std::map<std::string, matrix<float,0,1> > word_vectors;
-    get_average_context_window_vector_per_word(words, window_size, tok, Ltrans, Rtrans, word_vectors);
+    get_average_context_window_vector_per_word(vocab, window_size, files, num_threads, Ltrans, Rtrans, word_vectors);
 
-    std::ofstream fout("word_vects.dat", ios::binary);
+    cout << "Saving word to vector map to " << out_file << " file..." << endl;
+    std::ofstream fout(out_file.c_str(), ios::binary);
     serialize(word_vectors, fout);
 }
 